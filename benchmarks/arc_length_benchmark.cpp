@@ -0,0 +1,313 @@
+/*
+ * arc_length_benchmark.cpp
+ *
+ * Measures how the arc length engines of the library trade accuracy for
+ * time, and prints the results to the screen while logging them to a file.
+ *
+ * The engines are bez2ArcLength, swept over flatness_threshold, and the
+ * chord sampling behind Curve::getLength, swept over the number of samples
+ * per Bezier curve that BEZ_ARC_SAMPLES sets at compile time. They are run
+ * over a corpus of four kinds of curves:
+ *
+ *   random          control points uniform in a square
+ *   near_degenerate control points within a hair of the chord or of the
+ *                   anchor points, so that the hull test is decided by
+ *                   rounding
+ *   cusped          randomly placed copies of a curve whose derivative
+ *                   vanishes at t = 0.5
+ *   straight        collinear control points between the anchor points
+ *
+ * Each result is compared with a reference computed in double precision by
+ * Gauss-Legendre quadrature of the speed over many subintervals. For each
+ * kind of curve, a table gives the percentiles of the relative error against
+ * the median time per call, sorted by time, with the settings no faster
+ * setting beats on 99th percentile error marked as the Pareto front.
+ *
+ * Usage: benchmark-arc_length [curves_per_kind] [harness options, see benchInit]
+ */
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <time.h>
+#include <math.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "bezier.h"
+#include "benchmark.h"
+
+
+// default number of curves of each kind
+#define DEFAULT_CURVE_COUNT 1024
+
+// subintervals of the reference quadrature
+#define REFERENCE_INTERVALS 4096
+
+// name of file to log the benchmarks to
+#define LOG_FILE_NAME "arc_length_benchmark.log"
+
+
+/*
+ * struct: Cubic
+ *
+ * Coordinates x0, y0, x1, y1, x2, y2, x3, y3 of a cubic Bezier curve.
+ */
+struct Cubic {
+    BEZ_DTYPE p[8];
+};
+
+/*
+ * struct: Setting
+ *
+ * One engine with one value of its parameter.
+ */
+struct Setting {
+    const char* engine;
+    double parameter;  // flatness_threshold or samples per curve
+};
+
+/*
+ * struct: Row
+ *
+ * Results of one setting on one kind of curve.
+ */
+struct Row {
+    const Setting* setting;
+    double ns;  // median nanoseconds per call
+    double p50, p90, p99, max;  // relative error
+};
+
+
+/*
+ * function: uniform
+ *
+ * Returns a random value uniformly distributed on [a, b].
+ */
+double uniform(double a, double b) {
+    return a + (b - a) * (double)(rand()) / (double)(RAND_MAX);
+}
+
+/*
+ * function: referenceLength
+ *
+ * Returns the arc length of a curve in double precision, integrating its
+ * speed with 4 point Gauss-Legendre quadrature on REFERENCE_INTERVALS
+ * subintervals. A cusp only makes the speed kink, so the error stays far
+ * below that of the engines.
+ */
+double referenceLength(const Cubic& c) {
+    static const double nodes[4] = {-0.8611363115940526, -0.3399810435848563,
+                                    0.3399810435848563, 0.8611363115940526};
+    static const double weights[4] = {0.3478548451374538, 0.6521451548625461,
+                                      0.6521451548625461, 0.3478548451374538};
+    double length = 0.;
+    double h = 1. / REFERENCE_INTERVALS;
+
+    for (size_t i = 0; i < REFERENCE_INTERVALS; i++) {
+        for (size_t k = 0; k < 4; k++) {
+            double t = ((double)(i) + .5 * (nodes[k] + 1.)) * h;
+            double omt = 1. - t;
+            double dx = 3. * (omt * omt * (c.p[2] - c.p[0]) + 2. * omt * t * (c.p[4] - c.p[2]) +
+                              t * t * (c.p[6] - c.p[4]));
+            double dy = 3. * (omt * omt * (c.p[3] - c.p[1]) + 2. * omt * t * (c.p[5] - c.p[3]) +
+                              t * t * (c.p[7] - c.p[5]));
+            length += .5 * h * weights[k] * sqrt(dx * dx + dy * dy);
+        }
+    }
+    return length;
+}
+
+/*
+ * function: sampledLength
+ *
+ * Returns the length of the polyline through samples + 1 evenly spaced
+ * points of a curve, summed in double as Curve::updateArcLengths does.
+ */
+BEZ_DTYPE sampledLength(const Cubic& c, size_t samples) {
+    BEZ_DTYPE x, y, last_x = c.p[0], last_y = c.p[1];
+    double total = 0.;
+
+    for (size_t k = 1; k <= samples; k++) {
+        bez2Evaluate(c.p[0], c.p[1], c.p[2], c.p[3], c.p[4], c.p[5], c.p[6], c.p[7],
+                     (BEZ_DTYPE)(k) / (BEZ_DTYPE)(samples), &x, &y);
+        total += sqrt((double)((x - last_x) * (x - last_x) + (y - last_y) * (y - last_y)));
+        last_x = x;
+        last_y = y;
+    }
+    return (BEZ_DTYPE)(total);
+}
+
+/*
+ * function: measure
+ *
+ * Returns the arc length of a curve as computed with the given setting.
+ */
+BEZ_DTYPE measure(const Setting& setting, const Cubic& c) {
+    if (setting.engine[0] == 'b') {
+        return bez2ArcLength(c.p[0], c.p[1], c.p[2], c.p[3], c.p[4], c.p[5], c.p[6], c.p[7],
+                             (BEZ_DTYPE)(setting.parameter));
+    }
+    return sampledLength(c, (size_t)(setting.parameter));
+}
+
+/*
+ * function: makeCorpus
+ *
+ * Returns count random curves of the given kind, see the top of the file.
+ */
+std::vector<Cubic> makeCorpus(const char* kind, size_t count) {
+    std::vector<Cubic> corpus(count);
+
+    for (Cubic& c : corpus) {
+        double x0 = uniform(0., 100.), y0 = uniform(0., 100.);
+        double x3 = uniform(0., 100.), y3 = uniform(0., 100.);
+
+        if (kind[0] == 'r') {
+            double p[8] = {x0, y0, uniform(0., 100.), uniform(0., 100.),
+                           uniform(0., 100.), uniform(0., 100.), x3, y3};
+            std::copy(p, p + 8, c.p);
+        }
+        else if (kind[0] == 'n') {
+            // half pull the control points off the chord by a hair, half put
+            // them a hair away from the anchor points
+            double nx = -(y3 - y0), ny = x3 - x0;
+            double e1 = uniform(-1e-4, 1e-4), e2 = uniform(-1e-4, 1e-4);
+            double s1 = uniform(0., 1.), s2 = uniform(0., 1.);
+            if (rand() % 2 == 0) {
+                double p[8] = {x0, y0,
+                               x0 + s1 * (x3 - x0) + e1 * nx, y0 + s1 * (y3 - y0) + e1 * ny,
+                               x0 + s2 * (x3 - x0) + e2 * nx, y0 + s2 * (y3 - y0) + e2 * ny,
+                               x3, y3};
+                std::copy(p, p + 8, c.p);
+            }
+            else {
+                double p[8] = {x0, y0, x0 + e1, y0 + e2, x3 - e2, y3 + e1, x3, y3};
+                std::copy(p, p + 8, c.p);
+            }
+        }
+        else if (kind[0] == 'c') {
+            // (0, 0), (1, 1), (0, 1), (1, 0) has a cusp at t = 0.5, and so
+            // has any affine image of it
+            double scale = uniform(1., 50.), angle = uniform(0., 6.283185307179586);
+            double shear = uniform(-.5, .5);
+            double unit[8] = {0., 0., 1., 1., 0., 1., 1., 0.};
+            for (size_t k = 0; k < 8; k += 2) {
+                double u = unit[k] + shear * unit[k + 1], v = unit[k + 1];
+                c.p[k] = (BEZ_DTYPE)(x0 + scale * (cos(angle) * u - sin(angle) * v));
+                c.p[k + 1] = (BEZ_DTYPE)(y0 + scale * (sin(angle) * u + cos(angle) * v));
+            }
+        }
+        else {
+            double s1 = uniform(0., 1.), s2 = uniform(s1, 1.);
+            double p[8] = {x0, y0, x0 + s1 * (x3 - x0), y0 + s1 * (y3 - y0),
+                           x0 + s2 * (x3 - x0), y0 + s2 * (y3 - y0), x3, y3};
+            std::copy(p, p + 8, c.p);
+        }
+    }
+    return corpus;
+}
+
+/*
+ * function: percentile
+ *
+ * Returns quantile q of sorted values.
+ */
+double percentile(const std::vector<double>& sorted, double q) {
+    return benchQuantile(sorted.data(), sorted.size(), q);
+}
+
+
+int main(int argc, char* argv[]) {
+    benchHarness harness;
+    size_t curve_count = DEFAULT_CURVE_COUNT;
+    size_t i, k, s;
+    char name[96];
+
+    benchInit(&harness, LOG_FILE_NAME, &argc, argv);
+    if (argc > 1) {
+        curve_count = strtoul(argv[1], NULL, 10);
+    }
+
+    const char* kinds[] = {"random", "near_degenerate", "cusped", "straight"};
+    const Setting settings[] = {
+        {"bez2ArcLength", 1.1}, {"bez2ArcLength", 1.05}, {"bez2ArcLength", 1.02},
+        {"bez2ArcLength", 1.01}, {"bez2ArcLength", 1.005}, {"bez2ArcLength", 1.002},
+        {"bez2ArcLength", 1.001}, {"bez2ArcLength", 1.0005}, {"bez2ArcLength", 1.0002},
+        {"bez2ArcLength", 1.0001},
+        {"sampled", 4}, {"sampled", 8}, {"sampled", 16}, {"sampled", 32},
+        {"sampled", 64}, {"sampled", 128}, {"sampled", 256},
+    };
+    const size_t setting_count = sizeof(settings) / sizeof(settings[0]);
+
+    printAndLog(harness.log_file, harness.log, "Beginning arc length accuracy and cost sweep\n");
+    printAndLog(harness.log_file, harness.log, "curves per kind: %zu\n", curve_count);
+
+    srand(7);
+    for (const char* kind : kinds) {
+        std::vector<Cubic> corpus = makeCorpus(kind, curve_count);
+        std::vector<double> reference(curve_count);
+        std::vector<Row> rows;
+
+        for (i = 0; i < curve_count; i++) {
+            reference[i] = referenceLength(corpus[i]);
+        }
+
+        printAndLog(harness.log_file, harness.log, "\n\n%s curves:\n", kind);
+
+        for (s = 0; s < setting_count; s++) {
+            const Setting& setting = settings[s];
+            Row row = {&setting, NAN, 0., 0., 0., 0.};
+            std::vector<double> errors(curve_count);
+            size_t result_count = harness.result_count;
+
+            snprintf(name, sizeof(name), "%s/%s/%g", kind, setting.engine, setting.parameter);
+            benchmarkThisCode(harness, name, (double)(curve_count),
+                for (k = 0; k < curve_count; k++) {
+                    BEZ_DTYPE length = measure(setting, corpus[k]);
+                    benchDoNotOptimize(length);
+                }
+            )
+            if (harness.result_count == result_count) {
+                continue;
+            }
+            row.ns = harness.stats.median;
+
+            for (k = 0; k < curve_count; k++) {
+                errors[k] = fabs((double)(measure(setting, corpus[k])) - reference[k]) / reference[k];
+            }
+            std::sort(errors.begin(), errors.end());
+            row.p50 = percentile(errors, .5);
+            row.p90 = percentile(errors, .9);
+            row.p99 = percentile(errors, .99);
+            row.max = errors.back();
+            rows.push_back(row);
+        }
+
+        //*********************************************************************
+        printAndLog(harness.log_file, harness.log, "\nPareto table for %s curves, relative error:\n", kind);
+        //*********************************************************************
+        std::sort(rows.begin(), rows.end(), [](const Row& a, const Row& b) { return a.ns < b.ns; });
+        printAndLog(harness.log_file, harness.log, "%-15s %10s %10s %11s %11s %11s %11s  %s\n",
+            "engine", "parameter", "ns/call", "p50", "p90", "p99", "max", "pareto");
+        double best_p99 = INFINITY;
+        for (const Row& row : rows) {
+            bool pareto = row.p99 < best_p99;
+
+            if (pareto) {
+                best_p99 = row.p99;
+            }
+            printAndLog(harness.log_file, harness.log, "%-15s %10g %10.2f %11.3e %11.3e %11.3e %11.3e  %s\n",
+                row.setting->engine, row.setting->parameter, row.ns,
+                row.p50, row.p90, row.p99, row.max, pareto ? "*" : "");
+        }
+    }
+
+    printAndLog(harness.log_file, harness.log, "\n\nThis concludes the arc length accuracy and cost sweep\n");
+
+    benchFinish(&harness);
+
+    return 0;
+}
@@ -0,0 +1,265 @@
+/*
+ * bench_compare.cpp
+ *
+ * Compares two result files written by the --json option of the benchmark
+ * harness, such as a baseline from the last release and a run of the
+ * current tree, and prints the change of every benchmark they share.
+ *
+ * A benchmark has regressed when its median grew by more than the threshold
+ * and a two-sided Mann-Whitney U test over the repetitions of both runs
+ * finds the difference significant at the given level. The test makes no
+ * assumption about the distribution of the samples, which is rarely normal
+ * for timings. Benchmarks found in only one of the files are listed without
+ * being compared.
+ *
+ * Usage: benchmark-compare [--threshold=PERCENT] [--alpha=LEVEL] BASELINE CANDIDATE
+ *
+ *   --threshold=PERCENT  least growth of the median that counts, default 5
+ *   --alpha=LEVEL        significance level of the test, default 0.01
+ *
+ * Exits with 0 if no benchmark regressed, 1 if any did, and 2 if a file
+ * could not be read.
+ */
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <time.h>
+#include <math.h>
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "benchmark.h"
+
+
+// defaults of the comparison, each overridable from the command line
+#define DEFAULT_THRESHOLD 5.
+#define DEFAULT_ALPHA 0.01
+
+// name of file to log the comparison to
+#define LOG_FILE_NAME "bench_compare.log"
+
+
+/*
+ * function: readResults
+ *
+ * Reads the samples of every benchmark in a JSON file written by the
+ * harness, keyed by name. Returns whether the file could be read.
+ *
+ * NOTE: this only understands the layout written by benchStop, not JSON in
+ * general.
+ */
+bool readResults(const char* file_name, std::map<std::string, std::vector<double> >& results) {
+    FILE* file = fopen(file_name, "rb");
+    std::string text;
+    char chunk[65536];
+    size_t n;
+
+    if (file == NULL) {
+        fprintf(stderr, "Error: unable to open %s.\n", file_name);
+        return false;
+    }
+    while ((n = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        text.append(chunk, n);
+    }
+    fclose(file);
+
+    const char* name_key = "\"name\": \"";
+    const char* samples_key = "\"samples_ns\": [";
+    size_t position = 0;
+
+    while ((position = text.find(name_key, position)) != std::string::npos) {
+        size_t name_begin = position + strlen(name_key);
+        size_t name_end = text.find('"', name_begin);
+        size_t samples = text.find(samples_key, name_begin);
+
+        if (name_end == std::string::npos || samples == std::string::npos) {
+            fprintf(stderr, "Error: %s is not a benchmark result file.\n", file_name);
+            return false;
+        }
+
+        std::vector<double>& values = results[text.substr(name_begin, name_end - name_begin)];
+        const char* cursor = text.c_str() + samples + strlen(samples_key);
+        char* number_end;
+
+        values.clear();
+        while (*cursor != ']' && *cursor != '\0') {
+            double value = strtod(cursor, &number_end);
+
+            if (number_end == cursor) {
+                fprintf(stderr, "Error: malformed samples in %s.\n", file_name);
+                return false;
+            }
+            values.push_back(value);
+            cursor = number_end;
+            while (*cursor == ',' || *cursor == ' ') {
+                cursor++;
+            }
+        }
+        position = cursor - text.c_str();
+    }
+
+    if (results.empty()) {
+        fprintf(stderr, "Error: no benchmark results in %s.\n", file_name);
+        return false;
+    }
+    return true;
+}
+
+/*
+ * function: median
+ *
+ * Returns the median of the given values.
+ */
+double median(std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+    return benchQuantile(values.data(), values.size(), .5);
+}
+
+/*
+ * function: mannWhitney
+ *
+ * Returns the two-sided p-value of the Mann-Whitney U test of whether two
+ * samples come from the same distribution. Tied values get their average
+ * rank, and the variance is corrected for them. The p-value comes from the
+ * normal approximation of U, which is close from about 8 values per sample.
+ */
+double mannWhitney(const std::vector<double>& a, const std::vector<double>& b) {
+    std::vector<std::pair<double, int> > all;
+    double n_a = (double)(a.size());
+    double n_b = (double)(b.size());
+    double n = n_a + n_b;
+    double rank_sum = 0.;
+    double ties = 0.;
+    size_t i, j, k;
+
+    if (a.empty() || b.empty()) {
+        return 1.;
+    }
+
+    for (double value : a) {
+        all.push_back(std::make_pair(value, 0));
+    }
+    for (double value : b) {
+        all.push_back(std::make_pair(value, 1));
+    }
+    std::sort(all.begin(), all.end());
+
+    for (i = 0; i < all.size(); i = j) {
+        double t;
+
+        j = i + 1;
+        while (j < all.size() && all[j].first == all[i].first) {
+            j++;
+        }
+        t = (double)(j - i);
+        ties += t * t * t - t;
+        for (k = i; k < j; k++) {
+            if (all[k].second == 0) {
+                rank_sum += (double)(i + j + 1) * .5;
+            }
+        }
+    }
+
+    double u = rank_sum - n_a * (n_a + 1.) * .5;
+    double mean = n_a * n_b * .5;
+    double variance = n_a * n_b / 12. * ((n + 1.) - ties / (n * (n - 1.)));
+
+    if (variance <= 0.) {
+        return u == mean ? 1. : 0.;
+    }
+    return erfc(fabs(u - mean) / sqrt(2. * variance));
+}
+
+
+int main(int argc, char* argv[]) {
+    double threshold = DEFAULT_THRESHOLD;
+    double alpha = DEFAULT_ALPHA;
+    const char* files[2] = {NULL, NULL};
+    const char* value;
+    int i, file_count = 0;
+    FILE* log_file;
+    BOOL log = TRUE;
+
+    for (i = 1; i < argc; i++) {
+        if (benchParseArg(argv[i], "--threshold", &value)) {
+            threshold = strtod(value, NULL);
+        }
+        else if (benchParseArg(argv[i], "--alpha", &value)) {
+            alpha = strtod(value, NULL);
+        }
+        else if (file_count < 2) {
+            files[file_count++] = argv[i];
+        }
+    }
+    if (file_count != 2) {
+        fprintf(stderr, "Usage: %s [--threshold=PERCENT] [--alpha=LEVEL] BASELINE CANDIDATE\n", argv[0]);
+        return 2;
+    }
+
+    std::map<std::string, std::vector<double> > baseline, candidate;
+    if (!readResults(files[0], baseline) || !readResults(files[1], candidate)) {
+        return 2;
+    }
+
+    log_file = fopen(LOG_FILE_NAME, "w+");
+    if (log_file == NULL) {
+        fprintf(stderr, "Error: unable to open log file.\n");
+        log = FALSE;
+    }
+
+    printAndLog(log_file, log, "baseline:  %s\ncandidate: %s\n", files[0], files[1]);
+    printAndLog(log_file, log, "threshold: %g%%, significance level: %g\n\n", threshold, alpha);
+    printAndLog(log_file, log, "%-44s %12s %12s %9s %9s  %s\n",
+        "benchmark", "base ns", "new ns", "change", "p-value", "verdict");
+
+    size_t regressions = 0, improvements = 0, unchanged = 0;
+    for (const auto& entry : baseline) {
+        auto match = candidate.find(entry.first);
+
+        if (match == candidate.end()) {
+            printAndLog(log_file, log, "%-44s %12.3f %12s %9s %9s  only in baseline\n",
+                entry.first.c_str(), median(entry.second), "-", "-", "-");
+            continue;
+        }
+
+        double before = median(entry.second);
+        double after = median(match->second);
+        double change = before > 0. ? (after / before - 1.) * 100. : 0.;
+        double p = mannWhitney(entry.second, match->second);
+        const char* verdict = "";
+
+        if (p < alpha && change > threshold) {
+            verdict = "REGRESSION";
+            regressions++;
+        }
+        else if (p < alpha && change < -threshold) {
+            verdict = "improvement";
+            improvements++;
+        }
+        else {
+            unchanged++;
+        }
+        printAndLog(log_file, log, "%-44s %12.3f %12.3f %+8.2f%% %9.2g  %s\n",
+            entry.first.c_str(), before, after, change, p, verdict);
+    }
+    for (const auto& entry : candidate) {
+        if (baseline.find(entry.first) == baseline.end()) {
+            printAndLog(log_file, log, "%-44s %12s %12.3f %9s %9s  only in candidate\n",
+                entry.first.c_str(), "-", median(entry.second), "-", "-");
+        }
+    }
+
+    printAndLog(log_file, log, "\n%zu regressions, %zu improvements, %zu unchanged\n",
+        regressions, improvements, unchanged);
+
+    if (log) {
+        fclose(log_file);
+    }
+
+    return regressions > 0 ? 1 : 0;
+}
@@ -1,8 +1,14 @@
 /*
  * bezier_benchmark.c
- * 
+ *
  * Performs benchmarks on the functions defined in bezier.h and prints them to
  * the screen while logging them to a file.
+ *
+ * Each function is timed in two regimes. The chained variant feeds an output
+ * of every call into the next one, so it measures latency. The L1, L2 and
+ * DRAM variants call it on independent random inputs read from arrays of
+ * those sizes, so they measure throughput with the inputs in each level of
+ * the memory hierarchy.
  */
 
 
@@ -16,128 +22,164 @@
 #include "benchmark.h"
 
 
-// constants used to determine how long to time an operation
-#define MIN_DURATION 1.
-#define MAX_DURATION 2.
-
 // name of file to log the benchmarks to
 #define LOG_FILE_NAME "bezier_benchmark.log"
 
+// values per random input record: 12 coordinates, then t
+#define RECORD_SIZE 13
+
+
+static const char* VARIANT_NAMES[3] = {"L1", "L2", "DRAM"};
+static const size_t VARIANT_BYTES[3] = {BENCH_L1_BYTES, BENCH_L2_BYTES, BENCH_DRAM_BYTES};
+
+
+/*
+ * function-like macro: benchmarkVariants
+ *
+ * Times the given code once per input array size, running it for every
+ * record r of the array.
+ *
+ * Args:
+ *   harness: benchHarness set up by benchInit
+ *   function: name of the function being timed (const char*)
+ *   pool: random input records (const BEZ_DTYPE*)
+ *   ...: code reading its inputs from r
+ */
+#define benchmarkVariants(harness, function, pool, ...) {\
+    size_t variant, record, record_count;\
+    char variant_name[64];\
+    for (variant = 0; variant < 3; variant++) {\
+        record_count = VARIANT_BYTES[variant] / (RECORD_SIZE * sizeof(BEZ_DTYPE));\
+        snprintf(variant_name, sizeof(variant_name), "%s/%s", function, VARIANT_NAMES[variant]);\
+        benchmarkThisCode(harness, variant_name, (double)(record_count),\
+            for (record = 0; record < record_count; record++) {\
+                const BEZ_DTYPE* r = (pool) + RECORD_SIZE * record;\
+                __VA_ARGS__\
+            }\
+        )\
+    }\
+}
+
 
 int main(int argc, char* argv[]) {
-    FILE* log_file;
-    BOOL log = TRUE;
-    double duration;
-    int num_executions;
+    benchHarness harness;
+    BEZ_DTYPE* pool;
+    size_t i;
     BEZ_DTYPE x, y, z,
-        x0, y0, z0,
-        x1, y1, z1,
-        x2, y2, z2,
-        x3, y3, z3,
-        a, b, c,
         a0, b0, c0,
         a1, b1, c1,
         a2, b2, c2,
         a3, b3, c3,
-        d, e, f,
         d0, e0, f0,
         d1, e1, f1,
         d2, e2, f2,
         d3, e3, f3,
-        t, t2, t3;
+        t;
+
+    benchInit(&harness, LOG_FILE_NAME, &argc, argv);
 
-    log_file = fopen(LOG_FILE_NAME, "w+");
-    if (log_file == NULL) {
-        fprintf(stderr, "Error: unable to open log file.\n");
-        log = FALSE;
+    // random control points in [-10, 10] and t in [0, 1]
+    pool = (BEZ_DTYPE*)(malloc(BENCH_DRAM_BYTES));
+    if (pool == NULL) {
+        fprintf(stderr, "Error: unable to allocate benchmark inputs.\n");
+        return 1;
+    }
+    srand(7);
+    for (i = 0; i < BENCH_DRAM_BYTES / sizeof(BEZ_DTYPE); i++) {
+        pool[i] = (BEZ_DTYPE)(rand()) / (BEZ_DTYPE)(RAND_MAX);
+        if (i % RECORD_SIZE != RECORD_SIZE - 1) {
+            pool[i] = pool[i] * 20. - 10.;
+        }
     }
 
-    printAndLog(log_file, log, "Beginning benchmarks for bezier.h\n");
+    // the chained variants start from t, hidden from the compiler
+    t = 0.48;
+    benchDoNotOptimize(t);
 
+    printAndLog(harness.log_file, harness.log, "Beginning benchmarks for bezier.h\n");
 
-    //*************************************************************************
-    printAndLog(log_file, log, "\nTiming function bez2Evaluate:\n");
-    //*************************************************************************
 
-    timeThisCode(MIN_DURATION, MAX_DURATION, duration, num_executions,
-        bez2Evaluate(8., -8.5,
+    //*************************************************************************
+    x = 8.;
+    benchmarkThisCode(harness, "bez2Evaluate/chained", 1,
+        bez2Evaluate(x, -8.5,
                      2.5, 3.17,
                      -3.92, -8.5,
                      -5.33, -0.17,
-                     0.48,
+                     t,
                      &x, &y);
-    );
-
-    printAndLog(log_file, log, "million operations per second: %f\n",
-        (double)(num_executions) / duration * 1e-6);
-    printAndLog(log_file, log, "microseconds per operation:    %f\n",
-        duration * 1e6 / (double)(num_executions));
+        benchDoNotOptimize(y);
+    )
+    benchmarkVariants(harness, "bez2Evaluate", pool,
+        bez2Evaluate(r[0], r[1], r[2], r[3], r[4], r[5], r[6], r[7], r[12], &x, &y);
+        benchDoNotOptimize(x);
+        benchDoNotOptimize(y);
+    )
 
 
     //*************************************************************************
-    printAndLog(log_file, log, "\nTiming function bez2EvaluateQuadratic:\n");
-    //*************************************************************************
-
-    timeThisCode(MIN_DURATION, MAX_DURATION, duration, num_executions,
-        bez2EvaluateQuadratic(8., -8.5,
+    x = 8.;
+    benchmarkThisCode(harness, "bez2EvaluateQuadratic/chained", 1,
+        bez2EvaluateQuadratic(x, -8.5,
                               2.5, 3.17,
                               -3.92, -8.5,
-                              0.48,
+                              t,
                               &x, &y);
-    );
-
-    printAndLog(log_file, log, "million operations per second: %f\n",
-        (double)(num_executions) / duration * 1e-6);
-    printAndLog(log_file, log, "microseconds per operation:    %f\n",
-        duration * 1e6 / (double)(num_executions));
+        benchDoNotOptimize(y);
+    )
+    benchmarkVariants(harness, "bez2EvaluateQuadratic", pool,
+        bez2EvaluateQuadratic(r[0], r[1], r[2], r[3], r[4], r[5], r[12], &x, &y);
+        benchDoNotOptimize(x);
+        benchDoNotOptimize(y);
+    )
 
 
     //*************************************************************************
-    printAndLog(log_file, log, "\nTiming function bez2EvaluateLinear:\n");
-    //*************************************************************************
-
-    timeThisCode(MIN_DURATION, MAX_DURATION, duration, num_executions,
-        bez2EvaluateLinear(8., -8.5,
+    x = 8.;
+    benchmarkThisCode(harness, "bez2EvaluateLinear/chained", 1,
+        bez2EvaluateLinear(x, -8.5,
                            2.5, 3.17,
-                           0.48,
+                           t,
                            &x, &y);
-    );
+        benchDoNotOptimize(y);
+    )
+    benchmarkVariants(harness, "bez2EvaluateLinear", pool,
+        bez2EvaluateLinear(r[0], r[1], r[2], r[3], r[12], &x, &y);
+        benchDoNotOptimize(x);
+        benchDoNotOptimize(y);
+    )
 
-    printAndLog(log_file, log, "million operations per second: %f\n",
-        (double)(num_executions) / duration * 1e-6);
-    printAndLog(log_file, log, "microseconds per operation:    %f\n",
-        duration * 1e6 / (double)(num_executions));
 
-
-    //*************************************************************************
-    printAndLog(log_file, log, "\nTiming function bez3Evaluate:\n");
     //*************************************************************************
-
-    timeThisCode(MIN_DURATION, MAX_DURATION, duration, num_executions,
-        bez3Evaluate(-0.085, -3.165, -5.487,
+    x = -0.085;
+    benchmarkThisCode(harness, "bez3Evaluate/chained", 1,
+        bez3Evaluate(x, -3.165, -5.487,
                      -2.688, 0.121, -9.054,
                      3.462, -4.075, 2.702,
                      1.990, -3.235, -9.770,
-                     0.770,
+                     t,
                      &x, &y, &z);
-    );
+        benchDoNotOptimize(y);
+        benchDoNotOptimize(z);
+    )
+    benchmarkVariants(harness, "bez3Evaluate", pool,
+        bez3Evaluate(r[0], r[1], r[2], r[3], r[4], r[5], r[6], r[7], r[8], r[9], r[10], r[11],
+                     r[12], &x, &y, &z);
+        benchDoNotOptimize(x);
+        benchDoNotOptimize(y);
+        benchDoNotOptimize(z);
+    )
 
-    printAndLog(log_file, log, "million operations per second: %f\n",
-        (double)(num_executions) / duration * 1e-6);
-    printAndLog(log_file, log, "microseconds per operation:    %f\n",
-        duration * 1e6 / (double)(num_executions));
 
-
-    //*************************************************************************
-    printAndLog(log_file, log, "\nTiming function bez2SplitCurve:\n");
     //*************************************************************************
-
-    timeThisCode(MIN_DURATION, MAX_DURATION, duration, num_executions,
-        bez2SplitCurve(8., -8.5,
+    // the point at t, the end of the first half, is fed back
+    a3 = 8.;
+    benchmarkThisCode(harness, "bez2SplitCurve/chained", 1,
+        bez2SplitCurve(a3, -8.5,
                        2.5, 3.17,
                        -3.92, -8.5,
                        -5.33, -0.17,
-                       0.48,
+                       t,
                        &a0, &b0,
                        &a1, &b1,
                        &a2, &b2,
@@ -146,24 +188,33 @@ int main(int argc, char* argv[]) {
                        &d1, &e1,
                        &d2, &e2,
                        &d3, &e3);
-    );
-
-    printAndLog(log_file, log, "million operations per second: %f\n",
-        (double)(num_executions) / duration * 1e-6);
-    printAndLog(log_file, log, "microseconds per operation:    %f\n",
-        duration * 1e6 / (double)(num_executions));
+        benchClobberMemory();
+    )
+    benchmarkVariants(harness, "bez2SplitCurve", pool,
+        bez2SplitCurve(r[0], r[1], r[2], r[3], r[4], r[5], r[6], r[7], r[12],
+                       &a0, &b0, &a1, &b1, &a2, &b2, &a3, &b3,
+                       &d0, &e0, &d1, &e1, &d2, &e2, &d3, &e3);
+        benchDoNotOptimize(a1);
+        benchDoNotOptimize(b1);
+        benchDoNotOptimize(a2);
+        benchDoNotOptimize(b2);
+        benchDoNotOptimize(a3);
+        benchDoNotOptimize(b3);
+        benchDoNotOptimize(d1);
+        benchDoNotOptimize(e1);
+        benchDoNotOptimize(d2);
+        benchDoNotOptimize(e2);
+    )
 
 
     //*************************************************************************
-    printAndLog(log_file, log, "\nTiming function bez3SplitCurve:\n");
-    //*************************************************************************
-
-    timeThisCode(MIN_DURATION, MAX_DURATION, duration, num_executions,
-        bez3SplitCurve(-0.085, -3.165, -5.487,
+    a3 = -0.085;
+    benchmarkThisCode(harness, "bez3SplitCurve/chained", 1,
+        bez3SplitCurve(a3, -3.165, -5.487,
                        -2.688, 0.121, -9.054,
                        3.462, -4.075, 2.702,
                        1.990, -3.235, -9.770,
-                       0.770,
+                       t,
                        &a0, &b0, &c0,
                        &a1, &b1, &c1,
                        &a2, &b2, &c2,
@@ -172,71 +223,95 @@ int main(int argc, char* argv[]) {
                        &d1, &e1, &f1,
                        &d2, &e2, &f2,
                        &d3, &e3, &f3);
-    );
-
-    printAndLog(log_file, log, "million operations per second: %f\n",
-        (double)(num_executions) / duration * 1e-6);
-    printAndLog(log_file, log, "microseconds per operation:    %f\n",
-        duration * 1e6 / (double)(num_executions));
+        benchClobberMemory();
+    )
+    benchmarkVariants(harness, "bez3SplitCurve", pool,
+        bez3SplitCurve(r[0], r[1], r[2], r[3], r[4], r[5], r[6], r[7], r[8], r[9], r[10], r[11],
+                       r[12],
+                       &a0, &b0, &c0, &a1, &b1, &c1, &a2, &b2, &c2, &a3, &b3, &c3,
+                       &d0, &e0, &f0, &d1, &e1, &f1, &d2, &e2, &f2, &d3, &e3, &f3);
+        benchDoNotOptimize(a1);
+        benchDoNotOptimize(b1);
+        benchDoNotOptimize(c1);
+        benchDoNotOptimize(a2);
+        benchDoNotOptimize(b2);
+        benchDoNotOptimize(c2);
+        benchDoNotOptimize(a3);
+        benchDoNotOptimize(b3);
+        benchDoNotOptimize(c3);
+        benchDoNotOptimize(d1);
+        benchDoNotOptimize(e1);
+        benchDoNotOptimize(f1);
+        benchDoNotOptimize(d2);
+        benchDoNotOptimize(e2);
+        benchDoNotOptimize(f2);
+    )
 
 
     //*************************************************************************
-    printAndLog(log_file, log, "\nTiming function bez2Derivative:\n");
-    //*************************************************************************
-
-    timeThisCode(MIN_DURATION, MAX_DURATION, duration, num_executions,
-        bez2Derivative(8., -8.5,
+    // the derivative is scaled by 1/4 before being fed back so the chain
+    // stays bounded
+    a0 = 8.;
+    benchmarkThisCode(harness, "bez2Derivative/chained", 1,
+        bez2Derivative(a0 * 0.25, -8.5,
                        2.5, 3.17,
                        -3.92, -8.5,
                        -5.33, -0.17,
                        &a0, &b0,
                        &a1, &b1,
                        &a2, &b2);
-    );
-
-    printAndLog(log_file, log, "million operations per second: %f\n",
-        (double)(num_executions) / duration * 1e-6);
-    printAndLog(log_file, log, "microseconds per operation:    %f\n",
-        duration * 1e6 / (double)(num_executions));
+        benchClobberMemory();
+    )
+    benchmarkVariants(harness, "bez2Derivative", pool,
+        bez2Derivative(r[0], r[1], r[2], r[3], r[4], r[5], r[6], r[7],
+                       &a0, &b0, &a1, &b1, &a2, &b2);
+        benchDoNotOptimize(a0);
+        benchDoNotOptimize(b0);
+        benchDoNotOptimize(a1);
+        benchDoNotOptimize(b1);
+        benchDoNotOptimize(a2);
+        benchDoNotOptimize(b2);
+    )
 
 
     //*************************************************************************
-    printAndLog(log_file, log, "\nTiming function bez2DerivativeQuadratic:\n");
-    //*************************************************************************
-
-    timeThisCode(MIN_DURATION, MAX_DURATION, duration, num_executions,
-        bez2DerivativeQuadratic(8., -8.5,
+    a0 = 8.;
+    benchmarkThisCode(harness, "bez2DerivativeQuadratic/chained", 1,
+        bez2DerivativeQuadratic(a0 * 0.25, -8.5,
                                 2.5, 3.17,
                                 -3.92, -8.5,
                                 &a0, &b0,
                                 &a1, &b1);
-    );
+        benchClobberMemory();
+    )
+    benchmarkVariants(harness, "bez2DerivativeQuadratic", pool,
+        bez2DerivativeQuadratic(r[0], r[1], r[2], r[3], r[4], r[5], &a0, &b0, &a1, &b1);
+        benchDoNotOptimize(a0);
+        benchDoNotOptimize(b0);
+        benchDoNotOptimize(a1);
+        benchDoNotOptimize(b1);
+    )
 
-    printAndLog(log_file, log, "million operations per second: %f\n",
-        (double)(num_executions) / duration * 1e-6);
-    printAndLog(log_file, log, "microseconds per operation:    %f\n",
-        duration * 1e6 / (double)(num_executions));
 
-
-    //*************************************************************************
-    printAndLog(log_file, log, "\nTiming function bez2DerivativeLinear:\n");
     //*************************************************************************
-
-    timeThisCode(MIN_DURATION, MAX_DURATION, duration, num_executions,
-        bez2DerivativeLinear(8., -8.5,
+    a0 = 8.;
+    benchmarkThisCode(harness, "bez2DerivativeLinear/chained", 1,
+        bez2DerivativeLinear(a0 * 0.25, -8.5,
                              2.5, 3.17,
                              &a0, &b0);
-    );
-
-    printAndLog(log_file, log, "million operations per second: %f\n",
-        (double)(num_executions) / duration * 1e-6);
-    printAndLog(log_file, log, "microseconds per operation:    %f\n",
-        duration * 1e6 / (double)(num_executions));
+        benchDoNotOptimize(b0);
+    )
+    benchmarkVariants(harness, "bez2DerivativeLinear", pool,
+        bez2DerivativeLinear(r[0], r[1], r[2], r[3], &a0, &b0);
+        benchDoNotOptimize(a0);
+        benchDoNotOptimize(b0);
+    )
 
 
-    printAndLog(log_file, log, "\n\nThis concludes the benchmarks for bezier.h\n");
+    printAndLog(harness.log_file, harness.log, "\n\nThis concludes the benchmarks for bezier.h\n");
 
-    fclose(log_file);
+    free(pool);
+    benchFinish(&harness);
 
     return 0;
 }
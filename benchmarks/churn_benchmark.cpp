@@ -0,0 +1,117 @@
+/*
+ * churn_benchmark.cpp
+ *
+ * Measures a frame of many short-lived Curve2D objects, each constructed,
+ * sampled once and destroyed, with the default allocator and with a
+ * FrameArena reset once per frame, and prints the results to the screen while
+ * logging them to a file.
+ *
+ * Usage: benchmark-curve_churn [splines_per_frame] [harness options, see benchInit]
+ */
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <time.h>
+#include <math.h>
+
+#include <vector>
+
+#include "curve.h"
+#include "frame_arena.h"
+#include "benchmark.h"
+
+
+// default number of splines created and destroyed per frame
+#define DEFAULT_SPLINES_PER_FRAME 1000
+
+// name of file to log the benchmarks to
+#define LOG_FILE_NAME "churn_benchmark.log"
+
+
+/*
+ * function: runFrame
+ *
+ * Constructs, samples and destroys one spline per anchor set, allocating from
+ * the given resource, and returns the sum of the samples.
+ */
+BEZ_DTYPE runFrame(const std::vector<std::vector<bezVect2D> >& anchor_sets,
+                   std::pmr::memory_resource* resource) {
+    BEZ_DTYPE sum = 0.;
+    size_t i;
+
+    for (i = 0; i < anchor_sets.size(); i++) {
+        Curve2D curve(anchor_sets[i], false, BEZ_UNIFORM, resource);
+        sum += curve.getPositionAt(.5)[0];
+    }
+
+    return sum;
+}
+
+
+int main(int argc, char* argv[]) {
+    benchHarness harness;
+    double arena_ns;
+    double default_ns;
+    size_t splines_per_frame = DEFAULT_SPLINES_PER_FRAME;
+    size_t anchor_counts[] = { 4, 16, 64, 256 };
+    size_t a, i, j, count;
+    char name[64];
+    volatile BEZ_DTYPE sink = 0.;
+
+    benchInit(&harness, LOG_FILE_NAME, &argc, argv);
+    if (argc > 1) {
+        splines_per_frame = strtoul(argv[1], NULL, 10);
+    }
+
+    srand(7);
+
+    printAndLog(harness.log_file, harness.log, "Beginning allocation churn benchmarks for Curve2D\n");
+    printAndLog(harness.log_file, harness.log, "splines per frame: %zu\n", splines_per_frame);
+    printAndLog(harness.log_file, harness.log, "operations are splines\n");
+
+    for (a = 0; a < sizeof(anchor_counts) / sizeof(anchor_counts[0]); a++) {
+        std::vector<std::vector<bezVect2D> > anchor_sets(splines_per_frame,
+            std::vector<bezVect2D>(anchor_counts[a]));
+
+        for (i = 0; i < splines_per_frame; i++) {
+            for (j = 0; j < anchor_counts[a]; j++) {
+                anchor_sets[i][j][0] = (BEZ_DTYPE)(rand()) / (BEZ_DTYPE)(RAND_MAX) * 100.;
+                anchor_sets[i][j][1] = (BEZ_DTYPE)(rand()) / (BEZ_DTYPE)(RAND_MAX) * 100.;
+            }
+        }
+
+        //*********************************************************************
+        printAndLog(harness.log_file, harness.log, "\n\n%zu anchor points per spline:\n", anchor_counts[a]);
+        //*********************************************************************
+        count = harness.result_count;
+        snprintf(name, sizeof(name), "default/%zu", anchor_counts[a]);
+        benchmarkThisCode(harness, name, (double)(splines_per_frame),
+            sink = sink + runFrame(anchor_sets, std::pmr::get_default_resource());
+        )
+        default_ns = benchLastMedian(&harness, count);
+
+        FrameArena arena;
+        count = harness.result_count;
+        snprintf(name, sizeof(name), "FrameArena/%zu", anchor_counts[a]);
+        benchmarkThisCode(harness, name, (double)(splines_per_frame),
+            sink = sink + runFrame(anchor_sets, &arena);
+            arena.reset();
+        )
+        arena_ns = benchLastMedian(&harness, count);
+
+        if (!isnan(arena_ns)) {
+            printAndLog(harness.log_file, harness.log, "FrameArena bytes per frame:       %zu\n",
+                arena.capacity());
+            printAndLog(harness.log_file, harness.log, "speedup over default allocator:   %f\n",
+                default_ns / arena_ns);
+        }
+    }
+
+    printAndLog(harness.log_file, harness.log, "\n\nThis concludes the allocation churn benchmarks for Curve2D\n");
+
+    benchFinish(&harness);
+
+    return 0;
+}
@@ -0,0 +1,199 @@
+/*
+ * curve_benchmark.cpp
+ *
+ * Measures how the cost of Curve2D construction, solving, evaluation and
+ * single anchor edits scales with the number of anchor points, from 4 up to
+ * 10^7, and prints the results to the screen while logging them to a file.
+ * Costs are reported per anchor point where the work is proportional to the
+ * spline, so a flat column means linear scaling and a growing one shows the
+ * slope of a regression.
+ *
+ * When the library is built with BEZ_ENABLE_TRACE, it also times a trace
+ * hook of curve_trace.h with tracing stopped and started.
+ *
+ * Usage: benchmark-curve [max_anchor_count] [harness options, see benchInit]
+ */
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <time.h>
+#include <math.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "curve.h"
+#include "curve_trace.h"
+#include "benchmark.h"
+
+
+// default largest number of anchor points, the sweep multiplies by 4 from 4
+#define DEFAULT_MAX_ANCHOR_COUNT 10000000
+
+// evaluations per execution of the evaluation benchmarks
+#define QUERY_COUNT 4096
+
+// edits cycled through by the edit benchmark
+#define EDIT_COUNT 4096
+
+// name of file to log the benchmarks to
+#define LOG_FILE_NAME "curve_benchmark.log"
+
+
+/*
+ * function: curveBytes
+ *
+ * Returns the bytes of heap storage held by a spline.
+ */
+size_t curveBytes(const Curve2D& curve) {
+    return curve.points.capacity() * sizeof(bezVect2D) +
+           curve.B_points.capacity() * sizeof(bezVect2D) +
+           curve.c.capacity() * sizeof(BEZ_DTYPE) +
+           curve.z.capacity() * sizeof(BEZ_DTYPE) +
+           curve.knots.capacity() * sizeof(BEZ_DTYPE) +
+           curve.knot_buckets.capacity() * sizeof(size_t) +
+           curve.arc_lengths.capacity() * sizeof(BEZ_DTYPE);
+}
+
+
+int main(int argc, char* argv[]) {
+    benchHarness harness;
+    size_t max_anchor_count = DEFAULT_MAX_ANCHOR_COUNT;
+    size_t i, j, k;
+    char name[64];
+    volatile BEZ_DTYPE sink = 0.;
+
+    benchInit(&harness, LOG_FILE_NAME, &argc, argv);
+    if (argc > 1) {
+        max_anchor_count = strtoul(argv[1], NULL, 10);
+    }
+
+    std::vector<size_t> sizes;
+    for (i = 4; i < max_anchor_count; i *= 4) {
+        sizes.push_back(i);
+    }
+    sizes.push_back(max_anchor_count);
+
+    std::vector<bezVect2D> anchors(max_anchor_count);
+    std::vector<BEZ_DTYPE> random_ts(QUERY_COUNT), sorted_ts(QUERY_COUNT);
+    std::vector<size_t> edits(EDIT_COUNT);
+    srand(7);
+    for (i = 0; i < max_anchor_count; i++) {
+        anchors[i][0] = (BEZ_DTYPE)(rand()) / (BEZ_DTYPE)(RAND_MAX) * 100.;
+        anchors[i][1] = (BEZ_DTYPE)(rand()) / (BEZ_DTYPE)(RAND_MAX) * 100.;
+    }
+    for (i = 0; i < QUERY_COUNT; i++) {
+        random_ts[i] = sorted_ts[i] = (BEZ_DTYPE)(rand()) / (BEZ_DTYPE)(RAND_MAX);
+    }
+    std::sort(sorted_ts.begin(), sorted_ts.end());
+
+    printAndLog(harness.log_file, harness.log, "Beginning scaling benchmarks for Curve2D\n");
+
+    std::vector<std::vector<double> > table;
+    for (size_t n : sizes) {
+        std::vector<bezVect2D> subset(anchors.begin(), anchors.begin() + n);
+        std::vector<double> row(1, (double)(n));
+        size_t count;
+
+        for (i = 0; i < EDIT_COUNT; i++) {
+            edits[i] = rand() % n;
+        }
+
+        printAndLog(harness.log_file, harness.log, "\n\n%zu anchor points:\n", n);
+
+        // per anchor point
+        count = harness.result_count;
+        snprintf(name, sizeof(name), "construct/%zu", n);
+        benchmarkThisCode(harness, name, (double)(n),
+            Curve2D curve(subset);
+            sink = sink + curve.points[1][0];
+        )
+        row.push_back(benchLastMedian(&harness, count));
+
+        Curve2D curve(subset);
+
+        count = harness.result_count;
+        snprintf(name, sizeof(name), "updateControlPoints/%zu", n);
+        benchmarkThisCode(harness, name, (double)(n),
+            curve.markDirty(0, n);
+            curve.updateControlPoints();
+        )
+        row.push_back(benchLastMedian(&harness, count));
+
+        // per evaluation
+        count = harness.result_count;
+        snprintf(name, sizeof(name), "getPositionAt_random/%zu", n);
+        benchmarkThisCode(harness, name, QUERY_COUNT,
+            for (j = 0; j < QUERY_COUNT; j++) {
+                sink = sink + curve.getPositionAt(random_ts[j])[0];
+            }
+        )
+        row.push_back(benchLastMedian(&harness, count));
+
+        count = harness.result_count;
+        snprintf(name, sizeof(name), "getPositionAt_sorted/%zu", n);
+        benchmarkThisCode(harness, name, QUERY_COUNT,
+            for (j = 0; j < QUERY_COUNT; j++) {
+                sink = sink + curve.getPositionAt(sorted_ts[j])[0];
+            }
+        )
+        row.push_back(benchLastMedian(&harness, count));
+
+        // per edit: move one anchor point and read the spline next to it,
+        // which forces the local solve
+        count = harness.result_count;
+        k = 0;
+        snprintf(name, sizeof(name), "edit/%zu", n);
+        benchmarkThisCode(harness, name, 1,
+            size_t e = edits[k++ % EDIT_COUNT];
+            curve.setAnchor(subset[edits[k % EDIT_COUNT]], e);
+            sink = sink + curve.getPositionAt((BEZ_DTYPE)(e) / (BEZ_DTYPE)(n))[0];
+        )
+        row.push_back(benchLastMedian(&harness, count));
+
+        row.push_back((double)(curveBytes(curve)) / (double)(n));
+        printAndLog(harness.log_file, harness.log, "\nbytes per anchor point: %f\n", row.back());
+        table.push_back(row);
+    }
+
+    //*************************************************************************
+    printAndLog(harness.log_file, harness.log, "\n\nSummary, median nanoseconds:\n");
+    //*************************************************************************
+    printAndLog(harness.log_file, harness.log, "%10s %12s %12s %12s %12s %12s %12s\n",
+        "anchors", "build/anc", "solve/anc", "eval rand", "eval sort", "edit", "bytes/anc");
+    for (const std::vector<double>& row : table) {
+        printAndLog(harness.log_file, harness.log, "%10.0f %12.3f %12.3f %12.3f %12.3f %12.3f %12.1f\n",
+            row[0], row[1], row[2], row[3], row[4], row[5], row[6]);
+    }
+
+#if defined(BEZ_ENABLE_TRACE)
+    //*************************************************************************
+    printAndLog(harness.log_file, harness.log, "\n\nTrace hook overhead:\n");
+    //*************************************************************************
+    benchmarkThisCode(harness, "trace/scope_stopped", 1,
+        BEZ_TRACE_SCOPE("benchmark", 1);
+        benchClobberMemory();
+    )
+
+    // clearing now and then keeps the buffer from filling up and dropping
+    k = 0;
+    bezTraceStart();
+    benchmarkThisCode(harness, "trace/scope_started", 1,
+        if (++k % BEZ_TRACE_BUFFER_EVENTS == 0) {
+            bezTraceClear();
+        }
+        BEZ_TRACE_SCOPE("benchmark", 1);
+        benchClobberMemory();
+    )
+    bezTraceStop();
+    bezTraceClear();
+#endif
+
+    printAndLog(harness.log_file, harness.log, "\n\nThis concludes the scaling benchmarks for Curve2D\n");
+
+    benchFinish(&harness);
+
+    return 0;
+}
@@ -0,0 +1,97 @@
+/*
+ * file_benchmark.cpp
+ *
+ * Measures loading a large spline by constructing Curve2D from its anchor
+ * points against mapping a curve file written by writeCurveFile, and prints
+ * the results to the screen while logging them to a file.
+ *
+ * Usage: benchmark-curve_file [anchor_count] [harness options, see benchInit]
+ */
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <time.h>
+#include <math.h>
+
+#include <vector>
+
+#include "curve.h"
+#include "curve_file.h"
+#include "benchmark.h"
+
+
+// default number of anchor points in the benchmarked spline
+#define DEFAULT_ANCHOR_COUNT 1000000
+
+// evaluations after each load, so the mapped pages are actually touched
+#define QUERY_COUNT 1000
+
+// name of the curve file written and mapped
+#define CURVE_FILE_NAME "file_benchmark.bin"
+
+// name of file to log the benchmarks to
+#define LOG_FILE_NAME "file_benchmark.log"
+
+
+int main(int argc, char* argv[]) {
+    benchHarness harness;
+    size_t anchor_count = DEFAULT_ANCHOR_COUNT;
+    size_t i;
+    volatile BEZ_DTYPE sink = 0.;
+
+    benchInit(&harness, LOG_FILE_NAME, &argc, argv);
+    if (argc > 1) {
+        anchor_count = strtoul(argv[1], NULL, 10);
+    }
+
+    std::vector<bezVect2D> anchors(anchor_count);
+    std::vector<BEZ_DTYPE> ts(QUERY_COUNT);
+    srand(7);
+    for (i = 0; i < anchor_count; i++) {
+        anchors[i][0] = (BEZ_DTYPE)(rand()) / (BEZ_DTYPE)(RAND_MAX) * 100.;
+        anchors[i][1] = (BEZ_DTYPE)(rand()) / (BEZ_DTYPE)(RAND_MAX) * 100.;
+    }
+    for (i = 0; i < QUERY_COUNT; i++) {
+        ts[i] = (BEZ_DTYPE)(rand()) / (BEZ_DTYPE)(RAND_MAX);
+    }
+
+    printAndLog(harness.log_file, harness.log, "Beginning load benchmarks for curve files\n");
+    printAndLog(harness.log_file, harness.log, "anchor points: %zu\n", anchor_count);
+    printAndLog(harness.log_file, harness.log, "operations are loads\n");
+
+    //*************************************************************************
+    printAndLog(harness.log_file, harness.log, "\nCurve2D from anchor points:\n");
+    //*************************************************************************
+    benchmarkThisCode(harness, "load/construct", 1,
+        Curve2D curve(anchors);
+        for (size_t q = 0; q < QUERY_COUNT; q++) {
+            sink = sink + curve.getPositionAt(ts[q])[0];
+        }
+    )
+
+    //*************************************************************************
+    printAndLog(harness.log_file, harness.log, "\n\nMappedCurve2D:\n");
+    //*************************************************************************
+    Curve2D curve(anchors);
+    writeCurveFile(curve, CURVE_FILE_NAME);
+
+    benchmarkThisCode(harness, "load/mapped", 1,
+        MappedCurve2D mapped(CURVE_FILE_NAME);
+        CurveView2D view = mapped.view();
+        for (size_t q = 0; q < QUERY_COUNT; q++) {
+            sink = sink + view.getPositionAt(ts[q])[0];
+        }
+    )
+    printAndLog(harness.log_file, harness.log, "file size in bytes:               %llu\n",
+        (unsigned long long)(MappedCurve2D(CURVE_FILE_NAME).header().file_size));
+
+    remove(CURVE_FILE_NAME);
+
+    printAndLog(harness.log_file, harness.log, "\n\nThis concludes the load benchmarks for curve files\n");
+
+    benchFinish(&harness);
+
+    return 0;
+}
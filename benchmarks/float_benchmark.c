@@ -1,8 +1,19 @@
 /*
  * float_benchmark.c
- * 
+ *
  * Performs benchmarks on floating point arithmetic and prints them to the
  * screen while logging them to a file.
+ *
+ * Each operation is timed in two regimes. The chained variant uses every
+ * result as the next operand, so it measures latency. The L1, L2 and DRAM
+ * variants apply it to independent random operands read from arrays of those
+ * sizes, so they measure throughput with the operands in each level of the
+ * memory hierarchy.
+ *
+ * Next to sqrt and division, float is timed for the reciprocal square root,
+ * fused multiply-add and the fast math functions of bezier.h, whose costs
+ * decide between the precise and fast values of BEZ_MATH_POLICY. Unless the
+ * compiler targets FMA instructions, fmaf and fma are library calls.
  */
 
 
@@ -12,250 +23,349 @@
 #include <time.h>
 #include <math.h>
 
+#include "bezier.h"
 #include "benchmark.h"
 
 
-// constants used to determine how long to time an operation
-#define MIN_DURATION 1e-2
-#define MAX_DURATION 2e-2
-
 // name of file to log the benchmarks to
 #define LOG_FILE_NAME "float_benchmark.log"
 
 
-// declare as global variables to prevent optimization
-float f = 1.;
-double d = 1.;
-long double ld = 1.;
-
-
-int main(int argc, char* argv[]) {
-    FILE* log_file;
-    BOOL log = TRUE;
-    double duration;
-    size_t num_executions;
-
-    log_file = fopen(LOG_FILE_NAME, "w+");
-    if (log_file == NULL) {
-        fprintf(stderr, "Error: unable to open log file.\n");
-        log = FALSE;
-    }
+static const char* VARIANT_NAMES[3] = {"L1", "L2", "DRAM"};
+static const size_t VARIANT_BYTES[3] = {BENCH_L1_BYTES, BENCH_L2_BYTES, BENCH_DRAM_BYTES};
 
 
-    printAndLog(log_file, log, "********************************************************************************\n");
-    printAndLog(log_file, log, "Beginning benchmarks for data type float.\n");
-    printAndLog(log_file, log, "********************************************************************************\n");
-
-    //*************************************************************************
-    printAndLog(log_file, log, "\nTiming addition:\n");
+/*
+ * function-like macro: fillOperands
+ *
+ * Fills the pool with random operands of the given type in [1, 2], which
+ * keeps every operation away from zero, infinity and subnormal numbers.
+ */
+#define fillOperands(type, pool) {\
+    size_t operand;\
+    type* operands = (type*)(pool);\
+    srand(7);\
+    for (operand = 0; operand < BENCH_DRAM_BYTES / sizeof(type); operand++) {\
+        operands[operand] = (type)(1.) + (type)(rand()) / (type)(RAND_MAX);\
+    }\
+}
 
-    timeThisCode(MIN_DURATION, MAX_DURATION, duration, num_executions,
-        f = f + f;
-    );
+/*
+ * function-like macro: benchmarkArrays
+ *
+ * Times the given code once per array size, with a and b pointing to two
+ * arrays of random operands that together take that size. The code stores
+ * its result for operand k in out.
+ *
+ * Args:
+ *   harness: benchHarness set up by benchInit
+ *   type: floating point type of the operands
+ *   name: name of the operation being timed (const char*)
+ *   pool: operands filled by fillOperands
+ *   ...: code computing out from a[k] and b[k]
+ */
+#define benchmarkArrays(harness, type, name, pool, ...) {\
+    size_t variant, k, operand_count;\
+    char variant_name[64];\
+    const type* a = (const type*)(pool);\
+    const type* b;\
+    type out;\
+    for (variant = 0; variant < 3; variant++) {\
+        operand_count = VARIANT_BYTES[variant] / (2 * sizeof(type));\
+        b = a + operand_count;\
+        (void)(b);\
+        snprintf(variant_name, sizeof(variant_name), "%s/%s", name, VARIANT_NAMES[variant]);\
+        benchmarkThisCode(harness, variant_name, (double)(operand_count),\
+            for (k = 0; k < operand_count; k++) {\
+                __VA_ARGS__\
+                benchDoNotOptimize(out);\
+            }\
+        )\
+    }\
+}
 
-    printAndLog(log_file, log, "million operations per second: %f\n",
-        (double)(num_executions) / duration * 1e-6);
-    printAndLog(log_file, log, "microseconds per operation:    %f\n",
-        duration * 1e6 / (double)(num_executions));
 
+int main(int argc, char* argv[]) {
+    benchHarness harness;
+    void* pool;
+    float f, g;
+    double d, e;
+    long double ld, le;
+
+    benchInit(&harness, LOG_FILE_NAME, &argc, argv);
+
+    pool = malloc(BENCH_DRAM_BYTES);
+    if (pool == NULL) {
+        fprintf(stderr, "Error: unable to allocate benchmark operands.\n");
+        return 1;
+    }
 
-    //*************************************************************************
-    printAndLog(log_file, log, "\nTiming subtraction:\n");
+    // the chained variants start from values hidden from the compiler, and
+    // combine with an operand of 1 so the chain neither overflows nor decays
+    f = g = 1.;
+    d = e = 1.;
+    ld = le = 1.;
+    benchDoNotOptimize(g);
+    benchDoNotOptimize(e);
+    benchDoNotOptimize(le);
 
-    timeThisCode(MIN_DURATION, MAX_DURATION, duration, num_executions,
-        f = f - f;
-    );
 
-    printAndLog(log_file, log, "million operations per second: %f\n",
-        (double)(num_executions) / duration * 1e-6);
-    printAndLog(log_file, log, "microseconds per operation:    %f\n",
-        duration * 1e6 / (double)(num_executions));
+    printAndLog(harness.log_file, harness.log, "********************************************************************************\n");
+    printAndLog(harness.log_file, harness.log, "Beginning benchmarks for data type float.\n");
+    printAndLog(harness.log_file, harness.log, "********************************************************************************\n");
 
+    fillOperands(float, pool);
 
     //*************************************************************************
-    printAndLog(log_file, log, "\nTiming multiplication:\n");
+    benchmarkThisCode(harness, "float/add/chained", 1,
+        f = f + g;
+        benchDoNotOptimize(f);
+    )
+    benchmarkArrays(harness, float, "float/add", pool,
+        out = a[k] + b[k];
+    )
 
-    timeThisCode(MIN_DURATION, MAX_DURATION, duration, num_executions,
-        f = f * f;
-    );
 
-    printAndLog(log_file, log, "million operations per second: %f\n",
-        (double)(num_executions) / duration * 1e-6);
-    printAndLog(log_file, log, "microseconds per operation:    %f\n",
-        duration * 1e6 / (double)(num_executions));
+    //*************************************************************************
+    benchmarkThisCode(harness, "float/sub/chained", 1,
+        f = f - g;
+        benchDoNotOptimize(f);
+    )
+    benchmarkArrays(harness, float, "float/sub", pool,
+        out = a[k] - b[k];
+    )
 
 
     //*************************************************************************
-    printAndLog(log_file, log, "\nTiming division:\n");
+    benchmarkThisCode(harness, "float/mul/chained", 1,
+        f = f * g;
+        benchDoNotOptimize(f);
+    )
+    benchmarkArrays(harness, float, "float/mul", pool,
+        out = a[k] * b[k];
+    )
 
-    timeThisCode(MIN_DURATION, MAX_DURATION, duration, num_executions,
-        f = f / f;
-    );
 
-    printAndLog(log_file, log, "million operations per second: %f\n",
-        (double)(num_executions) / duration * 1e-6);
-    printAndLog(log_file, log, "microseconds per operation:    %f\n",
-        duration * 1e6 / (double)(num_executions));
+    //*************************************************************************
+    benchmarkThisCode(harness, "float/div/chained", 1,
+        f = f / g;
+        benchDoNotOptimize(f);
+    )
+    benchmarkArrays(harness, float, "float/div", pool,
+        out = a[k] / b[k];
+    )
 
 
     //*************************************************************************
-    printAndLog(log_file, log, "\nTiming square root:\n");
-
-    timeThisCode(MIN_DURATION, MAX_DURATION, duration, num_executions,
+    benchmarkThisCode(harness, "float/sqrt/chained", 1,
         f = sqrtf(f);
-    );
+        benchDoNotOptimize(f);
+    )
+    benchmarkArrays(harness, float, "float/sqrt", pool,
+        out = sqrtf(a[k]);
+    )
 
-    printAndLog(log_file, log, "million operations per second: %f\n",
-        (double)(num_executions) / duration * 1e-6);
-    printAndLog(log_file, log, "microseconds per operation:    %f\n",
-        duration * 1e6 / (double)(num_executions));
 
+    //*************************************************************************
+    benchmarkThisCode(harness, "float/rsqrt/chained", 1,
+        f = 1.f / sqrtf(f);
+        benchDoNotOptimize(f);
+    )
+    benchmarkArrays(harness, float, "float/rsqrt", pool,
+        out = 1.f / sqrtf(a[k]);
+    )
 
-    printAndLog(log_file, log, "\n\n");
-    printAndLog(log_file, log, "********************************************************************************\n");
-    printAndLog(log_file, log, "Beginning benchmarks for data type double.\n");
-    printAndLog(log_file, log, "********************************************************************************\n");
 
     //*************************************************************************
-    printAndLog(log_file, log, "\nTiming addition (x = y + z):\n");
+    benchmarkThisCode(harness, "float/reciprocal/chained", 1,
+        f = 1.f / f;
+        benchDoNotOptimize(f);
+    )
+    benchmarkArrays(harness, float, "float/reciprocal", pool,
+        out = 1.f / a[k];
+    )
 
-    timeThisCode(MIN_DURATION, MAX_DURATION, duration, num_executions,
-        d = d + d;
-    );
 
-    printAndLog(log_file, log, "million operations per second: %f\n",
-        (double)(num_executions) / duration * 1e-6);
-    printAndLog(log_file, log, "microseconds per operation:    %f\n",
-        duration * 1e6 / (double)(num_executions));
+    //*************************************************************************
+    benchmarkThisCode(harness, "float/fma/chained", 1,
+        f = fmaf(f, g, g);
+        benchDoNotOptimize(f);
+    )
+    benchmarkArrays(harness, float, "float/fma", pool,
+        out = fmaf(a[k], b[k], a[k]);
+    )
 
 
     //*************************************************************************
-    printAndLog(log_file, log, "\nTiming subtraction:\n");
+    benchmarkThisCode(harness, "float/fast_rsqrt/chained", 1,
+        f = bezFastRsqrt(f);
+        benchDoNotOptimize(f);
+    )
+    benchmarkArrays(harness, float, "float/fast_rsqrt", pool,
+        out = bezFastRsqrt(a[k]);
+    )
 
-    timeThisCode(MIN_DURATION, MAX_DURATION, duration, num_executions,
-        d = d - d;
-    );
 
-    printAndLog(log_file, log, "million operations per second: %f\n",
-        (double)(num_executions) / duration * 1e-6);
-    printAndLog(log_file, log, "microseconds per operation:    %f\n",
-        duration * 1e6 / (double)(num_executions));
+    //*************************************************************************
+    benchmarkThisCode(harness, "float/fast_sqrt/chained", 1,
+        f = bezFastSqrt(f);
+        benchDoNotOptimize(f);
+    )
+    benchmarkArrays(harness, float, "float/fast_sqrt", pool,
+        out = bezFastSqrt(a[k]);
+    )
+    {
+        // four operands per call, each taken out of the lanes in turn
+        float lanes[4];
+        benchmarkArrays(harness, float, "float/fast_sqrt4", pool,
+            if ((k & 3) == 0) {
+                bezFastSqrt4(a + k, lanes);
+            }
+            out = lanes[k & 3];
+        )
+    }
 
 
     //*************************************************************************
-    printAndLog(log_file, log, "\nTiming multiplication:\n");
+    benchmarkThisCode(harness, "float/fast_reciprocal/chained", 1,
+        f = bezFastReciprocal(f);
+        benchDoNotOptimize(f);
+    )
+    benchmarkArrays(harness, float, "float/fast_reciprocal", pool,
+        out = bezFastReciprocal(a[k]);
+    )
 
-    timeThisCode(MIN_DURATION, MAX_DURATION, duration, num_executions,
-        d = d * d;
-    );
 
-    printAndLog(log_file, log, "million operations per second: %f\n",
-        (double)(num_executions) / duration * 1e-6);
-    printAndLog(log_file, log, "microseconds per operation:    %f\n",
-        duration * 1e6 / (double)(num_executions));
+    printAndLog(harness.log_file, harness.log, "\n\n");
+    printAndLog(harness.log_file, harness.log, "********************************************************************************\n");
+    printAndLog(harness.log_file, harness.log, "Beginning benchmarks for data type double.\n");
+    printAndLog(harness.log_file, harness.log, "********************************************************************************\n");
 
+    fillOperands(double, pool);
 
     //*************************************************************************
-    printAndLog(log_file, log, "\nTiming division:\n");
-
-    timeThisCode(MIN_DURATION, MAX_DURATION, duration, num_executions,
-        d = d / d;
-    );
-
-    printAndLog(log_file, log, "million operations per second: %f\n",
-        (double)(num_executions) / duration * 1e-6);
-    printAndLog(log_file, log, "microseconds per operation:    %f\n",
-        duration * 1e6 / (double)(num_executions));
+    benchmarkThisCode(harness, "double/add/chained", 1,
+        d = d + e;
+        benchDoNotOptimize(d);
+    )
+    benchmarkArrays(harness, double, "double/add", pool,
+        out = a[k] + b[k];
+    )
 
 
     //*************************************************************************
-    printAndLog(log_file, log, "\nTiming square root:\n");
-
-    timeThisCode(MIN_DURATION, MAX_DURATION, duration, num_executions,
-        d = sqrt(d);
-    );
+    benchmarkThisCode(harness, "double/sub/chained", 1,
+        d = d - e;
+        benchDoNotOptimize(d);
+    )
+    benchmarkArrays(harness, double, "double/sub", pool,
+        out = a[k] - b[k];
+    )
 
-    printAndLog(log_file, log, "million operations per second: %f\n",
-        (double)(num_executions) / duration * 1e-6);
-    printAndLog(log_file, log, "microseconds per operation:    %f\n",
-        duration * 1e6 / (double)(num_executions));
 
+    //*************************************************************************
+    benchmarkThisCode(harness, "double/mul/chained", 1,
+        d = d * e;
+        benchDoNotOptimize(d);
+    )
+    benchmarkArrays(harness, double, "double/mul", pool,
+        out = a[k] * b[k];
+    )
 
-    printAndLog(log_file, log, "\n\n");
-    printAndLog(log_file, log, "********************************************************************************\n");
-    printAndLog(log_file, log, "Beginning benchmarks for data type long double.\n");
-    printAndLog(log_file, log, "********************************************************************************\n");
 
     //*************************************************************************
-    printAndLog(log_file, log, "\nTiming addition:\n");
+    benchmarkThisCode(harness, "double/div/chained", 1,
+        d = d / e;
+        benchDoNotOptimize(d);
+    )
+    benchmarkArrays(harness, double, "double/div", pool,
+        out = a[k] / b[k];
+    )
 
-    timeThisCode(MIN_DURATION, MAX_DURATION, duration, num_executions,
-        ld = ld + ld;
-    );
 
-    printAndLog(log_file, log, "million operations per second: %f\n",
-        (double)(num_executions) / duration * 1e-6);
-    printAndLog(log_file, log, "microseconds per operation:    %f\n",
-        duration * 1e6 / (double)(num_executions));
+    //*************************************************************************
+    benchmarkThisCode(harness, "double/sqrt/chained", 1,
+        d = sqrt(d);
+        benchDoNotOptimize(d);
+    )
+    benchmarkArrays(harness, double, "double/sqrt", pool,
+        out = sqrt(a[k]);
+    )
 
 
     //*************************************************************************
-    printAndLog(log_file, log, "\nTiming subtraction:\n");
+    benchmarkThisCode(harness, "double/fma/chained", 1,
+        d = fma(d, e, e);
+        benchDoNotOptimize(d);
+    )
+    benchmarkArrays(harness, double, "double/fma", pool,
+        out = fma(a[k], b[k], a[k]);
+    )
 
-    timeThisCode(MIN_DURATION, MAX_DURATION, duration, num_executions,
-        ld = ld - ld;
-    );
 
-    printAndLog(log_file, log, "million operations per second: %f\n",
-        (double)(num_executions) / duration * 1e-6);
-    printAndLog(log_file, log, "microseconds per operation:    %f\n",
-        duration * 1e6 / (double)(num_executions));
+    printAndLog(harness.log_file, harness.log, "\n\n");
+    printAndLog(harness.log_file, harness.log, "********************************************************************************\n");
+    printAndLog(harness.log_file, harness.log, "Beginning benchmarks for data type long double.\n");
+    printAndLog(harness.log_file, harness.log, "********************************************************************************\n");
 
+    fillOperands(long double, pool);
 
     //*************************************************************************
-    printAndLog(log_file, log, "\nTiming multiplication:\n");
+    benchmarkThisCode(harness, "long_double/add/chained", 1,
+        ld = ld + le;
+        benchDoNotOptimize(ld);
+    )
+    benchmarkArrays(harness, long double, "long_double/add", pool,
+        out = a[k] + b[k];
+    )
 
-    timeThisCode(MIN_DURATION, MAX_DURATION, duration, num_executions,
-        ld = ld * ld;
-    );
 
-    printAndLog(log_file, log, "million operations per second: %f\n",
-        (double)(num_executions) / duration * 1e-6);
-    printAndLog(log_file, log, "microseconds per operation:    %f\n",
-        duration * 1e6 / (double)(num_executions));
+    //*************************************************************************
+    benchmarkThisCode(harness, "long_double/sub/chained", 1,
+        ld = ld - le;
+        benchDoNotOptimize(ld);
+    )
+    benchmarkArrays(harness, long double, "long_double/sub", pool,
+        out = a[k] - b[k];
+    )
 
 
     //*************************************************************************
-    printAndLog(log_file, log, "\nTiming division:\n");
+    benchmarkThisCode(harness, "long_double/mul/chained", 1,
+        ld = ld * le;
+        benchDoNotOptimize(ld);
+    )
+    benchmarkArrays(harness, long double, "long_double/mul", pool,
+        out = a[k] * b[k];
+    )
 
-    timeThisCode(MIN_DURATION, MAX_DURATION, duration, num_executions,
-        ld = ld / ld;
-    );
 
-    printAndLog(log_file, log, "million operations per second: %f\n",
-        (double)(num_executions) / duration * 1e-6);
-    printAndLog(log_file, log, "microseconds per operation:    %f\n",
-        duration * 1e6 / (double)(num_executions));
+    //*************************************************************************
+    benchmarkThisCode(harness, "long_double/div/chained", 1,
+        ld = ld / le;
+        benchDoNotOptimize(ld);
+    )
+    benchmarkArrays(harness, long double, "long_double/div", pool,
+        out = a[k] / b[k];
+    )
 
 
     //*************************************************************************
-    printAndLog(log_file, log, "\nTiming square root:\n");
-
-    timeThisCode(MIN_DURATION, MAX_DURATION, duration, num_executions,
+    benchmarkThisCode(harness, "long_double/sqrt/chained", 1,
         ld = sqrtl(ld);
-    );
-
-    printAndLog(log_file, log, "million operations per second: %f\n",
-        (double)(num_executions) / duration * 1e-6);
-    printAndLog(log_file, log, "microseconds per operation:    %f\n",
-        duration * 1e6 / (double)(num_executions));
-
-    printAndLog(log_file, log, "\n\n");
-    printAndLog(log_file, log, "********************************************************************************\n");
-    printAndLog(log_file, log, "This concludes the floating point operation benchmarks.\n");
-    printAndLog(log_file, log, "********************************************************************************\n");
-
-    fclose(log_file);
+        benchDoNotOptimize(ld);
+    )
+    benchmarkArrays(harness, long double, "long_double/sqrt", pool,
+        out = sqrtl(a[k]);
+    )
+
+    printAndLog(harness.log_file, harness.log, "\n\n");
+    printAndLog(harness.log_file, harness.log, "********************************************************************************\n");
+    printAndLog(harness.log_file, harness.log, "This concludes the floating point operation benchmarks.\n");
+    printAndLog(harness.log_file, harness.log, "********************************************************************************\n");
+
+    free(pool);
+    benchFinish(&harness);
 
     return 0;
 }
@@ -10,16 +10,144 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdarg.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
 #include <time.h>
 
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+#if defined(__linux__) && (defined(_DEFAULT_SOURCE) || defined(_GNU_SOURCE))
+#define BENCH_HAVE_AFFINITY 1
+#define BENCH_HAVE_COUNTERS 1
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
 
 #define BOOL int
 #define TRUE 1
 #define FALSE 0
 
+// defaults of the statistical harness, each overridable from the command line
+#define BENCH_DEFAULT_REPETITIONS 20  // --repetitions=N
+#define BENCH_DEFAULT_WARMUP 0.05  // --warmup=SECONDS
+#define BENCH_DEFAULT_MIN_TIME 0.01  // --min-time=SECONDS per repetition
+
+// most --filter arguments a harness keeps
+#define BENCH_MAX_FILTERS 16
+
+// hardware counters read with --counters, in the order of
+// BENCH_COUNTER_NAMES
+#define BENCH_COUNTER_COUNT 5
+#define BENCH_CYCLES 0
+#define BENCH_INSTRUCTIONS 1
+#define BENCH_BRANCH_MISSES 2
+#define BENCH_L1D_MISSES 3
+#define BENCH_LLC_MISSES 4
+
+static const char* const BENCH_COUNTER_NAMES[BENCH_COUNTER_COUNT] = {
+    "cycles", "instructions", "branch_misses", "l1d_misses", "llc_misses"
+};
+
+// bytes of input for the cache-resident and memory-bound variants of a
+// benchmark, well inside typical L1 and L2 caches and far past any L3
+#define BENCH_L1_BYTES (16 * 1024)
+#define BENCH_L2_BYTES (512 * 1024)
+#define BENCH_DRAM_BYTES (256 * 1024 * 1024)
+
+
+/*
+ * function-like macros: benchDoNotOptimize, benchClobberMemory
+ *
+ * benchDoNotOptimize(value) makes the compiler assume that the lvalue value
+ * is read and modified at that point, so the computation of its value cannot
+ * be removed, nor hoisted out of the timed loop or folded into constants
+ * when value is an input. benchClobberMemory() makes it assume that all
+ * memory is read and written, so stores are not elided.
+ *
+ * Neither emits any instruction. Where GCC style inline assembly is not
+ * available, a volatile pointer store is used instead, which costs one
+ * store per use.
+ */
+#if defined(__GNUC__) || defined(__clang__)
+#define benchDoNotOptimize(value) __asm__ __volatile__("" : "+m,r"(value) : : "memory")
+#define benchClobberMemory() __asm__ __volatile__("" : : : "memory")
+#else
+static void* volatile bench_escape;
+#define benchDoNotOptimize(value) (bench_escape = (void*)(&(value)))
+#define benchClobberMemory() (bench_escape = bench_escape)
+#endif
+
+
+/*
+ * struct: benchStats
+ *
+ * Summary of the repetitions of one benchmark, in nanoseconds per operation.
+ */
+typedef struct {
+    double median;
+    double p90;
+    double p99;
+    double mad;  // median absolute deviation from the median
+    double mean;
+    double min;
+} benchStats;
+
+/*
+ * struct: benchHarness
+ *
+ * Settings and state of a statistical benchmark run, see benchmarkThisCode.
+ */
+typedef struct {
+    // settings
+    size_t repetitions;  // timed repetitions per benchmark
+    double warmup;  // seconds run untimed before the repetitions
+    double min_time;  // least seconds per repetition
+    int cpu;  // CPU the process is pinned to, or -1
+    BOOL counters;  // whether hardware counters are read
+    const char* filters[BENCH_MAX_FILTERS];  // substrings of names to run
+    size_t filter_count;
+
+    // outputs
+    FILE* log_file;  // text log, as for printAndLog
+    BOOL log;
+    FILE* json;  // JSON results, or NULL
+    FILE* csv;  // CSV results, or NULL
+
+    // current benchmark
+    const char* name;
+    double ops;  // operations per execution of the timed code
+    size_t iterations;  // executions of the timed code per repetition
+    double* samples;  // seconds taken by each repetition
+    size_t result_count;  // benchmarks finished so far
+    benchStats stats;  // of the last benchmark finished
+
+    // hardware counters
+    int counter_fds[BENCH_COUNTER_COUNT];  // -1 where unavailable
+    uint64_t counter_start[BENCH_COUNTER_COUNT][3];  // value, time enabled, time running
+    double counts[BENCH_COUNTER_COUNT];  // per operation in the last benchmark, or -1
+} benchHarness;
+
 
 double timespec2sec(struct timespec start, struct timespec end);
-void printAndLog(FILE* log_file, BOOL log, char* format, ...);
+void printAndLog(FILE* log_file, BOOL log, const char* format, ...);
+double benchNow(void);
+BOOL benchParseArg(const char* arg, const char* key, const char** value);
+BOOL benchPin(int cpu);
+void benchCountersOpen(benchHarness* harness);
+BOOL benchCounterRead(int fd, uint64_t value[3]);
+void benchCountersBegin(benchHarness* harness);
+void benchCountersEnd(benchHarness* harness);
+void benchInit(benchHarness* harness, const char* log_file_name, int* argc, char* argv[]);
+void benchFinish(benchHarness* harness);
+BOOL benchStart(benchHarness* harness, const char* name, double ops);
+size_t benchGrow(size_t iterations, double elapsed, double min_time);
+int benchCompareDoubles(const void* a, const void* b);
+double benchQuantile(const double* sorted, size_t n, double q);
+void benchStop(benchHarness* harness);
+double benchLastMedian(const benchHarness* harness, size_t result_count);
 
 
 /*
@@ -39,6 +167,9 @@ void printAndLog(FILE* log_file, BOOL log, char* format, ...);
  * void (void* arg_data) prototyped function pointer in, which would incur
  * redundant function definitions and obscene argument structs among other
  * nasty things...
+ *
+ * NOTE: this reports a single wall clock measurement, so results that need
+ * to be compared across runs should use benchmarkThisCode instead.
  */
 #define timeThisCode(min_duration, max_duration, duration, num_times,\
                      code_to_time) {\
@@ -61,6 +192,59 @@ void printAndLog(FILE* log_file, BOOL log, char* format, ...);
 }
 
 
+/*
+ * function-like macro: benchmarkThisCode
+ *
+ * Times the given code with the statistical harness: the code is run untimed
+ * for the warmup while the number of executions per repetition is calibrated
+ * to take at least min_time, then timed over the configured number of
+ * repetitions on a monotonic clock. The median, 90th and 99th percentiles
+ * and median absolute deviation are printed and logged, and written to the
+ * JSON and CSV outputs if requested. With --counters, the hardware counters
+ * are read around the timed repetitions and reported per operation as well.
+ * Benchmarks whose names do not match a --filter argument are skipped.
+ *
+ * Args:
+ *   harness: benchHarness set up by benchInit
+ *   name: name of the benchmark (const char*)
+ *   ops: operations performed by one execution of the code (double)
+ *   ...: the code whose execution time to measure
+ *
+ * NOTE: the variables of the macro start with bench_ so that the timed code
+ * can use any other names.
+ */
+#define benchmarkThisCode(harness, name, ops, ...) {\
+    if (benchStart(&(harness), (name), (ops))) {\
+        size_t bench_i, bench_rep;\
+        double bench_start, bench_elapsed;\
+        double bench_warm_until = benchNow() + (harness).warmup;\
+        while (TRUE) {\
+            bench_start = benchNow();\
+            for (bench_i = 0; bench_i < (harness).iterations; bench_i++) {\
+                {__VA_ARGS__}\
+            }\
+            bench_elapsed = benchNow() - bench_start;\
+            if (bench_elapsed < (harness).min_time) {\
+                (harness).iterations = benchGrow((harness).iterations, bench_elapsed, (harness).min_time);\
+            }\
+            else if (benchNow() >= bench_warm_until) {\
+                break;\
+            }\
+        }\
+        benchCountersBegin(&(harness));\
+        for (bench_rep = 0; bench_rep < (harness).repetitions; bench_rep++) {\
+            bench_start = benchNow();\
+            for (bench_i = 0; bench_i < (harness).iterations; bench_i++) {\
+                {__VA_ARGS__}\
+            }\
+            (harness).samples[bench_rep] = benchNow() - bench_start;\
+        }\
+        benchCountersEnd(&(harness));\
+        benchStop(&(harness));\
+    }\
+}
+
+
 /*
  * function: timespec2sec
  * 
@@ -82,7 +266,7 @@ double timespec2sec(struct timespec start, struct timespec end) {
  *   format: the format string
  *   ...: values to be formatted into the string
  */
-void printAndLog(FILE* log_file, BOOL log, char* format, ...) {
+void printAndLog(FILE* log_file, BOOL log, const char* format, ...) {
     va_list args;
 
     va_start(args, format);
@@ -96,4 +280,537 @@ void printAndLog(FILE* log_file, BOOL log, char* format, ...) {
     }
 }
 
+/*
+ * function: benchNow
+ *
+ * Returns the time in seconds on a monotonic clock, which unlike the wall
+ * clock never jumps while a benchmark runs.
+ */
+double benchNow(void) {
+    struct timespec now;
+
+#if defined(CLOCK_MONOTONIC)
+    clock_gettime(CLOCK_MONOTONIC, &now);
+#else
+    timespec_get(&now, TIME_UTC);
+#endif
+    return (double)(now.tv_sec) + (double)(now.tv_nsec) * 1e-9;
+}
+
+/*
+ * function: benchParseArg
+ *
+ * Returns whether arg is --key=value, storing value in *value if so.
+ */
+BOOL benchParseArg(const char* arg, const char* key, const char** value) {
+    size_t length = strlen(key);
+
+    if (strncmp(arg, key, length) == 0 && arg[length] == '=') {
+        *value = arg + length + 1;
+        return TRUE;
+    }
+    return FALSE;
+}
+
+/*
+ * function: benchPin
+ *
+ * Pins the calling process to the given CPU. Returns whether it succeeded,
+ * which it never does on platforms other than Linux or in strict ISO C mode.
+ */
+BOOL benchPin(int cpu) {
+#if defined(BENCH_HAVE_AFFINITY)
+    unsigned long mask[16] = {0};
+    size_t bits = 8 * sizeof(unsigned long);
+
+    if (cpu < 0 || (size_t)(cpu) >= 16 * bits) {
+        return FALSE;
+    }
+    mask[cpu / bits] |= 1UL << (cpu % bits);
+    return syscall(SYS_sched_setaffinity, 0, sizeof(mask), mask) == 0;
+#else
+    (void)(cpu);
+    return FALSE;
+#endif
+}
+
+/*
+ * function: benchCountersOpen
+ *
+ * Opens the hardware counters of the calling thread, counting user space
+ * only. Each counter is opened on its own so that the ones the CPU or
+ * kernel does not offer are left out without losing the rest. Where
+ * perf_event_open is unavailable or not permitted, as in many containers or
+ * with a perf_event_paranoid setting above 2, a warning is printed and the
+ * harness reports time alone.
+ */
+void benchCountersOpen(benchHarness* harness) {
+    size_t opened = 0;
+
+#if defined(BENCH_HAVE_COUNTERS)
+    size_t i;
+
+    for (i = 0; i < BENCH_COUNTER_COUNT; i++) {
+        struct perf_event_attr attr;
+
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        switch (i) {
+            case BENCH_CYCLES:
+                attr.config = PERF_COUNT_HW_CPU_CYCLES;
+                break;
+            case BENCH_INSTRUCTIONS:
+                attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+                break;
+            case BENCH_BRANCH_MISSES:
+                attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+                break;
+            case BENCH_L1D_MISSES:
+                attr.type = PERF_TYPE_HW_CACHE;
+                attr.config = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                              (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+                break;
+            default:
+                attr.config = PERF_COUNT_HW_CACHE_MISSES;
+                break;
+        }
+        harness->counter_fds[i] = (int)(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+        if (harness->counter_fds[i] >= 0) {
+            opened++;
+        }
+    }
+#endif
+
+    if (opened == 0) {
+        fprintf(stderr, "Warning: hardware counters are unavailable, reporting time only.\n");
+        harness->counters = FALSE;
+    }
+    else if (opened < BENCH_COUNTER_COUNT) {
+        fprintf(stderr, "Warning: only %zu of %d hardware counters are available.\n",
+                opened, BENCH_COUNTER_COUNT);
+    }
+}
+
+/*
+ * function: benchCounterRead
+ *
+ * Reads the value, time enabled and time running of one counter. Returns
+ * whether it succeeded.
+ */
+BOOL benchCounterRead(int fd, uint64_t value[3]) {
+#if defined(BENCH_HAVE_COUNTERS)
+    return fd >= 0 && read(fd, value, 3 * sizeof(uint64_t)) == (ssize_t)(3 * sizeof(uint64_t));
+#else
+    (void)(fd);
+    (void)(value);
+    return FALSE;
+#endif
+}
+
+/*
+ * function: benchCountersBegin
+ *
+ * Reads the hardware counters before the timed repetitions, if enabled.
+ */
+void benchCountersBegin(benchHarness* harness) {
+    size_t i;
+
+    if (!harness->counters) {
+        return;
+    }
+    for (i = 0; i < BENCH_COUNTER_COUNT; i++) {
+        if (!benchCounterRead(harness->counter_fds[i], harness->counter_start[i])) {
+            harness->counter_start[i][2] = 0;
+        }
+    }
+}
+
+/*
+ * function: benchCountersEnd
+ *
+ * Reads the hardware counters after the timed repetitions, if enabled, and
+ * stores the totals in between in counts, or -1 for the counters that could
+ * not be read or never ran. The kernel multiplexes counters when there are
+ * more than the CPU has registers, so each total is scaled up by the share
+ * of the time its counter ran.
+ */
+void benchCountersEnd(benchHarness* harness) {
+    uint64_t end[3];
+    double enabled, running;
+    size_t i;
+
+    for (i = 0; i < BENCH_COUNTER_COUNT; i++) {
+        harness->counts[i] = -1.;
+        if (!harness->counters || harness->counter_start[i][2] == 0 ||
+            !benchCounterRead(harness->counter_fds[i], end)) {
+            continue;
+        }
+        enabled = (double)(end[1] - harness->counter_start[i][1]);
+        running = (double)(end[2] - harness->counter_start[i][2]);
+        if (running > 0.) {
+            harness->counts[i] = (double)(end[0] - harness->counter_start[i][0]) * enabled / running;
+        }
+    }
+}
+
+/*
+ * function: benchInit
+ *
+ * Sets up a harness from the command line and opens its outputs. The
+ * arguments it recognizes are removed from argv, so that the benchmark can
+ * read its own positional arguments afterwards:
+ *
+ *   --filter=SUBSTRING   run only benchmarks whose names contain one of the
+ *                        given substrings, may be repeated
+ *   --repetitions=N      timed repetitions per benchmark
+ *   --warmup=SECONDS     untimed run before the repetitions
+ *   --min-time=SECONDS   least time per repetition
+ *   --pin=CPU            pin the process to one CPU
+ *   --counters           read hardware counters around each benchmark
+ *   --json=FILE          write the results and every repetition as JSON
+ *   --csv=FILE           write the results as CSV
+ *
+ * Args:
+ *   harness: harness to set up
+ *   log_file_name: name of the text log, as for printAndLog
+ *   argc: number of arguments, updated
+ *   argv: arguments, updated
+ */
+void benchInit(benchHarness* harness, const char* log_file_name, int* argc, char* argv[]) {
+    const char* json_name = NULL;
+    const char* csv_name = NULL;
+    const char* value;
+    int i, kept = 1;
+
+    memset(harness, 0, sizeof(*harness));
+    harness->repetitions = BENCH_DEFAULT_REPETITIONS;
+    harness->warmup = BENCH_DEFAULT_WARMUP;
+    harness->min_time = BENCH_DEFAULT_MIN_TIME;
+    harness->cpu = -1;
+
+    for (i = 1; i < *argc; i++) {
+        if (benchParseArg(argv[i], "--filter", &value)) {
+            if (harness->filter_count < BENCH_MAX_FILTERS) {
+                harness->filters[harness->filter_count++] = value;
+            }
+        }
+        else if (benchParseArg(argv[i], "--repetitions", &value)) {
+            harness->repetitions = strtoul(value, NULL, 10);
+            if (harness->repetitions == 0) {
+                harness->repetitions = 1;
+            }
+        }
+        else if (benchParseArg(argv[i], "--warmup", &value)) {
+            harness->warmup = strtod(value, NULL);
+        }
+        else if (benchParseArg(argv[i], "--min-time", &value)) {
+            harness->min_time = strtod(value, NULL);
+        }
+        else if (benchParseArg(argv[i], "--pin", &value)) {
+            harness->cpu = (int)(strtol(value, NULL, 10));
+        }
+        else if (strcmp(argv[i], "--counters") == 0) {
+            harness->counters = TRUE;
+        }
+        else if (benchParseArg(argv[i], "--json", &value)) {
+            json_name = value;
+        }
+        else if (benchParseArg(argv[i], "--csv", &value)) {
+            csv_name = value;
+        }
+        else {
+            argv[kept++] = argv[i];
+        }
+    }
+    *argc = kept;
+    argv[kept] = NULL;
+
+    harness->samples = (double*)(malloc(harness->repetitions * sizeof(double)));
+    if (harness->samples == NULL) {
+        fprintf(stderr, "Error: unable to allocate benchmark samples.\n");
+        exit(1);
+    }
+
+    harness->log = TRUE;
+    harness->log_file = fopen(log_file_name, "w+");
+    if (harness->log_file == NULL) {
+        fprintf(stderr, "Error: unable to open log file.\n");
+        harness->log = FALSE;
+    }
+
+    if (json_name != NULL) {
+        harness->json = fopen(json_name, "w");
+        if (harness->json == NULL) {
+            fprintf(stderr, "Error: unable to open JSON file %s.\n", json_name);
+        }
+        else {
+            fprintf(harness->json, "{\n  \"repetitions\": %zu,\n  \"results\": [", harness->repetitions);
+        }
+    }
+    if (csv_name != NULL) {
+        harness->csv = fopen(csv_name, "w");
+        if (harness->csv == NULL) {
+            fprintf(stderr, "Error: unable to open CSV file %s.\n", csv_name);
+        }
+        else {
+            fprintf(harness->csv, "name,repetitions,iterations,median_ns,p90_ns,p99_ns,mad_ns,mean_ns,min_ns,"
+                    "cycles,instructions,ipc,branch_misses,l1d_misses,llc_misses\n");
+        }
+    }
+
+    for (i = 0; i < BENCH_COUNTER_COUNT; i++) {
+        harness->counter_fds[i] = -1;
+        harness->counts[i] = -1.;
+    }
+    if (harness->counters) {
+        benchCountersOpen(harness);
+    }
+
+    if (harness->cpu >= 0) {
+        if (benchPin(harness->cpu)) {
+            printAndLog(harness->log_file, harness->log, "pinned to CPU %d\n", harness->cpu);
+        }
+        else {
+            fprintf(stderr, "Warning: unable to pin to CPU %d, running unpinned.\n", harness->cpu);
+        }
+    }
+}
+
+/*
+ * function: benchFinish
+ *
+ * Completes and closes the outputs of a harness and frees its memory.
+ */
+void benchFinish(benchHarness* harness) {
+#if defined(BENCH_HAVE_COUNTERS)
+    size_t i;
+
+    for (i = 0; i < BENCH_COUNTER_COUNT; i++) {
+        if (harness->counter_fds[i] >= 0) {
+            close(harness->counter_fds[i]);
+            harness->counter_fds[i] = -1;
+        }
+    }
+#endif
+    if (harness->json != NULL) {
+        fprintf(harness->json, "\n  ]\n}\n");
+        fclose(harness->json);
+    }
+    if (harness->csv != NULL) {
+        fclose(harness->csv);
+    }
+    if (harness->log) {
+        fclose(harness->log_file);
+    }
+    free(harness->samples);
+    harness->samples = NULL;
+}
+
+/*
+ * function: benchStart
+ *
+ * Returns whether the named benchmark passes the filters, and if so gets
+ * the harness ready to time it.
+ */
+BOOL benchStart(benchHarness* harness, const char* name, double ops) {
+    size_t i;
+    BOOL selected = harness->filter_count == 0;
+
+    for (i = 0; i < harness->filter_count; i++) {
+        if (strstr(name, harness->filters[i]) != NULL) {
+            selected = TRUE;
+        }
+    }
+    if (!selected) {
+        return FALSE;
+    }
+
+    harness->name = name;
+    harness->ops = ops > 0. ? ops : 1.;
+    harness->iterations = 1;
+    return TRUE;
+}
+
+/*
+ * function: benchGrow
+ *
+ * Returns the number of executions per repetition to try after one that took
+ * elapsed seconds, aiming 20% past min_time and growing by 2 to 10 times.
+ */
+size_t benchGrow(size_t iterations, double elapsed, double min_time) {
+    double factor = elapsed > 0. ? 1.2 * min_time / elapsed : 10.;
+
+    if (factor < 2.) {
+        factor = 2.;
+    }
+    if (factor > 10.) {
+        factor = 10.;
+    }
+    return (size_t)(iterations * factor);
+}
+
+int benchCompareDoubles(const void* a, const void* b) {
+    double x = *(const double*)(a);
+    double y = *(const double*)(b);
+
+    return (x > y) - (x < y);
+}
+
+/*
+ * function: benchQuantile
+ *
+ * Returns quantile q of n sorted values, interpolating between neighbours.
+ */
+double benchQuantile(const double* sorted, size_t n, double q) {
+    double position = q * (double)(n - 1);
+    size_t below = (size_t)(position);
+
+    if (below + 1 >= n) {
+        return sorted[n - 1];
+    }
+    return sorted[below] + (position - (double)(below)) * (sorted[below + 1] - sorted[below]);
+}
+
+/*
+ * function: benchStop
+ *
+ * Computes the statistics of the benchmark just timed, and prints, logs and
+ * writes them. The hardware counts, if any, are turned into counts per
+ * operation.
+ */
+void benchStop(benchHarness* harness) {
+    size_t n = harness->repetitions;
+    double scale = 1e9 / ((double)(harness->iterations) * harness->ops);
+    double* counts = harness->counts;
+    double ipc = -1.;
+    double* sorted = (double*)(malloc(n * sizeof(double)));
+    benchStats* stats = &harness->stats;
+    size_t i;
+
+    if (sorted == NULL) {
+        fprintf(stderr, "Error: unable to allocate benchmark statistics.\n");
+        exit(1);
+    }
+
+    stats->mean = 0.;
+    for (i = 0; i < n; i++) {
+        sorted[i] = harness->samples[i] * scale;
+        stats->mean += sorted[i] / (double)(n);
+    }
+    qsort(sorted, n, sizeof(double), benchCompareDoubles);
+    stats->min = sorted[0];
+    stats->median = benchQuantile(sorted, n, .5);
+    stats->p90 = benchQuantile(sorted, n, .9);
+    stats->p99 = benchQuantile(sorted, n, .99);
+
+    for (i = 0; i < n; i++) {
+        sorted[i] = sorted[i] > stats->median ? sorted[i] - stats->median : stats->median - sorted[i];
+    }
+    qsort(sorted, n, sizeof(double), benchCompareDoubles);
+    stats->mad = benchQuantile(sorted, n, .5);
+    free(sorted);
+
+    for (i = 0; i < BENCH_COUNTER_COUNT; i++) {
+        if (counts[i] >= 0.) {
+            counts[i] /= (double)(n) * (double)(harness->iterations) * harness->ops;
+        }
+    }
+    if (counts[BENCH_CYCLES] > 0. && counts[BENCH_INSTRUCTIONS] >= 0.) {
+        ipc = counts[BENCH_INSTRUCTIONS] / counts[BENCH_CYCLES];
+    }
+
+    printAndLog(harness->log_file, harness->log, "\n%s:\n", harness->name);
+    printAndLog(harness->log_file, harness->log, "median nanoseconds per operation: %f\n", stats->median);
+    printAndLog(harness->log_file, harness->log, "p90/p99 nanoseconds:              %f / %f\n",
+        stats->p90, stats->p99);
+    printAndLog(harness->log_file, harness->log, "median absolute deviation:        %f (%.2f%%)\n",
+        stats->mad, stats->median > 0. ? stats->mad / stats->median * 100. : 0.);
+    printAndLog(harness->log_file, harness->log, "million operations per second:    %f\n",
+        stats->median > 0. ? 1e3 / stats->median : 0.);
+    printAndLog(harness->log_file, harness->log, "repetitions x executions:         %zu x %zu\n",
+        n, harness->iterations);
+    if (counts[BENCH_CYCLES] >= 0.) {
+        printAndLog(harness->log_file, harness->log, "cycles per operation:             %f\n", counts[BENCH_CYCLES]);
+    }
+    if (counts[BENCH_INSTRUCTIONS] >= 0.) {
+        printAndLog(harness->log_file, harness->log, "instructions per operation:       %f\n",
+            counts[BENCH_INSTRUCTIONS]);
+    }
+    if (ipc >= 0.) {
+        printAndLog(harness->log_file, harness->log, "instructions per cycle:           %f\n", ipc);
+    }
+    if (counts[BENCH_BRANCH_MISSES] >= 0.) {
+        printAndLog(harness->log_file, harness->log, "branch misses per operation:      %f\n",
+            counts[BENCH_BRANCH_MISSES]);
+    }
+    if (counts[BENCH_L1D_MISSES] >= 0.) {
+        printAndLog(harness->log_file, harness->log, "L1D read misses per operation:    %f\n",
+            counts[BENCH_L1D_MISSES]);
+    }
+    if (counts[BENCH_LLC_MISSES] >= 0.) {
+        printAndLog(harness->log_file, harness->log, "LLC misses per operation:         %f\n",
+            counts[BENCH_LLC_MISSES]);
+    }
+
+    if (harness->json != NULL) {
+        fprintf(harness->json, "%s\n    {\"name\": \"%s\", \"iterations\": %zu, \"ops\": %g, "
+                "\"median_ns\": %.9g, \"p90_ns\": %.9g, \"p99_ns\": %.9g, \"mad_ns\": %.9g, "
+                "\"mean_ns\": %.9g, \"min_ns\": %.9g,\n     \"samples_ns\": [",
+                harness->result_count > 0 ? "," : "", harness->name, harness->iterations, harness->ops,
+                stats->median, stats->p90, stats->p99, stats->mad, stats->mean, stats->min);
+        for (i = 0; i < n; i++) {
+            fprintf(harness->json, "%s%.9g", i > 0 ? ", " : "", harness->samples[i] * scale);
+        }
+        fprintf(harness->json, "]");
+        for (i = 0; i < BENCH_COUNTER_COUNT; i++) {
+            if (counts[i] >= 0.) {
+                fprintf(harness->json, ", \"%s\": %.9g", BENCH_COUNTER_NAMES[i], counts[i]);
+            }
+        }
+        if (ipc >= 0.) {
+            fprintf(harness->json, ", \"ipc\": %.9g", ipc);
+        }
+        fprintf(harness->json, "}");
+    }
+    if (harness->csv != NULL) {
+        fprintf(harness->csv, "\"%s\",%zu,%zu,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g",
+                harness->name, n, harness->iterations,
+                stats->median, stats->p90, stats->p99, stats->mad, stats->mean, stats->min);
+        // unavailable counts are left empty
+        for (i = 0; i < BENCH_COUNTER_COUNT; i++) {
+            if (counts[i] >= 0.) {
+                fprintf(harness->csv, ",%.9g", counts[i]);
+            }
+            else {
+                fprintf(harness->csv, ",");
+            }
+            if (i == BENCH_INSTRUCTIONS) {
+                if (ipc >= 0.) {
+                    fprintf(harness->csv, ",%.9g", ipc);
+                }
+                else {
+                    fprintf(harness->csv, ",");
+                }
+            }
+        }
+        fprintf(harness->csv, "\n");
+    }
+
+    harness->result_count++;
+}
+
+/*
+ * function: benchLastMedian
+ *
+ * Returns the median of the last benchmark if it ran since result_count was
+ * read, or NAN if the filters skipped it.
+ */
+double benchLastMedian(const benchHarness* harness, size_t result_count) {
+    return harness->result_count > result_count ? harness->stats.median : NAN;
+}
+
 #endif
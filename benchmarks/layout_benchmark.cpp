@@ -0,0 +1,133 @@
+/*
+ * layout_benchmark.cpp
+ *
+ * Compares the throughput of the curve_layout.h kernels on the interleaved,
+ * structure-of-arrays and packed layouts and prints the results to the screen
+ * while logging them to a file. The structure-of-arrays and packed layouts
+ * take the SIMD kernels, 4 lanes wide with SSE or 8 with BEZ_ENABLE_AVX.
+ *
+ * Usage: benchmark-curve_layout [anchor_count] [harness options, see benchInit]
+ */
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <time.h>
+#include <math.h>
+
+#include <vector>
+
+#include "curve.h"
+#include "curve_layout.h"
+#include "benchmark.h"
+
+
+// default number of anchor points in the benchmarked spline
+#define DEFAULT_ANCHOR_COUNT 100000
+
+// points per Bezier curve when tessellating
+#define TESSELLATION_STEPS 16
+
+// number of random queries per call to evaluateSegments
+#define QUERY_COUNT 1000000
+
+// name of file to log the benchmarks to
+#define LOG_FILE_NAME "layout_benchmark.log"
+
+
+/*
+ * function: benchmarkLayout
+ *
+ * Times each kernel on the given layout and returns the median nanoseconds
+ * per point, box and point of each, in the order tessellate,
+ * segmentBoundingBoxes, evaluateSegments.
+ */
+template <class Layout>
+void benchmarkLayout(benchHarness& harness, const char* name, const Layout& layout,
+                     const std::vector<std::size_t>& segments, const std::vector<BEZ_DTYPE>& ts,
+                     double ns[3]) {
+    std::vector<bezVect2D> tess;
+    std::vector<bezVect2D> mins(layout.segmentCount()), maxs(layout.segmentCount());
+    std::vector<bezVect2D> evals(ts.size());
+    double n = (double)(layout.segmentCount());
+    char full_name[64];
+    size_t count;
+
+    printAndLog(harness.log_file, harness.log, "\n\nLayout %s:\n", name);
+
+    count = harness.result_count;
+    snprintf(full_name, sizeof(full_name), "%s/tessellate", name);
+    benchmarkThisCode(harness, full_name, n * TESSELLATION_STEPS,
+        tessellate(layout, TESSELLATION_STEPS, tess);
+        benchClobberMemory();
+    )
+    ns[0] = benchLastMedian(&harness, count);
+
+    count = harness.result_count;
+    snprintf(full_name, sizeof(full_name), "%s/segmentBoundingBoxes", name);
+    benchmarkThisCode(harness, full_name, n,
+        segmentBoundingBoxes(layout, mins.data(), maxs.data());
+        benchClobberMemory();
+    )
+    ns[1] = benchLastMedian(&harness, count);
+
+    count = harness.result_count;
+    snprintf(full_name, sizeof(full_name), "%s/evaluateSegments", name);
+    benchmarkThisCode(harness, full_name, (double)(ts.size()),
+        evaluateSegments(layout, segments.data(), ts.data(), ts.size(), evals.data());
+        benchClobberMemory();
+    )
+    ns[2] = benchLastMedian(&harness, count);
+}
+
+
+int main(int argc, char* argv[]) {
+    benchHarness harness;
+    size_t anchor_count = DEFAULT_ANCHOR_COUNT;
+    size_t i;
+    double interleaved[3], soa[3], packed[3];
+
+    benchInit(&harness, LOG_FILE_NAME, &argc, argv);
+    if (argc > 1) {
+        anchor_count = strtoul(argv[1], NULL, 10);
+    }
+
+    std::vector<bezVect2D> anchors(anchor_count);
+    std::vector<std::size_t> segments(QUERY_COUNT);
+    std::vector<BEZ_DTYPE> ts(QUERY_COUNT);
+
+    srand(7);
+    for (i = 0; i < anchor_count; i++) {
+        anchors[i][0] = (BEZ_DTYPE)(rand()) / (BEZ_DTYPE)(RAND_MAX) * 100.;
+        anchors[i][1] = (BEZ_DTYPE)(rand()) / (BEZ_DTYPE)(RAND_MAX) * 100.;
+    }
+    for (i = 0; i < QUERY_COUNT; i++) {
+        segments[i] = rand() % (anchor_count - 1);
+        ts[i] = (BEZ_DTYPE)(rand()) / (BEZ_DTYPE)(RAND_MAX);
+    }
+
+    Curve2D curve(anchors);
+
+    printAndLog(harness.log_file, harness.log, "Beginning benchmarks for curve_layout.h\n");
+    printAndLog(harness.log_file, harness.log, "anchor points: %zu\n", anchor_count);
+
+    benchmarkLayout(harness, "CurveInterleavedView", CurveInterleavedView<2, BEZ_DTYPE>(curve),
+                    segments, ts, interleaved);
+    benchmarkLayout(harness, "CurveSoA", CurveSoA<2, BEZ_DTYPE>(curve),
+                    segments, ts, soa);
+    benchmarkLayout(harness, "CurvePacked", CurvePacked<2, BEZ_DTYPE>(curve),
+                    segments, ts, packed);
+
+    printAndLog(harness.log_file, harness.log, "\n\nSpeedup over CurveInterleavedView (tessellate, boxes, evaluate):\n");
+    printAndLog(harness.log_file, harness.log, "CurveSoA:    %f %f %f\n",
+        interleaved[0] / soa[0], interleaved[1] / soa[1], interleaved[2] / soa[2]);
+    printAndLog(harness.log_file, harness.log, "CurvePacked: %f %f %f\n",
+        interleaved[0] / packed[0], interleaved[1] / packed[1], interleaved[2] / packed[2]);
+
+    printAndLog(harness.log_file, harness.log, "\n\nThis concludes the benchmarks for curve_layout.h\n");
+
+    benchFinish(&harness);
+
+    return 0;
+}
@@ -0,0 +1,225 @@
+/*
+ * publish_benchmark.cpp
+ *
+ * Measures read and publish throughput of a spline shared between one writer
+ * thread and a growing number of reader threads, both through CurvePublisher
+ * and through a Curve2D guarded by a mutex, and prints the results to the
+ * screen while logging them to a file.
+ *
+ * Usage: benchmark-curve_publisher [anchor_count] [max_readers]
+ */
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <time.h>
+#include <math.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "curve.h"
+#include "curve_publisher.h"
+#include "benchmark.h"
+
+
+// seconds to run each configuration for
+#define RUN_DURATION 2.
+
+// default number of anchor points in the shared spline
+#define DEFAULT_ANCHOR_COUNT 10000
+
+// default largest number of reader threads to measure
+#define DEFAULT_MAX_READERS 8
+
+// points sampled by each read
+#define QUERIES_PER_READ 16
+
+// name of file to log the benchmarks to
+#define LOG_FILE_NAME "publish_benchmark.log"
+
+
+/*
+ * struct: Throughput
+ *
+ * Operations completed by each side during one run.
+ */
+struct Throughput {
+    double reads_per_second;
+    double publishes_per_second;
+};
+
+
+/*
+ * function: sampleSpline
+ *
+ * Evaluates the spline at QUERIES_PER_READ values of t and returns the sum of
+ * the coordinates, so the work cannot be optimized away.
+ */
+BEZ_DTYPE sampleSpline(const Curve2D& curve, std::size_t seed) {
+    BEZ_DTYPE sum = 0.;
+    std::size_t q;
+
+    for (q = 0; q < QUERIES_PER_READ; q++) {
+        BEZ_DTYPE t = (BEZ_DTYPE)((seed * 7919 + q * 104729) % 10007) / 10007.;
+        bezVect2D v = curve.getPositionAt(t);
+        sum += v[0] + v[1];
+    }
+
+    return sum;
+}
+
+/*
+ * function: runConcurrently
+ *
+ * Runs reader_count copies of read_once and one copy of write_once in loops
+ * for RUN_DURATION seconds and returns how often each completed.
+ */
+template <class Read, class Write>
+Throughput runConcurrently(std::size_t reader_count, Read read_once, Write write_once) {
+    std::atomic<bool> start(false), stop(false);
+    std::atomic<std::size_t> reads(0);
+    std::size_t writes = 0;
+    std::vector<std::thread> readers;
+    struct timespec begin, end;
+    std::size_t r;
+    Throughput result;
+
+    for (r = 0; r < reader_count; r++) {
+        readers.emplace_back([&, r] {
+            std::size_t count = 0;
+            volatile BEZ_DTYPE sink = 0.;
+
+            while (!start.load()) {
+                std::this_thread::yield();
+            }
+            while (!stop.load()) {
+                sink = sink + read_once(r, count);
+                count++;
+            }
+
+            reads += count;
+        });
+    }
+
+    std::thread writer([&] {
+        while (!start.load()) {
+            std::this_thread::yield();
+        }
+        while (!stop.load()) {
+            write_once(writes);
+            writes++;
+        }
+    });
+
+    timespec_get(&begin, TIME_UTC);
+    start = true;
+    std::this_thread::sleep_for(std::chrono::duration<double>(RUN_DURATION));
+    stop = true;
+
+    writer.join();
+    for (std::thread& reader : readers) {
+        reader.join();
+    }
+    timespec_get(&end, TIME_UTC);
+
+    result.reads_per_second = (double)(reads.load()) / timespec2sec(begin, end);
+    result.publishes_per_second = (double)(writes) / timespec2sec(begin, end);
+
+    return result;
+}
+
+
+int main(int argc, char* argv[]) {
+    FILE* log_file;
+    BOOL log = TRUE;
+    size_t anchor_count = DEFAULT_ANCHOR_COUNT;
+    size_t max_readers = DEFAULT_MAX_READERS;
+    size_t readers;
+    size_t i;
+
+    if (argc > 1) {
+        anchor_count = strtoul(argv[1], NULL, 10);
+    }
+    if (argc > 2) {
+        max_readers = strtoul(argv[2], NULL, 10);
+    }
+
+    log_file = fopen(LOG_FILE_NAME, "w+");
+    if (log_file == NULL) {
+        fprintf(stderr, "Error: unable to open log file.\n");
+        log = FALSE;
+    }
+
+    std::vector<bezVect2D> anchors(anchor_count);
+    srand(7);
+    for (i = 0; i < anchor_count; i++) {
+        anchors[i][0] = (BEZ_DTYPE)(rand()) / (BEZ_DTYPE)(RAND_MAX) * 100.;
+        anchors[i][1] = (BEZ_DTYPE)(rand()) / (BEZ_DTYPE)(RAND_MAX) * 100.;
+    }
+
+    printAndLog(log_file, log, "Beginning concurrent read/write benchmarks for CurvePublisher\n");
+    printAndLog(log_file, log, "anchor points: %zu\n", anchor_count);
+    printAndLog(log_file, log, "hardware threads: %u\n", std::thread::hardware_concurrency());
+    printAndLog(log_file, log, "points sampled per read: %d\n", QUERIES_PER_READ);
+
+    for (readers = 1; readers <= max_readers; readers *= 2) {
+        //*********************************************************************
+        printAndLog(log_file, log, "\n%zu reader thread(s), 1 writer thread:\n", readers);
+        //*********************************************************************
+        Curve2D locked(anchors);
+        std::mutex mutex;
+        CurvePublisher2D publisher(Curve2D(anchors), readers);
+        std::vector<std::size_t> slots(readers);
+
+        // Every edit moves one anchor point and changes every control point
+        // near it, then makes the result visible
+        Throughput baseline = runConcurrently(readers,
+            [&](std::size_t, std::size_t count) {
+                std::lock_guard<std::mutex> lock(mutex);
+                return sampleSpline(locked, count);
+            },
+            [&](std::size_t count) {
+                std::lock_guard<std::mutex> lock(mutex);
+                locked.moveAnchor(bezVect2D{ .01, -.01 }, count % anchor_count);
+                locked.getLength();
+            });
+
+        for (i = 0; i < readers; i++) {
+            slots[i] = publisher.registerReader();
+        }
+
+        Throughput published = runConcurrently(readers,
+            [&](std::size_t r, std::size_t count) {
+                CurvePublisher2D::Snapshot snapshot = publisher.read(slots[r]);
+                return sampleSpline(*snapshot, count);
+            },
+            [&](std::size_t count) {
+                publisher.edit().moveAnchor(bezVect2D{ .01, -.01 }, count % anchor_count);
+                publisher.publish();
+            });
+
+        printAndLog(log_file, log, "mutex, million reads per second:                  %f\n",
+            baseline.reads_per_second * 1e-6);
+        printAndLog(log_file, log, "mutex, updates per second:                        %f\n",
+            baseline.publishes_per_second);
+        printAndLog(log_file, log, "CurvePublisher, million reads per second:         %f\n",
+            published.reads_per_second * 1e-6);
+        printAndLog(log_file, log, "CurvePublisher, publishes per second:             %f\n",
+            published.publishes_per_second);
+        printAndLog(log_file, log, "read speedup over mutex:                          %f\n",
+            published.reads_per_second / baseline.reads_per_second);
+    }
+
+    printAndLog(log_file, log, "\n\nThis concludes the concurrent read/write benchmarks for CurvePublisher\n");
+
+    if (log) {
+        fclose(log_file);
+    }
+
+    return 0;
+}
@@ -0,0 +1,312 @@
+/*
+ * scaling_benchmark.cpp
+ *
+ * Measures how batch evaluation, bounding boxes, arc lengths and Curve2D
+ * solves scale from 1 thread up to every hardware thread, and prints the
+ * results to the screen while logging them to a file.
+ *
+ * Every workload processes a fixed total number of items split evenly over
+ * the threads of a ThreadPool, so perfect scaling divides the time per item
+ * by the thread count. Each workload runs over two data placements:
+ *
+ *   shared   one read-only array allocated and filled by the main thread,
+ *            which on a NUMA host puts all of it on one node
+ *   private  a copy of each thread's slice allocated and filled by the pool
+ *            task that reads it, so that it is local to that thread
+ *
+ * For Curve2D, shared is one spline solved by updateControlPoints on the
+ * pool, and private is one spline per thread solved serially.
+ *
+ * Speedup and parallel efficiency are relative to one thread with the same
+ * placement. Bandwidth is the input read per second, also given as a share
+ * of the read workload at the same thread count, which only sums the curves
+ * and so shows how close the memory system is to saturation.
+ *
+ * Usage: benchmark-scaling [curve_count [max_threads]] [harness options, see benchInit]
+ */
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <time.h>
+#include <math.h>
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "bezier.h"
+#include "curve.h"
+#include "thread_pool.h"
+#include "benchmark.h"
+
+
+// default number of cubic Bezier curves, 64 MB of input
+#define DEFAULT_CURVE_COUNT (1 << 21)
+
+// share of the curves used by the slower workloads
+#define ARC_LENGTH_DIVISOR 16
+#define SOLVE_DIVISOR 4
+
+// flatness threshold of the arc length workload
+#define ARC_LENGTH_FLATNESS 1.001
+
+// values per curve: x0, y0, x1, y1, x2, y2, x3, y3
+#define CURVE_SIZE 8
+
+// name of file to log the benchmarks to
+#define LOG_FILE_NAME "scaling_benchmark.log"
+
+
+/*
+ * struct: Partial
+ *
+ * Result of one thread, on its own cache line so that threads do not share
+ * the line they write.
+ */
+struct alignas(64) Partial {
+    BEZ_DTYPE value;
+};
+
+/*
+ * typedef: Kernel
+ *
+ * Processes count curves and returns a value depending on all of them.
+ */
+typedef BEZ_DTYPE (*Kernel)(const BEZ_DTYPE* curves, size_t count);
+
+/*
+ * struct: Workload
+ *
+ * A kernel and the share of the curves it processes.
+ */
+struct Workload {
+    const char* name;
+    Kernel kernel;
+    size_t divisor;  // processes curve_count / divisor curves
+};
+
+
+// keeps one sum per value of a curve, so the additions are independent and
+// the loop is limited by memory rather than by their latency
+BEZ_DTYPE readKernel(const BEZ_DTYPE* curves, size_t count) {
+    BEZ_DTYPE sums[CURVE_SIZE] = {0.};
+    BEZ_DTYPE sum = 0.;
+
+    for (size_t i = 0; i < count; i++) {
+        for (size_t j = 0; j < CURVE_SIZE; j++) {
+            sums[j] += curves[CURVE_SIZE * i + j];
+        }
+    }
+    for (size_t j = 0; j < CURVE_SIZE; j++) {
+        sum += sums[j];
+    }
+    return sum;
+}
+
+BEZ_DTYPE evaluateKernel(const BEZ_DTYPE* curves, size_t count) {
+    BEZ_DTYPE sum = 0., x, y;
+
+    for (size_t i = 0; i < count; i++) {
+        const BEZ_DTYPE* c = curves + CURVE_SIZE * i;
+        bez2Evaluate(c[0], c[1], c[2], c[3], c[4], c[5], c[6], c[7],
+                     (BEZ_DTYPE)(i & 15) * (BEZ_DTYPE)(1. / 16.), &x, &y);
+        sum += x + y;
+    }
+    return sum;
+}
+
+BEZ_DTYPE boundingBoxKernel(const BEZ_DTYPE* curves, size_t count) {
+    BEZ_DTYPE sum = 0., x_min, y_min, x_max, y_max;
+
+    for (size_t i = 0; i < count; i++) {
+        const BEZ_DTYPE* c = curves + CURVE_SIZE * i;
+        bez2BoundingBox(c[0], c[1], c[2], c[3], c[4], c[5], c[6], c[7],
+                        &x_min, &y_min, &x_max, &y_max);
+        sum += x_min + y_min + x_max + y_max;
+    }
+    return sum;
+}
+
+BEZ_DTYPE arcLengthKernel(const BEZ_DTYPE* curves, size_t count) {
+    BEZ_DTYPE sum = 0.;
+
+    for (size_t i = 0; i < count; i++) {
+        const BEZ_DTYPE* c = curves + CURVE_SIZE * i;
+        sum += bez2ArcLength(c[0], c[1], c[2], c[3], c[4], c[5], c[6], c[7], ARC_LENGTH_FLATNESS);
+    }
+    return sum;
+}
+
+/*
+ * function: sliceBegin
+ *
+ * Returns the first of count items taken by part k of parts.
+ */
+size_t sliceBegin(size_t count, size_t k, size_t parts) {
+    return count * k / parts;
+}
+
+
+int main(int argc, char* argv[]) {
+    benchHarness harness;
+    size_t curve_count = DEFAULT_CURVE_COUNT;
+    size_t max_threads = std::thread::hardware_concurrency();
+    size_t threads, i, w;
+    char name[64];
+
+    benchInit(&harness, LOG_FILE_NAME, &argc, argv);
+    if (argc > 1) {
+        curve_count = strtoul(argv[1], NULL, 10);
+    }
+    if (argc > 2) {
+        max_threads = strtoul(argv[2], NULL, 10);
+    }
+    if (max_threads == 0) {
+        max_threads = 1;
+    }
+
+    std::vector<size_t> thread_counts;
+    for (threads = 1; threads < max_threads; threads *= 2) {
+        thread_counts.push_back(threads);
+    }
+    thread_counts.push_back(max_threads);
+
+    const Workload workloads[] = {
+        {"read", readKernel, 1},
+        {"evaluate", evaluateKernel, 1},
+        {"bounding_box", boundingBoxKernel, 1},
+        {"arc_length", arcLengthKernel, ARC_LENGTH_DIVISOR},
+    };
+    const size_t workload_count = sizeof(workloads) / sizeof(workloads[0]);
+    const char* placements[2] = {"shared", "private"};
+
+    // random curves in [0, 100], and anchor points for the solves
+    std::vector<BEZ_DTYPE> curves(curve_count * CURVE_SIZE);
+    std::vector<bezVect2D> anchors(curve_count / SOLVE_DIVISOR);
+    srand(7);
+    for (i = 0; i < curves.size(); i++) {
+        curves[i] = (BEZ_DTYPE)(rand()) / (BEZ_DTYPE)(RAND_MAX) * 100.;
+    }
+    for (i = 0; i < anchors.size(); i++) {
+        anchors[i][0] = (BEZ_DTYPE)(i) + (BEZ_DTYPE)(rand()) / (BEZ_DTYPE)(RAND_MAX);
+        anchors[i][1] = (BEZ_DTYPE)(rand()) / (BEZ_DTYPE)(RAND_MAX) * 100.;
+    }
+
+    printAndLog(harness.log_file, harness.log, "Beginning multi-core scaling benchmarks\n");
+    printAndLog(harness.log_file, harness.log, "curves: %zu, anchor points per solve: %zu\n",
+        curve_count, anchors.size());
+    printAndLog(harness.log_file, harness.log, "hardware threads: %u\n", std::thread::hardware_concurrency());
+
+    // median nanoseconds per item, by placement, workload and thread count,
+    // with the solve as the last workload
+    std::vector<double> medians[2][workload_count + 1];
+
+    for (size_t t = 0; t < thread_counts.size(); t++) {
+        threads = thread_counts[t];
+        ThreadPool pool(threads);
+        std::vector<Partial> partials(threads);
+        std::vector<std::vector<BEZ_DTYPE> > slices(threads);
+        std::vector<std::unique_ptr<Curve2D> > splines(threads);
+        std::vector<std::unique_ptr<ThreadPool> > serial_pools(threads);
+
+        printAndLog(harness.log_file, harness.log, "\n\n%zu threads:\n", threads);
+
+        // each task copies its own slice, so the copy is first touched by
+        // the thread that reads it
+        pool.run(threads, [&](size_t k) {
+            size_t begin = sliceBegin(curve_count, k, threads);
+            size_t end = sliceBegin(curve_count, k + 1, threads);
+            slices[k].assign(curves.begin() + CURVE_SIZE * begin, curves.begin() + CURVE_SIZE * end);
+
+            begin = sliceBegin(anchors.size(), k, threads);
+            end = sliceBegin(anchors.size(), k + 1, threads);
+            splines[k].reset(new Curve2D(std::vector<bezVect2D>(anchors.begin() + begin,
+                                                                anchors.begin() + end)));
+            serial_pools[k].reset(new ThreadPool(1));
+        });
+
+        for (w = 0; w < workload_count; w++) {
+            const Workload& workload = workloads[w];
+            size_t count = curve_count / workload.divisor;
+            size_t result_count;
+
+            //*****************************************************************
+            result_count = harness.result_count;
+            snprintf(name, sizeof(name), "%s/shared/%zu", workload.name, threads);
+            benchmarkThisCode(harness, name, (double)(count),
+                pool.run(threads, [&](size_t k) {
+                    size_t begin = sliceBegin(count, k, threads);
+                    size_t end = sliceBegin(count, k + 1, threads);
+                    partials[k].value = workload.kernel(&curves[CURVE_SIZE * begin], end - begin);
+                    benchDoNotOptimize(partials[k].value);
+                });
+            )
+            medians[0][w].push_back(benchLastMedian(&harness, result_count));
+
+            //*****************************************************************
+            result_count = harness.result_count;
+            snprintf(name, sizeof(name), "%s/private/%zu", workload.name, threads);
+            benchmarkThisCode(harness, name, (double)(count),
+                pool.run(threads, [&](size_t k) {
+                    size_t slice_count = sliceBegin(count, k + 1, threads) - sliceBegin(count, k, threads);
+                    partials[k].value = workload.kernel(slices[k].data(), slice_count);
+                    benchDoNotOptimize(partials[k].value);
+                });
+            )
+            medians[1][w].push_back(benchLastMedian(&harness, result_count));
+        }
+
+        //*********************************************************************
+        size_t result_count = harness.result_count;
+        Curve2D shared_spline(anchors);
+        snprintf(name, sizeof(name), "solve/shared/%zu", threads);
+        benchmarkThisCode(harness, name, (double)(anchors.size()),
+            shared_spline.updateControlPoints(pool);
+        )
+        medians[0][workload_count].push_back(benchLastMedian(&harness, result_count));
+
+        //*********************************************************************
+        result_count = harness.result_count;
+        snprintf(name, sizeof(name), "solve/private/%zu", threads);
+        benchmarkThisCode(harness, name, (double)(anchors.size()),
+            pool.run(threads, [&](size_t k) {
+                splines[k]->updateControlPoints(*serial_pools[k]);
+            });
+        )
+        medians[1][workload_count].push_back(benchLastMedian(&harness, result_count));
+    }
+
+    //*************************************************************************
+    printAndLog(harness.log_file, harness.log, "\n\nSummary:\n");
+    //*************************************************************************
+    for (size_t p = 0; p < 2; p++) {
+        for (w = 0; w <= workload_count; w++) {
+            const char* workload_name = w < workload_count ? workloads[w].name : "solve";
+            // input read per item: a curve, or for the solve an anchor point
+            // and the two control points written next to it
+            double bytes = w < workload_count ? CURVE_SIZE * sizeof(BEZ_DTYPE) : 3 * sizeof(bezVect2D);
+            const std::vector<double>& row = medians[p][w];
+
+            printAndLog(harness.log_file, harness.log, "\n%s, %s data:\n", workload_name, placements[p]);
+            printAndLog(harness.log_file, harness.log, "%8s %12s %10s %10s %10s %10s\n",
+                "threads", "ns/item", "speedup", "efficiency", "GB/s", "% of read");
+            for (size_t t = 0; t < thread_counts.size(); t++) {
+                double speedup = row[0] / row[t];
+                double bandwidth = bytes / row[t];
+                double read_bandwidth = CURVE_SIZE * sizeof(BEZ_DTYPE) / medians[p][0][t];
+
+                printAndLog(harness.log_file, harness.log, "%8zu %12.3f %10.3f %10.3f %10.3f %10.1f\n",
+                    thread_counts[t], row[t], speedup, speedup / (double)(thread_counts[t]),
+                    bandwidth, bandwidth / read_bandwidth * 100.);
+            }
+        }
+    }
+
+    printAndLog(harness.log_file, harness.log, "\n\nThis concludes the multi-core scaling benchmarks\n");
+
+    benchFinish(&harness);
+
+    return 0;
+}
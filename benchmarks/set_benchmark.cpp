@@ -0,0 +1,161 @@
+/*
+ * set_benchmark.cpp
+ *
+ * Measures building, solving, evaluating, bounding and tessellating many
+ * small splines, both as separate Curve2D objects and as one CurveSet2D, and
+ * prints the results to the screen while logging them to a file.
+ *
+ * Usage: benchmark-curve_set [curve_count] [harness options, see benchInit]
+ */
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <time.h>
+#include <math.h>
+
+#include <vector>
+
+#include "curve.h"
+#include "curve_layout.h"
+#include "curve_set.h"
+#include "thread_pool.h"
+#include "benchmark.h"
+
+
+// default number of splines
+#define DEFAULT_CURVE_COUNT 20000
+
+// largest number of anchor points per spline
+#define MAX_ANCHORS 64
+
+// points per Bezier curve when tessellating
+#define TESSELLATION_STEPS 8
+
+// evaluations per benchmark run
+#define QUERY_COUNT 100000
+
+// name of file to log the benchmarks to
+#define LOG_FILE_NAME "set_benchmark.log"
+
+
+int main(int argc, char* argv[]) {
+    benchHarness harness;
+    size_t curve_count = DEFAULT_CURVE_COUNT;
+    size_t anchor_total = 0;
+    size_t i, j;
+    volatile BEZ_DTYPE sink = 0.;
+
+    benchInit(&harness, LOG_FILE_NAME, &argc, argv);
+    if (argc > 1) {
+        curve_count = strtoul(argv[1], NULL, 10);
+    }
+
+    std::vector<std::vector<bezVect2D> > anchor_sets(curve_count);
+    srand(7);
+    for (i = 0; i < curve_count; i++) {
+        anchor_sets[i].resize(4 + rand() % (MAX_ANCHORS - 3));
+        anchor_total += anchor_sets[i].size();
+
+        for (j = 0; j < anchor_sets[i].size(); j++) {
+            anchor_sets[i][j][0] = (BEZ_DTYPE)(rand()) / (BEZ_DTYPE)(RAND_MAX) * 100.;
+            anchor_sets[i][j][1] = (BEZ_DTYPE)(rand()) / (BEZ_DTYPE)(RAND_MAX) * 100.;
+        }
+    }
+
+    std::vector<size_t> queries(QUERY_COUNT);
+    std::vector<BEZ_DTYPE> ts(QUERY_COUNT);
+    std::vector<bezVect2D> evals(QUERY_COUNT);
+    for (i = 0; i < QUERY_COUNT; i++) {
+        queries[i] = rand() % curve_count;
+        ts[i] = (BEZ_DTYPE)(rand()) / (BEZ_DTYPE)(RAND_MAX);
+    }
+
+    printAndLog(harness.log_file, harness.log, "Beginning batch benchmarks for CurveSet\n");
+    printAndLog(harness.log_file, harness.log, "splines: %zu\n", curve_count);
+    printAndLog(harness.log_file, harness.log, "anchor points: %zu\n", anchor_total);
+    printAndLog(harness.log_file, harness.log, "hardware threads: %zu\n", ThreadPool::shared().threadCount());
+    printAndLog(harness.log_file, harness.log, "operations are splines, or evaluations for evaluate\n");
+
+    //*************************************************************************
+    printAndLog(harness.log_file, harness.log, "\nSeparate Curve2D objects:\n");
+    //*************************************************************************
+    std::vector<Curve2D> curves;
+    std::vector<bezVect2D> polyline;
+
+    // built once up front so that the other benchmarks can run on their own
+    for (j = 0; j < curve_count; j++) {
+        curves.emplace_back(anchor_sets[j]);
+    }
+
+    benchmarkThisCode(harness, "curves/build", (double)(curve_count),
+        curves.clear();
+        for (j = 0; j < curve_count; j++) {
+            curves.emplace_back(anchor_sets[j]);
+        }
+    )
+
+    benchmarkThisCode(harness, "curves/evaluate", QUERY_COUNT,
+        for (j = 0; j < QUERY_COUNT; j++) {
+            evals[j] = curves[queries[j]].getPositionAt(ts[j]);
+        }
+        benchClobberMemory();
+    )
+
+    benchmarkThisCode(harness, "curves/tessellate", (double)(curve_count),
+        for (j = 0; j < curve_count; j++) {
+            tessellate(CurveInterleavedView<2, BEZ_DTYPE>(curves[j]), TESSELLATION_STEPS, polyline);
+            sink = sink + polyline.back()[0];
+        }
+    )
+
+    //*************************************************************************
+    printAndLog(harness.log_file, harness.log, "\n\nCurveSet2D:\n");
+    //*************************************************************************
+    CurveSet2D set;
+    std::vector<bezVect2D> mins(curve_count), maxs(curve_count);
+    std::vector<size_t> offsets;
+
+    for (j = 0; j < curve_count; j++) {
+        set.add(anchor_sets[j]);
+    }
+    set.rebuild();
+
+    benchmarkThisCode(harness, "set/build", (double)(curve_count),
+        set.clear();
+        for (j = 0; j < curve_count; j++) {
+            set.add(anchor_sets[j]);
+        }
+        set.rebuild();
+    )
+
+    benchmarkThisCode(harness, "set/build_parallel", (double)(curve_count),
+        set.clear();
+        for (j = 0; j < curve_count; j++) {
+            set.add(anchor_sets[j]);
+        }
+        set.rebuild(ThreadPool::shared());
+    )
+
+    benchmarkThisCode(harness, "set/evaluate", QUERY_COUNT,
+        set.evaluate(queries.data(), ts.data(), QUERY_COUNT, evals.data());
+        benchClobberMemory();
+    )
+
+    benchmarkThisCode(harness, "set/tessellate", (double)(curve_count),
+        set.tessellate(TESSELLATION_STEPS, polyline, offsets);
+        sink = sink + polyline.back()[0];
+    )
+
+    benchmarkThisCode(harness, "set/boundingBoxes", (double)(curve_count),
+        set.boundingBoxes(mins.data(), maxs.data());
+        sink = sink + mins[0][0];
+    )
+
+    printAndLog(harness.log_file, harness.log, "\n\nThis concludes the batch benchmarks for CurveSet\n");
+
+    benchFinish(&harness);
+
+    return 0;
+}
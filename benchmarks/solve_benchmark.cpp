@@ -0,0 +1,106 @@
+/*
+ * solve_benchmark.cpp
+ *
+ * Measures the strong scaling of Curve2D::updateControlPoints on a very large
+ * spline from 1 to 64 threads and prints the results to the screen while
+ * logging them to a file. Speedups are relative to the single sweep of
+ * solveAll, which reads of a dirty spline run when the shared pool has one
+ * thread.
+ *
+ * Usage: benchmark-parallel_solve [anchor_count] [harness options, see benchInit]
+ */
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <time.h>
+#include <math.h>
+
+#include <vector>
+
+#include "curve.h"
+#include "thread_pool.h"
+#include "benchmark.h"
+
+
+// default number of anchor points in the benchmarked spline
+#define DEFAULT_ANCHOR_COUNT 10000000
+
+// largest thread count to measure
+#define MAX_THREADS 64
+
+// name of file to log the benchmarks to
+#define LOG_FILE_NAME "solve_benchmark.log"
+
+
+int main(int argc, char* argv[]) {
+    benchHarness harness;
+    double ns;
+    double serial_ns;
+    size_t anchor_count = DEFAULT_ANCHOR_COUNT;
+    size_t threads;
+    size_t i, count;
+    char name[64];
+
+    // solveAll only sweeps serially if the shared pool has a single thread
+    ThreadPool::setSharedThreadCount(1);
+
+    benchInit(&harness, LOG_FILE_NAME, &argc, argv);
+    if (argc > 1) {
+        anchor_count = strtoul(argv[1], NULL, 10);
+    }
+
+    std::vector<bezVect2D> anchors(anchor_count);
+    srand(7);
+    for (i = 0; i < anchor_count; i++) {
+        anchors[i][0] = (BEZ_DTYPE)(i) + (BEZ_DTYPE)(rand()) / (BEZ_DTYPE)(RAND_MAX);
+        anchors[i][1] = (BEZ_DTYPE)(rand()) / (BEZ_DTYPE)(RAND_MAX) * 100.;
+    }
+
+    Curve2D curve(anchors);
+
+    printAndLog(harness.log_file, harness.log, "Beginning strong scaling benchmarks for Curve2D::updateControlPoints\n");
+    printAndLog(harness.log_file, harness.log, "anchor points: %zu\n", anchor_count);
+    printAndLog(harness.log_file, harness.log, "hardware threads: %u\n", std::thread::hardware_concurrency());
+    printAndLog(harness.log_file, harness.log, "operations are anchor points solved\n");
+
+
+    //*************************************************************************
+    printAndLog(harness.log_file, harness.log, "\nTiming serial solve (solveAll):\n");
+    //*************************************************************************
+    count = harness.result_count;
+    benchmarkThisCode(harness, "solve/serial", (double)(anchor_count),
+        curve.markDirty(0, anchor_count);
+        curve.updateControlPoints();
+    )
+    serial_ns = benchLastMedian(&harness, count);
+
+
+    for (threads = 1; threads <= MAX_THREADS; threads *= 2) {
+        //*********************************************************************
+        printAndLog(harness.log_file, harness.log, "\n\nTiming partitioned solve on %zu threads:\n", threads);
+        //*********************************************************************
+        ThreadPool pool(threads);
+
+        count = harness.result_count;
+        snprintf(name, sizeof(name), "solve/%zu", threads);
+        benchmarkThisCode(harness, name, (double)(anchor_count),
+            curve.updateControlPoints(pool);
+        )
+        ns = benchLastMedian(&harness, count);
+
+        if (!isnan(ns)) {
+            printAndLog(harness.log_file, harness.log, "speedup over serial:              %f\n", serial_ns / ns);
+            printAndLog(harness.log_file, harness.log, "parallel efficiency:              %f\n",
+                serial_ns / ns / (double)(threads));
+        }
+    }
+
+
+    printAndLog(harness.log_file, harness.log, "\n\nThis concludes the strong scaling benchmarks for Curve2D::updateControlPoints\n");
+
+    benchFinish(&harness);
+
+    return 0;
+}
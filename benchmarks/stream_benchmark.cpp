@@ -0,0 +1,132 @@
+/*
+ * stream_benchmark.cpp
+ *
+ * Measures the latency of appending anchor points to a StreamingCurve2D with a
+ * fixed window as the stream grows, next to a Curve2D kept at the same window
+ * by adding and removing anchor points, and prints the results to the screen
+ * while logging them to a file.
+ *
+ * Usage: benchmark-streaming_curve [window] [stream_length]
+ */
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <time.h>
+#include <math.h>
+
+#include <vector>
+
+#include "curve.h"
+#include "streaming_curve.h"
+#include "benchmark.h"
+
+
+// default number of anchor points kept
+#define DEFAULT_WINDOW 10000
+
+// default number of anchor points streamed
+#define DEFAULT_STREAM_LENGTH 10000000
+
+// appends timed together at each checkpoint
+#define BLOCK_SIZE 10000
+
+// name of file to log the benchmarks to
+#define LOG_FILE_NAME "stream_benchmark.log"
+
+
+/*
+ * function: streamPoint
+ *
+ * Returns the i-th point of a noisy spiral, standing in for telemetry.
+ */
+bezVect2D streamPoint(size_t i) {
+    BEZ_DTYPE angle = (BEZ_DTYPE)(i % 100000) * .01;
+    BEZ_DTYPE noise = (BEZ_DTYPE)(rand()) / (BEZ_DTYPE)(RAND_MAX) - .5;
+
+    return bezVect2D{ (BEZ_DTYPE)(cos(angle)) * 50 + noise, (BEZ_DTYPE)(sin(angle)) * 50 - noise };
+}
+
+
+int main(int argc, char* argv[]) {
+    FILE* log_file;
+    BOOL log = TRUE;
+    struct timespec start, end;
+    size_t window = DEFAULT_WINDOW;
+    size_t stream_length = DEFAULT_STREAM_LENGTH;
+    size_t checkpoint;
+    size_t i;
+
+    if (argc > 1) {
+        window = strtoul(argv[1], NULL, 10);
+    }
+    if (argc > 2) {
+        stream_length = strtoul(argv[2], NULL, 10);
+    }
+
+    log_file = fopen(LOG_FILE_NAME, "w+");
+    if (log_file == NULL) {
+        fprintf(stderr, "Error: unable to open log file.\n");
+        log = FALSE;
+    }
+
+    srand(7);
+
+    printAndLog(log_file, log, "Beginning append latency benchmarks for StreamingCurve\n");
+    printAndLog(log_file, log, "window: %zu anchor points\n", window);
+    printAndLog(log_file, log, "appends timed per checkpoint: %d\n", BLOCK_SIZE);
+
+    //*************************************************************************
+    printAndLog(log_file, log, "\nStreamingCurve2D::append:\n");
+    //*************************************************************************
+    StreamingCurve2D stream(window);
+    volatile BEZ_DTYPE sink = 0.;
+
+    i = 0;
+    for (checkpoint = BLOCK_SIZE; checkpoint <= stream_length; checkpoint *= 10) {
+        for (; i + BLOCK_SIZE < checkpoint; i++) {
+            stream.append(streamPoint(i));
+        }
+
+        timespec_get(&start, TIME_UTC);
+        for (; i < checkpoint; i++) {
+            stream.append(streamPoint(i));
+        }
+        timespec_get(&end, TIME_UTC);
+        sink = sink + stream.getPositionAt(1.)[0];
+
+        printAndLog(log_file, log, "after %10zu appends, nanoseconds per append: %f\n",
+            checkpoint, timespec2sec(start, end) / BLOCK_SIZE * 1e9);
+    }
+
+    //*************************************************************************
+    printAndLog(log_file, log, "\nCurve2D::addAnchor and removeAnchor at the same window:\n");
+    //*************************************************************************
+    std::vector<bezVect2D> anchors(window);
+    size_t block = BLOCK_SIZE / 100;
+
+    for (i = 0; i < window; i++) {
+        anchors[i] = streamPoint(i);
+    }
+    Curve2D curve(anchors);
+
+    timespec_get(&start, TIME_UTC);
+    for (i = 0; i < block; i++) {
+        curve.removeAnchor(0);
+        curve.addAnchor(streamPoint(window + i), window - 1);
+        sink = sink + curve.getPositionAt(1.)[0];
+    }
+    timespec_get(&end, TIME_UTC);
+
+    printAndLog(log_file, log, "nanoseconds per append:                         %f\n",
+        timespec2sec(start, end) / block * 1e9);
+
+    printAndLog(log_file, log, "\n\nThis concludes the append latency benchmarks for StreamingCurve\n");
+
+    if (log) {
+        fclose(log_file);
+    }
+
+    return 0;
+}
@@ -0,0 +1,165 @@
+/*
+ * svg_benchmark.cpp
+ *
+ * Measures the throughput of SvgPathParser on a large generated path, parsed
+ * whole and in chunks as read from a file, and prints the results to the
+ * screen while logging them to a file.
+ *
+ * Usage: benchmark-svg_path [megabytes] [harness options, see benchInit]
+ */
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <time.h>
+#include <math.h>
+
+#include <string>
+
+#include "svg_path.h"
+#include "benchmark.h"
+
+
+// default size of the generated path data in megabytes
+#define DEFAULT_MEGABYTES 16
+
+// size of the chunks fed to the parser, like reads from a file
+#define CHUNK_SIZE 65536
+
+// name of file to log the benchmarks to
+#define LOG_FILE_NAME "svg_benchmark.log"
+
+
+/*
+ * function: randomCoordinate
+ *
+ * Returns a coordinate formatted the way drawing tools write them.
+ */
+const char* randomCoordinate(char* buffer) {
+    snprintf(buffer, 32, "%.3f", (double)(rand()) / RAND_MAX * 200. - 100.);
+    return buffer;
+}
+
+/*
+ * function: printMegabytes
+ *
+ * Prints and logs the throughput of the last benchmark, whose operations are
+ * bytes, if it ran since result_count was read.
+ */
+void printMegabytes(const benchHarness& harness, size_t result_count) {
+    if (harness.result_count > result_count) {
+        printAndLog(harness.log_file, harness.log, "megabytes per second:             %f\n",
+            1e9 / harness.stats.median / 1048576.);
+    }
+}
+
+
+int main(int argc, char* argv[]) {
+    benchHarness harness;
+    size_t megabytes = DEFAULT_MEGABYTES;
+    size_t i, j, count;
+    char buffer[32];
+    const char commands[] = "LlCcSsQqTtHhVv";
+    const int arg_counts[] = {2, 2, 6, 6, 4, 4, 4, 4, 2, 2, 1, 1, 1, 1};
+
+    benchInit(&harness, LOG_FILE_NAME, &argc, argv);
+    if (argc > 1) {
+        megabytes = strtoul(argv[1], NULL, 10);
+    }
+
+    // random commands with a new subpath every 64 of them
+    std::string data;
+    srand(7);
+    for (i = 0; data.size() < megabytes << 20; i++) {
+        int c = rand() % 14;
+
+        if (i % 64 == 0) {
+            data += i == 0 ? "M" : "Z M";
+            data += randomCoordinate(buffer);
+            data += ',';
+            data += randomCoordinate(buffer);
+        }
+        data += ' ';
+        data += commands[c];
+        for (j = 0; j < (size_t)(arg_counts[c]); j++) {
+            data += j == 0 ? "" : (j % 2 ? "," : " ");
+            data += randomCoordinate(buffer);
+        }
+    }
+
+    PathSegments2D path;
+    parseSvgPath(data.data(), data.size(), path);
+
+    printAndLog(harness.log_file, harness.log, "Beginning parse benchmarks for SvgPathParser\n");
+    printAndLog(harness.log_file, harness.log, "megabytes of path data: %f\n", data.size() / 1048576.);
+    printAndLog(harness.log_file, harness.log, "cubic Bezier curves: %zu\n", path.segmentCount());
+    printAndLog(harness.log_file, harness.log, "quadratic Bezier curves: %zu\n", path.quadraticCount());
+    printAndLog(harness.log_file, harness.log, "operations are bytes of path data\n");
+
+    //*************************************************************************
+    printAndLog(harness.log_file, harness.log, "\nWhole path in one feed:\n");
+    //*************************************************************************
+    count = harness.result_count;
+    benchmarkThisCode(harness, "parse/whole", (double)(data.size()),
+        path.clear();
+        parseSvgPath(data.data(), data.size(), path);
+    )
+    printMegabytes(harness, count);
+    if (harness.result_count > count) {
+        printAndLog(harness.log_file, harness.log, "million segments per second:      %f\n",
+            (double)(path.segmentCount() + path.quadraticCount()) /
+            (harness.stats.median * (double)(data.size())) * 1e3);
+    }
+
+    //*************************************************************************
+    printAndLog(harness.log_file, harness.log, "\n\nChunks of %d bytes:\n", CHUNK_SIZE);
+    //*************************************************************************
+    count = harness.result_count;
+    benchmarkThisCode(harness, "parse/chunked", (double)(data.size()),
+        path.clear();
+        SvgPathParser parser(path);
+        for (j = 0; j < data.size(); j += CHUNK_SIZE) {
+            parser.feed(data.data() + j, data.size() - j < CHUNK_SIZE ? data.size() - j : CHUNK_SIZE);
+        }
+        parser.finish();
+    )
+    printMegabytes(harness, count);
+
+    //*************************************************************************
+    printAndLog(harness.log_file, harness.log, "\n\nQuadratics elevated to cubics:\n");
+    //*************************************************************************
+    count = harness.result_count;
+    benchmarkThisCode(harness, "parse/elevated", (double)(data.size()),
+        path.clear();
+        parseSvgPath(data.data(), data.size(), path, true);
+    )
+    printMegabytes(harness, count);
+
+    //*************************************************************************
+    printAndLog(harness.log_file, harness.log, "\n\nNumbers only, with strtof:\n");
+    //*************************************************************************
+    // reference for the cost of number conversion alone
+    volatile BEZ_DTYPE sink = 0.;
+    count = harness.result_count;
+    benchmarkThisCode(harness, "strtof", (double)(data.size()),
+        const char* p = data.c_str();
+        char* number_end;
+        while (*p) {
+            if ((*p >= '0' && *p <= '9') || *p == '-' || *p == '.') {
+                sink = sink + strtof(p, &number_end);
+                p = number_end;
+            }
+            else {
+                p++;
+            }
+        }
+    )
+    printMegabytes(harness, count);
+
+    printAndLog(harness.log_file, harness.log, "\n\nThis concludes the parse benchmarks for SvgPathParser\n");
+
+    benchFinish(&harness);
+
+    return 0;
+}
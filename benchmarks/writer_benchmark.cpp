@@ -0,0 +1,143 @@
+/*
+ * writer_benchmark.cpp
+ *
+ * Measures exporting a large spline as SVG path data with PathWriter against
+ * formatting it with fprintf, and prints the results to the screen while
+ * logging them to a file.
+ *
+ * Usage: benchmark-path_writer [anchor_count] [harness options, see benchInit]
+ */
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <time.h>
+#include <math.h>
+
+#include <vector>
+
+#include "curve.h"
+#include "path_writer.h"
+#include "benchmark.h"
+
+
+// default number of anchor points in the exported spline
+#define DEFAULT_ANCHOR_COUNT 200000
+
+// decimals written by the reduced precision exports
+#define PRECISION 3
+
+// name of the file the exports are written to
+#define OUTPUT_FILE_NAME "/dev/null"
+
+// name of file to log the benchmarks to
+#define LOG_FILE_NAME "writer_benchmark.log"
+
+
+/*
+ * function: printExport
+ *
+ * Prints and logs the throughput and size of the last export, whose
+ * operations are points, if it ran since result_count was read.
+ */
+void printExport(const benchHarness& harness, size_t result_count, size_t points, size_t bytes) {
+    if (harness.result_count > result_count) {
+        printAndLog(harness.log_file, harness.log, "megabytes per second:             %f\n",
+            (double)(bytes) / (harness.stats.median * (double)(points)) * 1e9 / 1048576.);
+        printAndLog(harness.log_file, harness.log, "bytes per export:                 %zu\n", bytes);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    benchHarness harness;
+    size_t anchor_count = DEFAULT_ANCHOR_COUNT;
+    size_t i, j, count;
+    size_t bytes = 0;
+
+    benchInit(&harness, LOG_FILE_NAME, &argc, argv);
+    if (argc > 1) {
+        anchor_count = strtoul(argv[1], NULL, 10);
+    }
+
+    FILE* output = fopen(OUTPUT_FILE_NAME, "w");
+    if (output == NULL) {
+        fprintf(stderr, "Error: unable to open output file.\n");
+        return 1;
+    }
+
+    std::vector<bezVect2D> anchors(anchor_count);
+    srand(7);
+    for (i = 0; i < anchor_count; i++) {
+        anchors[i][0] = (BEZ_DTYPE)(rand()) / (BEZ_DTYPE)(RAND_MAX) * 100.;
+        anchors[i][1] = (BEZ_DTYPE)(rand()) / (BEZ_DTYPE)(RAND_MAX) * 100.;
+    }
+    Curve2D curve(anchors);
+    curve.solvePending();
+
+    double points = (double)(curve.points.size());
+
+    printAndLog(harness.log_file, harness.log, "Beginning export benchmarks for PathWriter\n");
+    printAndLog(harness.log_file, harness.log, "anchor points: %zu\n", anchor_count);
+    printAndLog(harness.log_file, harness.log, "operations are points written\n");
+
+    //*************************************************************************
+    printAndLog(harness.log_file, harness.log, "\nfprintf with %%.9g:\n");
+    //*************************************************************************
+    count = harness.result_count;
+    benchmarkThisCode(harness, "fprintf/round_trip", points,
+        bytes = fprintf(output, "M%.9g,%.9g", curve.points[0][0], curve.points[0][1]);
+        for (j = 1; j < curve.points.size(); j++) {
+            bytes += fprintf(output, j == 1 ? "C%.9g,%.9g" : " %.9g,%.9g", curve.points[j][0], curve.points[j][1]);
+        }
+        fflush(output);
+    )
+    printExport(harness, count, curve.points.size(), bytes);
+
+    //*************************************************************************
+    printAndLog(harness.log_file, harness.log, "\n\nPathWriter, shortest round trip:\n");
+    //*************************************************************************
+    count = harness.result_count;
+    benchmarkThisCode(harness, "PathWriter/round_trip", points,
+        PathWriter writer(fileno(output));
+        writer.writeSvgPath(curve);
+        writer.flush();
+        bytes = writer.bytesWritten();
+    )
+    printExport(harness, count, curve.points.size(), bytes);
+
+    //*************************************************************************
+    printAndLog(harness.log_file, harness.log, "\n\nfprintf with %%.%df:\n", PRECISION);
+    //*************************************************************************
+    count = harness.result_count;
+    benchmarkThisCode(harness, "fprintf/fixed", points,
+        bytes = fprintf(output, "M%.*f,%.*f", PRECISION, curve.points[0][0], PRECISION, curve.points[0][1]);
+        for (j = 1; j < curve.points.size(); j++) {
+            bytes += fprintf(output, j == 1 ? "C%.*f,%.*f" : " %.*f,%.*f",
+                             PRECISION, curve.points[j][0], PRECISION, curve.points[j][1]);
+        }
+        fflush(output);
+    )
+    printExport(harness, count, curve.points.size(), bytes);
+
+    //*************************************************************************
+    printAndLog(harness.log_file, harness.log, "\n\nPathWriter, %d decimals:\n", PRECISION);
+    //*************************************************************************
+    count = harness.result_count;
+    benchmarkThisCode(harness, "PathWriter/fixed", points,
+        PathWriter writer(fileno(output));
+        writer.setPrecision(PRECISION);
+        writer.writeSvgPath(curve);
+        writer.flush();
+        bytes = writer.bytesWritten();
+    )
+    printExport(harness, count, curve.points.size(), bytes);
+
+    fclose(output);
+
+    printAndLog(harness.log_file, harness.log, "\n\nThis concludes the export benchmarks for PathWriter\n");
+
+    benchFinish(&harness);
+
+    return 0;
+}
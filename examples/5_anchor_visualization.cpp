@@ -112,7 +112,6 @@ int main() {
                 v[1] = cursor_y;
                 c1.setAnchor(v, edit_point);
             }
-            c1.updateControlPoints();
         }
         else {
             edit_point = -1;
@@ -125,6 +124,10 @@ int main() {
             drawCircle(v[0], v[1], CONTROL_RADIUS, MATH_TAU * .05);
         }
 
+        // B_points is internal, so bring it up to date before reading it
+        // directly. This does nothing unless an anchor moved.
+        c1.updateControlPoints();
+
         bezVect2D v2 = c1.getAnchor(0);
         glColor3f(.6f, .1f, .2f);
         drawCircle(v2[0], v2[1], CONTROL_RADIUS * .5, MATH_TAU * .05);
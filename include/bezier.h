@@ -16,6 +16,31 @@
 #define BEZ_DTYPE float
 #define BEZ_SQRT_FUNC(x) sqrtf(x)
 
+// Most times bez2ArcLength and bez3ArcLength halve a curve. Near a cusp the
+// halves of a curve a few units in the last place across can round back to
+// the curve itself, so without a limit the recursion may never end. Past
+// 24 halvings a float curve has no more precision to resolve.
+#define BEZ_ARC_LENGTH_MAX_DEPTH 24
+
+// Math policy of bez2IsFlat, the arc length functions, bez2BoundingBox and
+// the segmentBoundingBoxes kernels of curve_layout.h, see bezier_math.h.
+// BEZ_MATH_PRECISE takes square roots with BEZ_SQRT_FUNC and divides, so
+// each operation is correctly rounded. BEZ_MATH_FAST uses bezFastSqrt and
+// bezFastReciprocal instead, which are a few units in the last place off but
+// avoid the long latency of sqrt and division. Define it when building the
+// library, for example with the BEZ_FAST_MATH CMake option.
+#define BEZ_MATH_PRECISE 0
+#define BEZ_MATH_FAST 1
+#ifndef BEZ_MATH_POLICY
+#define BEZ_MATH_POLICY BEZ_MATH_PRECISE
+#endif
+
+// Largest errors of the fast math functions in units in the last place, for
+// any hardware estimate within the 1.5 * 2^-12 relative error x86 specifies
+#define BEZ_FAST_RSQRT_MAX_ULP 5
+#define BEZ_FAST_SQRT_MAX_ULP 5
+#define BEZ_FAST_RECIPROCAL_MAX_ULP 4
+
 // Allow linkage with C++ code
 #ifdef __cplusplus
 extern "C" {
@@ -276,6 +301,59 @@ void bez2DerivativeLinear(BEZ_DTYPE x0, BEZ_DTYPE y0,
                           BEZ_DTYPE *x0_out, BEZ_DTYPE *y0_out);
 
 
+//*****************************************************************************
+//* MATH
+//*****************************************************************************
+
+/*
+ * function: bezFastRsqrt
+ *
+ * Returns 1 / sqrt(x) within BEZ_FAST_RSQRT_MAX_ULP, refining the hardware
+ * estimate with one Newton step. Falls back to BEZ_SQRT_FUNC without SSE or
+ * when BEZ_DTYPE is not float.
+ *
+ * Args:
+ *   x: finite value no smaller than the smallest normal float
+ */
+BEZ_DTYPE bezFastRsqrt(BEZ_DTYPE x);
+
+/*
+ * function: bezFastSqrt
+ *
+ * Returns sqrt(x) within BEZ_FAST_SQRT_MAX_ULP, as x times the estimate of
+ * 1 / sqrt(x) refined with one Newton step. Values below the smallest normal
+ * float, including zero, give zero, which is off by less than 1.1e-19.
+ * Falls back to BEZ_SQRT_FUNC without SSE or when BEZ_DTYPE is not float.
+ *
+ * Args:
+ *   x: finite value, at least zero
+ */
+BEZ_DTYPE bezFastSqrt(BEZ_DTYPE x);
+
+/*
+ * function: bezFastSqrt4
+ *
+ * Computes bezFastSqrt of four values at once with SSE.
+ *
+ * Args:
+ *   in: four values as for bezFastSqrt
+ *   out: where the four square roots are stored, may be in
+ */
+void bezFastSqrt4(const BEZ_DTYPE* in, BEZ_DTYPE* out);
+
+/*
+ * function: bezFastReciprocal
+ *
+ * Returns 1 / x within BEZ_FAST_RECIPROCAL_MAX_ULP, refining the hardware
+ * estimate with one Newton step. Falls back to division without SSE or when
+ * BEZ_DTYPE is not float.
+ *
+ * Args:
+ *   x: normal value of magnitude below 2^126
+ */
+BEZ_DTYPE bezFastReciprocal(BEZ_DTYPE x);
+
+
 //*****************************************************************************
 //* BOUNDING BOX
 //*****************************************************************************
@@ -0,0 +1,117 @@
+/*
+ * bezier_math.h
+ *
+ * Defines the square roots and reciprocals the kernels of the library take,
+ * following BEZ_MATH_POLICY in bezier.h, so that the kernels of bezier.c and
+ * the layout kernels of curve_layout.cpp round alike. Internal to the
+ * library: applications call the math functions of bezier.h instead.
+ */
+
+#ifndef BEZIER_BEZIER_MATH_H
+#define BEZIER_BEZIER_MATH_H
+
+#include <float.h>
+#include <math.h>
+
+#include "bezier.h"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define BEZ_HAVE_SSE
+#endif
+
+
+//*****************************************************************************
+//* MATH
+//*****************************************************************************
+
+#if defined(BEZ_HAVE_SSE)
+
+/*
+ * function: bezFastSqrtPs
+ *
+ * Returns bezFastSqrt of each of four floats: x times the estimate of
+ * 1 / sqrt(x) refined with one Newton step, or zero below the smallest
+ * normal float.
+ *
+ * Args:
+ *   x: finite values, at least zero
+ */
+static inline __m128 bezFastSqrtPs(__m128 x) {
+    __m128 r = _mm_rsqrt_ps(x);
+    __m128 s = _mm_mul_ps(x, r);
+    __m128 h = _mm_mul_ps(_mm_set1_ps(.5f), r);
+
+    // s + (x - s^2) / (2 sqrt(x)) squares the relative error of s
+    s = _mm_add_ps(s, _mm_mul_ps(h, _mm_sub_ps(x, _mm_mul_ps(s, s))));
+
+    // the estimate of 1 / sqrt(0) is infinite
+    return _mm_and_ps(s, _mm_cmpge_ps(x, _mm_set1_ps(FLT_MIN)));
+}
+
+/*
+ * function: bezFastReciprocalPs
+ *
+ * Returns bezFastReciprocal of each of four floats: the estimate of 1 / x
+ * refined with one Newton step.
+ *
+ * Args:
+ *   x: normal values of magnitude below 2^126
+ */
+static inline __m128 bezFastReciprocalPs(__m128 x) {
+    __m128 r = _mm_rcp_ps(x);
+
+    // r (1 + (1 - x r)) squares the relative error of r
+    return _mm_add_ps(r, _mm_mul_ps(r, _mm_sub_ps(_mm_set1_ps(1.f), _mm_mul_ps(x, r))));
+}
+
+#endif
+
+/*
+ * function: bezKernelSqrt4
+ *
+ * Computes bezFastSqrt4 of four values the kernels just computed. Gathering
+ * them from registers rather than loading them from memory avoids waiting on
+ * four separate stores, which costs more than the square roots.
+ *
+ * Args:
+ *   in: four values as for bezFastSqrt
+ *   out: where the four square roots are stored, may be in
+ */
+static inline void bezKernelSqrt4(const BEZ_DTYPE* in, BEZ_DTYPE* out) {
+#if defined(BEZ_HAVE_SSE)
+    if (sizeof(BEZ_DTYPE) == sizeof(float)) {
+        __m128 x = _mm_setr_ps((float)(in[0]), (float)(in[1]), (float)(in[2]), (float)(in[3]));
+
+        _mm_storeu_ps((float*)(out), bezFastSqrtPs(x));
+        return;
+    }
+#endif
+    bezFastSqrt4(in, out);
+}
+
+
+/*
+ * function-like macros: BEZ_KERNEL_SQRT, BEZ_KERNEL_SQRT4, BEZ_KERNEL_RECIPROCAL
+ *
+ * BEZ_KERNEL_SQRT(x) and BEZ_KERNEL_RECIPROCAL(x) return the square root and
+ * reciprocal of x, and BEZ_KERNEL_SQRT4(in, out) stores the square roots of
+ * four values, with BEZ_SQRT_FUNC and division under BEZ_MATH_PRECISE and
+ * with the fast math functions under BEZ_MATH_FAST.
+ */
+#if BEZ_MATH_POLICY == BEZ_MATH_FAST
+#define BEZ_KERNEL_SQRT(x) bezFastSqrt(x)
+#define BEZ_KERNEL_SQRT4(in, out) bezKernelSqrt4(in, out)
+#define BEZ_KERNEL_RECIPROCAL(x) bezFastReciprocal(x)
+#else
+#define BEZ_KERNEL_SQRT(x) BEZ_SQRT_FUNC(x)
+#define BEZ_KERNEL_SQRT4(in, out) do {\
+    (out)[0] = BEZ_SQRT_FUNC((in)[0]);\
+    (out)[1] = BEZ_SQRT_FUNC((in)[1]);\
+    (out)[2] = BEZ_SQRT_FUNC((in)[2]);\
+    (out)[3] = BEZ_SQRT_FUNC((in)[3]);\
+} while (0)
+#define BEZ_KERNEL_RECIPROCAL(x) (1. / (x))
+#endif
+
+#endif
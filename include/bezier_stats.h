@@ -0,0 +1,128 @@
+/*
+ * bezier_stats.h
+ *
+ * Defines optional counters of the work done by the adaptive procedures of
+ * the library, such as the subdivisions of bez2ArcLength and the solves of
+ * Curve::updateControlPoints, so that slow calls can be traced back to the
+ * curves that caused them.
+ *
+ * The counters are only updated when the library is compiled with
+ * BEZ_ENABLE_STATS defined, for example with the CMake option of the same
+ * name. Otherwise the counting macros expand to nothing and the snapshot is
+ * always zero.
+ */
+
+#ifndef BEZIER_BEZIER_STATS_H
+#define BEZIER_BEZIER_STATS_H
+
+// Allow linkage with C++ code
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+//*****************************************************************************
+//* STATS
+//*****************************************************************************
+
+/*
+ * struct: bezStats
+ *
+ * Counts of the work done by one thread since it started or last called
+ * bezStatsReset. Work done by pool threads on behalf of a call is counted
+ * on the thread that made the call.
+ */
+typedef struct {
+    // bez2ArcLength and bez3ArcLength
+    unsigned long long arc_length_calls;
+    unsigned long long arc_length_leaves;  // sub-curves measured as flat
+    unsigned long long arc_length_max_depth;  // deepest subdivision
+    unsigned long long arc_length_depth_limited;  // leaves cut off at
+                                                  // BEZ_ARC_LENGTH_MAX_DEPTH
+
+    // bez2BoundingBox, once per axis
+    unsigned long long bounding_box_calls;
+    unsigned long long bounding_box_extrema[3];  // axes with 0, 1 or 2
+                                                 // extrema inside the curve
+    unsigned long long bounding_box_degenerate;  // axes whose derivative is
+                                                 // not quadratic, counted in
+                                                 // bounding_box_extrema by
+                                                 // its linear root, if any
+
+    // Curve::updateControlPoints and the solves it and the reads trigger,
+    // and the solves of CurveSet::rebuild
+    unsigned long long update_calls;
+    unsigned long long full_solves;
+    unsigned long long local_solves;
+    unsigned long long solved_anchors;  // rows of all solves together
+    unsigned long long max_solved_anchors;  // rows of the largest solve
+
+    // Evaluations by the spline classes and layout kernels, one per point
+    unsigned long long evaluations;
+} bezStats;
+
+
+/*
+ * function: bezStatsSnapshot
+ *
+ * Copies the counters of the calling thread.
+ *
+ * Args:
+ *   out: where to copy them
+ */
+void bezStatsSnapshot(bezStats* out);
+
+/*
+ * function: bezStatsReset
+ *
+ * Sets the counters of the calling thread to zero.
+ */
+void bezStatsReset(void);
+
+/*
+ * function: bezStatsLocal
+ *
+ * Returns the counters of the calling thread, for the counting macros.
+ */
+bezStats* bezStatsLocal(void);
+
+
+/*
+ * function-like macros: BEZ_STATS_ADD, BEZ_STATS_MAX
+ *
+ * BEZ_STATS_ADD(field, n) adds n to a counter of the calling thread, and
+ * BEZ_STATS_MAX(field, n) raises it to n if it is lower. Both do nothing,
+ * without evaluating n, unless BEZ_ENABLE_STATS is defined.
+ */
+#if defined(BEZ_ENABLE_STATS)
+#define BEZ_STATS_ADD(field, n) (bezStatsLocal()->field += (unsigned long long)(n))
+#define BEZ_STATS_MAX(field, n) do {\
+    bezStats* bez_stats = bezStatsLocal();\
+    if ((unsigned long long)(n) > bez_stats->field) {\
+        bez_stats->field = (unsigned long long)(n);\
+    }\
+} while (0)
+#else
+#define BEZ_STATS_ADD(field, n) ((void)0)
+#define BEZ_STATS_MAX(field, n) ((void)0)
+#endif
+
+/*
+ * function-like macro: BEZ_STATS_SOLVE
+ *
+ * BEZ_STATS_SOLVE(field, rows) counts one solve of the given number of rows
+ * in field, which is full_solves or local_solves.
+ */
+#define BEZ_STATS_SOLVE(field, rows) do {\
+    BEZ_STATS_ADD(field, 1);\
+    BEZ_STATS_ADD(solved_anchors, rows);\
+    BEZ_STATS_MAX(max_solved_anchors, rows);\
+} while (0)
+
+
+// Finish extern "C"
+#ifdef __cplusplus
+}
+#endif
+
+#endif
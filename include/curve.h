@@ -1,36 +1,146 @@
 /*
  * curve.h
  *
- * Defines the interface for the classes Curve2D and Curve3D.
+ * Defines the interface for the class template Curve and its instantiations
+ * Curve2D and Curve3D.
  */
 
 #ifndef BEZIER_CURVE_H
 #define BEZIER_CURVE_H
 
 #include <array>
+#include <memory_resource>
 #include <vector>
 
 //#define BEZ_DIMS 2
 #define BEZ_DTYPE float
 
+// Number of chords sampled per Bezier curve when building the arc length index
+#ifndef BEZ_ARC_SAMPLES
+#define BEZ_ARC_SAMPLES 16
+#endif
+
+// Minimum number of anchor points for updateControlPoints to use all cores
+#ifndef BEZ_PARALLEL_SOLVE_THRESHOLD
+#define BEZ_PARALLEL_SOLVE_THRESHOLD 131072
+#endif
+
+// Rows re-solved on each side of the edited anchor points by a partial update
+#ifndef BEZ_LOCAL_SOLVE_MARGIN
+#define BEZ_LOCAL_SOLVE_MARGIN 32
+#endif
+
 
 typedef std::array<BEZ_DTYPE, 2> bezVect2D;
 typedef std::array<BEZ_DTYPE, 3> bezVect3D;
 
+class ThreadPool;
+
+
+/*
+ * enum: bezParameterization
+ *
+ * How the parameter t of a spline is divided among its Bezier curves.
+ *   BEZ_UNIFORM: every Bezier curve spans the same range of t
+ *   BEZ_CHORD_LENGTH: in proportion to the distance between its anchor points
+ *   BEZ_CENTRIPETAL: in proportion to the square root of that distance
+ */
+enum bezParameterization {
+    BEZ_UNIFORM,
+    BEZ_CHORD_LENGTH,
+    BEZ_CENTRIPETAL
+};
+
+
+/*
+ * struct: ArcLengthCursor
+ *
+ * Remembers where the previous arc length lookup ended so that a sequence of
+ * lookups with non-decreasing distances can resume from there instead of
+ * searching the whole spline again.
+ */
+struct ArcLengthCursor {
+    std::size_t sample = 0;  // index of the arc length sample last visited
+};
+
+
+/*
+ * function: bezEvaluateSegment
+ *
+ * Returns the coordinates of the Bezier curve with points p0 ... p3
+ * evaluated at t, with the same definition equation as bez2Evaluate and
+ * bez3Evaluate. Every spline class evaluates through it, so they agree on
+ * each point. Callers count the evaluations, see bezier_stats.h.
+ *
+ * Args:
+ *   p0, p1, p2, p3: anchor point, control points and anchor point
+ *   t: parameter value local to the Bezier curve, in range [0, 1]
+ */
+template <std::size_t Dim, typename T>
+inline std::array<T, Dim> bezEvaluateSegment(const std::array<T, Dim>& p0,
+                                             const std::array<T, Dim>& p1,
+                                             const std::array<T, Dim>& p2,
+                                             const std::array<T, Dim>& p3, T t) {
+    T t_squared = t * t;
+    T t_cubed = t_squared * t;
+    T omt = 1. - t;  // one minus t
+    T omt_squared = omt * omt;
+    T omt_cubed = omt_squared * omt;
+    T coef1 = 3. * t * omt_squared;
+    T coef2 = 3. * t_squared * omt;
+    std::array<T, Dim> out;
+    std::size_t k;
+
+    for (k = 0; k < Dim; k++) {
+        out[k] = p0[k] * omt_cubed + p1[k] * coef1 + p2[k] * coef2 + p3[k] * t_cubed;
+    }
+
+    return out;
+}
+
 
 //*****************************************************************************
-//* CURVE2D
+//* CURVE
 //*****************************************************************************
 
 /*
- * class: Curve2D
+ * class: Curve
+ *
+ * Implements a cubic Bezier spline with C2 continuity in Dim dimensions.
+ * Interface allows interaction with the anchor points, and the control points
+ * are determined internally.
+ *
+ * Edits to the anchor points only mark them dirty. The control points are
+ * recomputed once, on the next read, for all edits made since the last one.
+ * Such a read writes the spline, so const reads are only safe from several
+ * threads at once when no edit is pending: call updateControlPoints after
+ * the last edit and before sharing the spline between threads.
+ *
+ * A closed spline has one more Bezier curve, from the final anchor point back
+ * to the first, and is C2 continuous there as well.
  *
- * Implements a cubic Bezier spline with C2 continuity. Interface allows
- * interaction with the anchor points, and the control points are determined
- * internally.
+ * With a non-uniform parameterization the spline is C2 continuous with
+ * respect to the global t, and the Bezier curve containing a given t is found
+ * through a uniform grid of buckets over the knots in expected O(1).
+ *
+ * All storage comes from the std::pmr::memory_resource given at construction,
+ * so short-lived splines can be allocated from a FrameArena. Copy
+ * construction without a resource uses the default resource, and assignment
+ * keeps the resource of the destination.
+ *
+ * The member functions are defined in curve.cpp and explicitly instantiated
+ * for Curve2D and Curve3D.
+ *
+ * Template args:
+ *   Dim: number of coordinates per point
+ *   T: floating point type of the coordinates
  */
-class Curve2D {
+template <std::size_t Dim, typename T>
+class Curve {
 public:
+    typedef std::array<T, Dim> Vect;  // Type of a single point
+
+
     //*************************************************************************
     // Constructors/Destructors
     //*************************************************************************
@@ -40,7 +150,17 @@ public:
      *
      * Constructs an empty spline.
      */
-    Curve2D(void);
+    Curve(void);
+
+    /*
+     * constructor
+     *
+     * Constructs an empty spline that allocates from the given resource.
+     *
+     * Args:
+     *   resource: memory resource for all storage of the spline
+     */
+    explicit Curve(std::pmr::memory_resource* resource);
 
     /*
      * constructor
@@ -49,8 +169,30 @@ public:
      *
      * Args:
      *   anchor_points: ordered anchor points from which to construct spline
+     *   closed: whether to join the final anchor point back to the first
+     *   parameterization: how t is divided among the Bezier curves
+     *   resource: memory resource for all storage of the spline
      */
-    Curve2D(const std::vector<bezVect2D>& anchor_points);
+    Curve(const std::vector<Vect>& anchor_points, bool closed = false,
+          bezParameterization parameterization = BEZ_UNIFORM,
+          std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    /*
+     * copy constructor
+     *
+     * Constructs a copy of the given spline that allocates from the given
+     * resource.
+     *
+     * Args:
+     *   other: spline to copy
+     *   resource: memory resource for all storage of the copy
+     */
+    Curve(const Curve& other, std::pmr::memory_resource* resource);
+
+    Curve(const Curve& other) = default;
+    Curve(Curve&& other) = default;
+    Curve& operator=(const Curve& other) = default;
+    Curve& operator=(Curve&& other) = default;
 
 
     //*************************************************************************
@@ -60,7 +202,8 @@ public:
     /*
      * function: getPositionAt
      *
-     * Returns the coordinates of the spline evaluated at the given t.
+     * Returns the coordinates of the spline evaluated at the given t. A
+     * closed spline is periodic in t, so any t is accepted.
      *
      * Args:
      *   t: parameter value in the range [0, 1]
@@ -68,7 +211,7 @@ public:
      * Throws:
      *   std::out_of_range if 0 <= i <= 1 is not satisfied
      */
-    bezVect2D getPositionAt(BEZ_DTYPE t) const;
+    Vect getPositionAt(T t) const;
 
     /*
      * function: anchorCount
@@ -77,6 +220,27 @@ public:
      */
     std::size_t anchorCount(void) const;
 
+    /*
+     * function: getResource
+     *
+     * Returns the memory resource the spline allocates from.
+     */
+    std::pmr::memory_resource* getResource(void) const;
+
+    /*
+     * function: isClosed
+     *
+     * Returns whether the final anchor point is joined back to the first.
+     */
+    bool isClosed(void) const;
+
+    /*
+     * function: getParameterization
+     *
+     * Returns how t is divided among the Bezier curves.
+     */
+    bezParameterization getParameterization(void) const;
+
     /*
      * function: getAnchor
      *
@@ -88,7 +252,7 @@ public:
      * Throws:
      *   std::out_of_range if 0 <= i < anchorCount() is not satisfied
      */
-    const bezVect2D& getAnchor(std::size_t i) const;
+    const Vect& getAnchor(std::size_t i) const;
 
     /*
      * function: getLength
@@ -102,14 +266,55 @@ public:
      * Throws:
      *   std::out_of_range if 0 <= t0,t1 <= 1 is not satified
      */
-    BEZ_DTYPE getLength(BEZ_DTYPE t0, BEZ_DTYPE t1) const;
+    T getLength(T t0, T t1) const;
 
     /*
      * function: getLength
      *
      * Returns the total length of the spline.
      */
-    BEZ_DTYPE getLength(void) const;
+    T getLength(void) const;
+
+    /*
+     * function: positionAtDistance
+     *
+     * Returns the coordinates of the point at the given distance along the
+     * spline, measured from the first anchor point. On a closed spline the
+     * distance wraps around instead of being clamped.
+     *
+     * Args:
+     *   s: distance along the spline, clamped to [0, getLength()]
+     */
+    Vect positionAtDistance(T s) const;
+
+    /*
+     * function: positionAtDistance
+     *
+     * Same as above, but resumes the search from the given cursor and leaves
+     * the cursor at the sample containing s. Advancing s monotonically costs
+     * amortized O(1) per call; moving backwards falls back to a binary search.
+     *
+     * Args:
+     *   s: distance along the spline, clamped to [0, getLength()]
+     *   cursor: search position, initially default-constructed
+     */
+    Vect positionAtDistance(T s, ArcLengthCursor& cursor) const;
+
+    /*
+     * function: resampleByArcLength
+     *
+     * Replaces the contents of out with points spaced at equal distances
+     * along the spline, starting at the first anchor point. The final anchor
+     * point is only included if the length is a multiple of spacing.
+     *
+     * Args:
+     *   spacing: distance between consecutive points
+     *   out: vector to fill with the sampled points
+     *
+     * Throws:
+     *   std::invalid_argument if spacing <= 0
+     */
+    void resampleByArcLength(T spacing, std::vector<Vect>& out) const;
 
     /*
      * function: split
@@ -126,7 +331,7 @@ public:
      * Throws:
      *   std::out_of_range if 0 <= t <= 1 is not satisfied
      */
-    void split(BEZ_DTYPE t, Curve2D& c1, Curve2D& c2) const;
+    void split(T t, Curve& c1, Curve& c2) const;
 
 
     //*************************************************************************
@@ -136,7 +341,8 @@ public:
     /*
      * function: addAnchor
      *
-     * Adds an anchor point at the given index.
+     * Adds an anchor point at the given index. The control points are
+     * updated lazily.
      *
      * Args:
      *   position: the position of the new anchor point
@@ -145,12 +351,13 @@ public:
      * Throws:
      *   std::out_of_range if 0 <= i <= anchorCount() is not satisfied
      */
-    void addAnchor(bezVect2D position, std::size_t i);
+    void addAnchor(Vect position, std::size_t i);
 
     /*
      * function: removeAnchor
      *
-     * Removes the anchor point at the given index from the spline.
+     * Removes the anchor point at the given index from the spline. The
+     * control points are updated lazily.
      *
      * Args:
      *   i: the index of the anchor point to remove
@@ -163,7 +370,8 @@ public:
     /*
      * function: setAnchor
      *
-     * Sets the new position of the anchor point at the given index.
+     * Sets the new position of the anchor point at the given index. The
+     * control points are updated lazily.
      *
      * Args:
      *   position: new position for the anchor point
@@ -172,7 +380,7 @@ public:
      * Throws:
      *   std::out_of_range if 0 <= i < anchorCount() is not satisfied
      */
-    void setAnchor(bezVect2D position, std::size_t i);
+    void setAnchor(Vect position, std::size_t i);
 
     /*
      * function: moveAnchor
@@ -186,235 +394,161 @@ public:
      * Throws:
      *   std::out_of_range if 0 <= i < anchorCount() is not satisfied
      */
-    void moveAnchor(bezVect2D offset, std::size_t i);
+    void moveAnchor(Vect offset, std::size_t i);
 
     /*
-     * function: clear
+     * function: setClosed
      *
-     * Removes all anchor points from the spline.
+     * Joins the final anchor point back to the first, or separates them
+     * again. The control points are updated lazily.
+     *
+     * Args:
+     *   closed: whether the spline should be closed
      */
-    void clear(void);
-    
-
-//private:
-    //*************************************************************************
-    // Hidden procedures
-    //*************************************************************************
+    void setClosed(bool closed);
 
     /*
-     * function: updateControlPoints
+     * function: setParameterization
+     *
+     * Changes how t is divided among the Bezier curves. The control points
+     * are updated lazily.
      *
-     * Sets the positions of the control points to ensure C2 continuity.
+     * Args:
+     *   parameterization: new parameterization
      */
-    void updateControlPoints(void);
-
-
-    //*************************************************************************
-    // Internal attributes
-    //*************************************************************************
-    std::size_t anchor_count;  // Number of anchor points in the spline
-    std::size_t bezier_count;  // Number of bezier curves in the spline
-
-    std::vector<bezVect2D> points;  // Must contain
-                                                          // 3n + 1 points for
-                                                          // n anchor points
-    std::vector<bezVect2D> B_points;  // Contains n points
-                                                            // Used to create
-                                                            // B-spline curve
-    std::vector<BEZ_DTYPE> c;  // Contains n values
-                               // Used for calculating B-spline points
-};
+    void setParameterization(bezParameterization parameterization);
 
+    /*
+     * function: clear
+     *
+     * Removes all anchor points from the spline. Whether it is closed is
+     * kept.
+     */
+    void clear(void);
 
-//*****************************************************************************
-//* CURVE3D
-//*****************************************************************************
 
-/*
- * class: Curve3D
- *
- * Implements a cubic Bezier spline with C2 continuity. Interface allows
- * interaction with the anchor points, and the control points are determined
- * internally.
- */
-class Curve3D {
-public:
+//private:
     //*************************************************************************
-    // Constructors/Destructors
+    // Hidden procedures
     //*************************************************************************
 
     /*
-     * default constructor
+     * function: updateControlPoints
      *
-     * Constructs an empty spline.
+     * Sets the positions of the control points to ensure C2 continuity if
+     * any anchor point has changed since they were last set. Reads call this
+     * implicitly, so it is only needed to control when the work happens, or
+     * before reading from several threads at once.
      */
-    Curve3D(void);
+    void updateControlPoints(void);
 
     /*
-     * constructor
+     * function: updateControlPoints
      *
-     * Constructs a spline from the given anchor points.
+     * Sets the positions of the control points to ensure C2 continuity,
+     * splitting the anchor points into one chunk per thread of the given
+     * pool regardless of the spline's size.
      *
      * Args:
-     *   anchor_points: ordered anchor points from which to construct spline
+     *   pool: threads to solve on
      */
-    Curve3D(const std::vector<bezVect3D>& anchor_points);
-
-
-    //*************************************************************************
-    // Access functions
-    //*************************************************************************
+    void updateControlPoints(ThreadPool& pool);
 
     /*
-     * function: getPositionAt
-     *
-     * Returns the coordinates of the spline evaluated at the given t.
-     *
-     * Args:
-     *   t: parameter value in the range [0, 1]
+     * function: solvePending
      *
-     * Throws:
-     *   std::out_of_range if 0 <= i <= 1 is not satisfied
+     * Recomputes the control points affected by the anchor points edited
+     * since the last solve, or does nothing if there were none. Not safe to
+     * call from several threads at once while an edit is pending.
      */
-    bezVect3D getPositionAt(BEZ_DTYPE t) const;
+    void solvePending(void) const;
 
     /*
-     * function: anchorCount
+     * function: solveAll
      *
-     * Returns the number of anchor points.
+     * Recomputes every control point. Splines with at least
+     * BEZ_PARALLEL_SOLVE_THRESHOLD anchor points are solved on
+     * ThreadPool::shared().
      */
-    std::size_t anchorCount(void) const;
+    void solveAll(void) const;
 
     /*
-     * function: getAnchor
-     *
-     * Returns the coordinates of the anchor point at the given index.
+     * function: solveClosed
      *
-     * Args:
-     *   i: index of point
-     *
-     * Throws:
-     *   std::out_of_range if 0 <= i < anchorCount() is not satisfied
+     * Recomputes every control point of a closed spline.
      */
-    const bezVect3D& getAnchor(std::size_t i) const;
+    void solveClosed(void) const;
 
     /*
-     * function: getLength
-     *
-     * Returns the length of the spline between two parameter values.
+     * function: solveNonUniform
      *
-     * Args:
-     *   t0: value of t to start at
-     *   t1: value of t to stop at
-     *
-     * Throws:
-     *   std::out_of_range if 0 <= t0,t1 <= 1 is not satified
+     * Recomputes the knots and every control point of a spline with a
+     * non-uniform parameterization.
      */
-    BEZ_DTYPE getLength(BEZ_DTYPE t0, BEZ_DTYPE t1) const;
+    void solveNonUniform(void) const;
 
     /*
-     * function: getLength
+     * function: solveParallel
      *
-     * Returns the total length of the spline.
+     * Recomputes every control point on the given pool. Closed and
+     * non-uniform splines are solved serially.
      */
-    BEZ_DTYPE getLength(void) const;
+    void solveParallel(ThreadPool& pool) const;
 
     /*
-     * function: split
-     *
-     * Splits the spline into two sub-splines.
-     *
-     * Overwrites the two given Curve objects with the sub-splines.
-     *
-     * Args:
-     *   t: parameter value at which to split, in range [0, 1]
-     *   c1: sub-spline taken from [0, t]
-     *   c2: sub-spline taken from [t, 1]
+     * function: solveRange
      *
-     * Throws:
-     *   std::out_of_range if 0 <= t <= 1 is not satisfied
+     * Recomputes the control points near the anchor points [begin, end),
+     * assuming all others still satisfy the C2 system.
      */
-    void split(BEZ_DTYPE t, Curve3D& c1, Curve3D& c2) const;
-
-
-    //*************************************************************************
-    // Manipulation procedures
-    //*************************************************************************
+    void solveRange(std::size_t begin, std::size_t end) const;
 
     /*
-     * function: addPoint
-     *
-     * Adds an anchor point at the given index.
-     *
-     * Args:
-     *   position: the position of the new anchor point
-     *   i: the index at which to insert the point
+     * function: markDirty
      *
-     * Throws:
-     *   std::out_of_range if 0 <= i <= anchorCount() is not satisfied
+     * Adds the anchor points [begin, end) to the range awaiting a solve.
      */
-    void addPoint(bezVect3D position, std::size_t i);
+    void markDirty(std::size_t begin, std::size_t end);
 
     /*
-     * function: removePoint
+     * function: updateArcLengths
      *
-     * Removes the anchor point at the given index from the spline.
-     *
-     * Args:
-     *   i: the index of the anchor point to remove
-     *
-     * Throws:
-     *   std::out_of_range if 0 <= i < anchorCount() is not satisfied
+     * Rebuilds the arc length index if the control points have changed since
+     * it was last built.
      */
-    void removePoint(std::size_t i);
+    void updateArcLengths(void) const;
 
     /*
-     * function: setAnchor
+     * function: findSegment
      *
-     * Sets the new position of the anchor point at the given index.
+     * Finds the Bezier curve containing the given t and the parameter value
+     * local to it.
      *
      * Args:
-     *   position: new position for the anchor point
-     *   i: index of anchor point to move
-     *
-     * Throws:
-     *   std::out_of_range if 0 <= i < anchorCount() is not satisfied
+     *   t: parameter value in the range [0, 1]
+     *   bez_i: set to the index of the Bezier curve
+     *   local_t: set to the parameter value within it, in range [0, 1]
      */
-    void setAnchor(bezVect3D position, std::size_t i);
+    void findSegment(T t, std::size_t& bez_i, T& local_t) const;
 
     /*
-     * function: moveAnchor
+     * function: evaluateSegment
      *
-     * Translates the given anchor point by the given offset.
+     * Returns the coordinates of the given Bezier curve evaluated at t.
      *
      * Args:
-     *   offset: displacement to apply to anchor point
-     *   i: index of anchor point to move
-     *
-     * Throws:
-     *   std::out_of_range if 0 <= i < anchorCount() is not satisfied
+     *   bez_i: index of the Bezier curve
+     *   t: parameter value local to the Bezier curve, in range [0, 1]
      */
-    void moveAnchor(bezVect3D offset, std::size_t i);
+    Vect evaluateSegment(std::size_t bez_i, T t) const;
 
     /*
-     * function: clear
+     * function: evaluateAtSample
      *
-     * Removes all anchor points from the spline.
+     * Returns the coordinates of the spline at the fractional position
+     * sample + frac in the arc length index.
      */
-    void clear(void);
-    
-
-//private:
-    //*************************************************************************
-    // Hidden procedures
-    //*************************************************************************
-
-    /*
-     * function: updateControlPoints
-     *
-     * Sets the positions of the control points to ensure C2 continuity.
-     */
-    void updateControlPoints(void);
+    Vect evaluateAtSample(std::size_t sample, T frac) const;
 
 
     //*************************************************************************
@@ -422,15 +556,48 @@ public:
     //*************************************************************************
     std::size_t anchor_count;  // Number of anchor points in the spline
     std::size_t bezier_count;  // Number of bezier curves in the spline
-
-    std::vector<bezVect3D> points;  // Must contain
-                                                          // 3n + 1 points for
-                                                          // n anchor points
-    std::vector<bezVect3D> B_points;  // Contains n points
-                                                            // Used to create
-                                                            // B-spline curve
-    std::vector<BEZ_DTYPE> c;  // Contains n values
-                               // Used for calculating B-spline points
+    bool closed;  // Whether the final anchor point joins the first
+    bezParameterization parameterization;  // How t is divided among the
+                                           // Bezier curves
+
+    // The control points are a cache of the anchor points, so the solver
+    // state is mutable to let reads bring it up to date
+    mutable std::pmr::vector<Vect> points;  // Must contain
+                                            // 3n - 2 points for
+                                            // n anchor points, or
+                                            // 3n + 1 if closed,
+                                            // ending with the first
+                                            // anchor point again
+    mutable std::pmr::vector<Vect> B_points;  // Contains n points
+                                              // Used to create
+                                              // B-spline curve
+    mutable std::pmr::vector<T> c;  // Contains n values
+                                    // Used for calculating B-spline points
+    mutable std::pmr::vector<T> z;  // Contains n values if closed
+                                    // Used for the Sherman-Morrison correction
+
+    mutable std::pmr::vector<T> knots;  // Contains bezier_count + 1 values
+                                        // t at which each Bezier curve starts,
+                                        // then 1, if not BEZ_UNIFORM
+    mutable std::pmr::vector<std::size_t> knot_buckets;  // Bezier curve containing
+                                                         // t = b / bezier_count
+                                                         // for each bucket b
+
+    mutable std::size_t dirty_begin;  // Edited anchor points awaiting a
+    mutable std::size_t dirty_end;    // solve are [dirty_begin, dirty_end)
+
+    mutable std::pmr::vector<T> arc_lengths;  // Distance from the start at
+                                              // BEZ_ARC_SAMPLES evenly
+                                              // spaced t per Bezier curve
+    mutable bool arc_lengths_valid;  // Whether arc_lengths matches points
 };
 
+
+//*****************************************************************************
+//* CURVE2D/CURVE3D
+//*****************************************************************************
+
+typedef Curve<2, BEZ_DTYPE> Curve2D;
+typedef Curve<3, BEZ_DTYPE> Curve3D;
+
 #endif
@@ -0,0 +1,241 @@
+/*
+ * curve_file.h
+ *
+ * Defines a binary file format for solved splines, the function
+ * writeCurveFile that produces it, and the class template MappedCurve that
+ * reads it in place through a memory mapping.
+ */
+
+#ifndef BEZIER_CURVE_FILE_H
+#define BEZIER_CURVE_FILE_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "curve.h"
+#include "curve_view.h"
+
+// Version written to and accepted from the header
+#define BEZ_CURVE_FILE_VERSION 1
+
+// Alignment in bytes of every section of the file
+#define BEZ_CURVE_FILE_ALIGNMENT 64
+
+// Flags of CurveFileHeader::flags, also used as options of writeCurveFile
+#define BEZ_CURVE_FILE_CLOSED 0x1u  // The spline is closed
+#define BEZ_CURVE_FILE_BOXES 0x2u  // Bounding box of each Bezier curve
+#define BEZ_CURVE_FILE_ARC_LENGTHS 0x4u  // Arc length index of the Curve
+
+
+//*****************************************************************************
+//* CURVEFILEHEADER
+//*****************************************************************************
+
+/*
+ * struct: CurveFileHeader
+ *
+ * Starts every curve file. All fields, and all data in the sections, are
+ * little-endian. Each section starts at a multiple of
+ * BEZ_CURVE_FILE_ALIGNMENT bytes, and an offset of 0 means the section is
+ * absent.
+ *
+ * Sections:
+ *   points: the interleaved points, as in Curve::points
+ *   knots: bezier_count + 1 values of t, if not BEZ_UNIFORM
+ *   boxes: bezier_count lower corners, then bezier_count upper corners
+ *   arc lengths: bezier_count * arc_samples + 1 distances, as in
+ *                Curve::arc_lengths
+ */
+struct CurveFileHeader {
+    char magic[8];  // "BEZCURV" followed by a zero byte
+    std::uint32_t version;  // BEZ_CURVE_FILE_VERSION
+    std::uint32_t header_size;  // sizeof(CurveFileHeader)
+    std::uint32_t dims;  // Coordinates per point
+    std::uint32_t scalar_size;  // Bytes per coordinate
+    std::uint32_t flags;  // BEZ_CURVE_FILE_* flags
+    std::uint32_t parameterization;  // bezParameterization of the spline
+    std::uint32_t arc_samples;  // Samples per Bezier curve in arc lengths
+    std::uint32_t reserved;  // Zero
+    std::uint64_t anchor_count;  // Number of anchor points
+    std::uint64_t bezier_count;  // Number of Bezier curves
+    std::uint64_t points_offset;  // Byte offsets of the sections
+    std::uint64_t knots_offset;
+    std::uint64_t boxes_offset;
+    std::uint64_t arc_lengths_offset;
+    std::uint64_t file_size;  // Total size in bytes
+};
+
+static_assert(sizeof(CurveFileHeader) == 96, "CurveFileHeader must not be padded");
+
+
+//*****************************************************************************
+//* WRITECURVEFILE
+//*****************************************************************************
+
+/*
+ * function: writeCurveFile
+ *
+ * Solves the given spline if needed and writes it to a curve file.
+ *
+ * Args:
+ *   curve: spline to write
+ *   path: name of the file to create or overwrite
+ *   options: BEZ_CURVE_FILE_BOXES and/or BEZ_CURVE_FILE_ARC_LENGTHS to store
+ *            the corresponding cached data
+ *
+ * Throws:
+ *   std::runtime_error if the file cannot be written
+ */
+template <std::size_t Dim, typename T>
+void writeCurveFile(const Curve<Dim, T>& curve, const char* path,
+                    unsigned options = BEZ_CURVE_FILE_BOXES | BEZ_CURVE_FILE_ARC_LENGTHS);
+
+
+//*****************************************************************************
+//* MAPPEDCURVE
+//*****************************************************************************
+
+/*
+ * class: MappedCurve
+ *
+ * Maps a curve file into memory read-only and presents its sections in place,
+ * without parsing or copying them. Opening validates the header and the
+ * bounds of every section, and the pages are loaded by the operating system
+ * as they are first touched.
+ *
+ * The mapping is read directly only on little-endian hosts, which is every
+ * platform the library targets. On other hosts opening throws. Where mmap is
+ * unavailable the file is read into memory instead.
+ *
+ * The view and the layout interface divide u evenly among the Bezier curves,
+ * so for a non-uniform spline use knots() to convert t.
+ *
+ * Template args:
+ *   Dim: number of coordinates per point
+ *   T: floating point type of the coordinates
+ */
+template <std::size_t Dim, typename T>
+class MappedCurve {
+public:
+    static const std::size_t dims = Dim;
+    typedef T value_type;
+    typedef std::array<T, Dim> Vect;  // Type of a single point
+
+
+    //*************************************************************************
+    // Constructors/Destructors
+    //*************************************************************************
+
+    /*
+     * constructor
+     *
+     * Maps the given curve file.
+     *
+     * Args:
+     *   path: name of the file to map
+     *
+     * Throws:
+     *   std::runtime_error if the file cannot be mapped or is not a valid
+     *   curve file of this Dim and T
+     */
+    explicit MappedCurve(const char* path);
+
+    /*
+     * destructor
+     *
+     * Unmaps the file.
+     */
+    ~MappedCurve(void);
+
+    MappedCurve(MappedCurve&& other);
+    MappedCurve(const MappedCurve&) = delete;
+    MappedCurve& operator=(const MappedCurve&) = delete;
+
+
+    //*************************************************************************
+    // Access functions
+    //*************************************************************************
+
+    const CurveFileHeader& header(void) const;
+    std::size_t anchorCount(void) const;
+    bool isClosed(void) const;
+    bezParameterization getParameterization(void) const;
+
+    /*
+     * function: points
+     *
+     * Returns the interleaved points of the spline.
+     */
+    const Vect* points(void) const;
+
+    /*
+     * functions: knots, boxMins, boxMaxs, arcLengths
+     *
+     * Return the optional sections, or nullptr for those not in the file.
+     */
+    const T* knots(void) const;
+    const Vect* boxMins(void) const;
+    const Vect* boxMaxs(void) const;
+    const T* arcLengths(void) const;
+
+    /*
+     * function: view
+     *
+     * Returns a view of every Bezier curve of the spline, or an empty view if
+     * it has none.
+     */
+    CurveView<Dim, T> view(void) const;
+
+    std::size_t segmentCount(void) const;
+    T get(std::size_t s, std::size_t p, std::size_t d) const;
+
+
+//private:
+    //*************************************************************************
+    // Hidden procedures
+    //*************************************************************************
+
+    /*
+     * function: validate
+     *
+     * Checks the header against the file size and this Dim and T.
+     *
+     * Throws:
+     *   std::runtime_error naming the first problem found
+     */
+    void validate(void) const;
+
+    /*
+     * function: release
+     *
+     * Unmaps or frees the file contents, if any.
+     */
+    void release(void);
+
+    /*
+     * function: section
+     *
+     * Returns a pointer to the section at the given offset, or nullptr if the
+     * offset is 0.
+     */
+    const void* section(std::uint64_t offset) const;
+
+
+    //*************************************************************************
+    // Internal attributes
+    //*************************************************************************
+    const unsigned char* data;  // First byte of the file in memory
+    std::size_t size;  // Size of the file in bytes
+    bool mapped;  // Whether data is a mapping, or else allocated with new[]
+};
+
+
+//*****************************************************************************
+//* MAPPEDCURVE2D/MAPPEDCURVE3D
+//*****************************************************************************
+
+typedef MappedCurve<2, BEZ_DTYPE> MappedCurve2D;
+typedef MappedCurve<3, BEZ_DTYPE> MappedCurve3D;
+
+#endif
@@ -0,0 +1,288 @@
+/*
+ * curve_layout.h
+ *
+ * Defines alternative storage layouts for the points of a Curve and batch
+ * kernels that evaluate, tessellate and bound a spline in any of them.
+ *
+ * Every layout provides the same access interface:
+ *   dims: number of coordinates per point
+ *   value_type: floating point type of the coordinates
+ *   segmentCount(): number of Bezier curves
+ *   get(s, p, d): coordinate d of point p (0 ... 3) of Bezier curve s
+ *
+ * The layouts are:
+ *   CurveInterleavedView: the Curve's own array of points, without copying
+ *   CurveSoA: one contiguous array per coordinate
+ *   CurvePacked: segment-major, the 4 values of each coordinate of each
+ *       Bezier curve next to each other, aligned to BEZ_PACKED_ALIGNMENT
+ *
+ * CurveSoA and CurvePacked also provide block(s, d), the 4 values of
+ * coordinate d of Bezier curve s stored next to each other. For float
+ * coordinates the kernels use it to load several Bezier curves into SIMD
+ * lanes at once, 8 with AVX and 4 with SSE, see BEZ_ENABLE_AVX in
+ * CMakeLists.txt. The other layouts take the scalar kernels.
+ *
+ * The kernels are also instantiated for CurveView, defined in curve_view.h.
+ */
+
+#ifndef BEZIER_CURVE_LAYOUT_H
+#define BEZIER_CURVE_LAYOUT_H
+
+#include <array>
+#include <cstddef>
+#include <new>
+#include <vector>
+
+#include "curve.h"
+
+// Alignment in bytes of the start of each CurvePacked buffer
+#ifndef BEZ_PACKED_ALIGNMENT
+#define BEZ_PACKED_ALIGNMENT 32
+#endif
+
+
+//*****************************************************************************
+//* ALIGNEDALLOCATOR
+//*****************************************************************************
+
+/*
+ * class: AlignedAllocator
+ *
+ * Minimal allocator that returns storage aligned to Align bytes.
+ */
+template <typename T, std::size_t Align>
+class AlignedAllocator {
+public:
+    typedef T value_type;
+
+    template <typename U>
+    struct rebind {
+        typedef AlignedAllocator<U, Align> other;
+    };
+
+    AlignedAllocator(void) = default;
+
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U, Align>&) {}
+
+    T* allocate(std::size_t n) {
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Align)));
+    }
+
+    void deallocate(T* p, std::size_t) {
+        ::operator delete(p, std::align_val_t(Align));
+    }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U, Align>&) const { return true; }
+
+    template <typename U>
+    bool operator!=(const AlignedAllocator<U, Align>&) const { return false; }
+};
+
+
+//*****************************************************************************
+//* CURVEINTERLEAVEDVIEW
+//*****************************************************************************
+
+/*
+ * class: CurveInterleavedView
+ *
+ * Presents the interleaved points of an existing Curve through the layout
+ * interface. The Curve must outlive the view and must not be modified while
+ * the view is in use.
+ */
+template <std::size_t Dim, typename T>
+class CurveInterleavedView {
+public:
+    static const std::size_t dims = Dim;
+    typedef T value_type;
+
+    /*
+     * constructor
+     *
+     * Args:
+     *   curve: spline whose points to present
+     */
+    explicit CurveInterleavedView(const Curve<Dim, T>& curve);
+
+    /*
+     * constructor
+     *
+     * Args:
+     *   points: 3 * bezier_count + 1 interleaved points
+     *   bezier_count: number of Bezier curves
+     */
+    CurveInterleavedView(const typename Curve<Dim, T>::Vect* points, std::size_t bezier_count);
+
+    std::size_t segmentCount(void) const;
+    T get(std::size_t s, std::size_t p, std::size_t d) const;
+
+private:
+    const typename Curve<Dim, T>::Vect* points;  // First point of the Curve
+    std::size_t bezier_count;  // Number of Bezier curves
+};
+
+
+//*****************************************************************************
+//* CURVESOA
+//*****************************************************************************
+
+/*
+ * class: CurveSoA
+ *
+ * Copy of the points of a Curve with one contiguous array per coordinate, in
+ * the same order as the Curve's interleaved array.
+ */
+template <std::size_t Dim, typename T>
+class CurveSoA {
+public:
+    static const std::size_t dims = Dim;
+    typedef T value_type;
+
+    CurveSoA(void);
+    explicit CurveSoA(const Curve<Dim, T>& curve);
+
+    /*
+     * function: assign
+     *
+     * Replaces the contents with the points of the given spline, reusing the
+     * existing storage when it is large enough.
+     */
+    void assign(const Curve<Dim, T>& curve);
+
+    std::size_t segmentCount(void) const;
+    T get(std::size_t s, std::size_t p, std::size_t d) const;
+
+    /*
+     * function: block
+     *
+     * Returns the 4 consecutive values of coordinate d of Bezier curve s,
+     * shared at either end with its neighbours.
+     */
+    const T* block(std::size_t s, std::size_t d) const;
+
+    std::array<std::vector<T>, Dim> coords;  // coords[d][i] is coordinate d
+                                             // of point i of the Curve
+    std::size_t bezier_count;  // Number of Bezier curves
+};
+
+
+//*****************************************************************************
+//* CURVEPACKED
+//*****************************************************************************
+
+/*
+ * class: CurvePacked
+ *
+ * Copy of the points of a Curve stored segment-major: Bezier curve s occupies
+ * 4 * Dim consecutive values, coordinate d of its points at
+ * data[(s * Dim + d) * 4 + p]. Each coordinate block of a float spline fills
+ * exactly 16 bytes, so one aligned SSE load reads a block, and each Bezier
+ * curve of a 2D float spline fills exactly 32 bytes, so one aligned AVX load
+ * reads both of its blocks.
+ */
+template <std::size_t Dim, typename T>
+class CurvePacked {
+public:
+    static const std::size_t dims = Dim;
+    typedef T value_type;
+
+    CurvePacked(void);
+    explicit CurvePacked(const Curve<Dim, T>& curve);
+
+    /*
+     * function: assign
+     *
+     * Replaces the contents with the points of the given spline, reusing the
+     * existing storage when it is large enough.
+     */
+    void assign(const Curve<Dim, T>& curve);
+
+    std::size_t segmentCount(void) const;
+    T get(std::size_t s, std::size_t p, std::size_t d) const;
+
+    /*
+     * function: block
+     *
+     * Returns the 4 consecutive values of coordinate d of Bezier curve s.
+     */
+    const T* block(std::size_t s, std::size_t d) const;
+
+    std::vector<T, AlignedAllocator<T, BEZ_PACKED_ALIGNMENT> > data;  // 4 * Dim
+                                                                       // values per
+                                                                       // Bezier curve
+    std::size_t bezier_count;  // Number of Bezier curves
+};
+
+
+//*****************************************************************************
+//* KERNELS
+//*****************************************************************************
+
+/*
+ * function: evaluateSegments
+ *
+ * Evaluates count (Bezier curve, t) pairs.
+ *
+ * Args:
+ *   layout: points of the spline
+ *   segments: index of the Bezier curve of each query
+ *   ts: parameter value local to the Bezier curve of each query
+ *   count: number of queries
+ *   out: output array of count points
+ */
+template <class Layout>
+void evaluateSegments(const Layout& layout,
+                      const std::size_t* segments,
+                      const typename Layout::value_type* ts,
+                      std::size_t count,
+                      std::array<typename Layout::value_type, Layout::dims>* out);
+
+/*
+ * function: tessellate
+ *
+ * Replaces the contents of out with steps points per Bezier curve at evenly
+ * spaced t, followed by the final anchor point.
+ *
+ * Args:
+ *   layout: points of the spline
+ *   steps: number of points per Bezier curve, at least 1
+ *   out: vector to fill with segmentCount() * steps + 1 points
+ */
+template <class Layout>
+void tessellate(const Layout& layout, std::size_t steps,
+                std::vector<std::array<typename Layout::value_type, Layout::dims> >& out);
+
+/*
+ * function: tessellate
+ *
+ * Writes steps points per Bezier curve at evenly spaced t, followed by the
+ * final anchor point, to the given array. Writes nothing if the spline has no
+ * Bezier curves.
+ *
+ * Args:
+ *   layout: points of the spline
+ *   steps: number of points per Bezier curve, at least 1
+ *   out: output array of segmentCount() * steps + 1 points
+ */
+template <class Layout>
+void tessellate(const Layout& layout, std::size_t steps,
+                std::array<typename Layout::value_type, Layout::dims>* out);
+
+/*
+ * function: segmentBoundingBoxes
+ *
+ * Computes the tight axis-aligned bounding box of every Bezier curve.
+ *
+ * Args:
+ *   layout: points of the spline
+ *   mins: output array of segmentCount() lower corners
+ *   maxs: output array of segmentCount() upper corners
+ */
+template <class Layout>
+void segmentBoundingBoxes(const Layout& layout,
+                          std::array<typename Layout::value_type, Layout::dims>* mins,
+                          std::array<typename Layout::value_type, Layout::dims>* maxs);
+
+#endif
@@ -0,0 +1,197 @@
+/*
+ * curve_publisher.h
+ *
+ * Defines the class template CurvePublisher, which lets one writer thread
+ * edit a spline while any number of reader threads sample immutable
+ * snapshots of it without waiting.
+ */
+
+#ifndef BEZIER_CURVE_PUBLISHER_H
+#define BEZIER_CURVE_PUBLISHER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "curve.h"
+
+// Default number of reader slots of a CurvePublisher
+#ifndef BEZ_MAX_READERS
+#define BEZ_MAX_READERS 64
+#endif
+
+
+//*****************************************************************************
+//* CURVEPUBLISHER
+//*****************************************************************************
+
+/*
+ * class: CurvePublisher
+ *
+ * Publishes snapshots of a spline in the style of read-copy-update.
+ *
+ * The writer edits a private working Curve. publish() solves it, copies it
+ * into the back buffer, and swaps that buffer in with a single atomic store.
+ * A reader announces the current epoch in its own slot, loads the front
+ * buffer, and may use it until it ends the read, so reading never blocks or
+ * retries. Before the writer reuses a retired buffer, it waits until every
+ * reader that might still hold it has ended its read.
+ *
+ * Snapshots are fully solved and have their arc length index built, so all
+ * const queries on them are read-only and safe to run concurrently.
+ *
+ * Template args:
+ *   Dim: number of coordinates per point
+ *   T: floating point type of the coordinates
+ */
+template <std::size_t Dim, typename T>
+class CurvePublisher {
+public:
+    /*
+     * class: Snapshot
+     *
+     * Holds a published spline for the duration of a read. Only one Snapshot
+     * per reader slot may exist at a time.
+     */
+    class Snapshot {
+    public:
+        Snapshot(Snapshot&& other);
+        ~Snapshot(void);
+
+        Snapshot(const Snapshot&) = delete;
+        Snapshot& operator=(const Snapshot&) = delete;
+
+        const Curve<Dim, T>& operator*(void) const { return *curve; }
+        const Curve<Dim, T>* operator->(void) const { return curve; }
+
+    private:
+        friend class CurvePublisher;
+
+        Snapshot(std::atomic<std::uint64_t>* slot, const Curve<Dim, T>* curve);
+
+        std::atomic<std::uint64_t>* slot;  // Reader slot to clear when done
+        const Curve<Dim, T>* curve;  // Published spline being read
+    };
+
+
+    //*************************************************************************
+    // Constructors/Destructors
+    //*************************************************************************
+
+    /*
+     * constructor
+     *
+     * Publishes the given spline as the first snapshot.
+     *
+     * Args:
+     *   curve: initial spline
+     *   max_readers: number of reader slots
+     */
+    explicit CurvePublisher(const Curve<Dim, T>& curve = Curve<Dim, T>(),
+                            std::size_t max_readers = BEZ_MAX_READERS);
+
+    CurvePublisher(const CurvePublisher&) = delete;
+    CurvePublisher& operator=(const CurvePublisher&) = delete;
+
+
+    //*************************************************************************
+    // Reader procedures
+    //*************************************************************************
+
+    /*
+     * function: registerReader
+     *
+     * Claims a reader slot for the calling thread and returns its index.
+     * Thread-safe.
+     *
+     * Throws:
+     *   std::length_error if every slot has been claimed
+     */
+    std::size_t registerReader(void);
+
+    /*
+     * function: read
+     *
+     * Returns the latest published snapshot. Wait-free.
+     *
+     * Args:
+     *   reader: slot returned by registerReader
+     */
+    Snapshot read(std::size_t reader) const;
+
+
+    //*************************************************************************
+    // Writer procedures
+    //*************************************************************************
+
+    /*
+     * function: edit
+     *
+     * Returns the working spline. Only the writer thread may use it, and
+     * readers do not see its changes until the next publish.
+     */
+    Curve<Dim, T>& edit(void);
+
+    /*
+     * function: publish
+     *
+     * Makes the current state of the working spline visible to readers.
+     * Waits first for readers still holding the snapshot retired by the
+     * previous publish.
+     */
+    void publish(void);
+
+    /*
+     * function: version
+     *
+     * Returns the number of snapshots published so far, counting the initial
+     * one.
+     */
+    std::uint64_t version(void) const;
+
+
+//private:
+    //*************************************************************************
+    // Hidden procedures
+    //*************************************************************************
+
+    /*
+     * function: waitForReaders
+     *
+     * Waits until no reader that started before the given epoch is still
+     * reading.
+     */
+    void waitForReaders(std::uint64_t epoch) const;
+
+
+    //*************************************************************************
+    // Internal attributes
+    //*************************************************************************
+
+    // Own cache line per slot, so readers do not contend with each other
+    struct alignas(64) ReaderSlot {
+        std::atomic<std::uint64_t> epoch;  // Epoch announced by the active
+                                           // read, or 0 when idle
+    };
+
+    Curve<Dim, T> working;  // Spline edited by the writer
+    Curve<Dim, T> buffers[2];  // Front and back snapshots
+    std::atomic<const Curve<Dim, T>*> front;  // Snapshot given to readers
+    std::atomic<std::uint64_t> epoch;  // Incremented by every publish
+    std::uint64_t retired_epoch;  // Epoch of the last publish, before which
+                                  // readers may still hold the back buffer
+
+    mutable std::vector<ReaderSlot> slots;  // One per registered reader
+    std::atomic<std::size_t> reader_count;  // Number of claimed slots
+};
+
+
+//*****************************************************************************
+//* CURVEPUBLISHER2D/CURVEPUBLISHER3D
+//*****************************************************************************
+
+typedef CurvePublisher<2, BEZ_DTYPE> CurvePublisher2D;
+typedef CurvePublisher<3, BEZ_DTYPE> CurvePublisher3D;
+
+#endif
@@ -0,0 +1,276 @@
+/*
+ * curve_set.h
+ *
+ * Defines the class template CurveSet, which stores many independent splines
+ * in shared contiguous arrays and operates on all of them at once.
+ */
+
+#ifndef BEZIER_CURVE_SET_H
+#define BEZIER_CURVE_SET_H
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include "curve.h"
+#include "curve_view.h"
+
+
+//*****************************************************************************
+//* CURVESET
+//*****************************************************************************
+
+/*
+ * class: CurveSet
+ *
+ * Holds a set of open, uniformly parameterized C2 splines. The points of
+ * every spline are stored back to back in one array, in the same interleaved
+ * order as Curve::points, and CSR-style offset arrays give where each spline
+ * starts:
+ *   points of spline i:         [point_offsets[i], point_offsets[i + 1])
+ *   Bezier curves of spline i:  [segment_offsets[i], segment_offsets[i + 1])
+ *
+ * Edits only mark splines dirty. rebuild solves the control points of every
+ * dirty spline in place, without scratch storage, and the parallel overload
+ * hands out ranges of splines with equal numbers of points to the threads.
+ * The batch queries assume the set has been rebuilt since the last edit.
+ *
+ * Template args:
+ *   Dim: number of coordinates per point
+ *   T: floating point type of the coordinates
+ */
+template <std::size_t Dim, typename T>
+class CurveSet {
+public:
+    typedef std::array<T, Dim> Vect;  // Type of a single point
+
+
+    //*************************************************************************
+    // Constructors/Destructors
+    //*************************************************************************
+
+    /*
+     * default constructor
+     *
+     * Constructs an empty set.
+     */
+    CurveSet(void);
+
+
+    //*************************************************************************
+    // Access functions
+    //*************************************************************************
+
+    /*
+     * function: curveCount
+     *
+     * Returns the number of splines in the set.
+     */
+    std::size_t curveCount(void) const;
+
+    /*
+     * function: segmentCount
+     *
+     * Returns the total number of Bezier curves of all splines.
+     */
+    std::size_t segmentCount(void) const;
+
+    /*
+     * function: anchorCount
+     *
+     * Returns the number of anchor points of the given spline.
+     *
+     * Args:
+     *   curve: index of spline
+     */
+    std::size_t anchorCount(std::size_t curve) const;
+
+    /*
+     * function: getAnchor
+     *
+     * Returns the coordinates of an anchor point of the given spline.
+     *
+     * Args:
+     *   curve: index of spline
+     *   i: index of anchor point
+     */
+    const Vect& getAnchor(std::size_t curve, std::size_t i) const;
+
+    /*
+     * function: view
+     *
+     * Returns a view of every Bezier curve of the given spline, or an empty
+     * view if it has fewer than two anchor points.
+     *
+     * Args:
+     *   curve: index of spline
+     */
+    CurveView<Dim, T> view(std::size_t curve) const;
+
+
+    //*************************************************************************
+    // Batch queries
+    //*************************************************************************
+
+    /*
+     * function: evaluate
+     *
+     * Evaluates count (spline, t) pairs, with t spread evenly over the Bezier
+     * curves of each spline as in Curve::getPositionAt.
+     *
+     * Args:
+     *   curves: index of the spline of each query
+     *   ts: parameter value in the range [0, 1] of each query
+     *   count: number of queries
+     *   out: output array of count points
+     */
+    void evaluate(const std::size_t* curves, const T* ts, std::size_t count, Vect* out) const;
+
+    /*
+     * function: boundingBoxes
+     *
+     * Computes the tight axis-aligned bounding box of every spline. A spline
+     * with one anchor point gets that point as its box.
+     *
+     * Args:
+     *   mins: output array of curveCount() lower corners
+     *   maxs: output array of curveCount() upper corners
+     */
+    void boundingBoxes(Vect* mins, Vect* maxs) const;
+
+    /*
+     * function: segmentBoundingBoxes
+     *
+     * Computes the tight axis-aligned bounding box of every Bezier curve of
+     * every spline, in the order given by segment_offsets.
+     *
+     * Args:
+     *   mins: output array of segmentCount() lower corners
+     *   maxs: output array of segmentCount() upper corners
+     */
+    void segmentBoundingBoxes(Vect* mins, Vect* maxs) const;
+
+    /*
+     * function: tessellate
+     *
+     * Replaces the contents of out with the polylines of every spline, steps
+     * points per Bezier curve followed by the final anchor point, and offsets
+     * with where each polyline starts.
+     *
+     * Args:
+     *   steps: number of points per Bezier curve, at least 1
+     *   out: vector to fill with the points of all polylines
+     *   offsets: vector to fill with curveCount() + 1 offsets into out
+     */
+    void tessellate(std::size_t steps, std::vector<Vect>& out,
+                    std::vector<std::size_t>& offsets) const;
+
+
+    //*************************************************************************
+    // Manipulation procedures
+    //*************************************************************************
+
+    /*
+     * function: add
+     *
+     * Appends a spline through the given anchor points and returns its index.
+     *
+     * Args:
+     *   anchor_points: ordered anchor points of the new spline
+     */
+    std::size_t add(const std::vector<Vect>& anchor_points);
+
+    /*
+     * function: setAnchor
+     *
+     * Sets the coordinates of an anchor point of the given spline.
+     *
+     * Args:
+     *   curve: index of spline
+     *   i: index of anchor point
+     *   position: new position of the anchor point
+     */
+    void setAnchor(std::size_t curve, std::size_t i, const Vect& position);
+
+    /*
+     * function: reserve
+     *
+     * Allocates room for the given numbers of splines and anchor points.
+     */
+    void reserve(std::size_t curve_count, std::size_t anchor_count);
+
+    /*
+     * function: clear
+     *
+     * Removes every spline, keeping the allocated storage.
+     */
+    void clear(void);
+
+    /*
+     * function: rebuild
+     *
+     * Solves the control points of every spline edited since the last
+     * rebuild.
+     */
+    void rebuild(void);
+
+    /*
+     * function: rebuild
+     *
+     * Solves the control points of every spline edited since the last
+     * rebuild, spreading the splines over the threads of the given pool.
+     *
+     * Args:
+     *   pool: threads to run the solves on
+     */
+    void rebuild(ThreadPool& pool);
+
+
+//private:
+    //*************************************************************************
+    // Hidden procedures
+    //*************************************************************************
+
+    /*
+     * function: solveCurve
+     *
+     * Solves the control points of one spline in place.
+     */
+    void solveCurve(std::size_t curve);
+
+    /*
+     * function: solveCurves
+     *
+     * Solves every dirty spline in [first, last).
+     */
+    void solveCurves(std::size_t first, std::size_t last);
+
+    /*
+     * function: countSolves
+     *
+     * Counts a full solve of every dirty spline, see bezier_stats.h.
+     */
+    void countSolves(void) const;
+
+
+    //*************************************************************************
+    // Internal attributes
+    //*************************************************************************
+    std::vector<Vect> points;  // Points of every spline, back to back
+    std::vector<std::size_t> point_offsets;  // curveCount() + 1 values
+    std::vector<std::size_t> segment_offsets;  // curveCount() + 1 values
+    std::vector<T> c;  // Thomas coefficient of each row, the same for
+                       // every spline with natural ends
+    std::vector<unsigned char> dirty;  // Whether each spline needs a solve
+    bool any_dirty;  // Whether any spline needs a solve
+};
+
+
+//*****************************************************************************
+//* CURVESET2D/CURVESET3D
+//*****************************************************************************
+
+typedef CurveSet<2, BEZ_DTYPE> CurveSet2D;
+typedef CurveSet<3, BEZ_DTYPE> CurveSet3D;
+
+#endif
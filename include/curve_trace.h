@@ -0,0 +1,147 @@
+/*
+ * curve_trace.h
+ *
+ * Defines optional tracing of the spline operations that can take long
+ * enough to drop a frame, such as constructing a spline, solving for its
+ * control points, and evaluating or tessellating in bulk. Each traced call
+ * records when it began and ended and how many items it handled, and the
+ * records of all threads can be written as a Chrome trace, which
+ * chrome://tracing and Perfetto open.
+ *
+ * The hooks are only compiled in when BEZ_ENABLE_TRACE is defined, for
+ * example with the CMake option of the same name. Even then nothing is
+ * recorded until bezTraceStart, and a hook that does not record costs one
+ * relaxed load and a branch.
+ */
+
+#ifndef BEZIER_CURVE_TRACE_H
+#define BEZIER_CURVE_TRACE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Events each thread can record before further ones are dropped
+#ifndef BEZ_TRACE_BUFFER_EVENTS
+#define BEZ_TRACE_BUFFER_EVENTS 16384
+#endif
+
+
+//*****************************************************************************
+//* TRACE
+//*****************************************************************************
+
+// Whether hooks record, set by bezTraceStart and bezTraceStop
+extern std::atomic<bool> bez_trace_enabled;
+
+/*
+ * function: bezTraceStart
+ *
+ * Makes the hooks of every thread record from now on.
+ */
+void bezTraceStart(void);
+
+/*
+ * function: bezTraceStop
+ *
+ * Makes the hooks of every thread stop recording. Calls already being
+ * traced are still recorded when they end.
+ */
+void bezTraceStop(void);
+
+/*
+ * function: bezTraceClear
+ *
+ * Discards the events recorded so far, and frees the buffers of the threads
+ * that exited. No thread may be recording.
+ */
+void bezTraceClear(void);
+
+/*
+ * function: bezTraceDropped
+ *
+ * Returns the number of events discarded because the buffer of their thread
+ * was full.
+ */
+std::size_t bezTraceDropped(void);
+
+/*
+ * function: bezTraceWrite
+ *
+ * Writes the events recorded so far as a Chrome trace in JSON, one complete
+ * event per traced call with its size as an argument. No thread may be
+ * recording. Returns whether the file could be written.
+ *
+ * Args:
+ *   file_name: path of the file to write
+ */
+bool bezTraceWrite(const char* file_name);
+
+/*
+ * function: bezTraceNow
+ *
+ * Returns the time of the steady clock in nanoseconds.
+ */
+std::uint64_t bezTraceNow(void);
+
+/*
+ * function: bezTraceRecord
+ *
+ * Appends an event to the buffer of the calling thread, without locking,
+ * or drops it if the buffer is full.
+ *
+ * Args:
+ *   name: name of the operation, which must outlive the trace
+ *   begin, end: times from bezTraceNow
+ *   size: number of items the operation handled
+ */
+void bezTraceRecord(const char* name, std::uint64_t begin, std::uint64_t end, std::size_t size);
+
+
+/*
+ * class: TraceScope
+ *
+ * Records an event from its construction to its destruction if tracing was
+ * started when it was constructed. Use through BEZ_TRACE_SCOPE.
+ */
+class TraceScope {
+public:
+    TraceScope(const char* name, std::size_t size) :
+        name(name), size(size),
+        begin(bez_trace_enabled.load(std::memory_order_relaxed) ? bezTraceNow() : 0) {
+        // Nothing to do
+    }
+
+    ~TraceScope(void) {
+        if (begin != 0) {
+            bezTraceRecord(name, begin, bezTraceNow(), size);
+        }
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* name;
+    std::size_t size;
+    std::uint64_t begin;  // 0 when not recording
+};
+
+
+/*
+ * function-like macro: BEZ_TRACE_SCOPE
+ *
+ * BEZ_TRACE_SCOPE(name, size) traces the rest of the enclosing block as an
+ * operation with the given name and number of items. Does nothing, without
+ * evaluating size, unless BEZ_ENABLE_TRACE is defined.
+ */
+#if defined(BEZ_ENABLE_TRACE)
+#define BEZ_TRACE_CONCAT_INNER(a, b) a##b
+#define BEZ_TRACE_CONCAT(a, b) BEZ_TRACE_CONCAT_INNER(a, b)
+#define BEZ_TRACE_SCOPE(name, size)\
+    TraceScope BEZ_TRACE_CONCAT(bez_trace_scope_, __LINE__)((name), (std::size_t)(size))
+#else
+#define BEZ_TRACE_SCOPE(name, size) ((void)0)
+#endif
+
+#endif
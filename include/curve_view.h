@@ -0,0 +1,215 @@
+/*
+ * curve_view.h
+ *
+ * Defines the class template CurveView, a non-owning window onto a range of
+ * the Bezier curves of a spline.
+ */
+
+#ifndef BEZIER_CURVE_VIEW_H
+#define BEZIER_CURVE_VIEW_H
+
+#include <array>
+#include <cstddef>
+
+#include "curve.h"
+
+
+//*****************************************************************************
+//* SPLITSEGMENT
+//*****************************************************************************
+
+/*
+ * function: splitSegment
+ *
+ * Splits a cubic Bezier curve into two sub-curves at the given t using
+ * bez2SplitCurve or bez3SplitCurve.
+ *
+ * Args:
+ *   p: the 4 points of the Bezier curve
+ *   t: value of t at which to split the curve
+ *   left: output for the 4 points of the sub-curve taken from [0, t]
+ *   right: output for the 4 points of the sub-curve taken from [t, 1]
+ */
+void splitSegment(const bezVect2D* p, BEZ_DTYPE t, bezVect2D* left, bezVect2D* right);
+void splitSegment(const bezVect3D* p, BEZ_DTYPE t, bezVect3D* left, bezVect3D* right);
+
+
+//*****************************************************************************
+//* CURVEVIEW
+//*****************************************************************************
+
+/*
+ * class: CurveView
+ *
+ * References the points of a range of the Bezier curves of a spline without
+ * copying them. When the range starts or ends part way through a Bezier
+ * curve, only that curve is split and kept in the view.
+ *
+ * The parameter u of the view is divided evenly among its Bezier curves,
+ * the partial ones at the ends included, the same way as for the Curve
+ * produced by Curve::split.
+ *
+ * The points must outlive the view and must not be modified while the view
+ * is in use. The view also provides the layout interface of curve_layout.h.
+ *
+ * Template args:
+ *   Dim: number of coordinates per point
+ *   T: floating point type of the coordinates
+ */
+template <std::size_t Dim, typename T>
+class CurveView {
+public:
+    static const std::size_t dims = Dim;
+    typedef T value_type;
+    typedef std::array<T, Dim> Vect;  // Type of a single point
+
+
+    //*************************************************************************
+    // Constructors/Destructors
+    //*************************************************************************
+
+    /*
+     * default constructor
+     *
+     * Constructs a view of nothing.
+     */
+    CurveView(void);
+
+    /*
+     * constructor
+     *
+     * Constructs a view of the whole spline.
+     *
+     * Args:
+     *   curve: spline to view
+     *
+     * Throws:
+     *   std::out_of_range if the spline is empty
+     */
+    explicit CurveView(const Curve<Dim, T>& curve);
+
+    /*
+     * constructor
+     *
+     * Constructs a view of the part of the spline between two parameter
+     * values.
+     *
+     * Args:
+     *   curve: spline to view
+     *   t0: value of t of the spline to start at
+     *   t1: value of t of the spline to stop at
+     *
+     * Throws:
+     *   std::out_of_range if 0 <= t0 <= t1 <= 1 is not satisfied or the
+     *       spline is empty
+     */
+    CurveView(const Curve<Dim, T>& curve, T t0, T t1);
+
+    /*
+     * constructor
+     *
+     * Constructs a view of Bezier curves stored like the points of a Curve,
+     * anchor point i at index 3i with its control points in between.
+     *
+     * Args:
+     *   points: 3 * bezier_count + 1 points
+     *   bezier_count: number of Bezier curves, at least 1
+     */
+    CurveView(const Vect* points, std::size_t bezier_count);
+
+
+    //*************************************************************************
+    // Access functions
+    //*************************************************************************
+
+    /*
+     * function: getPositionAt
+     *
+     * Returns the coordinates of the view evaluated at the given u.
+     *
+     * Args:
+     *   u: parameter value in the range [0, 1]
+     */
+    Vect getPositionAt(T u) const;
+
+    /*
+     * function: getLength
+     *
+     * Returns the length of the view between two parameter values, measured
+     * with BEZ_ARC_SAMPLES chords per Bezier curve.
+     *
+     * Args:
+     *   u0: value of u to start at
+     *   u1: value of u to stop at
+     *
+     * Throws:
+     *   std::out_of_range if 0 <= u0,u1 <= 1 is not satisfied
+     */
+    T getLength(T u0, T u1) const;
+
+    /*
+     * function: getLength
+     *
+     * Returns the total length of the view.
+     */
+    T getLength(void) const;
+
+    /*
+     * function: copyTo
+     *
+     * Overwrites the given Curve with the points of the view, reusing its
+     * storage when it is large enough. The Curve is open and uniformly
+     * parameterized, and keeps the copied control points until one of its
+     * anchor points is edited.
+     *
+     * out may be the viewed Curve itself, after which the view must not be
+     * used again.
+     *
+     * Args:
+     *   out: Curve to overwrite
+     */
+    void copyTo(Curve<Dim, T>& out) const;
+
+    std::size_t segmentCount(void) const;
+    T get(std::size_t s, std::size_t p, std::size_t d) const;
+
+
+//private:
+    //*************************************************************************
+    // Hidden procedures
+    //*************************************************************************
+
+    /*
+     * function: segmentPoint
+     *
+     * Returns point p (0 ... 3) of Bezier curve s of the view.
+     */
+    const Vect& segmentPoint(std::size_t s, std::size_t p) const;
+
+    /*
+     * function: segmentLength
+     *
+     * Returns the length of Bezier curve s of the view between local
+     * parameter values a <= b.
+     */
+    T segmentLength(std::size_t s, T a, T b) const;
+
+
+    //*************************************************************************
+    // Internal attributes
+    //*************************************************************************
+    const Vect* points;  // Point 0 of the first Bezier curve in the view
+    std::size_t bezier_count;  // Number of Bezier curves in the view
+    Vect head[4];  // First Bezier curve, split if the view starts inside it
+    Vect tail[4];  // Last Bezier curve, split if the view ends inside it
+};
+
+
+//*****************************************************************************
+//* CURVEVIEW2D/CURVEVIEW3D
+//*****************************************************************************
+
+typedef CurveView<2, BEZ_DTYPE> CurveView2D;
+typedef CurveView<3, BEZ_DTYPE> CurveView3D;
+
+#endif
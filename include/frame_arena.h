@@ -0,0 +1,122 @@
+/*
+ * frame_arena.h
+ *
+ * Defines the interface for the class FrameArena, a memory resource for
+ * splines that live no longer than one frame.
+ */
+
+#ifndef BEZIER_FRAME_ARENA_H
+#define BEZIER_FRAME_ARENA_H
+
+#include <cstddef>
+#include <memory_resource>
+#include <optional>
+
+// Default size in bytes of the buffer a FrameArena starts with
+#ifndef BEZ_FRAME_ARENA_SIZE
+#define BEZ_FRAME_ARENA_SIZE 65536
+#endif
+
+
+//*****************************************************************************
+//* FRAMEARENA
+//*****************************************************************************
+
+/*
+ * class: FrameArena
+ *
+ * Hands out memory by bumping a pointer through a reusable buffer, and frees
+ * all of it at once on reset. Deallocation does nothing.
+ *
+ * Allocations that do not fit in the buffer go to the upstream resource
+ * through a std::pmr::monotonic_buffer_resource. When that happens, reset
+ * grows the buffer to the most bytes used in one frame, so a steady workload
+ * stops calling the upstream resource after its first frame.
+ *
+ * Not thread-safe; use one arena per thread. Every object allocated from the
+ * arena must be destroyed before reset.
+ */
+class FrameArena : public std::pmr::memory_resource {
+public:
+    //*************************************************************************
+    // Constructors/Destructors
+    //*************************************************************************
+
+    /*
+     * constructor
+     *
+     * Allocates the initial buffer from the upstream resource.
+     *
+     * Args:
+     *   initial_size: size in bytes of the initial buffer
+     *   upstream: resource for the buffer and for allocations beyond it
+     */
+    explicit FrameArena(std::size_t initial_size = BEZ_FRAME_ARENA_SIZE,
+                        std::pmr::memory_resource* upstream = std::pmr::get_default_resource());
+
+    /*
+     * destructor
+     *
+     * Returns the buffer and any overflow to the upstream resource.
+     */
+    ~FrameArena(void);
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+
+    //*************************************************************************
+    // Access functions
+    //*************************************************************************
+
+    /*
+     * function: bytesUsed
+     *
+     * Returns the number of bytes handed out since the last reset, counting
+     * alignment padding.
+     */
+    std::size_t bytesUsed(void) const;
+
+    /*
+     * function: capacity
+     *
+     * Returns the size in bytes of the reusable buffer.
+     */
+    std::size_t capacity(void) const;
+
+
+    //*************************************************************************
+    // Manipulation procedures
+    //*************************************************************************
+
+    /*
+     * function: reset
+     *
+     * Frees everything allocated since the last reset, growing the buffer if
+     * this frame overflowed it.
+     */
+    void reset(void);
+
+
+//private:
+    //*************************************************************************
+    // Hidden procedures
+    //*************************************************************************
+
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+
+    //*************************************************************************
+    // Internal attributes
+    //*************************************************************************
+    std::pmr::memory_resource* upstream;  // Source of buffer and overflow
+    void* buffer;  // Reused every frame
+    std::size_t buffer_size;  // Size of buffer in bytes
+    std::size_t used;  // Bytes handed out since the last reset
+    std::optional<std::pmr::monotonic_buffer_resource> arena;  // Bumps through
+                                                               // buffer
+};
+
+#endif
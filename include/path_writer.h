@@ -0,0 +1,220 @@
+/*
+ * path_writer.h
+ *
+ * Defines the class PathWriter, which formats splines and raw Bezier curves
+ * as SVG path data or CSV.
+ */
+
+#ifndef BEZIER_PATH_WRITER_H
+#define BEZIER_PATH_WRITER_H
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <memory>
+
+#include "curve.h"
+
+// Default size in bytes of the buffer of a PathWriter
+#define BEZ_PATH_WRITER_BUFFER_SIZE 65536
+
+// Precision of a PathWriter that writes the shortest round-trip form
+#define BEZ_SHORTEST -1
+
+
+//*****************************************************************************
+//* PATHWRITER
+//*****************************************************************************
+
+/*
+ * class: PathWriter
+ *
+ * Formats points into a buffer allocated once at construction, and hands the
+ * buffer to a file descriptor or a callback whenever it fills up and on
+ * flush. Numbers are formatted with std::to_chars, either in the shortest
+ * form that reads back to the same value or with a fixed number of decimals
+ * and no trailing zeros, so writing never allocates.
+ *
+ * SVG path data uses the implicit repetition of commands, so consecutive
+ * Bezier curves cost only their points. CSV has one point per line.
+ */
+class PathWriter {
+public:
+    typedef std::function<void(const char* data, std::size_t size)> Sink;
+
+
+    //*************************************************************************
+    // Constructors/Destructors
+    //*************************************************************************
+
+    /*
+     * constructor
+     *
+     * Writes to an open file descriptor, which is not closed by the writer.
+     *
+     * Args:
+     *   fd: file descriptor to write to
+     *   buffer_size: size of the buffer in bytes, at least 64
+     *
+     * Throws:
+     *   std::invalid_argument if buffer_size is less than 64
+     */
+    explicit PathWriter(int fd, std::size_t buffer_size = BEZ_PATH_WRITER_BUFFER_SIZE);
+
+    /*
+     * constructor
+     *
+     * Passes the formatted text to a callback, which must use or copy it
+     * before returning.
+     *
+     * Args:
+     *   sink: function called with each full buffer
+     *   buffer_size: size of the buffer in bytes, at least 64
+     *
+     * Throws:
+     *   std::invalid_argument if buffer_size is less than 64
+     */
+    explicit PathWriter(Sink sink, std::size_t buffer_size = BEZ_PATH_WRITER_BUFFER_SIZE);
+
+    /*
+     * destructor
+     *
+     * Flushes the buffer, ignoring errors. Call flush first to see them.
+     */
+    ~PathWriter(void);
+
+    PathWriter(const PathWriter&) = delete;
+    PathWriter& operator=(const PathWriter&) = delete;
+
+
+    //*************************************************************************
+    // Settings
+    //*************************************************************************
+
+    /*
+     * function: setPrecision
+     *
+     * Sets the number of decimals written, or BEZ_SHORTEST for the shortest
+     * form that reads back to the same value, which is the default.
+     */
+    void setPrecision(int decimals);
+    int getPrecision(void) const;
+
+
+    //*************************************************************************
+    // Writing procedures
+    //*************************************************************************
+
+    /*
+     * function: writeSvgPath
+     *
+     * Writes the path data of a spline, ending with Z if it is closed.
+     */
+    void writeSvgPath(const Curve2D& curve);
+
+    /*
+     * function: writeSvgPath
+     *
+     * Writes the path data of raw cubic Bezier curves of 4 points each, such
+     * as PathSegments2D::cubics. A new subpath starts wherever a curve does
+     * not begin at the end of the previous one.
+     *
+     * Args:
+     *   cubics: 4 * bezier_count points
+     *   bezier_count: number of Bezier curves
+     */
+    void writeSvgPath(const bezVect2D* cubics, std::size_t bezier_count);
+
+    /*
+     * function: writeSvgPolyline
+     *
+     * Writes the path data of a polyline, such as the output of tessellate.
+     */
+    void writeSvgPolyline(const bezVect2D* points, std::size_t count);
+
+    /*
+     * function: writeCsv
+     *
+     * Writes the points of a spline as in Curve::points, anchor points and
+     * control points alternating, one per line.
+     */
+    template <std::size_t Dim, typename T>
+    void writeCsv(const Curve<Dim, T>& curve);
+
+    /*
+     * function: writeCsv
+     *
+     * Writes raw points, such as raw cubic Bezier curves or the output of
+     * tessellate, one per line.
+     */
+    template <std::size_t Dim, typename T>
+    void writeCsv(const std::array<T, Dim>* points, std::size_t count);
+
+    /*
+     * function: write
+     *
+     * Writes text as is, such as the surrounding SVG elements or a CSV
+     * header.
+     */
+    void write(const char* text, std::size_t size);
+
+    /*
+     * function: flush
+     *
+     * Hands the buffered text to the file descriptor or callback.
+     *
+     * Throws:
+     *   std::runtime_error if writing to the file descriptor fails
+     */
+    void flush(void);
+
+    /*
+     * function: bytesWritten
+     *
+     * Returns the number of bytes formatted so far, flushed or not.
+     */
+    std::size_t bytesWritten(void) const;
+
+
+//private:
+    //*************************************************************************
+    // Hidden procedures
+    //*************************************************************************
+
+    /*
+     * function: reserve
+     *
+     * Flushes if fewer than size bytes are left in the buffer.
+     */
+    void reserve(std::size_t size);
+
+    /*
+     * function: put
+     *
+     * Appends a number to the buffer, flushing first if needed.
+     */
+    template <typename T>
+    void put(T value);
+
+    /*
+     * function: putPoint
+     *
+     * Appends the coordinates of a point separated by the given character.
+     */
+    template <std::size_t Dim, typename T>
+    void putPoint(const std::array<T, Dim>& point, char separator);
+
+
+    //*************************************************************************
+    // Internal attributes
+    //*************************************************************************
+    int fd;  // File descriptor to write to, or -1 to call sink
+    Sink sink;  // Callback to write to
+    std::unique_ptr<char[]> buffer;  // Text not flushed yet
+    std::size_t buffer_size;  // Capacity of buffer in bytes
+    std::size_t used;  // Bytes of buffer in use
+    std::size_t flushed;  // Bytes flushed so far
+    int precision;  // Decimals written, or BEZ_SHORTEST
+};
+
+#endif
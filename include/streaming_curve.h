@@ -0,0 +1,187 @@
+/*
+ * streaming_curve.h
+ *
+ * Defines the class template StreamingCurve, a C2 spline through the most
+ * recent anchor points of an unbounded stream.
+ */
+
+#ifndef BEZIER_STREAMING_CURVE_H
+#define BEZIER_STREAMING_CURVE_H
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include "curve.h"
+
+
+//*****************************************************************************
+//* STREAMINGCURVE
+//*****************************************************************************
+
+/*
+ * class: StreamingCurve
+ *
+ * Keeps the last capacity() anchor points of a stream in a ring buffer,
+ * together with the control points of the Bezier curves between them.
+ *
+ * Appending an anchor point only changes the right-hand side of the last rows
+ * of the C2 system, and that change decays by a factor of about 0.27 per row,
+ * so only the last BEZ_LOCAL_SOLVE_MARGIN rows are re-solved. Once the buffer
+ * is full, each append retires the oldest anchor point by advancing the start
+ * of the ring, leaving the remaining Bezier curves as they were. Appends
+ * therefore take constant time and no memory is allocated after
+ * construction.
+ *
+ * The spline matches a Curve built from the same anchor points up to
+ * rounding error until the first anchor point is retired. The class also
+ * provides the layout interface of curve_layout.h.
+ *
+ * Template args:
+ *   Dim: number of coordinates per point
+ *   T: floating point type of the coordinates
+ */
+template <std::size_t Dim, typename T>
+class StreamingCurve {
+public:
+    static const std::size_t dims = Dim;
+    typedef T value_type;
+    typedef std::array<T, Dim> Vect;  // Type of a single point
+
+
+    //*************************************************************************
+    // Constructors/Destructors
+    //*************************************************************************
+
+    /*
+     * constructor
+     *
+     * Constructs an empty spline that keeps at most capacity anchor points.
+     *
+     * Args:
+     *   capacity: number of anchor points to keep, at least 2
+     *
+     * Throws:
+     *   std::invalid_argument if capacity < 2
+     */
+    explicit StreamingCurve(std::size_t capacity);
+
+
+    //*************************************************************************
+    // Access functions
+    //*************************************************************************
+
+    /*
+     * function: getPositionAt
+     *
+     * Returns the coordinates of the spline evaluated at the given t, spread
+     * evenly over the Bezier curves currently kept.
+     *
+     * Args:
+     *   t: parameter value in the range [0, 1]
+     */
+    Vect getPositionAt(T t) const;
+
+    /*
+     * function: anchorCount
+     *
+     * Returns the number of anchor points currently kept.
+     */
+    std::size_t anchorCount(void) const;
+
+    /*
+     * function: capacity
+     *
+     * Returns the largest number of anchor points kept at once.
+     */
+    std::size_t capacity(void) const;
+
+    /*
+     * function: streamLength
+     *
+     * Returns the number of anchor points appended since construction or the
+     * last clear, retired ones included.
+     */
+    std::size_t streamLength(void) const;
+
+    /*
+     * function: getAnchor
+     *
+     * Returns the coordinates of the anchor point at the given index, 0 being
+     * the oldest one kept.
+     *
+     * Args:
+     *   i: index of point, less than anchorCount()
+     */
+    const Vect& getAnchor(std::size_t i) const;
+
+    std::size_t segmentCount(void) const;
+    T get(std::size_t s, std::size_t p, std::size_t d) const;
+
+
+    //*************************************************************************
+    // Manipulation procedures
+    //*************************************************************************
+
+    /*
+     * function: append
+     *
+     * Adds an anchor point after the newest one, retiring the oldest if the
+     * buffer is full, and updates the affected control points.
+     *
+     * Args:
+     *   position: the position of the new anchor point
+     */
+    void append(const Vect& position);
+
+    /*
+     * function: clear
+     *
+     * Removes all anchor points, keeping the buffer.
+     */
+    void clear(void);
+
+
+//private:
+    //*************************************************************************
+    // Hidden procedures
+    //*************************************************************************
+
+    /*
+     * struct: Slot
+     *
+     * Everything stored for one anchor point of the ring.
+     */
+    struct Slot {
+        Vect anchor;  // The anchor point
+        Vect control1;  // Control points of the Bezier curve from this
+        Vect control2;  // anchor point to the next
+        Vect B_point;  // Solution of the C2 system for this anchor point
+    };
+
+    /*
+     * function: slot
+     *
+     * Returns the ring slot of the anchor point with the given stream index.
+     */
+    Slot& slot(std::size_t i);
+    const Slot& slot(std::size_t i) const;
+
+
+    //*************************************************************************
+    // Internal attributes
+    //*************************************************************************
+    std::vector<Slot> ring;  // capacity() slots
+    std::size_t begin;  // Stream index of the oldest anchor point kept
+    std::size_t end;  // Stream index one past the newest anchor point
+};
+
+
+//*****************************************************************************
+//* STREAMINGCURVE2D/STREAMINGCURVE3D
+//*****************************************************************************
+
+typedef StreamingCurve<2, BEZ_DTYPE> StreamingCurve2D;
+typedef StreamingCurve<3, BEZ_DTYPE> StreamingCurve3D;
+
+#endif
@@ -0,0 +1,223 @@
+/*
+ * svg_path.h
+ *
+ * Defines the class template PathSegments, which holds loose cubic and
+ * quadratic Bezier curves, and the class SvgPathParser, which fills one from
+ * SVG path data.
+ */
+
+#ifndef BEZIER_SVG_PATH_H
+#define BEZIER_SVG_PATH_H
+
+#include <array>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "curve.h"
+
+
+//*****************************************************************************
+//* PATHSEGMENTS
+//*****************************************************************************
+
+/*
+ * class: PathSegments
+ *
+ * Holds Bezier curves that need not join smoothly, such as those of an SVG
+ * path, grouped into subpaths. Each cubic Bezier curve takes 4 consecutive
+ * points and each quadratic one 3, in the order the bez2* functions take
+ * them, and the cubic ones are presented through the layout interface of
+ * curve_layout.h so the batch kernels run on them directly.
+ *
+ * Template args:
+ *   Dim: number of coordinates per point
+ *   T: floating point type of the coordinates
+ */
+template <std::size_t Dim, typename T>
+class PathSegments {
+public:
+    static const std::size_t dims = Dim;
+    typedef T value_type;
+    typedef std::array<T, Dim> Vect;  // Type of a single point
+
+    /*
+     * struct: Subpath
+     *
+     * Where a subpath starts in each array of Bezier curves.
+     */
+    struct Subpath {
+        std::size_t cubic_begin;  // Index of first cubic Bezier curve
+        std::size_t quadratic_begin;  // Index of first quadratic Bezier curve
+        bool closed;  // Whether the subpath ends by returning to its start
+    };
+
+    std::size_t segmentCount(void) const;
+    T get(std::size_t s, std::size_t p, std::size_t d) const;
+
+    /*
+     * function: quadraticCount
+     *
+     * Returns the number of quadratic Bezier curves.
+     */
+    std::size_t quadraticCount(void) const;
+
+    /*
+     * function: clear
+     *
+     * Removes every Bezier curve and subpath, keeping the allocated storage.
+     */
+    void clear(void);
+
+    std::vector<Vect> cubics;  // 4 points per cubic Bezier curve
+    std::vector<Vect> quadratics;  // 3 points per quadratic Bezier curve
+    std::vector<Subpath> subpaths;  // In the order they were started
+};
+
+
+//*****************************************************************************
+//* SVGPATHPARSER
+//*****************************************************************************
+
+/*
+ * class: SvgPathParser
+ *
+ * Parses the data of SVG path elements in one pass, in chunks of any size,
+ * and appends the Bezier curves to a PathSegments2D.
+ *
+ * Supports the commands M, L, H, V, C, S, Q, T and Z in both absolute and
+ * relative form, with implicit repetition. Straight lines are emitted as
+ * cubic Bezier curves with evenly spaced control points, which represent them
+ * exactly. Quadratic Bezier curves are kept as such unless the parser is told
+ * to elevate them to cubic ones. Arc commands are not supported.
+ *
+ * Numbers are read in place with std::from_chars. Only a number cut off by
+ * the end of a chunk is copied, into a small buffer reused for the whole
+ * parse, so the only allocations are those of the output.
+ */
+class SvgPathParser {
+public:
+    typedef bezVect2D Vect;
+
+
+    //*************************************************************************
+    // Constructors/Destructors
+    //*************************************************************************
+
+    /*
+     * constructor
+     *
+     * Args:
+     *   out: segments to append to
+     *   elevate_quadratics: whether to emit quadratic Bezier curves as cubic
+     */
+    explicit SvgPathParser(PathSegments<2, BEZ_DTYPE>& out, bool elevate_quadratics = false);
+
+
+    //*************************************************************************
+    // Parsing procedures
+    //*************************************************************************
+
+    /*
+     * function: feed
+     *
+     * Parses the next chunk of path data.
+     *
+     * Args:
+     *   data: characters of the chunk
+     *   size: number of characters
+     *
+     * Throws:
+     *   std::invalid_argument if the data is not valid path data
+     */
+    void feed(const char* data, std::size_t size);
+
+    /*
+     * function: finish
+     *
+     * Parses whatever is left of the path data and gets ready for another
+     * path.
+     *
+     * Throws:
+     *   std::invalid_argument if the data ends part way through a command
+     */
+    void finish(void);
+
+
+//private:
+    //*************************************************************************
+    // Hidden procedures
+    //*************************************************************************
+
+    /*
+     * function: parse
+     *
+     * Parses the given characters. If terminated is false and the last number
+     * runs up to the end, that number is left in carry instead.
+     */
+    void parse(const char* data, std::size_t size, bool terminated);
+
+    /*
+     * function: execute
+     *
+     * Emits the Bezier curve of the current command from args.
+     */
+    void execute(void);
+
+    void lineTo(const Vect& p);
+    void cubicTo(const Vect& c1, const Vect& c2, const Vect& p);
+    void quadraticTo(const Vect& c, const Vect& p);
+    void startSubpath(void);
+
+    /*
+     * function: fail
+     *
+     * Throws std::invalid_argument with the given message and the offset of
+     * the current chunk.
+     */
+    [[noreturn]] void fail(const char* message) const;
+
+
+    //*************************************************************************
+    // Internal attributes
+    //*************************************************************************
+    PathSegments<2, BEZ_DTYPE>& out;  // Segments to append to
+    bool elevate_quadratics;  // Whether to emit quadratics as cubics
+
+    char command;  // Current command letter, or 0 before the first
+    char previous;  // Command of the previous Bezier curve, made absolute
+    BEZ_DTYPE args[6];  // Numbers read so far for the current command
+    std::size_t arg_count;  // Number of values in args
+    bool awaiting_args;  // Whether the command letter read last has not
+                         // been given its arguments yet
+    bool open_subpath;  // Whether the current subpath has a Subpath entry
+
+    Vect current;  // Current point
+    Vect start;  // First point of the current subpath
+    Vect control;  // Last control point, for reflection by S and T
+
+    std::string carry;  // Number cut off by the end of the previous chunk
+    std::size_t offset;  // Characters fed before the current chunk
+};
+
+
+/*
+ * function: parseSvgPath
+ *
+ * Parses one complete SVG path and appends its Bezier curves to out.
+ *
+ * Throws:
+ *   std::invalid_argument if the data is not valid path data
+ */
+void parseSvgPath(const char* data, std::size_t size, PathSegments<2, BEZ_DTYPE>& out,
+                  bool elevate_quadratics = false);
+
+
+//*****************************************************************************
+//* PATHSEGMENTS2D/PATHSEGMENTS3D
+//*****************************************************************************
+
+typedef PathSegments<2, BEZ_DTYPE> PathSegments2D;
+typedef PathSegments<3, BEZ_DTYPE> PathSegments3D;
+
+#endif
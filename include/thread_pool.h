@@ -0,0 +1,151 @@
+/*
+ * thread_pool.h
+ *
+ * Defines the interface for the class ThreadPool, a fixed set of worker
+ * threads used by the parallel spline procedures.
+ */
+
+#ifndef BEZIER_THREAD_POOL_H
+#define BEZIER_THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+//*****************************************************************************
+//* THREADPOOL
+//*****************************************************************************
+
+/*
+ * class: ThreadPool
+ *
+ * Runs batches of indexed tasks on a fixed set of worker threads. The calling
+ * thread takes part in every batch, so a pool of n threads starts n - 1
+ * workers.
+ */
+class ThreadPool {
+public:
+    //*************************************************************************
+    // Constructors/Destructors
+    //*************************************************************************
+
+    /*
+     * constructor
+     *
+     * Starts thread_count - 1 worker threads.
+     *
+     * Args:
+     *   thread_count: total number of threads, including the caller of run
+     */
+    explicit ThreadPool(std::size_t thread_count);
+
+    /*
+     * destructor
+     *
+     * Stops and joins the worker threads.
+     */
+    ~ThreadPool(void);
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+
+    //*************************************************************************
+    // Access functions
+    //*************************************************************************
+
+    /*
+     * function: threadCount
+     *
+     * Returns the number of threads that execute tasks, including the caller.
+     */
+    std::size_t threadCount(void) const;
+
+    /*
+     * function: shared
+     *
+     * Returns a process-wide pool with one thread per hardware thread, or as
+     * many as setSharedThreadCount asked for, creating it on first use. Its
+     * tasks may read dirty splines, since a solve they trigger on it runs
+     * serially, see run.
+     */
+    static ThreadPool& shared(void);
+
+    /*
+     * function: setSharedThreadCount
+     *
+     * Sets the number of threads the shared pool is created with, or restores
+     * one per hardware thread if thread_count is zero. Has no effect once
+     * shared has been called, and must not race with its first call.
+     *
+     * Args:
+     *   thread_count: total number of threads of the shared pool
+     */
+    static void setSharedThreadCount(std::size_t thread_count);
+
+
+    //*************************************************************************
+    // Execution procedures
+    //*************************************************************************
+
+    /*
+     * function: run
+     *
+     * Calls task(i) for every i in [0, task_count) and returns once all calls
+     * have finished. Tasks are handed out dynamically, so their order is
+     * unspecified. Tasks must not throw. Concurrent calls are serialized.
+     * A call from one of this pool's own tasks runs its tasks serially on the
+     * calling thread, since the batch it belongs to holds the pool.
+     *
+     * Args:
+     *   task_count: number of tasks to run
+     *   task: function to call with each task index
+     */
+    void run(std::size_t task_count, const std::function<void(std::size_t)>& task);
+
+
+private:
+    //*************************************************************************
+    // Hidden procedures
+    //*************************************************************************
+
+    /*
+     * function: workerLoop
+     *
+     * Body of each worker thread. Waits for a batch, drains it, and reports
+     * back until the pool is destroyed.
+     */
+    void workerLoop(void);
+
+    /*
+     * function: drain
+     *
+     * Claims and runs tasks from the current batch until none are left.
+     */
+    void drain(void);
+
+
+    //*************************************************************************
+    // Internal attributes
+    //*************************************************************************
+    std::vector<std::thread> workers;  // Threads other than the caller
+
+    std::mutex run_mutex;  // Serializes calls to run
+    std::mutex mutex;  // Guards the batch state below
+    std::condition_variable start_cv;  // Signalled when a batch starts
+    std::condition_variable done_cv;  // Signalled when the last worker finishes
+
+    const std::function<void(std::size_t)>* task;  // Task of current batch
+    std::size_t task_count;  // Number of tasks in current batch
+    std::atomic<std::size_t> next_task;  // Index of next unclaimed task
+    std::size_t generation;  // Incremented for every batch
+    std::size_t busy_workers;  // Workers yet to finish the current batch
+    bool stopping;  // Set when the pool is being destroyed
+};
+
+#endif
@@ -8,6 +8,9 @@
 
 #include <math.h>
 
+#include "bezier_math.h"
+#include "bezier_stats.h"
+
 
 //*****************************************************************************
 //* EVALUATE
@@ -434,6 +437,95 @@ void bez2DerivativeLinear(BEZ_DTYPE x0, BEZ_DTYPE y0,
 }
 
 
+//*****************************************************************************
+//* MATH
+//*****************************************************************************
+
+/*
+ * function: bezFastRsqrt
+ *
+ * Returns 1 / sqrt(x) within BEZ_FAST_RSQRT_MAX_ULP, refining the hardware
+ * estimate with one Newton step. Falls back to BEZ_SQRT_FUNC without SSE or
+ * when BEZ_DTYPE is not float.
+ *
+ * Args:
+ *   x: finite value no smaller than the smallest normal float
+ */
+BEZ_DTYPE bezFastRsqrt(BEZ_DTYPE x) {
+#if defined(BEZ_HAVE_SSE)
+    if (sizeof(BEZ_DTYPE) == sizeof(float)) {
+        float xf = (float)(x);
+        float r = _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(xf)));
+
+        // r (1 + (1 - x r^2) / 2) squares the relative error of r
+        return r + .5f * r * (1.f - xf * r * r);
+    }
+#endif
+    return 1. / BEZ_SQRT_FUNC(x);
+}
+
+/*
+ * function: bezFastSqrt
+ *
+ * Returns sqrt(x) within BEZ_FAST_SQRT_MAX_ULP, as x times the estimate of
+ * 1 / sqrt(x) refined with one Newton step. Values below the smallest normal
+ * float, including zero, give zero, which is off by less than 1.1e-19.
+ * Falls back to BEZ_SQRT_FUNC without SSE or when BEZ_DTYPE is not float.
+ *
+ * Args:
+ *   x: finite value, at least zero
+ */
+BEZ_DTYPE bezFastSqrt(BEZ_DTYPE x) {
+#if defined(BEZ_HAVE_SSE)
+    if (sizeof(BEZ_DTYPE) == sizeof(float)) {
+        return _mm_cvtss_f32(bezFastSqrtPs(_mm_set_ss((float)(x))));
+    }
+#endif
+    return BEZ_SQRT_FUNC(x);
+}
+
+/*
+ * function: bezFastSqrt4
+ *
+ * Computes bezFastSqrt of four values at once with SSE.
+ *
+ * Args:
+ *   in: four values as for bezFastSqrt
+ *   out: where the four square roots are stored, may be in
+ */
+void bezFastSqrt4(const BEZ_DTYPE* in, BEZ_DTYPE* out) {
+#if defined(BEZ_HAVE_SSE)
+    if (sizeof(BEZ_DTYPE) == sizeof(float)) {
+        _mm_storeu_ps((float*)(out), bezFastSqrtPs(_mm_loadu_ps((const float*)(in))));
+        return;
+    }
+#endif
+    out[0] = bezFastSqrt(in[0]);
+    out[1] = bezFastSqrt(in[1]);
+    out[2] = bezFastSqrt(in[2]);
+    out[3] = bezFastSqrt(in[3]);
+}
+
+/*
+ * function: bezFastReciprocal
+ *
+ * Returns 1 / x within BEZ_FAST_RECIPROCAL_MAX_ULP, refining the hardware
+ * estimate with one Newton step. Falls back to division without SSE or when
+ * BEZ_DTYPE is not float.
+ *
+ * Args:
+ *   x: normal value of magnitude below 2^126
+ */
+BEZ_DTYPE bezFastReciprocal(BEZ_DTYPE x) {
+#if defined(BEZ_HAVE_SSE)
+    if (sizeof(BEZ_DTYPE) == sizeof(float)) {
+        return _mm_cvtss_f32(bezFastReciprocalPs(_mm_set_ss((float)(x))));
+    }
+#endif
+    return 1. / x;
+}
+
+
 //*****************************************************************************
 //* BOUNDING BOX
 //*****************************************************************************
@@ -463,6 +555,8 @@ void bez2BoundingBox(BEZ_DTYPE x0, BEZ_DTYPE y0,
     BEZ_DTYPE temp1, temp2;
     int num_t;
 
+    BEZ_STATS_ADD(bounding_box_calls, 1);
+
     // CALCULATE MIN/MAX FOR X
     a = -x0 + 3. * x1 - 3. * x2 + x3;
     b = 2. * (x0 - 2. * x1 + x2);
@@ -477,35 +571,51 @@ void bez2BoundingBox(BEZ_DTYPE x0, BEZ_DTYPE y0,
         *x_max = x0;
     }
 
-    disc = b * b - 4. * a * c;
+    if (a != 0.) {
+        disc = b * b - 4. * a * c;
 
-    if (disc > 0.) {
-        sqrtdisc = BEZ_SQRT_FUNC(disc);
+        if (disc > 0.) {
+            sqrtdisc = BEZ_KERNEL_SQRT(disc);
 
-        temp1 = 1. / (2. * a);
-        temp2 = -b;
+            temp1 = BEZ_KERNEL_RECIPROCAL(2. * a);
+            temp2 = -b;
 
-        t0 = (temp2 - sqrtdisc) * temp1;
-        t1 = (temp2 + sqrtdisc) * temp1;
+            t0 = (temp2 - sqrtdisc) * temp1;
+            t1 = (temp2 + sqrtdisc) * temp1;
 
-        if (t0 < 0. || t0 > 1.) {
-            if (t1 < 0. || t1 > 1.) {
+            if (t0 < 0. || t0 > 1.) {
+                if (t1 < 0. || t1 > 1.) {
+                    num_t = 0;
+                }
+                else {
+                    t0 = t1;
+                    num_t = 1;
+                }
+            }
+            else if (t1 < 0. || t1 > 1.) {
+                num_t = 1;
+            }
+            else {
+                num_t = 2;
+            }
+        }
+        else if (disc == 0.) {
+            t0 = -b / (2. * a);
+
+            if (t0 < 0. || t0 > 1.) {
                 num_t = 0;
             }
             else {
-                t0 = t1;
                 num_t = 1;
             }
         }
-        else if (t1 < 0. || t1 > 1.) {
-            num_t = 1;
-        }
         else {
-            num_t = 2;
+            num_t = 0;
         }
     }
-    else if (disc == 0.) {
-        t0 = -b / (2. * a);
+    else if (b != 0.) {
+        // the derivative is linear, with its root at -c / b
+        t0 = -c / b;
 
         if (t0 < 0. || t0 > 1.) {
             num_t = 0;
@@ -518,6 +628,9 @@ void bez2BoundingBox(BEZ_DTYPE x0, BEZ_DTYPE y0,
         num_t = 0;
     }
 
+    BEZ_STATS_ADD(bounding_box_extrema[num_t], 1);
+    BEZ_STATS_ADD(bounding_box_degenerate, a == 0.);
+
     switch (num_t) {
     case 2:
         bez2Evaluate(x0, y0, x1, y1, x2, y2, x3, y3, t0, &temp1, &temp2);
@@ -562,35 +675,51 @@ void bez2BoundingBox(BEZ_DTYPE x0, BEZ_DTYPE y0,
         *y_max = y0;
     }
 
-    disc = b * b - 4. * a * c;
+    if (a != 0.) {
+        disc = b * b - 4. * a * c;
 
-    if (disc > 0.) {
-        sqrtdisc = BEZ_SQRT_FUNC(disc);
+        if (disc > 0.) {
+            sqrtdisc = BEZ_KERNEL_SQRT(disc);
 
-        temp1 = 1. / (2. * a);
-        temp2 = -b;
+            temp1 = BEZ_KERNEL_RECIPROCAL(2. * a);
+            temp2 = -b;
 
-        t0 = (temp2 - sqrtdisc) * temp1;
-        t1 = (temp2 + sqrtdisc) * temp1;
+            t0 = (temp2 - sqrtdisc) * temp1;
+            t1 = (temp2 + sqrtdisc) * temp1;
 
-        if (t0 < 0. || t0 > 1.) {
-            if (t1 < 0. || t1 > 1.) {
+            if (t0 < 0. || t0 > 1.) {
+                if (t1 < 0. || t1 > 1.) {
+                    num_t = 0;
+                }
+                else {
+                    t0 = t1;
+                    num_t = 1;
+                }
+            }
+            else if (t1 < 0. || t1 > 1.) {
+                num_t = 1;
+            }
+            else {
+                num_t = 2;
+            }
+        }
+        else if (disc == 0.) {
+            t0 = -b / (2. * a);
+
+            if (t0 < 0. || t0 > 1.) {
                 num_t = 0;
             }
             else {
-                t0 = t1;
                 num_t = 1;
             }
         }
-        else if (t1 < 0. || t1 > 1.) {
-            num_t = 1;
-        }
         else {
-            num_t = 2;
+            num_t = 0;
         }
     }
-    else if (disc == 0.) {
-        t0 = -b / (2. * a);
+    else if (b != 0.) {
+        // the derivative is linear, with its root at -c / b
+        t0 = -c / b;
 
         if (t0 < 0. || t0 > 1.) {
             num_t = 0;
@@ -603,6 +732,9 @@ void bez2BoundingBox(BEZ_DTYPE x0, BEZ_DTYPE y0,
         num_t = 0;
     }
 
+    BEZ_STATS_ADD(bounding_box_extrema[num_t], 1);
+    BEZ_STATS_ADD(bounding_box_degenerate, a == 0.);
+
     switch (num_t) {
     case 2:
         bez2Evaluate(x0, y0, x1, y1, x2, y2, x3, y3, t0, &temp1, &temp2);
@@ -658,23 +790,28 @@ BEZ_DTYPE bez2IsFlat(BEZ_DTYPE x0, BEZ_DTYPE y0,
                      BEZ_DTYPE flatness_threshold) {
     BEZ_DTYPE hull_perimeter;
     BEZ_DTYPE anchor_distance;
+    BEZ_DTYPE lengths[4];  // of the sides of the hull, squared at first
     BEZ_DTYPE temp1, temp2;
 
     temp1 = x0 - x1;
     temp2 = y0 - y1;
-    hull_perimeter = BEZ_SQRT_FUNC(temp1 * temp1 + temp2 * temp2);
+    lengths[0] = temp1 * temp1 + temp2 * temp2;
 
     temp1 = x1 - x2;
     temp2 = y1 - y2;
-    hull_perimeter += BEZ_SQRT_FUNC(temp1 * temp1 + temp2 * temp2);
+    lengths[1] = temp1 * temp1 + temp2 * temp2;
 
     temp1 = x2 - x3;
     temp2 = y2 - y3;
-    hull_perimeter += BEZ_SQRT_FUNC(temp1 * temp1 + temp2 * temp2);
+    lengths[2] = temp1 * temp1 + temp2 * temp2;
 
     temp1 = x0 - x3;
     temp2 = y0 - y3;
-    anchor_distance = BEZ_SQRT_FUNC(temp1 * temp1 + temp2 * temp2);
+    lengths[3] = temp1 * temp1 + temp2 * temp2;
+
+    BEZ_KERNEL_SQRT4(lengths, lengths);
+    hull_perimeter = lengths[0] + lengths[1] + lengths[2];
+    anchor_distance = lengths[3];
 
     if (hull_perimeter <= flatness_threshold * anchor_distance) {
         return BEZ_TRUE;
@@ -690,9 +827,10 @@ BEZ_DTYPE bez2IsFlat(BEZ_DTYPE x0, BEZ_DTYPE y0,
 //*****************************************************************************
 
 /*
- * function: bez2ArcLength
+ * function: bez2ArcLengthRecursive
  * 
- * Returns the approximate arc length of the cubic Bezier curve.
+ * Returns the approximate arc length of the cubic Bezier curve, which is
+ * depth halvings deep into the curve passed to bez2ArcLength.
  * 
  * Args:
  *   x0, y0: coordinates of first anchor point
@@ -700,34 +838,45 @@ BEZ_DTYPE bez2IsFlat(BEZ_DTYPE x0, BEZ_DTYPE y0,
  *   x2, y2: coordinates of second control point
  *   x3, y3: coordinates of second anchor point
  *   flatness_threshold: max ratio of hull perimeter to anchor distance for flat
+ *   depth: number of times the curve has been split
  */
-BEZ_DTYPE bez2ArcLength(BEZ_DTYPE x0, BEZ_DTYPE y0,
-                        BEZ_DTYPE x1, BEZ_DTYPE y1,
-                        BEZ_DTYPE x2, BEZ_DTYPE y2,
-                        BEZ_DTYPE x3, BEZ_DTYPE y3,
-                        BEZ_DTYPE flatness_threshold) {
+static BEZ_DTYPE bez2ArcLengthRecursive(BEZ_DTYPE x0, BEZ_DTYPE y0,
+                                        BEZ_DTYPE x1, BEZ_DTYPE y1,
+                                        BEZ_DTYPE x2, BEZ_DTYPE y2,
+                                        BEZ_DTYPE x3, BEZ_DTYPE y3,
+                                        BEZ_DTYPE flatness_threshold,
+                                        int depth) {
     {
         BEZ_DTYPE hull_perimeter;
         BEZ_DTYPE anchor_distance;
+        BEZ_DTYPE lengths[4];  // of the sides of the hull, squared at first
         BEZ_DTYPE temp_x, temp_y;
 
         temp_x = x0 - x1;
         temp_y = y0 - y1;
-        hull_perimeter = BEZ_SQRT_FUNC(temp_x * temp_x + temp_y * temp_y);
+        lengths[0] = temp_x * temp_x + temp_y * temp_y;
 
         temp_x = x1 - x2;
         temp_y = y1 - y2;
-        hull_perimeter += BEZ_SQRT_FUNC(temp_x * temp_x + temp_y * temp_y);
+        lengths[1] = temp_x * temp_x + temp_y * temp_y;
 
         temp_x = x2 - x3;
         temp_y = y2 - y3;
-        hull_perimeter += BEZ_SQRT_FUNC(temp_x * temp_x + temp_y * temp_y);
+        lengths[2] = temp_x * temp_x + temp_y * temp_y;
 
         temp_x = x0 - x3;
         temp_y = y0 - y3;
-        anchor_distance = BEZ_SQRT_FUNC(temp_x * temp_x + temp_y * temp_y);
+        lengths[3] = temp_x * temp_x + temp_y * temp_y;
+
+        BEZ_KERNEL_SQRT4(lengths, lengths);
+        hull_perimeter = lengths[0] + lengths[1] + lengths[2];
+        anchor_distance = lengths[3];
 
-        if (hull_perimeter <= flatness_threshold * anchor_distance) {
+        if (hull_perimeter <= flatness_threshold * anchor_distance ||
+            depth >= BEZ_ARC_LENGTH_MAX_DEPTH) {
+            BEZ_STATS_ADD(arc_length_leaves, 1);
+            BEZ_STATS_MAX(arc_length_max_depth, depth);
+            BEZ_STATS_ADD(arc_length_depth_limited, hull_perimeter > flatness_threshold * anchor_distance);
             return (hull_perimeter + anchor_distance) * .5;
         }
     }
@@ -746,12 +895,12 @@ BEZ_DTYPE bez2ArcLength(BEZ_DTYPE x0, BEZ_DTYPE y0,
                    &d1, &e1,
                    &d2, &e2,
                    &d3, &e3);
-    return bez2ArcLength(a0, b0, a1, b1, a2, b2, a3, b3, flatness_threshold) +
-        bez2ArcLength(d0, e0, d1, e1, d2, e2, d3, e3, flatness_threshold);
+    return bez2ArcLengthRecursive(a0, b0, a1, b1, a2, b2, a3, b3, flatness_threshold, depth + 1) +
+        bez2ArcLengthRecursive(d0, e0, d1, e1, d2, e2, d3, e3, flatness_threshold, depth + 1);
 }
 
 /*
- * function: bez3ArcLength
+ * function: bez2ArcLength
  * 
  * Returns the approximate arc length of the cubic Bezier curve.
  * 
@@ -762,36 +911,69 @@ BEZ_DTYPE bez2ArcLength(BEZ_DTYPE x0, BEZ_DTYPE y0,
  *   x3, y3: coordinates of second anchor point
  *   flatness_threshold: max ratio of hull perimeter to anchor distance for flat
  */
-BEZ_DTYPE bez3ArcLength(BEZ_DTYPE x0, BEZ_DTYPE y0, BEZ_DTYPE z0,
-                        BEZ_DTYPE x1, BEZ_DTYPE y1, BEZ_DTYPE z1,
-                        BEZ_DTYPE x2, BEZ_DTYPE y2, BEZ_DTYPE z2,
-                        BEZ_DTYPE x3, BEZ_DTYPE y3, BEZ_DTYPE z3,
+BEZ_DTYPE bez2ArcLength(BEZ_DTYPE x0, BEZ_DTYPE y0,
+                        BEZ_DTYPE x1, BEZ_DTYPE y1,
+                        BEZ_DTYPE x2, BEZ_DTYPE y2,
+                        BEZ_DTYPE x3, BEZ_DTYPE y3,
                         BEZ_DTYPE flatness_threshold) {
+    BEZ_STATS_ADD(arc_length_calls, 1);
+    return bez2ArcLengthRecursive(x0, y0, x1, y1, x2, y2, x3, y3, flatness_threshold, 0);
+}
+
+/*
+ * function: bez3ArcLengthRecursive
+ * 
+ * Returns the approximate arc length of the cubic Bezier curve, which is
+ * depth halvings deep into the curve passed to bez3ArcLength.
+ * 
+ * Args:
+ *   x0, y0: coordinates of first anchor point
+ *   x1, y1: coordinates of first control point
+ *   x2, y2: coordinates of second control point
+ *   x3, y3: coordinates of second anchor point
+ *   flatness_threshold: max ratio of hull perimeter to anchor distance for flat
+ *   depth: number of times the curve has been split
+ */
+static BEZ_DTYPE bez3ArcLengthRecursive(BEZ_DTYPE x0, BEZ_DTYPE y0, BEZ_DTYPE z0,
+                                        BEZ_DTYPE x1, BEZ_DTYPE y1, BEZ_DTYPE z1,
+                                        BEZ_DTYPE x2, BEZ_DTYPE y2, BEZ_DTYPE z2,
+                                        BEZ_DTYPE x3, BEZ_DTYPE y3, BEZ_DTYPE z3,
+                                        BEZ_DTYPE flatness_threshold,
+                                        int depth) {
     BEZ_DTYPE hull_perimeter;
     BEZ_DTYPE anchor_distance;
+    BEZ_DTYPE lengths[4];  // of the sides of the hull, squared at first
     BEZ_DTYPE temp_x, temp_y, temp_z;
 
     temp_x = x0 - x1;
     temp_y = y0 - y1;
     temp_z = z0 - z1;
-    hull_perimeter = BEZ_SQRT_FUNC(temp_x * temp_x + temp_y * temp_y + temp_z * temp_z);
+    lengths[0] = temp_x * temp_x + temp_y * temp_y + temp_z * temp_z;
 
     temp_x = x1 - x2;
     temp_y = y1 - y2;
     temp_z = z1 - z2;
-    hull_perimeter += BEZ_SQRT_FUNC(temp_x * temp_x + temp_y * temp_y + temp_z * temp_z);
+    lengths[1] = temp_x * temp_x + temp_y * temp_y + temp_z * temp_z;
 
     temp_x = x2 - x3;
     temp_y = y2 - y3;
     temp_z = z2 - z3;
-    hull_perimeter += BEZ_SQRT_FUNC(temp_x * temp_x + temp_y * temp_y + temp_z * temp_z);
+    lengths[2] = temp_x * temp_x + temp_y * temp_y + temp_z * temp_z;
 
     temp_x = x0 - x3;
     temp_y = y0 - y3;
     temp_z = z0 - z3;
-    anchor_distance = BEZ_SQRT_FUNC(temp_x * temp_x + temp_y * temp_y + temp_z * temp_z);
+    lengths[3] = temp_x * temp_x + temp_y * temp_y + temp_z * temp_z;
 
-    if (hull_perimeter <= flatness_threshold * anchor_distance) {
+    BEZ_KERNEL_SQRT4(lengths, lengths);
+    hull_perimeter = lengths[0] + lengths[1] + lengths[2];
+    anchor_distance = lengths[3];
+
+    if (hull_perimeter <= flatness_threshold * anchor_distance ||
+        depth >= BEZ_ARC_LENGTH_MAX_DEPTH) {
+        BEZ_STATS_ADD(arc_length_leaves, 1);
+        BEZ_STATS_MAX(arc_length_max_depth, depth);
+        BEZ_STATS_ADD(arc_length_depth_limited, hull_perimeter > flatness_threshold * anchor_distance);
         return (hull_perimeter + anchor_distance) * .5;
     }
     else {
@@ -816,7 +998,31 @@ BEZ_DTYPE bez3ArcLength(BEZ_DTYPE x0, BEZ_DTYPE y0, BEZ_DTYPE z0,
                        &d1, &e1, &f1,
                        &d2, &e2, &f2,
                        &d3, &e3, &f3);
-        return bez3ArcLength(a0, b0, c0, a1, b1, c1, a2, b2, c2, a3, b3, c3, flatness_threshold) +
-            bez3ArcLength(d0, e0, f0, d1, e1, f1, d2, e2, f2, d3, e3, f3, flatness_threshold);
+        return bez3ArcLengthRecursive(a0, b0, c0, a1, b1, c1, a2, b2, c2, a3, b3, c3,
+                                      flatness_threshold, depth + 1) +
+            bez3ArcLengthRecursive(d0, e0, f0, d1, e1, f1, d2, e2, f2, d3, e3, f3,
+                                   flatness_threshold, depth + 1);
     }
 }
+
+/*
+ * function: bez3ArcLength
+ * 
+ * Returns the approximate arc length of the cubic Bezier curve.
+ * 
+ * Args:
+ *   x0, y0: coordinates of first anchor point
+ *   x1, y1: coordinates of first control point
+ *   x2, y2: coordinates of second control point
+ *   x3, y3: coordinates of second anchor point
+ *   flatness_threshold: max ratio of hull perimeter to anchor distance for flat
+ */
+BEZ_DTYPE bez3ArcLength(BEZ_DTYPE x0, BEZ_DTYPE y0, BEZ_DTYPE z0,
+                        BEZ_DTYPE x1, BEZ_DTYPE y1, BEZ_DTYPE z1,
+                        BEZ_DTYPE x2, BEZ_DTYPE y2, BEZ_DTYPE z2,
+                        BEZ_DTYPE x3, BEZ_DTYPE y3, BEZ_DTYPE z3,
+                        BEZ_DTYPE flatness_threshold) {
+    BEZ_STATS_ADD(arc_length_calls, 1);
+    return bez3ArcLengthRecursive(x0, y0, z0, x1, y1, z1, x2, y2, z2, x3, y3, z3,
+                                  flatness_threshold, 0);
+}
@@ -0,0 +1,54 @@
+/*
+ * bezier_stats.c
+ *
+ * Implements the counters defined in bezier_stats.h.
+ */
+
+#include "bezier_stats.h"
+
+#include <string.h>
+
+#if defined(_MSC_VER)
+#define BEZ_THREAD_LOCAL __declspec(thread)
+#else
+#define BEZ_THREAD_LOCAL _Thread_local
+#endif
+
+
+// Counters of each thread, zero until it does any counted work
+static BEZ_THREAD_LOCAL bezStats bez_stats_local;
+
+
+//*****************************************************************************
+//* STATS
+//*****************************************************************************
+
+/*
+ * function: bezStatsSnapshot
+ *
+ * Copies the counters of the calling thread.
+ *
+ * Args:
+ *   out: where to copy them
+ */
+void bezStatsSnapshot(bezStats* out) {
+    *out = bez_stats_local;
+}
+
+/*
+ * function: bezStatsReset
+ *
+ * Sets the counters of the calling thread to zero.
+ */
+void bezStatsReset(void) {
+    memset(&bez_stats_local, 0, sizeof(bez_stats_local));
+}
+
+/*
+ * function: bezStatsLocal
+ *
+ * Returns the counters of the calling thread, for the counting macros.
+ */
+bezStats* bezStatsLocal(void) {
+    return &bez_stats_local;
+}
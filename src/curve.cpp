@@ -1,14 +1,21 @@
 /*
  * curve.cpp
  *
- * Implements the class Curve.
+ * Implements the class template Curve.
  */
 
 #include "curve.h"
 
 #include <stdlib.h>
+#include <math.h>
+
+#include <algorithm>
+#include <stdexcept>
 
 #include "bezier.h"
+#include "bezier_stats.h"
+#include "curve_trace.h"
+#include "thread_pool.h"
 
 #define BEZ_ONE_THIRD 0.33333333333333333333333333333
 #define BEZ_TWO_THIRDS 0.66666666666666666666666666666
@@ -23,8 +30,28 @@
  *
  * Constructs an empty spline.
  */
-Curve2D::Curve2D(void) :
-    anchor_count(0), bezier_count(0) {
+template <std::size_t Dim, typename T>
+Curve<Dim, T>::Curve(void) :
+    anchor_count(0), bezier_count(0), closed(false), parameterization(BEZ_UNIFORM),
+    dirty_begin(0), dirty_end(0),
+    arc_lengths_valid(false) {
+    // Nothing to do
+}
+
+/*
+ * constructor
+ *
+ * Constructs an empty spline that allocates from the given resource.
+ *
+ * Args:
+ *   resource: memory resource for all storage of the spline
+ */
+template <std::size_t Dim, typename T>
+Curve<Dim, T>::Curve(std::pmr::memory_resource* resource) :
+    anchor_count(0), bezier_count(0), closed(false), parameterization(BEZ_UNIFORM),
+    points(resource), B_points(resource), c(resource), z(resource),
+    knots(resource), knot_buckets(resource), dirty_begin(0), dirty_end(0),
+    arc_lengths(resource), arc_lengths_valid(false) {
     // Nothing to do
 }
 
@@ -35,28 +62,70 @@ Curve2D::Curve2D(void) :
  *
  * Args:
  *   anchor_points: ordered anchor points from which to construct spline
+ *   closed: whether to join the final anchor point back to the first
+ *   parameterization: how t is divided among the Bezier curves
+ *   resource: memory resource for all storage of the spline
  */
-Curve2D::Curve2D(const std::vector<bezVect2D>& anchor_points) :
-    points(anchor_points) {
-    anchor_count = points.size();
-    bezier_count = points.size() - 1;
+template <std::size_t Dim, typename T>
+Curve<Dim, T>::Curve(const std::vector<Vect>& anchor_points, bool closed,
+                     bezParameterization parameterization,
+                     std::pmr::memory_resource* resource) :
+    closed(closed), parameterization(parameterization),
+    points(resource), B_points(resource), c(resource), z(resource),
+    knots(resource), knot_buckets(resource), dirty_begin(0), dirty_end(0),
+    arc_lengths(resource), arc_lengths_valid(false) {
+    BEZ_TRACE_SCOPE("Curve::Curve", anchor_points.size());
+
+    anchor_count = anchor_points.size();
 
     std::size_t i;
-    std::vector<bezVect2D>::iterator iter;
-    bezVect2D v{ 0, 0 };
+    Vect v{};
 
-    for (i = 0; i < anchor_count; i++) {
-        B_points.push_back(v);
-        c.push_back(0.);
+    B_points.assign(anchor_count, v);
+    c.assign(anchor_count, 0.);
+
+    // Anchor i lives at index 3i, with its two control points in between
+    if (anchor_count == 0) {
+        bezier_count = 0;
+    }
+    else if (closed) {
+        bezier_count = anchor_count;
+        points.assign(3 * anchor_count + 1, v);
+        points[3 * anchor_count] = anchor_points[0];
+    }
+    else {
+        bezier_count = anchor_count - 1;
+        points.assign(3 * anchor_count - 2, v);
     }
 
-    for (i = 1; i < points.size(); ) {
-        points.insert(points.begin() + i, v);
-        points.insert(points.begin() + i, v);
-        i += 3;
+    for (i = 0; i < anchor_count; i++) {
+        points[3 * i] = anchor_points[i];
     }
 
-    updateControlPoints();
+    solveAll();
+}
+
+/*
+ * copy constructor
+ *
+ * Constructs a copy of the given spline that allocates from the given
+ * resource.
+ *
+ * Args:
+ *   other: spline to copy
+ *   resource: memory resource for all storage of the copy
+ */
+template <std::size_t Dim, typename T>
+Curve<Dim, T>::Curve(const Curve& other, std::pmr::memory_resource* resource) :
+    anchor_count(other.anchor_count), bezier_count(other.bezier_count),
+    closed(other.closed), parameterization(other.parameterization),
+    points(other.points, resource), B_points(other.B_points, resource),
+    c(other.c, resource), z(other.z, resource), knots(other.knots, resource),
+    knot_buckets(other.knot_buckets, resource),
+    dirty_begin(other.dirty_begin), dirty_end(other.dirty_end),
+    arc_lengths(other.arc_lengths, resource),
+    arc_lengths_valid(other.arc_lengths_valid) {
+    // Nothing to do
 }
 
 
@@ -67,7 +136,8 @@ Curve2D::Curve2D(const std::vector<bezVect2D>& anchor_points) :
 /*
  * function: getPositionAt
  *
- * Returns the coordinates of the spline evaluated at the given t.
+ * Returns the coordinates of the spline evaluated at the given t. A closed
+ * spline is periodic in t, so any t is accepted.
  *
  * Args:
  *   t: parameter value in the range [0, 1]
@@ -75,27 +145,25 @@ Curve2D::Curve2D(const std::vector<bezVect2D>& anchor_points) :
  * Throws:
  *   std::out_of_range if 0 <= i <= 1 is not satisfied
  */
-bezVect2D Curve2D::getPositionAt(BEZ_DTYPE t) const {
-    t *= (BEZ_DTYPE)(bezier_count);
-    std::size_t bez_i = (std::size_t)(t);  // index of Bezier curve
-    std::size_t k;
+template <std::size_t Dim, typename T>
+typename Curve<Dim, T>::Vect Curve<Dim, T>::getPositionAt(T t) const {
+    std::size_t bez_i;  // index of Bezier curve
+    T local_t;
 
-    if (bez_i == anchor_count - 1) {
-        return points[points.size() - 1];
+    if (bezier_count == 0) {
+        return points[0];
     }
 
-    bez_i *= 3;  // index of corresponding P_0 in `points`
-    t = fmod(t, 1.);
-    bezVect2D out;
+    solvePending();
+
+    // The final Bezier curve of a closed spline ends where the first starts
+    if (closed) {
+        t -= floor(t);
+    }
 
-    bez2Evaluate(points[bez_i][0], points[bez_i][1],
-                 points[bez_i + 1][0], points[bez_i + 1][1],
-                 points[bez_i + 2][0], points[bez_i + 2][1],
-                 points[bez_i + 3][0], points[bez_i + 3][1],
-                 t,
-                 &out[0], &out[1]);
+    findSegment(t, bez_i, local_t);
 
-    return out;
+    return evaluateSegment(bez_i, local_t);
 }
 
 /*
@@ -103,11 +171,41 @@ bezVect2D Curve2D::getPositionAt(BEZ_DTYPE t) const {
  *
  * Returns the number of anchor points.
  */
-std::size_t Curve2D::anchorCount(void) const {
-    // Not implemented
+template <std::size_t Dim, typename T>
+std::size_t Curve<Dim, T>::anchorCount(void) const {
     return anchor_count;
 }
 
+/*
+ * function: getResource
+ *
+ * Returns the memory resource the spline allocates from.
+ */
+template <std::size_t Dim, typename T>
+std::pmr::memory_resource* Curve<Dim, T>::getResource(void) const {
+    return points.get_allocator().resource();
+}
+
+/*
+ * function: isClosed
+ *
+ * Returns whether the final anchor point is joined back to the first.
+ */
+template <std::size_t Dim, typename T>
+bool Curve<Dim, T>::isClosed(void) const {
+    return closed;
+}
+
+/*
+ * function: getParameterization
+ *
+ * Returns how t is divided among the Bezier curves.
+ */
+template <std::size_t Dim, typename T>
+bezParameterization Curve<Dim, T>::getParameterization(void) const {
+    return parameterization;
+}
+
 /*
  * function: getAnchor
  *
@@ -119,7 +217,8 @@ std::size_t Curve2D::anchorCount(void) const {
  * Throws:
  *   std::out_of_range if 0 <= i < anchorCount() is not satisfied
  */
-const bezVect2D& Curve2D::getAnchor(std::size_t i) const {
+template <std::size_t Dim, typename T>
+const typename Curve<Dim, T>::Vect& Curve<Dim, T>::getAnchor(std::size_t i) const {
     return points[i * 3];
 }
 
@@ -135,9 +234,44 @@ const bezVect2D& Curve2D::getAnchor(std::size_t i) const {
  * Throws:
  *   std::out_of_range if 0 <= t0,t1 <= 1 is not satified
  */
-BEZ_DTYPE Curve2D::getLength(BEZ_DTYPE t0, BEZ_DTYPE t1) const {
-    // Not implemented
-    return 0;
+template <std::size_t Dim, typename T>
+T Curve<Dim, T>::getLength(T t0, T t1) const {
+    if (t0 < 0. || t0 > 1. || t1 < 0. || t1 > 1.) {
+        throw std::out_of_range("Curve::getLength: t must be in [0, 1]");
+    }
+
+    if (bezier_count == 0) {
+        return 0;
+    }
+
+    solvePending();
+    updateArcLengths();
+
+    // Interpolate the arc length index linearly at both ends
+    T s[2];
+    T t[2] = { t0, t1 };
+    std::size_t last = arc_lengths.size() - 1;
+    std::size_t k;
+
+    for (k = 0; k < 2; k++) {
+        std::size_t bez_i;
+        T local_t;
+
+        findSegment(t[k], bez_i, local_t);
+
+        T pos = ((T)(bez_i) + local_t) * (T)(BEZ_ARC_SAMPLES);
+        std::size_t g = (std::size_t)(pos);
+
+        if (g >= last) {
+            s[k] = arc_lengths[last];
+        }
+        else {
+            pos -= (T)(g);
+            s[k] = arc_lengths[g] + pos * (arc_lengths[g + 1] - arc_lengths[g]);
+        }
+    }
+
+    return fabs(s[1] - s[0]);
 }
 
 /*
@@ -145,28 +279,131 @@ BEZ_DTYPE Curve2D::getLength(BEZ_DTYPE t0, BEZ_DTYPE t1) const {
  *
  * Returns the total length of the spline.
  */
-BEZ_DTYPE Curve2D::getLength(void) const {
-    // Not implemented
-    return 0;
+template <std::size_t Dim, typename T>
+T Curve<Dim, T>::getLength(void) const {
+    if (bezier_count == 0) {
+        return 0;
+    }
+
+    solvePending();
+    updateArcLengths();
+
+    return arc_lengths[arc_lengths.size() - 1];
 }
 
 /*
- * function: split
+ * function: positionAtDistance
+ *
+ * Returns the coordinates of the point at the given distance along the
+ * spline, measured from the first anchor point. On a closed spline the
+ * distance wraps around instead of being clamped.
  *
- * Splits the spline into two sub-splines.
+ * Args:
+ *   s: distance along the spline, clamped to [0, getLength()]
+ */
+template <std::size_t Dim, typename T>
+typename Curve<Dim, T>::Vect Curve<Dim, T>::positionAtDistance(T s) const {
+    ArcLengthCursor cursor;
+
+    // An out of range cursor forces a binary search
+    cursor.sample = (std::size_t)(-1);
+
+    return positionAtDistance(s, cursor);
+}
+
+/*
+ * function: positionAtDistance
+ *
+ * Same as above, but resumes the search from the given cursor and leaves
+ * the cursor at the sample containing s. Advancing s monotonically costs
+ * amortized O(1) per call; moving backwards falls back to a binary search.
+ *
+ * Args:
+ *   s: distance along the spline, clamped to [0, getLength()]
+ *   cursor: search position, initially default-constructed
+ */
+template <std::size_t Dim, typename T>
+typename Curve<Dim, T>::Vect Curve<Dim, T>::positionAtDistance(T s, ArcLengthCursor& cursor) const {
+    if (anchor_count == 0) {
+        throw std::out_of_range("Curve::positionAtDistance: spline is empty");
+    }
+
+    if (bezier_count == 0) {
+        cursor.sample = 0;
+        return points[0];
+    }
+
+    solvePending();
+    updateArcLengths();
+
+    std::size_t last = arc_lengths.size() - 1;
+    std::size_t g = cursor.sample;
+
+    if (closed && arc_lengths[last] > 0.) {
+        s -= floor(s / arc_lengths[last]) * arc_lengths[last];
+    }
+
+    if (s <= 0.) {
+        cursor.sample = 0;
+        return points[0];
+    }
+
+    if (s >= arc_lengths[last]) {
+        cursor.sample = last - 1;
+        return points[points.size() - 1];
+    }
+
+    if (g >= last || arc_lengths[g] > s) {
+        g = std::upper_bound(arc_lengths.begin(), arc_lengths.end(), s) -
+            arc_lengths.begin() - 1;
+    }
+
+    // s < arc_lengths[last], so this stops before running off the end
+    while (arc_lengths[g + 1] <= s) {
+        g++;
+    }
+
+    cursor.sample = g;
+
+    T chord = arc_lengths[g + 1] - arc_lengths[g];
+    return evaluateAtSample(g, (s - arc_lengths[g]) / chord);
+}
+
+/*
+ * function: resampleByArcLength
  *
- * Overwrites the two given Curve objects with the sub-splines.
+ * Replaces the contents of out with points spaced at equal distances
+ * along the spline, starting at the first anchor point. The final anchor
+ * point is only included if the length is a multiple of spacing.
  *
  * Args:
- *   t: parameter value at which to split, in range [0, 1]
- *   c1: sub-spline taken from [0, t]
- *   c2: sub-spline taken from [t, 1]
+ *   spacing: distance between consecutive points
+ *   out: vector to fill with the sampled points
  *
  * Throws:
- *   std::out_of_range if 0 <= t <= 1 is not satisfied
+ *   std::invalid_argument if spacing <= 0
  */
-void Curve2D::split(BEZ_DTYPE t, Curve2D& c1, Curve2D& c2) const {
-    // Not implemented
+template <std::size_t Dim, typename T>
+void Curve<Dim, T>::resampleByArcLength(T spacing, std::vector<Vect>& out) const {
+    if (!(spacing > 0.)) {
+        throw std::invalid_argument("Curve::resampleByArcLength: spacing must be positive");
+    }
+
+    out.clear();
+
+    if (anchor_count == 0) {
+        return;
+    }
+
+    std::size_t count = (std::size_t)(getLength() / spacing) + 1;
+    std::size_t i;
+    ArcLengthCursor cursor;
+
+    out.reserve(count);
+
+    for (i = 0; i < count; i++) {
+        out.push_back(positionAtDistance((T)(i) * spacing, cursor));
+    }
 }
 
 
@@ -177,7 +414,8 @@ void Curve2D::split(BEZ_DTYPE t, Curve2D& c1, Curve2D& c2) const {
 /*
  * function: addAnchor
  *
- * Adds an anchor point at the given index.
+ * Adds an anchor point at the given index. The control points are
+ * updated lazily.
  *
  * Args:
  *   position: the position of the new anchor point
@@ -186,14 +424,46 @@ void Curve2D::split(BEZ_DTYPE t, Curve2D& c1, Curve2D& c2) const {
  * Throws:
  *   std::out_of_range if 0 <= i <= anchorCount() is not satisfied
  */
-void Curve2D::addAnchor(bezVect2D position, std::size_t i) {
-    // Not implemented
+template <std::size_t Dim, typename T>
+void Curve<Dim, T>::addAnchor(Vect position, std::size_t i) {
+    if (i > anchor_count) {
+        throw std::out_of_range("Curve::addAnchor: index out of range");
+    }
+
+    Vect v{};
+
+    if (anchor_count == 0) {
+        points.push_back(position);
+        if (closed) {
+            points.insert(points.end(), { v, v, position });
+        }
+    }
+    else if (i == anchor_count && !closed) {
+        points.insert(points.end(), { v, v, position });
+    }
+    else {
+        points.insert(points.begin() + 3 * i, { position, v, v });
+    }
+
+    anchor_count++;
+    bezier_count = closed ? anchor_count : anchor_count - 1;
+
+    if (closed) {
+        points[points.size() - 1] = points[0];
+    }
+
+    B_points.resize(anchor_count);
+    c.resize(anchor_count);
+
+    // The neighbours' control points moved too, so solve everything
+    markDirty(0, anchor_count);
 }
 
 /*
  * function: removeAnchor
  *
- * Removes the anchor point at the given index from the spline.
+ * Removes the anchor point at the given index from the spline. The
+ * control points are updated lazily.
  *
  * Args:
  *   i: the index of the anchor point to remove
@@ -201,14 +471,44 @@ void Curve2D::addAnchor(bezVect2D position, std::size_t i) {
  * Throws:
  *   std::out_of_range if 0 <= i < anchorCount() is not satisfied
  */
-void Curve2D::removeAnchor(std::size_t i) {
-    // Not implemented
+template <std::size_t Dim, typename T>
+void Curve<Dim, T>::removeAnchor(std::size_t i) {
+    if (i >= anchor_count) {
+        throw std::out_of_range("Curve::removeAnchor: index out of range");
+    }
+
+    if (anchor_count == 1) {
+        clear();
+        return;
+    }
+
+    // Remove the anchor with the control points on one side of it
+    if (i == anchor_count - 1 && !closed) {
+        points.erase(points.end() - 3, points.end());
+    }
+    else {
+        points.erase(points.begin() + 3 * i, points.begin() + 3 * i + 3);
+    }
+
+    anchor_count--;
+    bezier_count = closed ? anchor_count : anchor_count - 1;
+
+    if (closed) {
+        points[points.size() - 1] = points[0];
+    }
+
+    B_points.resize(anchor_count);
+    c.resize(anchor_count);
+
+    // The neighbours' control points moved too, so solve everything
+    markDirty(0, anchor_count);
 }
 
 /*
  * function: setAnchor
  *
- * Sets the new position of the anchor point at the given index.
+ * Sets the new position of the anchor point at the given index. The
+ * control points are updated lazily.
  *
  * Args:
  *   position: new position for the anchor point
@@ -217,8 +517,13 @@ void Curve2D::removeAnchor(std::size_t i) {
  * Throws:
  *   std::out_of_range if 0 <= i < anchorCount() is not satisfied
  */
-void Curve2D::setAnchor(bezVect2D position, std::size_t i) {
+template <std::size_t Dim, typename T>
+void Curve<Dim, T>::setAnchor(Vect position, std::size_t i) {
     points[i * 3] = position;
+    if (closed && i == 0) {
+        points[points.size() - 1] = position;
+    }
+    markDirty(i, i + 1);
 }
 
 /*
@@ -233,17 +538,91 @@ void Curve2D::setAnchor(bezVect2D position, std::size_t i) {
  * Throws:
  *   std::out_of_range if 0 <= i < anchorCount() is not satisfied
  */
-void Curve2D::moveAnchor(bezVect2D offset, std::size_t i) {
-    // Not implemented
+template <std::size_t Dim, typename T>
+void Curve<Dim, T>::moveAnchor(Vect offset, std::size_t i) {
+    Vect position = points[i * 3];
+    std::size_t k;
+
+    for (k = 0; k < Dim; k++) {
+        position[k] += offset[k];
+    }
+
+    setAnchor(position, i);
+}
+
+/*
+ * function: setClosed
+ *
+ * Joins the final anchor point back to the first, or separates them again.
+ * The control points are updated lazily.
+ *
+ * Args:
+ *   closed: whether the spline should be closed
+ */
+template <std::size_t Dim, typename T>
+void Curve<Dim, T>::setClosed(bool closed) {
+    Vect v{};
+
+    if (closed == this->closed) {
+        return;
+    }
+
+    this->closed = closed;
+
+    if (anchor_count == 0) {
+        return;
+    }
+
+    if (closed) {
+        points.insert(points.end(), { v, v, points[0] });
+        bezier_count = anchor_count;
+    }
+    else {
+        points.erase(points.end() - 3, points.end());
+        bezier_count = anchor_count - 1;
+    }
+
+    markDirty(0, anchor_count);
+}
+
+/*
+ * function: setParameterization
+ *
+ * Changes how t is divided among the Bezier curves. The control points are
+ * updated lazily.
+ *
+ * Args:
+ *   parameterization: new parameterization
+ */
+template <std::size_t Dim, typename T>
+void Curve<Dim, T>::setParameterization(bezParameterization parameterization) {
+    if (parameterization == this->parameterization) {
+        return;
+    }
+
+    this->parameterization = parameterization;
+    markDirty(0, anchor_count);
 }
 
 /*
  * function: clear
  *
- * Removes all anchor points from the spline.
+ * Removes all anchor points from the spline. Whether it is closed is kept.
  */
-void Curve2D::clear(void) {
-    // Not implemented
+template <std::size_t Dim, typename T>
+void Curve<Dim, T>::clear(void) {
+    anchor_count = 0;
+    bezier_count = 0;
+
+    points.clear();
+    B_points.clear();
+    c.clear();
+    z.clear();
+    knots.clear();
+    knot_buckets.clear();
+
+    dirty_begin = dirty_end = 0;
+    arc_lengths_valid = false;
 }
 
 
@@ -254,71 +633,841 @@ void Curve2D::clear(void) {
 /*
  * function: updateControlPoints
  *
- * Sets the positions of the control points to ensure C2 continuity.
+ * Sets the positions of the control points to ensure C2 continuity if any
+ * anchor point has changed since they were last set. Reads call this
+ * implicitly, so it is only needed to control when the work happens, or
+ * before reading from several threads at once.
+ */
+template <std::size_t Dim, typename T>
+void Curve<Dim, T>::updateControlPoints(void) {
+    BEZ_STATS_ADD(update_calls, 1);
+    BEZ_TRACE_SCOPE("Curve::updateControlPoints", anchor_count);
+    solvePending();
+}
+
+/*
+ * function: updateControlPoints
+ *
+ * Sets the positions of the control points to ensure C2 continuity,
+ * splitting the anchor points into one chunk per thread of the given pool
+ * regardless of the spline's size.
+ *
+ * Args:
+ *   pool: threads to solve on
+ */
+template <std::size_t Dim, typename T>
+void Curve<Dim, T>::updateControlPoints(ThreadPool& pool) {
+    BEZ_STATS_ADD(update_calls, 1);
+    BEZ_TRACE_SCOPE("Curve::updateControlPoints", anchor_count);
+    solveParallel(pool);
+}
+
+/*
+ * function: solvePending
+ *
+ * Recomputes the control points affected by the anchor points edited since
+ * the last solve, or does nothing if there were none. Not safe to call from
+ * several threads at once while an edit is pending.
+ *
+ * Edits covering most of the spline, near the seam of a closed one, or to a
+ * non-uniform one are solved from scratch; otherwise only a window of
+ * BEZ_LOCAL_SOLVE_MARGIN rows on each side is re-solved.
+ */
+template <std::size_t Dim, typename T>
+void Curve<Dim, T>::solvePending(void) const {
+    if (dirty_begin >= dirty_end) {
+        return;
+    }
+
+    // Curves produced by split carry control points but no solver state
+    if (B_points.size() != anchor_count) {
+        B_points.resize(anchor_count);
+        c.resize(anchor_count);
+        solveAll();
+        return;
+    }
+
+    // The window of a closed spline must not reach across the seam, and the
+    // knots of a non-uniform one depend on every anchor point
+    bool near_seam = closed && (dirty_begin <= BEZ_LOCAL_SOLVE_MARGIN ||
+                                dirty_end + BEZ_LOCAL_SOLVE_MARGIN >= anchor_count);
+
+    if (near_seam || parameterization != BEZ_UNIFORM ||
+        (dirty_end - dirty_begin) + 2 * BEZ_LOCAL_SOLVE_MARGIN >= anchor_count / 2) {
+        solveAll();
+    }
+    else {
+        solveRange(dirty_begin, dirty_end);
+    }
+}
+
+/*
+ * function: solveAll
+ *
+ * Recomputes every control point. Splines with at least
+ * BEZ_PARALLEL_SOLVE_THRESHOLD anchor points are solved on
+ * ThreadPool::shared().
  */
-void Curve2D::updateControlPoints(void) {
+template <std::size_t Dim, typename T>
+void Curve<Dim, T>::solveAll(void) const {
     std::size_t i;  // i stores index of anchor point
     std::size_t j;  // j stores index of anchor point in `points`
-    std::size_t k;
-    BEZ_DTYPE inv_b;
+    std::size_t k;  // k stores index of coordinate
+
+    arc_lengths_valid = false;
+    dirty_begin = dirty_end = 0;
+
+    if (parameterization != BEZ_UNIFORM) {
+        solveNonUniform();
+        return;
+    }
+
+    if (closed) {
+        solveClosed();
+        return;
+    }
+
+    if (anchor_count >= BEZ_PARALLEL_SOLVE_THRESHOLD &&
+        ThreadPool::shared().threadCount() > 1) {
+        solveParallel(ThreadPool::shared());
+        return;
+    }
+
+    BEZ_STATS_SOLVE(full_solves, anchor_count);
+    BEZ_TRACE_SCOPE("Curve::solveAll", anchor_count);
 
     if (anchor_count <= 1)
         return;
 
     if (anchor_count == 2) {
-        points[1][0] = points[0][0];
-        points[1][1] = points[0][1];
+        points[1] = points[0];
+        points[2] = points[3];
 
-        points[2][0] = points[3][0];
-        points[2][1] = points[3][1];
-        
         return;
     }
 
     // Calculate positions of B_points
-    B_points[0][0] = points[0][0];
-    B_points[0][1] = points[0][1];
+    B_points[0] = points[0];
+    B_points[anchor_count - 1] = points[points.size() - 1];
 
-    B_points[anchor_count - 1][0] = points[points.size() - 1][0];
-    B_points[anchor_count - 1][1] = points[points.size() - 1][1];
-    
+    // The first row is known, but with three anchor points the last row
+    // reads c[0], which the closed and non-uniform solves overwrite
+    c[0] = 0.;
     c[1] = 0.25;
 
-    B_points[1][0] = c[1] * (6. * points[3][0] - points[0][0]);
-    B_points[1][1] = c[1] * (6. * points[3][1] - points[0][1]);
+    for (k = 0; k < Dim; k++) {
+        B_points[1][k] = c[1] * (6. * points[3][k] - points[0][k]);
+    }
 
     for (i = 2, j = 6; i < anchor_count - 2; i++, j += 3) {
         c[i] = 1. / (4. - c[i - 1]);
 
-        B_points[i][0] = c[i] * (6. * points[j][0] - B_points[i - 1][0]);
-        B_points[i][1] = c[i] * (6. * points[j][1] - B_points[i - 1][1]);
+        for (k = 0; k < Dim; k++) {
+            B_points[i][k] = c[i] * (6. * points[j][k] - B_points[i - 1][k]);
+        }
     }
 
     i = anchor_count - 2;
     j = points.size() - 1;
     c[i] = 1. / (4. - c[i - 1]);
 
-    B_points[i][0] = c[i] * (6. * points[j - 3][0] - points[j][0] - B_points[i - 1][0]);
-    B_points[i][1] = c[i] * (6. * points[j - 3][1] - points[j][1] - B_points[i - 1][1]);
+    for (k = 0; k < Dim; k++) {
+        B_points[i][k] = c[i] * (6. * points[j - 3][k] - points[j][k] - B_points[i - 1][k]);
+    }
 
     for (i = anchor_count - 3; i > 0; i--) {
-        B_points[i][0] -= c[i] * B_points[i + 1][0];
-        B_points[i][1] -= c[i] * B_points[i + 1][1];
+        for (k = 0; k < Dim; k++) {
+            B_points[i][k] -= c[i] * B_points[i + 1][k];
+        }
     }
 
     // Calculate positions of control points
     i = 1;
     j = 0;
     while (i < points.size()) {
-        points[i][0] = BEZ_TWO_THIRDS * B_points[j][0] + BEZ_ONE_THIRD * B_points[j + 1][0];
-        points[i][1] = BEZ_TWO_THIRDS * B_points[j][1] + BEZ_ONE_THIRD * B_points[j + 1][1];
+        for (k = 0; k < Dim; k++) {
+            points[i][k] = BEZ_TWO_THIRDS * B_points[j][k] + BEZ_ONE_THIRD * B_points[j + 1][k];
+            points[i + 1][k] = BEZ_ONE_THIRD * B_points[j][k] + BEZ_TWO_THIRDS * B_points[j + 1][k];
+        }
 
-        i++;
+        i += 3;
+        j++;
+    }
+}
 
-        points[i][0] = BEZ_ONE_THIRD * B_points[j][0] + BEZ_TWO_THIRDS * B_points[j + 1][0];
-        points[i][1] = BEZ_ONE_THIRD * B_points[j][1] + BEZ_TWO_THIRDS * B_points[j + 1][1];
+/*
+ * function: solveClosed
+ *
+ * Recomputes every control point of a closed spline.
+ *
+ * Every row of the system is B[i - 1] + 4 B[i] + B[i + 1] = 6 P[i], with the
+ * indices wrapping around, so the matrix is tridiagonal plus the two corner
+ * entries. It is written as T + u v^T, where T is tridiagonal with its first
+ * and last diagonal entries adjusted, u = (-4, 0, ..., 0, 1) and
+ * v = (1, 0, ..., 0, -1/4). The Thomas algorithm solves T y = 6 P and T z = u
+ * in the same sweeps, and the Sherman-Morrison formula gives the solution
+ * B = y - (v.y / (1 + v.z)) z, all in O(n).
+ */
+template <std::size_t Dim, typename T>
+void Curve<Dim, T>::solveClosed(void) const {
+    std::size_t n = anchor_count;
+    std::size_t i, j, k;
+    Vect factor;
 
-        i += 2;
-        j++;
+    BEZ_STATS_SOLVE(full_solves, n);
+    BEZ_TRACE_SCOPE("Curve::solveClosed", n);
+
+    if (n == 0) {
+        return;
+    }
+
+    if (n == 1) {
+        points[1] = points[2] = points[0];
+        return;
+    }
+
+    z.resize(n);
+
+    // Forward sweep, with diagonal 4 - (-4) in the first row and
+    // 4 - 1 / (-4) in the last
+    c[0] = 0.125;
+    for (k = 0; k < Dim; k++) {
+        B_points[0][k] = c[0] * 6. * points[0][k];
+    }
+    z[0] = c[0] * -4.;
+
+    for (i = 1; i < n; i++) {
+        c[i] = 1. / ((i == n - 1 ? 4.25 : 4.) - c[i - 1]);
+
+        for (k = 0; k < Dim; k++) {
+            B_points[i][k] = c[i] * (6. * points[3 * i][k] - B_points[i - 1][k]);
+        }
+        z[i] = c[i] * ((i == n - 1 ? 1. : 0.) - z[i - 1]);
+    }
+
+    // Back-substitution
+    for (i = n - 1; i > 0; i--) {
+        for (k = 0; k < Dim; k++) {
+            B_points[i - 1][k] -= c[i - 1] * B_points[i][k];
+        }
+        z[i - 1] -= c[i - 1] * z[i];
+    }
+
+    // Sherman-Morrison correction
+    for (k = 0; k < Dim; k++) {
+        factor[k] = (B_points[0][k] - 0.25 * B_points[n - 1][k]) /
+                    (1. + z[0] - 0.25 * z[n - 1]);
+    }
+
+    for (i = 0; i < n; i++) {
+        for (k = 0; k < Dim; k++) {
+            B_points[i][k] -= factor[k] * z[i];
+        }
+    }
+
+    // Calculate positions of control points, the last Bezier curve ending at
+    // B_points[0]
+    for (j = 0; j < n; j++) {
+        const Vect& b0 = B_points[j];
+        const Vect& b1 = B_points[j + 1 < n ? j + 1 : 0];
+
+        for (k = 0; k < Dim; k++) {
+            points[3 * j + 1][k] = BEZ_TWO_THIRDS * b0[k] + BEZ_ONE_THIRD * b1[k];
+            points[3 * j + 2][k] = BEZ_ONE_THIRD * b0[k] + BEZ_TWO_THIRDS * b1[k];
+        }
+    }
+}
+
+/*
+ * function: solveNonUniform
+ *
+ * Recomputes the knots and every control point of a spline with a
+ * non-uniform parameterization.
+ *
+ * Solves for the derivative D[i] of the spline at each anchor point, with
+ * respect to a parameter that advances by h[i] over Bezier curve i. Matching
+ * second derivatives at anchor point i gives
+ *   h[i] D[i - 1] + 2 (h[i - 1] + h[i]) D[i] + h[i - 1] D[i + 1] =
+ *       3 (h[i] / h[i - 1] (P[i] - P[i - 1]) + h[i - 1] / h[i] (P[i + 1] - P[i]))
+ * and an open spline ends with zero second derivative, giving
+ *   2 D[0] + D[1] = 3 (P[1] - P[0]) / h[0]
+ * and the mirror image at the other end. The rows of a closed spline wrap
+ * around and are solved with the same Sherman-Morrison correction as
+ * solveClosed. The control points of Bezier curve i are then
+ * P[i] + h[i] D[i] / 3 and P[i + 1] - h[i] D[i + 1] / 3.
+ *
+ * The system only depends on the ratios of the h[i], so they are used as
+ * measured, and normalized to [0, 1] afterwards to become the knots.
+ */
+template <std::size_t Dim, typename T>
+void Curve<Dim, T>::solveNonUniform(void) const {
+    std::size_t n = anchor_count;
+    std::size_t m = bezier_count;
+    std::size_t i, k;
+    double total = 0.;
+    T gamma = 0., alpha = 0., beta = 0.;  // Sherman-Morrison terms
+    Vect factor;
+
+    BEZ_STATS_SOLVE(full_solves, n);
+    BEZ_TRACE_SCOPE("Curve::solveNonUniform", n);
+
+    knots.resize(m + 1);
+    knot_buckets.resize(m);
+
+    if (m == 0) {
+        knots[0] = 0.;
+        return;
+    }
+
+    if (n == 1) {
+        points[1] = points[2] = points[0];
+        knots[0] = 0.;
+        knots[1] = 1.;
+        knot_buckets[0] = 0;
+        return;
+    }
+
+    // h[i] is held in knots[i + 1] until the solve is done. Anchor points
+    // that coincide still get a short interval to keep the system regular.
+    for (i = 0; i < m; i++) {
+        double chord = 0.;
+
+        for (k = 0; k < Dim; k++) {
+            double d = (double)(points[3 * i + 3][k]) - (double)(points[3 * i][k]);
+            chord += d * d;
+        }
+
+        chord = sqrt(chord);
+        if (parameterization == BEZ_CENTRIPETAL) {
+            chord = sqrt(chord);
+        }
+
+        knots[i + 1] = (T)(chord);
+        total += chord;
+    }
+
+    for (i = 0; i < m; i++) {
+        if (!(knots[i + 1] > 1e-6 * total)) {
+            knots[i + 1] = total > 0. ? (T)(1e-6 * total) : 1.;
+        }
+    }
+
+    // Coefficients and right-hand side of row i, with h[i] = knots[i + 1]
+    auto row = [&](std::size_t i, T& a, T& b, T& cc, Vect& r) {
+        std::size_t prev = i > 0 ? i - 1 : n - 1;  // wraps for closed splines
+        std::size_t next = i + 1 < n ? i + 1 : 0;
+        T h_prev = knots[(i > 0 ? i - 1 : m - 1) + 1];
+        T h = knots[(i < m ? i : m - 1) + 1];
+        std::size_t d;
+
+        if (!closed && i == 0) {
+            a = 0.;
+            b = 2.;
+            cc = 1.;
+            for (d = 0; d < Dim; d++) {
+                r[d] = 3. * (points[3][d] - points[0][d]) / h;
+            }
+        }
+        else if (!closed && i == n - 1) {
+            a = 1.;
+            b = 2.;
+            cc = 0.;
+            for (d = 0; d < Dim; d++) {
+                r[d] = 3. * (points[3 * i][d] - points[3 * prev][d]) / h_prev;
+            }
+        }
+        else {
+            a = h;
+            b = 2. * (h_prev + h);
+            cc = h_prev;
+            for (d = 0; d < Dim; d++) {
+                r[d] = 3. * (h / h_prev * (points[3 * i][d] - points[3 * prev][d]) +
+                             h_prev / h * (points[3 * next][d] - points[3 * i][d]));
+            }
+        }
+    };
+
+    // Forward sweep of T D = r, and of T z = u for a closed spline, holding
+    // D in B_points. The matrix of a closed spline is T + u v^T with
+    // u = (gamma, 0, ..., 0, alpha) and v = (1, 0, ..., 0, beta / gamma).
+    if (closed) {
+        z.resize(n);
+    }
+
+    for (i = 0; i < n; i++) {
+        T a, b, cc, denom;
+        Vect r;
+
+        row(i, a, b, cc, r);
+
+        if (closed && i == 0) {
+            gamma = -b;
+            beta = a;
+            b -= gamma;
+        }
+        if (closed && i == n - 1) {
+            alpha = cc;
+            b -= alpha * beta / gamma;
+        }
+
+        denom = i > 0 ? b - a * c[i - 1] : b;
+        c[i] = cc / denom;
+
+        for (k = 0; k < Dim; k++) {
+            B_points[i][k] = (r[k] - (i > 0 ? a * B_points[i - 1][k] : 0.)) / denom;
+        }
+
+        if (closed) {
+            T u = i == 0 ? gamma : (i == n - 1 ? alpha : 0.);
+            z[i] = (u - (i > 0 ? a * z[i - 1] : 0.)) / denom;
+        }
+    }
+
+    // Back-substitution
+    for (i = n - 1; i > 0; i--) {
+        for (k = 0; k < Dim; k++) {
+            B_points[i - 1][k] -= c[i - 1] * B_points[i][k];
+        }
+        if (closed) {
+            z[i - 1] -= c[i - 1] * z[i];
+        }
+    }
+
+    // Sherman-Morrison correction
+    if (closed) {
+        T v_last = beta / gamma;
+
+        for (k = 0; k < Dim; k++) {
+            factor[k] = (B_points[0][k] + v_last * B_points[n - 1][k]) /
+                        (1. + z[0] + v_last * z[n - 1]);
+        }
+
+        for (i = 0; i < n; i++) {
+            for (k = 0; k < Dim; k++) {
+                B_points[i][k] -= factor[k] * z[i];
+            }
+        }
+    }
+
+    // Calculate positions of control points, then turn the h[i] into knots
+    for (i = 0; i < m; i++) {
+        const Vect& d0 = B_points[i];
+        const Vect& d1 = B_points[i + 1 < n ? i + 1 : 0];
+        T h_third = BEZ_ONE_THIRD * knots[i + 1];
+
+        for (k = 0; k < Dim; k++) {
+            points[3 * i + 1][k] = points[3 * i][k] + h_third * d0[k];
+            points[3 * i + 2][k] = points[3 * i + 3][k] - h_third * d1[k];
+        }
+    }
+
+    total = 0.;
+    for (i = 0; i < m; i++) {
+        total += knots[i + 1];
+    }
+
+    double sum = 0.;
+    knots[0] = 0.;
+    for (i = 1; i < m; i++) {
+        sum += knots[i];
+        knots[i] = (T)(sum / total);
+    }
+    knots[m] = 1.;
+
+    // Bucket b starts at the Bezier curve containing t = b / m
+    k = 0;
+    for (i = 0; i < m; i++) {
+        T t = (T)(i) / (T)(m);
+
+        while (k + 1 < m && knots[k + 1] <= t) {
+            k++;
+        }
+
+        knot_buckets[i] = k;
+    }
+}
+
+/*
+ * function: solveParallel
+ *
+ * Recomputes every control point on the given pool, splitting the anchor
+ * points into one chunk per thread. Closed and non-uniform splines are solved
+ * serially.
+ *
+ * Both sweeps of the Thomas algorithm are linear first-order recurrences, so
+ * each chunk runs them locally as if the value entering from its neighbour
+ * were zero, a short serial pass over the chunks carries the true boundary
+ * values across, and each chunk then adds the boundary value times the
+ * running product of -c. That product shrinks by about 0.27 per row, so the
+ * correction stops as soon as it underflows, after at most a few dozen rows.
+ *
+ * The coefficients c depend only on the anchor count and converge to a fixed
+ * value within a few rows, so only their head is computed serially.
+ *
+ * Args:
+ *   pool: threads to solve on
+ */
+template <std::size_t Dim, typename T>
+void Curve<Dim, T>::solveParallel(ThreadPool& pool) const {
+    if (anchor_count <= 2 || closed || parameterization != BEZ_UNIFORM) {
+        solveAll();
+        return;
+    }
+
+    std::size_t n = anchor_count;
+    std::size_t rows = n - 2;  // unknown B_points are 1 ... n - 2
+    std::size_t chunk_count = std::max<std::size_t>(1, std::min(pool.threadCount(), rows / 2));
+    std::size_t converged;  // first row from which c is constant
+    std::vector<T> products(chunk_count);  // product of -c over each chunk
+    std::vector<Vect> forward_carry(chunk_count);  // true B_points[lo - 1]
+    std::vector<Vect> backward_carry(chunk_count);  // true B_points[hi + 1]
+    Vect x;
+    std::size_t i, k;
+
+    BEZ_STATS_SOLVE(full_solves, n);
+    BEZ_TRACE_SCOPE("Curve::solveParallel", n);
+
+    arc_lengths_valid = false;
+    dirty_begin = dirty_end = 0;
+
+    // first row of chunk_i is 1 + chunk_i * rows / chunk_count
+    auto chunkBegin = [&](std::size_t chunk_i) {
+        return 1 + chunk_i * rows / chunk_count;
+    };
+
+    c[1] = 0.25;
+    for (converged = 2; converged <= n - 2; converged++) {
+        c[converged] = 1. / (4. - c[converged - 1]);
+        if (c[converged] == c[converged - 1]) {
+            break;
+        }
+    }
+
+    // Forward sweep of each chunk, assuming B_points[lo - 1] = 0
+    pool.run(chunk_count, [&](std::size_t chunk_i) {
+        std::size_t lo = chunkBegin(chunk_i);
+        std::size_t hi = chunkBegin(chunk_i + 1) - 1;
+        std::size_t i, k;
+        T product = 1.;
+        Vect prev{};
+
+        for (i = std::max(lo, converged + 1); i <= hi; i++) {
+            c[i] = c[converged];
+        }
+
+        if (chunk_i == 0) {
+            B_points[0] = points[0];
+            prev = points[0];
+        }
+
+        for (i = lo; i <= hi; i++) {
+            for (k = 0; k < Dim; k++) {
+                T rhs = 6. * points[3 * i][k];
+                if (i == n - 2) {
+                    rhs -= points[3 * (n - 1)][k];
+                }
+                B_points[i][k] = c[i] * (rhs - prev[k]);
+            }
+            prev = B_points[i];
+            product *= -c[i];
+        }
+
+        products[chunk_i] = product;
+    });
+
+    // Carry the true values of B_points[hi] forward across the chunks
+    forward_carry[0] = Vect{};
+    for (i = 1; i < chunk_count; i++) {
+        x = B_points[chunkBegin(i) - 1];
+        for (k = 0; k < Dim; k++) {
+            forward_carry[i][k] = x[k] + products[i - 1] * forward_carry[i - 1][k];
+        }
     }
+
+    // Correct the forward sweep, then back-substitute each chunk, assuming
+    // B_points[hi + 1] = 0
+    pool.run(chunk_count, [&](std::size_t chunk_i) {
+        std::size_t lo = chunkBegin(chunk_i);
+        std::size_t hi = chunkBegin(chunk_i + 1) - 1;
+        std::size_t i, k;
+        T product = 1.;
+
+        if (chunk_i > 0) {
+            for (i = lo; i <= hi && product != 0.; i++) {
+                product *= -c[i];
+                for (k = 0; k < Dim; k++) {
+                    B_points[i][k] += product * forward_carry[chunk_i][k];
+                }
+            }
+        }
+
+        // The last row has no term from the right, so it is already final
+        for (i = hi; i > lo; i--) {
+            for (k = 0; k < Dim; k++) {
+                B_points[i - 1][k] -= c[i - 1] * B_points[i][k];
+            }
+        }
+    });
+
+    // Carry the true values of B_points[lo] backward across the chunks
+    x = B_points[chunkBegin(chunk_count - 1)];
+    for (i = chunk_count - 1; i > 0; i--) {
+        backward_carry[i - 1] = x;
+        for (k = 0; k < Dim; k++) {
+            x[k] = B_points[chunkBegin(i - 1)][k] + products[i - 1] * x[k];
+        }
+    }
+
+    // Correct the back-substitution
+    pool.run(chunk_count - 1, [&](std::size_t chunk_i) {
+        std::size_t lo = chunkBegin(chunk_i);
+        std::size_t hi = chunkBegin(chunk_i + 1) - 1;
+        std::size_t i, k;
+        T product = 1.;
+
+        for (i = hi + 1; i > lo && product != 0.; i--) {
+            product *= -c[i - 1];
+            for (k = 0; k < Dim; k++) {
+                B_points[i - 1][k] += product * backward_carry[chunk_i][k];
+            }
+        }
+    });
+
+    B_points[n - 1] = points[points.size() - 1];
+
+    // Calculate positions of control points
+    pool.run(chunk_count, [&](std::size_t chunk_i) {
+        std::size_t first = chunk_i * (n - 1) / chunk_count;
+        std::size_t last = (chunk_i + 1) * (n - 1) / chunk_count;
+        std::size_t j, k;
+
+        for (j = first; j < last; j++) {
+            for (k = 0; k < Dim; k++) {
+                points[3 * j + 1][k] = BEZ_TWO_THIRDS * B_points[j][k] + BEZ_ONE_THIRD * B_points[j + 1][k];
+                points[3 * j + 2][k] = BEZ_ONE_THIRD * B_points[j][k] + BEZ_TWO_THIRDS * B_points[j + 1][k];
+            }
+        }
+    });
 }
+
+/*
+ * function: solveRange
+ *
+ * Recomputes the control points near the anchor points [begin, end), assuming
+ * all others still satisfy the C2 system.
+ *
+ * A change to the right-hand side of the system decays by a factor of about
+ * 0.27 per row away from where it was made, so after BEZ_LOCAL_SOLVE_MARGIN
+ * rows it is far below rounding error. The rows of the edited anchor points
+ * plus that margin are re-solved with the Thomas algorithm, holding the
+ * B_points just outside the window fixed as boundary values.
+ */
+template <std::size_t Dim, typename T>
+void Curve<Dim, T>::solveRange(std::size_t begin, std::size_t end) const {
+    std::size_t n = anchor_count;
+    std::size_t first;  // first row of the window
+    std::size_t last;  // last row of the window
+    std::size_t i, j, k;
+
+    arc_lengths_valid = false;
+    dirty_begin = dirty_end = 0;
+
+    // The end rows of an open system are the end anchor points themselves
+    if (!closed) {
+        B_points[0] = points[0];
+        B_points[n - 1] = points[points.size() - 1];
+    }
+
+    first = begin > BEZ_LOCAL_SOLVE_MARGIN + 1 ? begin - BEZ_LOCAL_SOLVE_MARGIN : 1;
+    last = std::min(end - 1 + BEZ_LOCAL_SOLVE_MARGIN, n - 2);
+    BEZ_STATS_SOLVE(local_solves, last + 1 - first);
+    BEZ_TRACE_SCOPE("Curve::solveRange", last + 1 - first);
+
+    // Forward sweep, with c restarted at the left boundary of the window
+    c[first - 1] = 0.;
+    for (i = first; i <= last; i++) {
+        c[i] = 1. / (4. - c[i - 1]);
+
+        for (k = 0; k < Dim; k++) {
+            T rhs = 6. * points[3 * i][k];
+            if (i == last) {
+                rhs -= B_points[last + 1][k];
+            }
+            B_points[i][k] = c[i] * (rhs - (i == first ? B_points[first - 1][k] : B_points[i - 1][k]));
+        }
+    }
+
+    // Back-substitution
+    for (i = last; i > first; i--) {
+        for (k = 0; k < Dim; k++) {
+            B_points[i - 1][k] -= c[i - 1] * B_points[i][k];
+        }
+    }
+
+    // Control points of every Bezier curve touching a re-solved B_point
+    for (j = first - 1; j <= last; j++) {
+        for (k = 0; k < Dim; k++) {
+            points[3 * j + 1][k] = BEZ_TWO_THIRDS * B_points[j][k] + BEZ_ONE_THIRD * B_points[j + 1][k];
+            points[3 * j + 2][k] = BEZ_ONE_THIRD * B_points[j][k] + BEZ_TWO_THIRDS * B_points[j + 1][k];
+        }
+    }
+}
+
+/*
+ * function: markDirty
+ *
+ * Adds the anchor points [begin, end) to the range awaiting a solve.
+ */
+template <std::size_t Dim, typename T>
+void Curve<Dim, T>::markDirty(std::size_t begin, std::size_t end) {
+    if (dirty_begin >= dirty_end) {
+        dirty_begin = begin;
+        dirty_end = end;
+    }
+    else {
+        dirty_begin = std::min(dirty_begin, begin);
+        dirty_end = std::max(dirty_end, end);
+    }
+
+    arc_lengths_valid = false;
+}
+
+/*
+ * function: updateArcLengths
+ *
+ * Rebuilds the arc length index if the control points have changed since it
+ * was last built.
+ *
+ * Each Bezier curve is approximated by BEZ_ARC_SAMPLES chords of equal
+ * parameter width, so building the index costs O(n) evaluations.
+ */
+template <std::size_t Dim, typename T>
+void Curve<Dim, T>::updateArcLengths(void) const {
+    std::size_t i;  // i stores index of Bezier curve
+    std::size_t k;
+    std::size_t d;
+    std::size_t g;  // g stores index in `arc_lengths`
+    double total;  // accumulated in double to limit drift on long splines
+    double chord;
+    Vect v, last;
+
+    if (arc_lengths_valid) {
+        return;
+    }
+
+    arc_lengths.resize(bezier_count * BEZ_ARC_SAMPLES + 1);
+    arc_lengths[0] = 0.;
+    total = 0.;
+    g = 0;
+
+    for (i = 0; i < bezier_count; i++) {
+        last = points[3 * i];
+
+        for (k = 1; k <= BEZ_ARC_SAMPLES; k++) {
+            v = evaluateSegment(i, (T)(k) / (T)(BEZ_ARC_SAMPLES));
+
+            chord = 0.;
+            for (d = 0; d < Dim; d++) {
+                chord += (double)((v[d] - last[d]) * (v[d] - last[d]));
+            }
+
+            total += sqrt(chord);
+            arc_lengths[++g] = (T)(total);
+
+            last = v;
+        }
+    }
+
+    arc_lengths_valid = true;
+}
+
+/*
+ * function: findSegment
+ *
+ * Finds the Bezier curve containing the given t and the parameter value local
+ * to it.
+ *
+ * A non-uniform spline has as many buckets as Bezier curves, so on average
+ * the scan from the start of the bucket advances by at most about one curve.
+ *
+ * Args:
+ *   t: parameter value in the range [0, 1]
+ *   bez_i: set to the index of the Bezier curve
+ *   local_t: set to the parameter value within it, in range [0, 1]
+ */
+template <std::size_t Dim, typename T>
+void Curve<Dim, T>::findSegment(T t, std::size_t& bez_i, T& local_t) const {
+    std::size_t m = bezier_count;
+
+    if (parameterization == BEZ_UNIFORM) {
+        t *= (T)(m);
+        bez_i = (std::size_t)(t);
+
+        // t = 1 is the end of the final Bezier curve
+        if (bez_i >= m) {
+            bez_i = m - 1;
+        }
+
+        local_t = t - (T)(bez_i);
+        return;
+    }
+
+    std::size_t b = (std::size_t)(t * (T)(m));  // bucket
+
+    if (b >= m) {
+        b = m - 1;
+    }
+
+    bez_i = knot_buckets[b];
+
+    // t * m may round up into the next bucket
+    if (bez_i > 0 && knots[bez_i] > t) {
+        bez_i--;
+    }
+
+    while (bez_i + 1 < m && knots[bez_i + 1] <= t) {
+        bez_i++;
+    }
+
+    local_t = (t - knots[bez_i]) / (knots[bez_i + 1] - knots[bez_i]);
+}
+
+/*
+ * function: evaluateSegment
+ *
+ * Returns the coordinates of the given Bezier curve evaluated at t.
+ *
+ * Args:
+ *   bez_i: index of the Bezier curve
+ *   t: parameter value local to the Bezier curve, in range [0, 1]
+ */
+template <std::size_t Dim, typename T>
+typename Curve<Dim, T>::Vect Curve<Dim, T>::evaluateSegment(std::size_t bez_i, T t) const {
+    const Vect* p = &points[3 * bez_i];  // P_0 of the Bezier curve
+
+    BEZ_STATS_ADD(evaluations, 1);
+
+    return bezEvaluateSegment(p[0], p[1], p[2], p[3], t);
+}
+
+/*
+ * function: evaluateAtSample
+ *
+ * Returns the coordinates of the spline at the fractional position
+ * sample + frac in the arc length index.
+ */
+template <std::size_t Dim, typename T>
+typename Curve<Dim, T>::Vect Curve<Dim, T>::evaluateAtSample(std::size_t sample, T frac) const {
+    std::size_t bez_i = sample / BEZ_ARC_SAMPLES;  // index of Bezier curve
+    T t = ((T)(sample % BEZ_ARC_SAMPLES) + frac) / (T)(BEZ_ARC_SAMPLES);
+
+    return evaluateSegment(bez_i, t);
+}
+
+
+//*****************************************************************************
+// Explicit instantiations
+//*****************************************************************************
+
+template class Curve<2, BEZ_DTYPE>;
+template class Curve<3, BEZ_DTYPE>;
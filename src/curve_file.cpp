@@ -0,0 +1,513 @@
+/*
+ * curve_file.cpp
+ *
+ * Implements writeCurveFile and the class template MappedCurve.
+ */
+
+#include "curve_file.h"
+#include "curve_layout.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define BEZ_HAVE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const char bez_curve_file_magic[8] = { 'B', 'E', 'Z', 'C', 'U', 'R', 'V', '\0' };
+
+
+//*****************************************************************************
+// Byte order helpers
+//*****************************************************************************
+
+/*
+ * function: hostIsLittleEndian
+ *
+ * Returns whether the host stores the least significant byte first.
+ */
+static bool hostIsLittleEndian(void) {
+    const std::uint16_t one = 1;
+    unsigned char first;
+
+    memcpy(&first, &one, 1);
+
+    return first == 1;
+}
+
+/*
+ * function: storeLittleEndian
+ *
+ * Copies count values of the given size to dst in little-endian byte order.
+ * With count zero, dst may be the end of the buffer and src null.
+ */
+static void storeLittleEndian(unsigned char* dst, const void* src,
+                              std::size_t count, std::size_t size) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(src);
+    std::size_t i, b;
+
+    if (count == 0) {
+        return;
+    }
+
+    if (hostIsLittleEndian()) {
+        memcpy(dst, bytes, count * size);
+        return;
+    }
+
+    for (i = 0; i < count; i++) {
+        for (b = 0; b < size; b++) {
+            dst[i * size + b] = bytes[i * size + size - 1 - b];
+        }
+    }
+}
+
+/*
+ * function: alignOffset
+ *
+ * Rounds the given offset up to a multiple of BEZ_CURVE_FILE_ALIGNMENT.
+ */
+static std::uint64_t alignOffset(std::uint64_t offset) {
+    return (offset + BEZ_CURVE_FILE_ALIGNMENT - 1) / BEZ_CURVE_FILE_ALIGNMENT * BEZ_CURVE_FILE_ALIGNMENT;
+}
+
+
+//*****************************************************************************
+// writeCurveFile
+//*****************************************************************************
+
+/*
+ * function: writeCurveFile
+ *
+ * Solves the given spline if needed and writes it to a curve file.
+ *
+ * The whole file is assembled in memory and written with a single fwrite.
+ *
+ * Args:
+ *   curve: spline to write
+ *   path: name of the file to create or overwrite
+ *   options: BEZ_CURVE_FILE_BOXES and/or BEZ_CURVE_FILE_ARC_LENGTHS to store
+ *            the corresponding cached data
+ *
+ * Throws:
+ *   std::runtime_error if the file cannot be written
+ */
+template <std::size_t Dim, typename T>
+void writeCurveFile(const Curve<Dim, T>& curve, const char* path, unsigned options) {
+    typedef typename Curve<Dim, T>::Vect Vect;
+    CurveFileHeader header;
+    std::vector<Vect> mins, maxs;
+    std::uint64_t offset;
+    FILE* file;
+
+    curve.solvePending();
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, bez_curve_file_magic, sizeof(header.magic));
+    header.version = BEZ_CURVE_FILE_VERSION;
+    header.header_size = sizeof(CurveFileHeader);
+    header.dims = Dim;
+    header.scalar_size = sizeof(T);
+    header.flags = curve.closed ? BEZ_CURVE_FILE_CLOSED : 0;
+    header.parameterization = curve.parameterization;
+    header.anchor_count = curve.anchor_count;
+    header.bezier_count = curve.bezier_count;
+
+    offset = alignOffset(sizeof(CurveFileHeader));
+
+    header.points_offset = offset;
+    offset = alignOffset(offset + curve.points.size() * sizeof(Vect));
+
+    if (curve.parameterization != BEZ_UNIFORM && curve.bezier_count > 0) {
+        header.knots_offset = offset;
+        offset = alignOffset(offset + (curve.bezier_count + 1) * sizeof(T));
+    }
+
+    if ((options & BEZ_CURVE_FILE_BOXES) && curve.bezier_count > 0) {
+        mins.resize(curve.bezier_count);
+        maxs.resize(curve.bezier_count);
+        segmentBoundingBoxes(CurveInterleavedView<Dim, T>(curve), mins.data(), maxs.data());
+
+        header.flags |= BEZ_CURVE_FILE_BOXES;
+        header.boxes_offset = offset;
+        offset = alignOffset(offset + 2 * curve.bezier_count * sizeof(Vect));
+    }
+
+    if ((options & BEZ_CURVE_FILE_ARC_LENGTHS) && curve.bezier_count > 0) {
+        curve.updateArcLengths();
+
+        header.flags |= BEZ_CURVE_FILE_ARC_LENGTHS;
+        header.arc_samples = BEZ_ARC_SAMPLES;
+        header.arc_lengths_offset = offset;
+        offset += curve.arc_lengths.size() * sizeof(T);
+    }
+
+    header.file_size = offset;
+
+    std::vector<unsigned char> buffer(offset, 0);
+
+#define BEZ_STORE_FIELD(field) \
+    storeLittleEndian(&buffer[offsetof(CurveFileHeader, field)], &header.field, 1, sizeof(header.field))
+
+    memcpy(&buffer[0], header.magic, sizeof(header.magic));
+    BEZ_STORE_FIELD(version);
+    BEZ_STORE_FIELD(header_size);
+    BEZ_STORE_FIELD(dims);
+    BEZ_STORE_FIELD(scalar_size);
+    BEZ_STORE_FIELD(flags);
+    BEZ_STORE_FIELD(parameterization);
+    BEZ_STORE_FIELD(arc_samples);
+    BEZ_STORE_FIELD(reserved);
+    BEZ_STORE_FIELD(anchor_count);
+    BEZ_STORE_FIELD(bezier_count);
+    BEZ_STORE_FIELD(points_offset);
+    BEZ_STORE_FIELD(knots_offset);
+    BEZ_STORE_FIELD(boxes_offset);
+    BEZ_STORE_FIELD(arc_lengths_offset);
+    BEZ_STORE_FIELD(file_size);
+
+#undef BEZ_STORE_FIELD
+
+    storeLittleEndian(buffer.data() + header.points_offset, curve.points.data(),
+                      curve.points.size() * Dim, sizeof(T));
+    if (header.knots_offset != 0) {
+        storeLittleEndian(buffer.data() + header.knots_offset, curve.knots.data(),
+                          curve.bezier_count + 1, sizeof(T));
+    }
+    if (header.boxes_offset != 0) {
+        storeLittleEndian(buffer.data() + header.boxes_offset, mins.data(),
+                          curve.bezier_count * Dim, sizeof(T));
+        storeLittleEndian(buffer.data() + header.boxes_offset + curve.bezier_count * sizeof(Vect),
+                          maxs.data(), curve.bezier_count * Dim, sizeof(T));
+    }
+    if (header.arc_lengths_offset != 0) {
+        storeLittleEndian(buffer.data() + header.arc_lengths_offset, curve.arc_lengths.data(),
+                          curve.arc_lengths.size(), sizeof(T));
+    }
+
+    file = fopen(path, "wb");
+    if (file == NULL) {
+        throw std::runtime_error(std::string("writeCurveFile: unable to open ") + path);
+    }
+
+    if (fwrite(buffer.data(), 1, buffer.size(), file) != buffer.size()) {
+        fclose(file);
+        throw std::runtime_error(std::string("writeCurveFile: unable to write ") + path);
+    }
+
+    if (fclose(file) != 0) {
+        throw std::runtime_error(std::string("writeCurveFile: unable to write ") + path);
+    }
+}
+
+
+//*****************************************************************************
+// Constructors/Destructors
+//*****************************************************************************
+
+/*
+ * constructor
+ *
+ * Maps the given curve file.
+ *
+ * Args:
+ *   path: name of the file to map
+ *
+ * Throws:
+ *   std::runtime_error if the file cannot be mapped or is not a valid curve
+ *   file of this Dim and T
+ */
+template <std::size_t Dim, typename T>
+MappedCurve<Dim, T>::MappedCurve(const char* path) :
+    data(nullptr), size(0), mapped(false) {
+    if (!hostIsLittleEndian()) {
+        throw std::runtime_error("MappedCurve: curve files can only be mapped on little-endian hosts");
+    }
+
+#ifdef BEZ_HAVE_MMAP
+    struct stat info;
+    int fd = open(path, O_RDONLY);
+
+    if (fd < 0) {
+        throw std::runtime_error(std::string("MappedCurve: unable to open ") + path);
+    }
+
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+        close(fd);
+        throw std::runtime_error(std::string("MappedCurve: unable to map ") + path);
+    }
+
+    size = (std::size_t)(info.st_size);
+    void* address = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (address == MAP_FAILED) {
+        throw std::runtime_error(std::string("MappedCurve: unable to map ") + path);
+    }
+
+    data = static_cast<const unsigned char*>(address);
+    mapped = true;
+#else
+    FILE* file = fopen(path, "rb");
+    long end;
+
+    if (file == NULL) {
+        throw std::runtime_error(std::string("MappedCurve: unable to open ") + path);
+    }
+
+    if (fseek(file, 0, SEEK_END) != 0 || (end = ftell(file)) <= 0 || fseek(file, 0, SEEK_SET) != 0) {
+        fclose(file);
+        throw std::runtime_error(std::string("MappedCurve: unable to read ") + path);
+    }
+
+    size = (std::size_t)(end);
+    unsigned char* bytes = new unsigned char[size];
+
+    if (fread(bytes, 1, size, file) != size) {
+        delete[] bytes;
+        fclose(file);
+        throw std::runtime_error(std::string("MappedCurve: unable to read ") + path);
+    }
+
+    fclose(file);
+    data = bytes;
+#endif
+
+    try {
+        validate();
+    }
+    catch (...) {
+        release();
+        throw;
+    }
+}
+
+/*
+ * destructor
+ *
+ * Unmaps the file.
+ */
+template <std::size_t Dim, typename T>
+MappedCurve<Dim, T>::~MappedCurve(void) {
+    release();
+}
+
+template <std::size_t Dim, typename T>
+MappedCurve<Dim, T>::MappedCurve(MappedCurve&& other) :
+    data(other.data), size(other.size), mapped(other.mapped) {
+    other.data = nullptr;
+    other.size = 0;
+}
+
+
+//*****************************************************************************
+// Access functions
+//*****************************************************************************
+
+template <std::size_t Dim, typename T>
+const CurveFileHeader& MappedCurve<Dim, T>::header(void) const {
+    return *reinterpret_cast<const CurveFileHeader*>(data);
+}
+
+template <std::size_t Dim, typename T>
+std::size_t MappedCurve<Dim, T>::anchorCount(void) const {
+    return header().anchor_count;
+}
+
+template <std::size_t Dim, typename T>
+bool MappedCurve<Dim, T>::isClosed(void) const {
+    return (header().flags & BEZ_CURVE_FILE_CLOSED) != 0;
+}
+
+template <std::size_t Dim, typename T>
+bezParameterization MappedCurve<Dim, T>::getParameterization(void) const {
+    return (bezParameterization)(header().parameterization);
+}
+
+/*
+ * function: points
+ *
+ * Returns the interleaved points of the spline.
+ */
+template <std::size_t Dim, typename T>
+const typename MappedCurve<Dim, T>::Vect* MappedCurve<Dim, T>::points(void) const {
+    return static_cast<const Vect*>(section(header().points_offset));
+}
+
+/*
+ * functions: knots, boxMins, boxMaxs, arcLengths
+ *
+ * Return the optional sections, or nullptr for those not in the file.
+ */
+template <std::size_t Dim, typename T>
+const T* MappedCurve<Dim, T>::knots(void) const {
+    return static_cast<const T*>(section(header().knots_offset));
+}
+
+template <std::size_t Dim, typename T>
+const typename MappedCurve<Dim, T>::Vect* MappedCurve<Dim, T>::boxMins(void) const {
+    return static_cast<const Vect*>(section(header().boxes_offset));
+}
+
+template <std::size_t Dim, typename T>
+const typename MappedCurve<Dim, T>::Vect* MappedCurve<Dim, T>::boxMaxs(void) const {
+    const Vect* mins = boxMins();
+
+    return mins != nullptr ? mins + header().bezier_count : nullptr;
+}
+
+template <std::size_t Dim, typename T>
+const T* MappedCurve<Dim, T>::arcLengths(void) const {
+    return static_cast<const T*>(section(header().arc_lengths_offset));
+}
+
+/*
+ * function: view
+ *
+ * Returns a view of every Bezier curve of the spline, or an empty view if it
+ * has none.
+ */
+template <std::size_t Dim, typename T>
+CurveView<Dim, T> MappedCurve<Dim, T>::view(void) const {
+    if (segmentCount() == 0) {
+        return CurveView<Dim, T>();
+    }
+
+    return CurveView<Dim, T>(points(), segmentCount());
+}
+
+template <std::size_t Dim, typename T>
+std::size_t MappedCurve<Dim, T>::segmentCount(void) const {
+    return header().bezier_count;
+}
+
+template <std::size_t Dim, typename T>
+T MappedCurve<Dim, T>::get(std::size_t s, std::size_t p, std::size_t d) const {
+    return points()[3 * s + p][d];
+}
+
+
+//*****************************************************************************
+// Hidden procedures
+//*****************************************************************************
+
+/*
+ * function: validate
+ *
+ * Checks the header against the file size and this Dim and T.
+ *
+ * Throws:
+ *   std::runtime_error naming the first problem found
+ */
+template <std::size_t Dim, typename T>
+void MappedCurve<Dim, T>::validate(void) const {
+    if (size < sizeof(CurveFileHeader)) {
+        throw std::runtime_error("MappedCurve: file is too small for a header");
+    }
+
+    const CurveFileHeader& h = header();
+    std::uint64_t a = h.anchor_count;
+    bool closed = (h.flags & BEZ_CURVE_FILE_CLOSED) != 0;
+    std::uint64_t point_count = a == 0 ? 0 : closed ? 3 * a + 1 : 3 * a - 2;
+    std::uint64_t bezier_count = a == 0 ? 0 : closed ? a : a - 1;
+
+    if (memcmp(h.magic, bez_curve_file_magic, sizeof(h.magic)) != 0) {
+        throw std::runtime_error("MappedCurve: not a curve file");
+    }
+    if (h.version != BEZ_CURVE_FILE_VERSION || h.header_size != sizeof(CurveFileHeader)) {
+        throw std::runtime_error("MappedCurve: unsupported curve file version");
+    }
+    if (h.dims != Dim || h.scalar_size != sizeof(T)) {
+        throw std::runtime_error("MappedCurve: curve file has a different point type");
+    }
+    if (h.file_size != size) {
+        throw std::runtime_error("MappedCurve: curve file is truncated");
+    }
+    if (a > size || h.bezier_count != bezier_count || h.parameterization > BEZ_CENTRIPETAL) {
+        throw std::runtime_error("MappedCurve: curve file header is inconsistent");
+    }
+
+    // Bounds arc_samples so the size of the arc length section cannot overflow
+    if (h.arc_lengths_offset != 0 &&
+        (h.arc_samples == 0 || h.arc_samples > size / (bezier_count + 1))) {
+        throw std::runtime_error("MappedCurve: curve file header is inconsistent");
+    }
+
+    // Each present section must be aligned and lie within the file
+    struct {
+        std::uint64_t offset;
+        std::uint64_t bytes;
+        bool required;
+    } sections[] = {
+        { h.points_offset, point_count * sizeof(Vect), point_count > 0 },
+        { h.knots_offset, (bezier_count + 1) * sizeof(T),
+          bezier_count > 0 && h.parameterization != BEZ_UNIFORM },
+        { h.boxes_offset, 2 * bezier_count * sizeof(Vect), false },
+        { h.arc_lengths_offset, (bezier_count * h.arc_samples + 1) * sizeof(T), false },
+    };
+
+    for (const auto& s : sections) {
+        if (s.offset == 0) {
+            if (s.required) {
+                throw std::runtime_error("MappedCurve: curve file is missing a section");
+            }
+            continue;
+        }
+        if (s.offset % BEZ_CURVE_FILE_ALIGNMENT != 0 || s.offset > size || s.bytes > size - s.offset) {
+            throw std::runtime_error("MappedCurve: curve file section is out of bounds");
+        }
+    }
+
+}
+
+/*
+ * function: release
+ *
+ * Unmaps or frees the file contents, if any.
+ */
+template <std::size_t Dim, typename T>
+void MappedCurve<Dim, T>::release(void) {
+    if (data == nullptr) {
+        return;
+    }
+
+#ifdef BEZ_HAVE_MMAP
+    if (mapped) {
+        munmap(const_cast<unsigned char*>(data), size);
+    }
+#else
+    delete[] data;
+#endif
+
+    data = nullptr;
+}
+
+/*
+ * function: section
+ *
+ * Returns a pointer to the section at the given offset, or nullptr if the
+ * offset is 0.
+ */
+template <std::size_t Dim, typename T>
+const void* MappedCurve<Dim, T>::section(std::uint64_t offset) const {
+    return offset != 0 ? data + offset : nullptr;
+}
+
+
+//*****************************************************************************
+// Explicit instantiations
+//*****************************************************************************
+
+template void writeCurveFile<2, BEZ_DTYPE>(const Curve<2, BEZ_DTYPE>&, const char*, unsigned);
+template void writeCurveFile<3, BEZ_DTYPE>(const Curve<3, BEZ_DTYPE>&, const char*, unsigned);
+template class MappedCurve<2, BEZ_DTYPE>;
+template class MappedCurve<3, BEZ_DTYPE>;
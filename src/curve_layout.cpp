@@ -0,0 +1,942 @@
+/*
+ * curve_layout.cpp
+ *
+ * Implements the layouts and batch kernels defined in curve_layout.h.
+ */
+
+#include "curve_layout.h"
+#include "curve_view.h"
+#include "streaming_curve.h"
+#include "svg_path.h"
+
+#include <math.h>
+
+#include <type_traits>
+
+#include "bezier_math.h"
+#include "bezier_stats.h"
+#include "curve_trace.h"
+
+// Lanes of the SIMD kernels, the widest vectors the compiler targets
+#if defined(__AVX__)
+#include <immintrin.h>
+#define BEZ_LAYOUT_LANES LanesAvx
+#elif defined(BEZ_HAVE_SSE)
+#define BEZ_LAYOUT_LANES LanesSse
+#endif
+
+
+//*****************************************************************************
+// Lanes
+//*****************************************************************************
+
+#if defined(BEZ_LAYOUT_LANES)
+
+/*
+ * struct: LanesSse
+ *
+ * Operations on 4 floats at once with SSE. Comparisons return masks for
+ * land and select, and sqrt and reciprocal follow BEZ_MATH_POLICY like
+ * BEZ_KERNEL_SQRT and BEZ_KERNEL_RECIPROCAL.
+ */
+struct LanesSse {
+    typedef __m128 V;
+    static const std::size_t width = 4;
+
+    static V set1(float x) { return _mm_set1_ps(x); }
+    static V iota(void) { return _mm_setr_ps(0.f, 1.f, 2.f, 3.f); }
+    static V load(const float* p) { return _mm_loadu_ps(p); }
+    static void store(float* p, V x) { _mm_storeu_ps(p, x); }
+
+    static V add(V a, V b) { return _mm_add_ps(a, b); }
+    static V sub(V a, V b) { return _mm_sub_ps(a, b); }
+    static V mul(V a, V b) { return _mm_mul_ps(a, b); }
+#if BEZ_MATH_POLICY == BEZ_MATH_FAST
+    static V sqrt(V x) { return bezFastSqrtPs(x); }
+    static V reciprocal(V x) { return bezFastReciprocalPs(x); }
+#else
+    static V sqrt(V x) { return _mm_sqrt_ps(x); }
+    static V reciprocal(V x) { return _mm_div_ps(_mm_set1_ps(1.f), x); }
+#endif
+    static V min(V a, V b) { return _mm_min_ps(a, b); }
+    static V max(V a, V b) { return _mm_max_ps(a, b); }
+
+    static V lt(V a, V b) { return _mm_cmplt_ps(a, b); }
+    static V gt(V a, V b) { return _mm_cmpgt_ps(a, b); }
+    static V ge(V a, V b) { return _mm_cmpge_ps(a, b); }
+    static V ne(V a, V b) { return _mm_cmpneq_ps(a, b); }
+    static V land(V a, V b) { return _mm_and_ps(a, b); }
+    static V select(V mask, V a, V b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+
+    /*
+     * function: loadBlocks
+     *
+     * Loads the 4 floats at each of blocks[0 ... 3] and transposes them, so
+     * that p[j] holds float j of blocks[k] in lane k.
+     */
+    static void loadBlocks(const float* const* blocks, V p[4]) {
+        V r0 = _mm_loadu_ps(blocks[0]);
+        V r1 = _mm_loadu_ps(blocks[1]);
+        V r2 = _mm_loadu_ps(blocks[2]);
+        V r3 = _mm_loadu_ps(blocks[3]);
+
+        _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+        p[0] = r0;
+        p[1] = r1;
+        p[2] = r2;
+        p[3] = r3;
+    }
+
+    /*
+     * function: storeXY
+     *
+     * Stores the 2D points (x, y) of every lane to out, interleaved.
+     */
+    static void storeXY(float* out, V x, V y) {
+        _mm_storeu_ps(out, _mm_unpacklo_ps(x, y));
+        _mm_storeu_ps(out + 4, _mm_unpackhi_ps(x, y));
+    }
+};
+
+#if defined(__AVX__)
+
+/*
+ * struct: LanesAvx
+ *
+ * Operations on 8 floats at once with AVX, see LanesSse. The fast math
+ * functions run on each half with SSE.
+ */
+struct LanesAvx {
+    typedef __m256 V;
+    static const std::size_t width = 8;
+
+    static __m128 low(V x) { return _mm256_castps256_ps128(x); }
+    static __m128 high(V x) { return _mm256_extractf128_ps(x, 1); }
+    static V halves(__m128 lo, __m128 hi) { return _mm256_insertf128_ps(_mm256_castps128_ps256(lo), hi, 1); }
+
+    static V set1(float x) { return _mm256_set1_ps(x); }
+    static V iota(void) { return _mm256_setr_ps(0.f, 1.f, 2.f, 3.f, 4.f, 5.f, 6.f, 7.f); }
+    static V load(const float* p) { return _mm256_loadu_ps(p); }
+    static void store(float* p, V x) { _mm256_storeu_ps(p, x); }
+
+    static V add(V a, V b) { return _mm256_add_ps(a, b); }
+    static V sub(V a, V b) { return _mm256_sub_ps(a, b); }
+    static V mul(V a, V b) { return _mm256_mul_ps(a, b); }
+#if BEZ_MATH_POLICY == BEZ_MATH_FAST
+    static V sqrt(V x) { return halves(bezFastSqrtPs(low(x)), bezFastSqrtPs(high(x))); }
+    static V reciprocal(V x) { return halves(bezFastReciprocalPs(low(x)), bezFastReciprocalPs(high(x))); }
+#else
+    static V sqrt(V x) { return _mm256_sqrt_ps(x); }
+    static V reciprocal(V x) { return _mm256_div_ps(_mm256_set1_ps(1.f), x); }
+#endif
+    static V min(V a, V b) { return _mm256_min_ps(a, b); }
+    static V max(V a, V b) { return _mm256_max_ps(a, b); }
+
+    static V lt(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+    static V gt(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+    static V ge(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+    static V ne(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_NEQ_UQ); }
+    static V land(V a, V b) { return _mm256_and_ps(a, b); }
+    static V select(V mask, V a, V b) {
+        return _mm256_or_ps(_mm256_and_ps(mask, a), _mm256_andnot_ps(mask, b));
+    }
+
+    /*
+     * function: loadBlocks
+     *
+     * Loads the 4 floats at each of blocks[0 ... 7] and transposes them, so
+     * that p[j] holds float j of blocks[k] in lane k. Blocks k and k + 4
+     * share a register, whose halves are transposed side by side.
+     */
+    static void loadBlocks(const float* const* blocks, V p[4]) {
+        V r0 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(blocks[0])),
+                                    _mm_loadu_ps(blocks[4]), 1);
+        V r1 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(blocks[1])),
+                                    _mm_loadu_ps(blocks[5]), 1);
+        V r2 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(blocks[2])),
+                                    _mm_loadu_ps(blocks[6]), 1);
+        V r3 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(blocks[3])),
+                                    _mm_loadu_ps(blocks[7]), 1);
+        V t0 = _mm256_unpacklo_ps(r0, r1);
+        V t1 = _mm256_unpackhi_ps(r0, r1);
+        V t2 = _mm256_unpacklo_ps(r2, r3);
+        V t3 = _mm256_unpackhi_ps(r2, r3);
+
+        p[0] = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+        p[1] = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+        p[2] = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+        p[3] = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+    }
+
+    /*
+     * function: storeXY
+     *
+     * Stores the 2D points (x, y) of every lane to out, interleaved.
+     */
+    static void storeXY(float* out, V x, V y) {
+        V lo = _mm256_unpacklo_ps(x, y);  // points 0, 1, 4, 5
+        V hi = _mm256_unpackhi_ps(x, y);  // points 2, 3, 6, 7
+
+        _mm256_storeu_ps(out, _mm256_permute2f128_ps(lo, hi, 0x20));
+        _mm256_storeu_ps(out + 8, _mm256_permute2f128_ps(lo, hi, 0x31));
+    }
+};
+
+#endif
+
+#endif
+
+
+//*****************************************************************************
+// CurveInterleavedView
+//*****************************************************************************
+
+/*
+ * constructor
+ *
+ * Args:
+ *   curve: spline whose points to present
+ */
+template <std::size_t Dim, typename T>
+CurveInterleavedView<Dim, T>::CurveInterleavedView(const Curve<Dim, T>& curve) :
+    points(curve.points.data()), bezier_count(curve.bezier_count) {
+    curve.solvePending();
+}
+
+/*
+ * constructor
+ *
+ * Args:
+ *   points: 3 * bezier_count + 1 interleaved points
+ *   bezier_count: number of Bezier curves
+ */
+template <std::size_t Dim, typename T>
+CurveInterleavedView<Dim, T>::CurveInterleavedView(const typename Curve<Dim, T>::Vect* points,
+                                                   std::size_t bezier_count) :
+    points(points), bezier_count(bezier_count) {
+    // Nothing to do
+}
+
+template <std::size_t Dim, typename T>
+std::size_t CurveInterleavedView<Dim, T>::segmentCount(void) const {
+    return bezier_count;
+}
+
+template <std::size_t Dim, typename T>
+T CurveInterleavedView<Dim, T>::get(std::size_t s, std::size_t p, std::size_t d) const {
+    return points[3 * s + p][d];
+}
+
+
+//*****************************************************************************
+// CurveSoA
+//*****************************************************************************
+
+template <std::size_t Dim, typename T>
+CurveSoA<Dim, T>::CurveSoA(void) :
+    bezier_count(0) {
+    // Nothing to do
+}
+
+template <std::size_t Dim, typename T>
+CurveSoA<Dim, T>::CurveSoA(const Curve<Dim, T>& curve) {
+    assign(curve);
+}
+
+/*
+ * function: assign
+ *
+ * Replaces the contents with the points of the given spline, reusing the
+ * existing storage when it is large enough.
+ */
+template <std::size_t Dim, typename T>
+void CurveSoA<Dim, T>::assign(const Curve<Dim, T>& curve) {
+    std::size_t i, d;
+
+    curve.solvePending();
+    bezier_count = curve.bezier_count;
+
+    for (d = 0; d < Dim; d++) {
+        coords[d].resize(curve.points.size());
+
+        for (i = 0; i < curve.points.size(); i++) {
+            coords[d][i] = curve.points[i][d];
+        }
+    }
+}
+
+template <std::size_t Dim, typename T>
+std::size_t CurveSoA<Dim, T>::segmentCount(void) const {
+    return bezier_count;
+}
+
+template <std::size_t Dim, typename T>
+T CurveSoA<Dim, T>::get(std::size_t s, std::size_t p, std::size_t d) const {
+    return coords[d][3 * s + p];
+}
+
+/*
+ * function: block
+ *
+ * Returns the 4 consecutive values of coordinate d of Bezier curve s,
+ * shared at either end with its neighbours.
+ */
+template <std::size_t Dim, typename T>
+const T* CurveSoA<Dim, T>::block(std::size_t s, std::size_t d) const {
+    return &coords[d][3 * s];
+}
+
+
+//*****************************************************************************
+// CurvePacked
+//*****************************************************************************
+
+template <std::size_t Dim, typename T>
+CurvePacked<Dim, T>::CurvePacked(void) :
+    bezier_count(0) {
+    // Nothing to do
+}
+
+template <std::size_t Dim, typename T>
+CurvePacked<Dim, T>::CurvePacked(const Curve<Dim, T>& curve) {
+    assign(curve);
+}
+
+/*
+ * function: assign
+ *
+ * Replaces the contents with the points of the given spline, reusing the
+ * existing storage when it is large enough.
+ */
+template <std::size_t Dim, typename T>
+void CurvePacked<Dim, T>::assign(const Curve<Dim, T>& curve) {
+    std::size_t s, p, d;
+    T* block;
+
+    curve.solvePending();
+    bezier_count = curve.bezier_count;
+    data.resize(bezier_count * 4 * Dim);
+
+    for (s = 0; s < bezier_count; s++) {
+        for (d = 0; d < Dim; d++) {
+            block = &data[(s * Dim + d) * 4];
+
+            for (p = 0; p < 4; p++) {
+                block[p] = curve.points[3 * s + p][d];
+            }
+        }
+    }
+}
+
+template <std::size_t Dim, typename T>
+std::size_t CurvePacked<Dim, T>::segmentCount(void) const {
+    return bezier_count;
+}
+
+template <std::size_t Dim, typename T>
+T CurvePacked<Dim, T>::get(std::size_t s, std::size_t p, std::size_t d) const {
+    return data[(s * Dim + d) * 4 + p];
+}
+
+/*
+ * function: block
+ *
+ * Returns the 4 consecutive values of coordinate d of Bezier curve s.
+ */
+template <std::size_t Dim, typename T>
+const T* CurvePacked<Dim, T>::block(std::size_t s, std::size_t d) const {
+    return &data[(s * Dim + d) * 4];
+}
+
+
+//*****************************************************************************
+// Scalar kernels
+//*****************************************************************************
+
+/*
+ * function: evaluateSegmentsScalar
+ *
+ * Evaluates count (Bezier curve, t) pairs one at a time, see evaluateSegments.
+ */
+template <class Layout>
+void evaluateSegmentsScalar(const Layout& layout,
+                            const std::size_t* segments,
+                            const typename Layout::value_type* ts,
+                            std::size_t count,
+                            std::array<typename Layout::value_type, Layout::dims>* out) {
+    typedef typename Layout::value_type T;
+    const std::size_t Dim = Layout::dims;
+    std::size_t i, p, d;
+    T w[4];  // Bernstein weights
+
+    for (i = 0; i < count; i++) {
+        T t = ts[i];
+        T omt = 1. - t;  // one minus t
+
+        w[0] = omt * omt * omt;
+        w[1] = 3. * t * omt * omt;
+        w[2] = 3. * t * t * omt;
+        w[3] = t * t * t;
+
+        for (d = 0; d < Dim; d++) {
+            T sum = 0.;
+
+            for (p = 0; p < 4; p++) {
+                sum += w[p] * layout.get(segments[i], p, d);
+            }
+
+            out[i][d] = sum;
+        }
+    }
+}
+
+/*
+ * function: tessellateScalar
+ *
+ * Writes the points of Bezier curves first ... segmentCount() - 1 one Bezier
+ * curve at a time, followed by the final anchor point, see tessellate.
+ *
+ * Each Bezier curve is converted to power basis once, so every point costs
+ * 3 multiply-adds per coordinate.
+ */
+template <class Layout>
+void tessellateScalar(const Layout& layout, std::size_t steps, std::size_t first,
+                      std::array<typename Layout::value_type, Layout::dims>* out) {
+    typedef typename Layout::value_type T;
+    const std::size_t Dim = Layout::dims;
+    std::size_t n = layout.segmentCount();
+    std::size_t s, j, d;
+    T coef[Dim][4];  // power basis coefficients, constant term first
+    T inv_steps = 1. / (T)(steps);
+
+    for (s = first; s < n; s++) {
+        for (d = 0; d < Dim; d++) {
+            T p0 = layout.get(s, 0, d);
+            T p1 = layout.get(s, 1, d);
+            T p2 = layout.get(s, 2, d);
+            T p3 = layout.get(s, 3, d);
+
+            coef[d][0] = p0;
+            coef[d][1] = 3. * (p1 - p0);
+            coef[d][2] = 3. * (p0 - 2. * p1 + p2);
+            coef[d][3] = -p0 + 3. * (p1 - p2) + p3;
+        }
+
+        std::array<T, Dim>* dst = &out[s * steps];
+
+        for (j = 0; j < steps; j++) {
+            T t = (T)(j) * inv_steps;
+
+            for (d = 0; d < Dim; d++) {
+                dst[j][d] = ((coef[d][3] * t + coef[d][2]) * t + coef[d][1]) * t + coef[d][0];
+            }
+        }
+    }
+
+    for (d = 0; d < Dim; d++) {
+        out[n * steps][d] = layout.get(n - 1, 3, d);
+    }
+}
+
+/*
+ * function: segmentBoundingBoxesScalar
+ *
+ * Computes the bounding boxes of Bezier curves first ... segmentCount() - 1
+ * one Bezier curve at a time, see segmentBoundingBoxes.
+ *
+ * Uses the same roots of the derivative as bez2BoundingBox, but handles each
+ * coordinate independently so any number of dimensions works, and falls back
+ * to the linear root when the quadratic term vanishes.
+ */
+template <class Layout>
+void segmentBoundingBoxesScalar(const Layout& layout, std::size_t first,
+                                std::array<typename Layout::value_type, Layout::dims>* mins,
+                                std::array<typename Layout::value_type, Layout::dims>* maxs) {
+    typedef typename Layout::value_type T;
+    const std::size_t Dim = Layout::dims;
+    std::size_t n = layout.segmentCount();
+    std::size_t s, d, r;
+
+    for (s = first; s < n; s++) {
+        for (d = 0; d < Dim; d++) {
+            T p0 = layout.get(s, 0, d);
+            T p1 = layout.get(s, 1, d);
+            T p2 = layout.get(s, 2, d);
+            T p3 = layout.get(s, 3, d);
+            T a = -p0 + 3. * p1 - 3. * p2 + p3;
+            T b = 2. * (p0 - 2. * p1 + p2);
+            T c = p1 - p0;
+            T roots[2];
+            std::size_t num_roots = 0;
+            T lo = p0 < p3 ? p0 : p3;
+            T hi = p0 < p3 ? p3 : p0;
+
+            if (a != 0.) {
+                T disc = b * b - 4. * a * c;
+
+                if (disc >= 0.) {
+                    T sqrtdisc = BEZ_KERNEL_SQRT(disc);
+                    T inv_2a = BEZ_KERNEL_RECIPROCAL(2. * a);
+
+                    roots[0] = (-b - sqrtdisc) * inv_2a;
+                    roots[1] = (-b + sqrtdisc) * inv_2a;
+                    num_roots = 2;
+                }
+            }
+            else if (b != 0.) {
+                roots[0] = -c / b;
+                num_roots = 1;
+            }
+
+            for (r = 0; r < num_roots; r++) {
+                T t = roots[r];
+
+                if (t > 0. && t < 1.) {
+                    T omt = 1. - t;
+                    T v = p0 * omt * omt * omt + 3. * p1 * t * omt * omt +
+                          3. * p2 * t * t * omt + p3 * t * t * t;
+
+                    if (v < lo) {
+                        lo = v;
+                    }
+                    if (v > hi) {
+                        hi = v;
+                    }
+                }
+            }
+
+            mins[s][d] = lo;
+            maxs[s][d] = hi;
+        }
+    }
+}
+
+
+//*****************************************************************************
+// SIMD kernels
+//*****************************************************************************
+
+#if defined(BEZ_LAYOUT_LANES)
+
+/*
+ * function: storeLanes
+ *
+ * Stores the point made of lane k of each coordinate to out[k], for every
+ * lane k.
+ *
+ * Args:
+ *   coords: Dim vectors, one per coordinate
+ *   out: output array of Lanes::width points
+ */
+template <class Lanes, std::size_t Dim>
+inline void storeLanes(const typename Lanes::V* coords, std::array<float, Dim>* out) {
+    float lanes[Dim][Lanes::width];
+    std::size_t k, d;
+
+    if (Dim == 2) {
+        Lanes::storeXY(&out[0][0], coords[0], coords[Dim - 1]);
+        return;
+    }
+
+    for (d = 0; d < Dim; d++) {
+        Lanes::store(lanes[d], coords[d]);
+    }
+    for (k = 0; k < Lanes::width; k++) {
+        for (d = 0; d < Dim; d++) {
+            out[k][d] = lanes[d][k];
+        }
+    }
+}
+
+/*
+ * function: loadLanes
+ *
+ * Loads coordinate d of Bezier curves s[0] ... s[Lanes::width - 1] so that
+ * p[j] holds control point j of Bezier curve s[k] in lane k.
+ */
+template <class Lanes, class Layout>
+inline void loadLanes(const Layout& layout, const std::size_t* s, std::size_t d,
+                      typename Lanes::V p[4]) {
+    const float* blocks[Lanes::width];
+    std::size_t k;
+
+    for (k = 0; k < Lanes::width; k++) {
+        blocks[k] = layout.block(s[k], d);
+    }
+    Lanes::loadBlocks(blocks, p);
+}
+
+/*
+ * function: evaluateSegmentsLanes
+ *
+ * Evaluates count (Bezier curve, t) pairs Lanes::width at a time, one query
+ * per lane, leaving the remainder to evaluateSegmentsScalar.
+ */
+template <class Lanes, class Layout>
+void evaluateSegmentsLanes(const Layout& layout,
+                           const std::size_t* segments,
+                           const float* ts,
+                           std::size_t count,
+                           std::array<float, Layout::dims>* out) {
+    typedef typename Lanes::V V;
+    const std::size_t Dim = Layout::dims;
+    const V one = Lanes::set1(1.f), three = Lanes::set1(3.f);
+    V p[4], w[4], coords[Dim];
+    std::size_t i = 0, d;
+
+    for (; i + Lanes::width <= count; i += Lanes::width) {
+        V t = Lanes::load(ts + i);
+        V omt = Lanes::sub(one, t);  // one minus t
+
+        w[0] = Lanes::mul(Lanes::mul(omt, omt), omt);
+        w[1] = Lanes::mul(Lanes::mul(Lanes::mul(three, t), omt), omt);
+        w[2] = Lanes::mul(Lanes::mul(Lanes::mul(three, t), t), omt);
+        w[3] = Lanes::mul(Lanes::mul(t, t), t);
+
+        for (d = 0; d < Dim; d++) {
+            loadLanes<Lanes>(layout, segments + i, d, p);
+            coords[d] = Lanes::add(Lanes::add(Lanes::mul(w[0], p[0]), Lanes::mul(w[1], p[1])),
+                                   Lanes::add(Lanes::mul(w[2], p[2]), Lanes::mul(w[3], p[3])));
+        }
+        storeLanes<Lanes, Dim>(coords, out + i);
+    }
+
+    evaluateSegmentsScalar(layout, segments + i, ts + i, count - i, out + i);
+}
+
+/*
+ * function: tessellateLanes
+ *
+ * Converts Lanes::width Bezier curves at a time to power basis, one per lane,
+ * then writes the points of each Lanes::width at a time, one t per lane,
+ * leaving the remaining Bezier curves and points to tessellateScalar.
+ */
+template <class Lanes, class Layout>
+void tessellateLanes(const Layout& layout, std::size_t steps,
+                     std::array<float, Layout::dims>* out) {
+    typedef typename Lanes::V V;
+    const std::size_t Dim = Layout::dims;
+    const std::size_t W = Lanes::width;
+    std::size_t n = layout.segmentCount();
+    const V two = Lanes::set1(2.f), three = Lanes::set1(3.f);
+    const float inv_steps = 1.f / (float)(steps);
+    float coef[Dim][4][W];  // power basis coefficients, constant term first,
+                            // of the Bezier curve in each lane
+    std::size_t index[W];
+    V p[4], coords[Dim];
+    std::size_t s = 0, j, k, d;
+
+    for (; s + W <= n; s += W) {
+        for (k = 0; k < W; k++) {
+            index[k] = s + k;
+        }
+
+        for (d = 0; d < Dim; d++) {
+            loadLanes<Lanes>(layout, index, d, p);
+
+            Lanes::store(coef[d][0], p[0]);
+            Lanes::store(coef[d][1], Lanes::mul(three, Lanes::sub(p[1], p[0])));
+            Lanes::store(coef[d][2], Lanes::mul(three, Lanes::add(Lanes::sub(p[0],
+                Lanes::mul(two, p[1])), p[2])));
+            Lanes::store(coef[d][3], Lanes::add(Lanes::sub(p[3], p[0]),
+                Lanes::mul(three, Lanes::sub(p[1], p[2]))));
+        }
+
+        for (k = 0; k < W; k++) {
+            std::array<float, Dim>* dst = &out[(s + k) * steps];
+
+            for (j = 0; j + W <= steps; j += W) {
+                V t = Lanes::mul(Lanes::add(Lanes::set1((float)(j)), Lanes::iota()),
+                                 Lanes::set1(inv_steps));
+
+                for (d = 0; d < Dim; d++) {
+                    V c = Lanes::set1(coef[d][3][k]);
+
+                    c = Lanes::add(Lanes::mul(c, t), Lanes::set1(coef[d][2][k]));
+                    c = Lanes::add(Lanes::mul(c, t), Lanes::set1(coef[d][1][k]));
+                    coords[d] = Lanes::add(Lanes::mul(c, t), Lanes::set1(coef[d][0][k]));
+                }
+                storeLanes<Lanes, Dim>(coords, dst + j);
+            }
+
+            for (; j < steps; j++) {
+                float t = (float)(j) * inv_steps;
+
+                for (d = 0; d < Dim; d++) {
+                    dst[j][d] = ((coef[d][3][k] * t + coef[d][2][k]) * t + coef[d][1][k]) * t +
+                                coef[d][0][k];
+                }
+            }
+        }
+    }
+
+    tessellateScalar(layout, steps, s, out);
+}
+
+/*
+ * function: segmentBoundingBoxesLanes
+ *
+ * Computes the bounding boxes of Lanes::width Bezier curves at a time, one
+ * per lane, leaving the remainder to segmentBoundingBoxesScalar. Both roots
+ * of the derivative are always computed, and the lanes where a root does not
+ * exist or falls outside (0, 1) are masked out of the comparisons.
+ */
+template <class Lanes, class Layout>
+void segmentBoundingBoxesLanes(const Layout& layout,
+                               std::array<float, Layout::dims>* mins,
+                               std::array<float, Layout::dims>* maxs) {
+    typedef typename Lanes::V V;
+    const std::size_t Dim = Layout::dims;
+    const std::size_t W = Lanes::width;
+    std::size_t n = layout.segmentCount();
+    const V zero = Lanes::set1(0.f), one = Lanes::set1(1.f);
+    const V two = Lanes::set1(2.f), three = Lanes::set1(3.f), four = Lanes::set1(4.f);
+    std::size_t index[W];
+    V p[4], lo[Dim], hi[Dim];
+    std::size_t s = 0, k, d, r;
+
+    for (; s + W <= n; s += W) {
+        for (k = 0; k < W; k++) {
+            index[k] = s + k;
+        }
+
+        for (d = 0; d < Dim; d++) {
+            loadLanes<Lanes>(layout, index, d, p);
+
+            V a = Lanes::add(Lanes::sub(Lanes::mul(three, Lanes::sub(p[1], p[2])), p[0]), p[3]);
+            V b = Lanes::mul(two, Lanes::add(Lanes::sub(p[0], Lanes::mul(two, p[1])), p[2]));
+            V c = Lanes::sub(p[1], p[0]);
+            V disc = Lanes::sub(Lanes::mul(b, b), Lanes::mul(four, Lanes::mul(a, c)));
+            V quadratic = Lanes::ne(a, zero);
+            V sqrtdisc = Lanes::sqrt(Lanes::max(disc, zero));
+            V roots[2], exists[2];
+
+            // the linear root -c / b takes the place of the first when a = 0
+            V inv_denom = Lanes::reciprocal(Lanes::select(quadratic, Lanes::mul(two, a), b));
+
+            roots[0] = Lanes::mul(Lanes::select(quadratic, Lanes::sub(Lanes::sub(zero, b), sqrtdisc),
+                                                Lanes::sub(zero, c)), inv_denom);
+            roots[1] = Lanes::mul(Lanes::add(Lanes::sub(zero, b), sqrtdisc), inv_denom);
+            exists[1] = Lanes::land(quadratic, Lanes::ge(disc, zero));
+            exists[0] = Lanes::select(quadratic, exists[1], Lanes::ne(b, zero));
+
+            lo[d] = Lanes::min(p[0], p[3]);
+            hi[d] = Lanes::max(p[0], p[3]);
+
+            for (r = 0; r < 2; r++) {
+                V t = roots[r];
+                V omt = Lanes::sub(one, t);
+                V inside = Lanes::land(exists[r], Lanes::land(Lanes::gt(t, zero), Lanes::lt(t, one)));
+                V v = Lanes::add(
+                    Lanes::add(Lanes::mul(p[0], Lanes::mul(Lanes::mul(omt, omt), omt)),
+                               Lanes::mul(Lanes::mul(three, p[1]), Lanes::mul(Lanes::mul(t, omt), omt))),
+                    Lanes::add(Lanes::mul(Lanes::mul(three, p[2]), Lanes::mul(Lanes::mul(t, t), omt)),
+                               Lanes::mul(p[3], Lanes::mul(Lanes::mul(t, t), t))));
+
+                lo[d] = Lanes::select(inside, Lanes::min(lo[d], v), lo[d]);
+                hi[d] = Lanes::select(inside, Lanes::max(hi[d], v), hi[d]);
+            }
+        }
+
+        storeLanes<Lanes, Dim>(lo, mins + s);
+        storeLanes<Lanes, Dim>(hi, maxs + s);
+    }
+
+    segmentBoundingBoxesScalar(layout, s, mins, maxs);
+}
+
+#endif
+
+
+//*****************************************************************************
+// Kernels
+//*****************************************************************************
+
+/*
+ * struct: HasLanes
+ *
+ * Whether the SIMD kernels handle a layout, which needs float coordinates
+ * and block().
+ */
+template <class Layout>
+struct HasLanes : std::false_type {};
+
+#if defined(BEZ_LAYOUT_LANES)
+template <std::size_t Dim>
+struct HasLanes<CurveSoA<Dim, float> > : std::true_type {};
+
+template <std::size_t Dim>
+struct HasLanes<CurvePacked<Dim, float> > : std::true_type {};
+
+template <class Layout>
+void evaluateSegments(const Layout& layout, const std::size_t* segments, const float* ts,
+                      std::size_t count, std::array<float, Layout::dims>* out, std::true_type) {
+    evaluateSegmentsLanes<BEZ_LAYOUT_LANES>(layout, segments, ts, count, out);
+}
+
+template <class Layout>
+void tessellate(const Layout& layout, std::size_t steps, std::array<float, Layout::dims>* out,
+                std::true_type) {
+    tessellateLanes<BEZ_LAYOUT_LANES>(layout, steps, out);
+}
+
+template <class Layout>
+void segmentBoundingBoxes(const Layout& layout, std::array<float, Layout::dims>* mins,
+                          std::array<float, Layout::dims>* maxs, std::true_type) {
+    segmentBoundingBoxesLanes<BEZ_LAYOUT_LANES>(layout, mins, maxs);
+}
+#endif
+
+template <class Layout>
+void evaluateSegments(const Layout& layout, const std::size_t* segments,
+                      const typename Layout::value_type* ts, std::size_t count,
+                      std::array<typename Layout::value_type, Layout::dims>* out, std::false_type) {
+    evaluateSegmentsScalar(layout, segments, ts, count, out);
+}
+
+template <class Layout>
+void tessellate(const Layout& layout, std::size_t steps,
+                std::array<typename Layout::value_type, Layout::dims>* out, std::false_type) {
+    tessellateScalar(layout, steps, 0, out);
+}
+
+template <class Layout>
+void segmentBoundingBoxes(const Layout& layout,
+                          std::array<typename Layout::value_type, Layout::dims>* mins,
+                          std::array<typename Layout::value_type, Layout::dims>* maxs,
+                          std::false_type) {
+    segmentBoundingBoxesScalar(layout, 0, mins, maxs);
+}
+
+/*
+ * function: evaluateSegments
+ *
+ * Evaluates count (Bezier curve, t) pairs.
+ *
+ * Args:
+ *   layout: points of the spline
+ *   segments: index of the Bezier curve of each query
+ *   ts: parameter value local to the Bezier curve of each query
+ *   count: number of queries
+ *   out: output array of count points
+ */
+template <class Layout>
+void evaluateSegments(const Layout& layout,
+                      const std::size_t* segments,
+                      const typename Layout::value_type* ts,
+                      std::size_t count,
+                      std::array<typename Layout::value_type, Layout::dims>* out) {
+    BEZ_STATS_ADD(evaluations, count);
+    BEZ_TRACE_SCOPE("evaluateSegments", count);
+
+    evaluateSegments(layout, segments, ts, count, out, HasLanes<Layout>());
+}
+
+/*
+ * function: tessellate
+ *
+ * Replaces the contents of out with steps points per Bezier curve at evenly
+ * spaced t, followed by the final anchor point.
+ *
+ * Args:
+ *   layout: points of the spline
+ *   steps: number of points per Bezier curve, at least 1
+ *   out: vector to fill with segmentCount() * steps + 1 points
+ */
+template <class Layout>
+void tessellate(const Layout& layout, std::size_t steps,
+                std::vector<std::array<typename Layout::value_type, Layout::dims> >& out) {
+    std::size_t n = layout.segmentCount();
+
+    if (n == 0) {
+        out.clear();
+        return;
+    }
+
+    out.resize(n * steps + 1);
+    tessellate(layout, steps, out.data());
+}
+
+/*
+ * function: tessellate
+ *
+ * Writes steps points per Bezier curve at evenly spaced t, followed by the
+ * final anchor point, to the given array. Writes nothing if the spline has no
+ * Bezier curves.
+ *
+ * Args:
+ *   layout: points of the spline
+ *   steps: number of points per Bezier curve, at least 1
+ *   out: output array of segmentCount() * steps + 1 points
+ */
+template <class Layout>
+void tessellate(const Layout& layout, std::size_t steps,
+                std::array<typename Layout::value_type, Layout::dims>* out) {
+    std::size_t n = layout.segmentCount();
+
+    if (n == 0) {
+        return;
+    }
+
+    BEZ_TRACE_SCOPE("tessellate", n * steps + 1);
+
+    tessellate(layout, steps, out, HasLanes<Layout>());
+}
+
+/*
+ * function: segmentBoundingBoxes
+ *
+ * Computes the tight axis-aligned bounding box of every Bezier curve.
+ *
+ * Args:
+ *   layout: points of the spline
+ *   mins: output array of segmentCount() lower corners
+ *   maxs: output array of segmentCount() upper corners
+ */
+template <class Layout>
+void segmentBoundingBoxes(const Layout& layout,
+                          std::array<typename Layout::value_type, Layout::dims>* mins,
+                          std::array<typename Layout::value_type, Layout::dims>* maxs) {
+    segmentBoundingBoxes(layout, mins, maxs, HasLanes<Layout>());
+}
+
+
+//*****************************************************************************
+// Explicit instantiations
+//*****************************************************************************
+
+#define BEZ_INSTANTIATE_KERNELS(LAYOUT, DIM) \
+    template void evaluateSegments<LAYOUT<DIM, BEZ_DTYPE> >( \
+        const LAYOUT<DIM, BEZ_DTYPE>&, const std::size_t*, const BEZ_DTYPE*, \
+        std::size_t, std::array<BEZ_DTYPE, DIM>*); \
+    template void tessellate<LAYOUT<DIM, BEZ_DTYPE> >( \
+        const LAYOUT<DIM, BEZ_DTYPE>&, std::size_t, \
+        std::vector<std::array<BEZ_DTYPE, DIM> >&); \
+    template void tessellate<LAYOUT<DIM, BEZ_DTYPE> >( \
+        const LAYOUT<DIM, BEZ_DTYPE>&, std::size_t, std::array<BEZ_DTYPE, DIM>*); \
+    template void segmentBoundingBoxes<LAYOUT<DIM, BEZ_DTYPE> >( \
+        const LAYOUT<DIM, BEZ_DTYPE>&, std::array<BEZ_DTYPE, DIM>*, \
+        std::array<BEZ_DTYPE, DIM>*);
+
+#define BEZ_INSTANTIATE_LAYOUT(LAYOUT, DIM) \
+    template class LAYOUT<DIM, BEZ_DTYPE>; \
+    BEZ_INSTANTIATE_KERNELS(LAYOUT, DIM)
+
+BEZ_INSTANTIATE_LAYOUT(CurveInterleavedView, 2)
+BEZ_INSTANTIATE_LAYOUT(CurveInterleavedView, 3)
+BEZ_INSTANTIATE_LAYOUT(CurveSoA, 2)
+BEZ_INSTANTIATE_LAYOUT(CurveSoA, 3)
+BEZ_INSTANTIATE_LAYOUT(CurvePacked, 2)
+BEZ_INSTANTIATE_LAYOUT(CurvePacked, 3)
+
+// CurveView itself is instantiated in curve_view.cpp
+BEZ_INSTANTIATE_KERNELS(CurveView, 2)
+BEZ_INSTANTIATE_KERNELS(CurveView, 3)
+
+// StreamingCurve itself is instantiated in streaming_curve.cpp
+BEZ_INSTANTIATE_KERNELS(StreamingCurve, 2)
+BEZ_INSTANTIATE_KERNELS(StreamingCurve, 3)
+
+// PathSegments itself is instantiated in svg_path.cpp
+BEZ_INSTANTIATE_KERNELS(PathSegments, 2)
+BEZ_INSTANTIATE_KERNELS(PathSegments, 3)
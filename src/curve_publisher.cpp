@@ -0,0 +1,201 @@
+/*
+ * curve_publisher.cpp
+ *
+ * Implements the class template CurvePublisher.
+ */
+
+#include "curve_publisher.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+
+
+//*****************************************************************************
+// Snapshot
+//*****************************************************************************
+
+template <std::size_t Dim, typename T>
+CurvePublisher<Dim, T>::Snapshot::Snapshot(std::atomic<std::uint64_t>* slot,
+                                           const Curve<Dim, T>* curve) :
+    slot(slot), curve(curve) {
+    // Nothing to do
+}
+
+template <std::size_t Dim, typename T>
+CurvePublisher<Dim, T>::Snapshot::Snapshot(Snapshot&& other) :
+    slot(other.slot), curve(other.curve) {
+    other.slot = nullptr;
+}
+
+/*
+ * destructor
+ *
+ * Ends the read, allowing the writer to reuse the snapshot.
+ */
+template <std::size_t Dim, typename T>
+CurvePublisher<Dim, T>::Snapshot::~Snapshot(void) {
+    if (slot != nullptr) {
+        slot->store(0);
+    }
+}
+
+
+//*****************************************************************************
+// Constructors/Destructors
+//*****************************************************************************
+
+/*
+ * constructor
+ *
+ * Publishes the given spline as the first snapshot.
+ *
+ * Args:
+ *   curve: initial spline
+ *   max_readers: number of reader slots
+ */
+template <std::size_t Dim, typename T>
+CurvePublisher<Dim, T>::CurvePublisher(const Curve<Dim, T>& curve, std::size_t max_readers) :
+    working(curve), epoch(1), retired_epoch(0), slots(max_readers), reader_count(0) {
+    std::size_t i;
+
+    for (i = 0; i < max_readers; i++) {
+        slots[i].epoch.store(0);
+    }
+
+    working.getLength();
+    buffers[0] = working;
+    front.store(&buffers[0]);
+}
+
+
+//*****************************************************************************
+// Reader procedures
+//*****************************************************************************
+
+/*
+ * function: registerReader
+ *
+ * Claims a reader slot for the calling thread and returns its index.
+ * Thread-safe.
+ *
+ * Throws:
+ *   std::length_error if every slot has been claimed
+ */
+template <std::size_t Dim, typename T>
+std::size_t CurvePublisher<Dim, T>::registerReader(void) {
+    std::size_t reader = reader_count.fetch_add(1);
+
+    if (reader >= slots.size()) {
+        reader_count.fetch_sub(1);
+        throw std::length_error("CurvePublisher::registerReader: no reader slots left");
+    }
+
+    return reader;
+}
+
+/*
+ * function: read
+ *
+ * Returns the latest published snapshot. Wait-free.
+ *
+ * The epoch is announced before the front buffer is loaded, so a writer that
+ * finds the slot idle or at a newer epoch knows this read cannot see the
+ * buffer it is about to overwrite.
+ *
+ * Args:
+ *   reader: slot returned by registerReader
+ */
+template <std::size_t Dim, typename T>
+typename CurvePublisher<Dim, T>::Snapshot CurvePublisher<Dim, T>::read(std::size_t reader) const {
+    std::atomic<std::uint64_t>* slot = &slots[reader].epoch;
+
+    slot->store(epoch.load());
+
+    return Snapshot(slot, front.load());
+}
+
+
+//*****************************************************************************
+// Writer procedures
+//*****************************************************************************
+
+/*
+ * function: edit
+ *
+ * Returns the working spline. Only the writer thread may use it, and readers
+ * do not see its changes until the next publish.
+ */
+template <std::size_t Dim, typename T>
+Curve<Dim, T>& CurvePublisher<Dim, T>::edit(void) {
+    return working;
+}
+
+/*
+ * function: publish
+ *
+ * Makes the current state of the working spline visible to readers. Waits
+ * first for readers still holding the snapshot retired by the previous
+ * publish.
+ *
+ * The working spline is solved and measured before the copy, outside of any
+ * wait, and the copy reuses the storage of the back buffer.
+ */
+template <std::size_t Dim, typename T>
+void CurvePublisher<Dim, T>::publish(void) {
+    Curve<Dim, T>* back;
+
+    // Solves the control points and builds the arc length index
+    working.getLength();
+
+    waitForReaders(retired_epoch);
+
+    back = front.load() == &buffers[0] ? &buffers[1] : &buffers[0];
+    *back = working;
+
+    front.store(back);
+    retired_epoch = epoch.fetch_add(1) + 1;
+}
+
+/*
+ * function: version
+ *
+ * Returns the number of snapshots published so far, counting the initial
+ * one.
+ */
+template <std::size_t Dim, typename T>
+std::uint64_t CurvePublisher<Dim, T>::version(void) const {
+    return epoch.load();
+}
+
+
+//*****************************************************************************
+// Hidden procedures
+//*****************************************************************************
+
+/*
+ * function: waitForReaders
+ *
+ * Waits until no reader that started before the given epoch is still reading.
+ */
+template <std::size_t Dim, typename T>
+void CurvePublisher<Dim, T>::waitForReaders(std::uint64_t epoch) const {
+    std::size_t count = std::min(reader_count.load(), slots.size());
+    std::size_t i;
+
+    for (i = 0; i < count; i++) {
+        std::uint64_t announced;
+
+        while ((announced = slots[i].epoch.load()) != 0 && announced < epoch) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+
+//*****************************************************************************
+// Explicit instantiations
+//*****************************************************************************
+
+template class CurvePublisher<2, BEZ_DTYPE>;
+template class CurvePublisher<3, BEZ_DTYPE>;
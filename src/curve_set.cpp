@@ -0,0 +1,510 @@
+/*
+ * curve_set.cpp
+ *
+ * Implements the class template CurveSet.
+ */
+
+#include "curve_set.h"
+#include "bezier_stats.h"
+#include "curve_layout.h"
+#include "curve_trace.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#define BEZ_ONE_THIRD 0.33333333333333333333333333333
+#define BEZ_TWO_THIRDS 0.66666666666666666666666666666
+
+// Tasks per thread handed out by the parallel rebuild, to even out the load
+#define BEZ_REBUILD_TASKS_PER_THREAD 4
+
+
+//*****************************************************************************
+// Constructors/Destructors
+//*****************************************************************************
+
+/*
+ * default constructor
+ *
+ * Constructs an empty set.
+ */
+template <std::size_t Dim, typename T>
+CurveSet<Dim, T>::CurveSet(void) :
+    point_offsets(1, 0), segment_offsets(1, 0), any_dirty(false) {
+    // Nothing to do
+}
+
+
+//*****************************************************************************
+// Access functions
+//*****************************************************************************
+
+/*
+ * function: curveCount
+ *
+ * Returns the number of splines in the set.
+ */
+template <std::size_t Dim, typename T>
+std::size_t CurveSet<Dim, T>::curveCount(void) const {
+    return dirty.size();
+}
+
+/*
+ * function: segmentCount
+ *
+ * Returns the total number of Bezier curves of all splines.
+ */
+template <std::size_t Dim, typename T>
+std::size_t CurveSet<Dim, T>::segmentCount(void) const {
+    return segment_offsets.back();
+}
+
+/*
+ * function: anchorCount
+ *
+ * Returns the number of anchor points of the given spline.
+ *
+ * Args:
+ *   curve: index of spline
+ */
+template <std::size_t Dim, typename T>
+std::size_t CurveSet<Dim, T>::anchorCount(std::size_t curve) const {
+    return segment_offsets[curve + 1] - segment_offsets[curve] + 1;
+}
+
+/*
+ * function: getAnchor
+ *
+ * Returns the coordinates of an anchor point of the given spline.
+ *
+ * Args:
+ *   curve: index of spline
+ *   i: index of anchor point
+ */
+template <std::size_t Dim, typename T>
+const typename CurveSet<Dim, T>::Vect& CurveSet<Dim, T>::getAnchor(std::size_t curve,
+                                                                    std::size_t i) const {
+    return points[point_offsets[curve] + 3 * i];
+}
+
+/*
+ * function: view
+ *
+ * Returns a view of every Bezier curve of the given spline, or an empty view
+ * if it has fewer than two anchor points.
+ *
+ * Args:
+ *   curve: index of spline
+ */
+template <std::size_t Dim, typename T>
+CurveView<Dim, T> CurveSet<Dim, T>::view(std::size_t curve) const {
+    std::size_t segments = segment_offsets[curve + 1] - segment_offsets[curve];
+
+    if (segments == 0) {
+        return CurveView<Dim, T>();
+    }
+
+    return CurveView<Dim, T>(&points[point_offsets[curve]], segments);
+}
+
+
+//*****************************************************************************
+// Batch queries
+//*****************************************************************************
+
+/*
+ * function: evaluate
+ *
+ * Evaluates count (spline, t) pairs, with t spread evenly over the Bezier
+ * curves of each spline as in Curve::getPositionAt.
+ *
+ * Args:
+ *   curves: index of the spline of each query
+ *   ts: parameter value in the range [0, 1] of each query
+ *   count: number of queries
+ *   out: output array of count points
+ */
+template <std::size_t Dim, typename T>
+void CurveSet<Dim, T>::evaluate(const std::size_t* curves, const T* ts, std::size_t count,
+                                Vect* out) const {
+    BEZ_TRACE_SCOPE("CurveSet::evaluate", count);
+    BEZ_STATS_ADD(evaluations, count);
+
+    std::size_t i;
+
+    for (i = 0; i < count; i++) {
+        std::size_t curve = curves[i];
+        std::size_t n = segment_offsets[curve + 1] - segment_offsets[curve];
+        const Vect* p = &points[point_offsets[curve]];
+
+        if (n == 0) {
+            out[i] = p[0];
+            continue;
+        }
+
+        T t = ts[i] * (T)(n);
+        std::size_t s = (std::size_t)(t);  // index of Bezier curve
+
+        // t = 1 is the end of the final Bezier curve
+        if (s >= n) {
+            s = n - 1;
+        }
+
+        t -= (T)(s);
+        p += 3 * s;
+
+        out[i] = bezEvaluateSegment(p[0], p[1], p[2], p[3], t);
+    }
+}
+
+/*
+ * function: boundingBoxes
+ *
+ * Computes the tight axis-aligned bounding box of every spline. A spline with
+ * one anchor point gets that point as its box.
+ *
+ * Args:
+ *   mins: output array of curveCount() lower corners
+ *   maxs: output array of curveCount() upper corners
+ */
+template <std::size_t Dim, typename T>
+void CurveSet<Dim, T>::boundingBoxes(Vect* mins, Vect* maxs) const {
+    std::size_t i, s, k;
+    Vect lo, hi;
+
+    for (i = 0; i < curveCount(); i++) {
+        const Vect* p = &points[point_offsets[i]];
+
+        mins[i] = maxs[i] = p[0];
+
+        for (s = segment_offsets[i]; s < segment_offsets[i + 1]; s++, p += 3) {
+            ::segmentBoundingBoxes(CurveInterleavedView<Dim, T>(p, 1), &lo, &hi);
+
+            for (k = 0; k < Dim; k++) {
+                mins[i][k] = std::min(mins[i][k], lo[k]);
+                maxs[i][k] = std::max(maxs[i][k], hi[k]);
+            }
+        }
+    }
+}
+
+/*
+ * function: segmentBoundingBoxes
+ *
+ * Computes the tight axis-aligned bounding box of every Bezier curve of every
+ * spline, in the order given by segment_offsets.
+ *
+ * Args:
+ *   mins: output array of segmentCount() lower corners
+ *   maxs: output array of segmentCount() upper corners
+ */
+template <std::size_t Dim, typename T>
+void CurveSet<Dim, T>::segmentBoundingBoxes(Vect* mins, Vect* maxs) const {
+    std::size_t i;
+
+    for (i = 0; i < curveCount(); i++) {
+        CurveInterleavedView<Dim, T> curve(&points[point_offsets[i]],
+                                           segment_offsets[i + 1] - segment_offsets[i]);
+
+        ::segmentBoundingBoxes(curve, mins + segment_offsets[i], maxs + segment_offsets[i]);
+    }
+}
+
+/*
+ * function: tessellate
+ *
+ * Replaces the contents of out with the polylines of every spline, steps
+ * points per Bezier curve followed by the final anchor point, and offsets
+ * with where each polyline starts.
+ *
+ * Args:
+ *   steps: number of points per Bezier curve, at least 1
+ *   out: vector to fill with the points of all polylines
+ *   offsets: vector to fill with curveCount() + 1 offsets into out
+ */
+template <std::size_t Dim, typename T>
+void CurveSet<Dim, T>::tessellate(std::size_t steps, std::vector<Vect>& out,
+                                  std::vector<std::size_t>& offsets) const {
+    BEZ_TRACE_SCOPE("CurveSet::tessellate", curveCount());
+
+    std::size_t i;
+
+    offsets.resize(curveCount() + 1);
+    offsets[0] = 0;
+
+    for (i = 0; i < curveCount(); i++) {
+        offsets[i + 1] = offsets[i] + (segment_offsets[i + 1] - segment_offsets[i]) * steps + 1;
+    }
+
+    out.resize(offsets.back());
+
+    for (i = 0; i < curveCount(); i++) {
+        CurveInterleavedView<Dim, T> curve(&points[point_offsets[i]],
+                                           segment_offsets[i + 1] - segment_offsets[i]);
+
+        if (curve.segmentCount() == 0) {
+            out[offsets[i]] = points[point_offsets[i]];
+        }
+        else {
+            ::tessellate(curve, steps, &out[offsets[i]]);
+        }
+    }
+}
+
+
+//*****************************************************************************
+// Manipulation procedures
+//*****************************************************************************
+
+/*
+ * function: add
+ *
+ * Appends a spline through the given anchor points and returns its index.
+ *
+ * Args:
+ *   anchor_points: ordered anchor points of the new spline
+ *
+ * Throws:
+ *   std::invalid_argument if anchor_points is empty
+ */
+template <std::size_t Dim, typename T>
+std::size_t CurveSet<Dim, T>::add(const std::vector<Vect>& anchor_points) {
+    std::size_t n = anchor_points.size();
+    std::size_t first = points.size();
+    std::size_t i;
+
+    if (n == 0) {
+        throw std::invalid_argument("CurveSet::add: a spline needs at least one anchor point");
+    }
+
+    points.resize(first + 3 * n - 2);
+    for (i = 0; i < n; i++) {
+        points[first + 3 * i] = anchor_points[i];
+    }
+
+    point_offsets.push_back(points.size());
+    segment_offsets.push_back(segment_offsets.back() + n - 1);
+    dirty.push_back(1);
+    any_dirty = true;
+
+    // c depends only on the row, so one table serves every spline
+    if (c.size() < n) {
+        i = c.size();
+        c.resize(n);
+
+        if (i == 0) {
+            c[i++] = 0.;
+        }
+        for (; i < n; i++) {
+            c[i] = 1. / (4. - c[i - 1]);
+        }
+    }
+
+    return dirty.size() - 1;
+}
+
+/*
+ * function: setAnchor
+ *
+ * Sets the coordinates of an anchor point of the given spline.
+ *
+ * Args:
+ *   curve: index of spline
+ *   i: index of anchor point
+ *   position: new position of the anchor point
+ */
+template <std::size_t Dim, typename T>
+void CurveSet<Dim, T>::setAnchor(std::size_t curve, std::size_t i, const Vect& position) {
+    points[point_offsets[curve] + 3 * i] = position;
+    dirty[curve] = 1;
+    any_dirty = true;
+}
+
+/*
+ * function: reserve
+ *
+ * Allocates room for the given numbers of splines and anchor points.
+ */
+template <std::size_t Dim, typename T>
+void CurveSet<Dim, T>::reserve(std::size_t curve_count, std::size_t anchor_count) {
+    points.reserve(3 * anchor_count);
+    point_offsets.reserve(curve_count + 1);
+    segment_offsets.reserve(curve_count + 1);
+    dirty.reserve(curve_count);
+}
+
+/*
+ * function: clear
+ *
+ * Removes every spline, keeping the allocated storage.
+ */
+template <std::size_t Dim, typename T>
+void CurveSet<Dim, T>::clear(void) {
+    points.clear();
+    point_offsets.resize(1);
+    segment_offsets.resize(1);
+    dirty.clear();
+    any_dirty = false;
+}
+
+/*
+ * function: rebuild
+ *
+ * Solves the control points of every spline edited since the last rebuild.
+ */
+template <std::size_t Dim, typename T>
+void CurveSet<Dim, T>::rebuild(void) {
+    if (any_dirty) {
+        countSolves();
+        solveCurves(0, curveCount());
+        any_dirty = false;
+    }
+}
+
+/*
+ * function: rebuild
+ *
+ * Solves the control points of every spline edited since the last rebuild,
+ * spreading the splines over the threads of the given pool.
+ *
+ * Each task takes the splines whose points start in an equal share of the
+ * points array, so a few long splines do not end up on one thread.
+ *
+ * Args:
+ *   pool: threads to run the solves on
+ */
+template <std::size_t Dim, typename T>
+void CurveSet<Dim, T>::rebuild(ThreadPool& pool) {
+    std::size_t tasks = std::min(curveCount(), pool.threadCount() * BEZ_REBUILD_TASKS_PER_THREAD);
+
+    if (!any_dirty) {
+        return;
+    }
+
+    if (pool.threadCount() <= 1 || tasks <= 1) {
+        rebuild();
+        return;
+    }
+
+    countSolves();
+    pool.run(tasks, [&](std::size_t task) {
+        std::size_t lo = points.size() * task / tasks;
+        std::size_t hi = points.size() * (task + 1) / tasks;
+        std::size_t first = std::lower_bound(point_offsets.begin(), point_offsets.end() - 1, lo) -
+                            point_offsets.begin();
+        std::size_t last = task + 1 == tasks ? curveCount() :
+                           std::lower_bound(point_offsets.begin(), point_offsets.end() - 1, hi) -
+                           point_offsets.begin();
+
+        solveCurves(first, last);
+    });
+
+    any_dirty = false;
+}
+
+
+//*****************************************************************************
+// Hidden procedures
+//*****************************************************************************
+
+/*
+ * function: solveCurve
+ *
+ * Solves the control points of one spline in place.
+ *
+ * Runs the same Thomas algorithm as Curve::solveAll with natural ends, but
+ * keeps each B_point in the first control point slot after its anchor point
+ * until the control points are computed, so no scratch storage is needed.
+ */
+template <std::size_t Dim, typename T>
+void CurveSet<Dim, T>::solveCurve(std::size_t curve) {
+    std::size_t n = anchorCount(curve);
+    Vect* p = &points[point_offsets[curve]];
+    std::size_t i, j, k;
+
+    if (n <= 1) {
+        return;
+    }
+
+    if (n == 2) {
+        p[1] = p[0];
+        p[2] = p[3];
+
+        return;
+    }
+
+    // B_point i lives at p[3i + 1] for 1 <= i <= n - 2
+    for (i = 1; i <= n - 2; i++) {
+        const Vect& prev = i == 1 ? p[0] : p[3 * i - 2];
+
+        for (k = 0; k < Dim; k++) {
+            T rhs = 6. * p[3 * i][k];
+            if (i == n - 2) {
+                rhs -= p[3 * (n - 1)][k];
+            }
+            p[3 * i + 1][k] = c[i] * (rhs - prev[k]);
+        }
+    }
+
+    for (i = n - 3; i > 0; i--) {
+        for (k = 0; k < Dim; k++) {
+            p[3 * i + 1][k] -= c[i] * p[3 * i + 4][k];
+        }
+    }
+
+    // Each Bezier curve reads its B_points before overwriting the first
+    for (j = 0; j < n - 1; j++) {
+        Vect b0 = j == 0 ? p[0] : p[3 * j + 1];
+        Vect b1 = j + 1 == n - 1 ? p[3 * (n - 1)] : p[3 * j + 4];
+
+        for (k = 0; k < Dim; k++) {
+            p[3 * j + 1][k] = BEZ_TWO_THIRDS * b0[k] + BEZ_ONE_THIRD * b1[k];
+            p[3 * j + 2][k] = BEZ_ONE_THIRD * b0[k] + BEZ_TWO_THIRDS * b1[k];
+        }
+    }
+}
+
+/*
+ * function: solveCurves
+ *
+ * Solves every dirty spline in [first, last).
+ */
+template <std::size_t Dim, typename T>
+void CurveSet<Dim, T>::solveCurves(std::size_t first, std::size_t last) {
+    std::size_t i;
+
+    for (i = first; i < last; i++) {
+        if (dirty[i]) {
+            solveCurve(i);
+            dirty[i] = 0;
+        }
+    }
+}
+
+/*
+ * function: countSolves
+ *
+ * Counts a full solve of every dirty spline, see bezier_stats.h. Called on
+ * the thread that rebuilds, before the solves are spread over a pool.
+ */
+template <std::size_t Dim, typename T>
+void CurveSet<Dim, T>::countSolves(void) const {
+#if defined(BEZ_ENABLE_STATS)
+    std::size_t i;
+
+    for (i = 0; i < curveCount(); i++) {
+        if (dirty[i]) {
+            BEZ_STATS_SOLVE(full_solves, anchorCount(i));
+        }
+    }
+#endif
+}
+
+
+//*****************************************************************************
+// Explicit instantiations
+//*****************************************************************************
+
+template class CurveSet<2, BEZ_DTYPE>;
+template class CurveSet<3, BEZ_DTYPE>;
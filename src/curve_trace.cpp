@@ -0,0 +1,273 @@
+/*
+ * curve_trace.cpp
+ *
+ * Implements the tracing defined in curve_trace.h.
+ */
+
+#include "curve_trace.h"
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+
+std::atomic<bool> bez_trace_enabled(false);
+
+namespace {
+
+/*
+ * struct: TraceEvent
+ *
+ * One traced call.
+ */
+struct TraceEvent {
+    const char* name;
+    std::uint64_t begin;
+    std::uint64_t end;
+    std::size_t size;
+};
+
+/*
+ * struct: TraceBuffer
+ *
+ * Events of one thread. Only that thread appends, publishing each event by
+ * storing count with release order, so readers that load it with acquire
+ * order see complete events.
+ */
+struct TraceBuffer {
+    TraceEvent events[BEZ_TRACE_BUFFER_EVENTS];
+    std::atomic<std::size_t> count;
+    std::size_t thread_index;  // order in which threads first recorded
+    bool retired;  // whether its thread exited, guarded by registry_mutex
+};
+
+// Buffers of the threads that recorded since the last clear, kept after a
+// thread exits so that its events can still be written
+std::mutex registry_mutex;
+std::vector<std::unique_ptr<TraceBuffer> > registry;
+std::size_t thread_count = 0;  // threads that ever recorded, for indices
+
+std::atomic<std::size_t> dropped(0);
+std::atomic<std::uint64_t> origin(0);  // time of the first start, or 0
+
+thread_local TraceBuffer* local_buffer = nullptr;
+
+
+/*
+ * struct: BufferOwner
+ *
+ * Retires the buffer of its thread when the thread exits, so that
+ * bezTraceClear can free it and registerThread can reuse it.
+ */
+struct BufferOwner {
+    TraceBuffer* buffer = nullptr;
+
+    ~BufferOwner(void) {
+        if (buffer != nullptr) {
+            std::lock_guard<std::mutex> lock(registry_mutex);
+            buffer->retired = true;
+        }
+    }
+};
+
+thread_local BufferOwner local_owner;
+
+
+/*
+ * function: registerThread
+ *
+ * Gives the calling thread a buffer, reusing that of an exited thread if it
+ * holds no events. Only its first event takes the lock.
+ */
+TraceBuffer* registerThread(void) {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    TraceBuffer* buffer = nullptr;
+
+    for (const auto& retired : registry) {
+        if (retired->retired && retired->count.load(std::memory_order_relaxed) == 0) {
+            buffer = retired.get();
+            break;
+        }
+    }
+    if (buffer == nullptr) {
+        registry.push_back(std::unique_ptr<TraceBuffer>(new TraceBuffer));
+        buffer = registry.back().get();
+        buffer->count.store(0, std::memory_order_relaxed);
+    }
+
+    buffer->thread_index = thread_count++;
+    buffer->retired = false;
+    local_owner.buffer = buffer;
+    local_buffer = buffer;
+    return buffer;
+}
+
+/*
+ * function: writeName
+ *
+ * Writes a name as a JSON string.
+ */
+void writeName(FILE* file, const char* name) {
+    fputc('"', file);
+    for (; *name != '\0'; name++) {
+        if (*name == '"' || *name == '\\') {
+            fputc('\\', file);
+        }
+        fputc(*name, file);
+    }
+    fputc('"', file);
+}
+
+}  // namespace
+
+
+//*****************************************************************************
+//* TRACE
+//*****************************************************************************
+
+/*
+ * function: bezTraceStart
+ *
+ * Makes the hooks of every thread record from now on.
+ */
+void bezTraceStart(void) {
+    std::uint64_t none = 0;
+
+    origin.compare_exchange_strong(none, bezTraceNow());
+    bez_trace_enabled.store(true, std::memory_order_relaxed);
+}
+
+/*
+ * function: bezTraceStop
+ *
+ * Makes the hooks of every thread stop recording. Calls already being
+ * traced are still recorded when they end.
+ */
+void bezTraceStop(void) {
+    bez_trace_enabled.store(false, std::memory_order_relaxed);
+}
+
+/*
+ * function: bezTraceClear
+ *
+ * Discards the events recorded so far, and frees the buffers of the threads
+ * that exited. No thread may be recording.
+ */
+void bezTraceClear(void) {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+
+    registry.erase(std::remove_if(registry.begin(), registry.end(),
+                                  [](const std::unique_ptr<TraceBuffer>& buffer) {
+                                      return buffer->retired;
+                                  }),
+                   registry.end());
+    for (const auto& buffer : registry) {
+        buffer->count.store(0, std::memory_order_relaxed);
+    }
+    dropped.store(0, std::memory_order_relaxed);
+    origin.store(bez_trace_enabled.load(std::memory_order_relaxed) ? bezTraceNow() : 0);
+}
+
+/*
+ * function: bezTraceDropped
+ *
+ * Returns the number of events discarded because the buffer of their thread
+ * was full.
+ */
+std::size_t bezTraceDropped(void) {
+    return dropped.load(std::memory_order_relaxed);
+}
+
+/*
+ * function: bezTraceWrite
+ *
+ * Writes the events recorded so far as a Chrome trace in JSON, one complete
+ * event per traced call with its size as an argument. No thread may be
+ * recording. Returns whether the file could be written.
+ *
+ * Args:
+ *   file_name: path of the file to write
+ */
+bool bezTraceWrite(const char* file_name) {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    FILE* file = fopen(file_name, "w");
+    std::uint64_t start = origin.load();
+    bool first = true;
+    std::size_t i;
+
+    if (file == NULL) {
+        return false;
+    }
+
+    // Chrome wants microseconds, which %.3f keeps to the nanosecond
+    fprintf(file, "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [");
+    for (const auto& buffer : registry) {
+        std::size_t count = buffer->count.load(std::memory_order_acquire);
+        std::size_t tid = buffer->thread_index + 1;
+
+        if (count == 0) {
+            continue;
+        }
+
+        fprintf(file, "%s\n  {\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %zu, "
+                "\"args\": {\"name\": \"thread %zu\"}}", first ? "" : ",", tid, tid);
+        first = false;
+
+        for (i = 0; i < count; i++) {
+            const TraceEvent& event = buffer->events[i];
+
+            fprintf(file, ",\n  {\"name\": ");
+            writeName(file, event.name);
+            fprintf(file, ", \"cat\": \"bezier\", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, "
+                    "\"pid\": 1, \"tid\": %zu, \"args\": {\"size\": %zu}}",
+                    (double)(event.begin > start ? event.begin - start : 0) * 1e-3,
+                    (double)(event.end - event.begin) * 1e-3,
+                    tid, event.size);
+        }
+    }
+    fprintf(file, "\n]}\n");
+
+    return fclose(file) == 0;
+}
+
+/*
+ * function: bezTraceNow
+ *
+ * Returns the time of the steady clock in nanoseconds.
+ */
+std::uint64_t bezTraceNow(void) {
+    return (std::uint64_t)(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+/*
+ * function: bezTraceRecord
+ *
+ * Appends an event to the buffer of the calling thread, without locking,
+ * or drops it if the buffer is full.
+ *
+ * Args:
+ *   name: name of the operation, which must outlive the trace
+ *   begin, end: times from bezTraceNow
+ *   size: number of items the operation handled
+ */
+void bezTraceRecord(const char* name, std::uint64_t begin, std::uint64_t end, std::size_t size) {
+    TraceBuffer* buffer = local_buffer;
+
+    if (buffer == nullptr) {
+        buffer = registerThread();
+    }
+
+    std::size_t count = buffer->count.load(std::memory_order_relaxed);
+
+    if (count >= BEZ_TRACE_BUFFER_EVENTS) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    buffer->events[count] = TraceEvent{name, begin, end, size};
+    buffer->count.store(count + 1, std::memory_order_release);
+}
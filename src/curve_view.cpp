@@ -0,0 +1,436 @@
+/*
+ * curve_view.cpp
+ *
+ * Implements the class template CurveView and Curve::split.
+ */
+
+#include "curve_view.h"
+
+#include <math.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "bezier.h"
+#include "bezier_stats.h"
+
+
+//*****************************************************************************
+// splitSegment
+//*****************************************************************************
+
+/*
+ * function: splitSegment
+ *
+ * Splits a cubic Bezier curve into two sub-curves at the given t using
+ * bez2SplitCurve or bez3SplitCurve.
+ *
+ * Args:
+ *   p: the 4 points of the Bezier curve
+ *   t: value of t at which to split the curve
+ *   left: output for the 4 points of the sub-curve taken from [0, t]
+ *   right: output for the 4 points of the sub-curve taken from [t, 1]
+ */
+void splitSegment(const bezVect2D* p, BEZ_DTYPE t, bezVect2D* left, bezVect2D* right) {
+    bez2SplitCurve(p[0][0], p[0][1], p[1][0], p[1][1],
+                   p[2][0], p[2][1], p[3][0], p[3][1],
+                   t,
+                   &left[0][0], &left[0][1], &left[1][0], &left[1][1],
+                   &left[2][0], &left[2][1], &left[3][0], &left[3][1],
+                   &right[0][0], &right[0][1], &right[1][0], &right[1][1],
+                   &right[2][0], &right[2][1], &right[3][0], &right[3][1]);
+}
+
+void splitSegment(const bezVect3D* p, BEZ_DTYPE t, bezVect3D* left, bezVect3D* right) {
+    bez3SplitCurve(p[0][0], p[0][1], p[0][2], p[1][0], p[1][1], p[1][2],
+                   p[2][0], p[2][1], p[2][2], p[3][0], p[3][1], p[3][2],
+                   t,
+                   &left[0][0], &left[0][1], &left[0][2],
+                   &left[1][0], &left[1][1], &left[1][2],
+                   &left[2][0], &left[2][1], &left[2][2],
+                   &left[3][0], &left[3][1], &left[3][2],
+                   &right[0][0], &right[0][1], &right[0][2],
+                   &right[1][0], &right[1][1], &right[1][2],
+                   &right[2][0], &right[2][1], &right[2][2],
+                   &right[3][0], &right[3][1], &right[3][2]);
+}
+
+
+//*****************************************************************************
+// Constructors/Destructors
+//*****************************************************************************
+
+/*
+ * default constructor
+ *
+ * Constructs a view of nothing.
+ */
+template <std::size_t Dim, typename T>
+CurveView<Dim, T>::CurveView(void) :
+    points(NULL), bezier_count(0), head(), tail() {
+    // Nothing to do
+}
+
+/*
+ * constructor
+ *
+ * Constructs a view of the whole spline.
+ *
+ * Args:
+ *   curve: spline to view
+ *
+ * Throws:
+ *   std::out_of_range if the spline is empty
+ */
+template <std::size_t Dim, typename T>
+CurveView<Dim, T>::CurveView(const Curve<Dim, T>& curve) :
+    CurveView(curve, 0., 1.) {
+    // Nothing to do
+}
+
+/*
+ * constructor
+ *
+ * Constructs a view of the part of the spline between two parameter values.
+ *
+ * Args:
+ *   curve: spline to view
+ *   t0: value of t of the spline to start at
+ *   t1: value of t of the spline to stop at
+ *
+ * Throws:
+ *   std::out_of_range if 0 <= t0 <= t1 <= 1 is not satisfied or the spline
+ *       is empty
+ */
+template <std::size_t Dim, typename T>
+CurveView<Dim, T>::CurveView(const Curve<Dim, T>& curve, T t0, T t1) :
+    head(), tail() {
+    std::size_t k0, k1;  // Bezier curves of the spline containing t0 and t1
+    T u0, u1;  // local parameter values of t0 and t1
+    Vect scratch[4];
+
+    if (!(t0 >= 0. && t0 <= t1 && t1 <= 1.)) {
+        throw std::out_of_range("CurveView: 0 <= t0 <= t1 <= 1 must hold");
+    }
+    if (curve.anchorCount() == 0) {
+        throw std::out_of_range("CurveView: spline is empty");
+    }
+
+    curve.solvePending();
+
+    if (curve.bezier_count == 0 || t0 == t1) {
+        points = curve.points.data();
+        bezier_count = 0;
+        head[0] = tail[0] = curve.getPositionAt(t0);
+        return;
+    }
+
+    curve.findSegment(t0, k0, u0);
+    curve.findSegment(t1, k1, u1);
+
+    // t1 at the start of a Bezier curve ends the previous one instead
+    if (k1 > k0 && u1 == 0.) {
+        k1--;
+        u1 = 1.;
+    }
+
+    points = &curve.points[3 * k0];
+    bezier_count = k1 - k0 + 1;
+
+    if (k0 == k1) {
+        splitSegment(points, u0, scratch, head);
+        if (u0 < 1.) {
+            splitSegment(head, (u1 - u0) / (1. - u0), scratch, tail);
+            std::copy(scratch, scratch + 4, head);
+        }
+        std::copy(head, head + 4, tail);
+    }
+    else {
+        splitSegment(points, u0, scratch, head);
+        splitSegment(&curve.points[3 * k1], u1, tail, scratch);
+    }
+}
+
+/*
+ * constructor
+ *
+ * Constructs a view of Bezier curves stored like the points of a Curve,
+ * anchor point i at index 3i with its control points in between.
+ *
+ * Args:
+ *   points: 3 * bezier_count + 1 points
+ *   bezier_count: number of Bezier curves, at least 1
+ */
+template <std::size_t Dim, typename T>
+CurveView<Dim, T>::CurveView(const Vect* points, std::size_t bezier_count) :
+    points(points), bezier_count(bezier_count) {
+    std::copy(points, points + 4, head);
+    std::copy(points + 3 * (bezier_count - 1), points + 3 * bezier_count + 1, tail);
+}
+
+
+//*****************************************************************************
+// Access functions
+//*****************************************************************************
+
+/*
+ * function: getPositionAt
+ *
+ * Returns the coordinates of the view evaluated at the given u.
+ *
+ * Args:
+ *   u: parameter value in the range [0, 1]
+ */
+template <std::size_t Dim, typename T>
+typename CurveView<Dim, T>::Vect CurveView<Dim, T>::getPositionAt(T u) const {
+    if (bezier_count == 0) {
+        return head[0];
+    }
+
+    u *= (T)(bezier_count);
+    std::size_t s = (std::size_t)(u);  // index of Bezier curve
+
+    // u = 1 is the end of the final Bezier curve
+    if (s >= bezier_count) {
+        s = bezier_count - 1;
+    }
+
+    BEZ_STATS_ADD(evaluations, 1);
+
+    return bezEvaluateSegment(segmentPoint(s, 0), segmentPoint(s, 1), segmentPoint(s, 2),
+                              segmentPoint(s, 3), u - (T)(s));
+}
+
+/*
+ * function: getLength
+ *
+ * Returns the length of the view between two parameter values, measured with
+ * BEZ_ARC_SAMPLES chords per Bezier curve.
+ *
+ * Args:
+ *   u0: value of u to start at
+ *   u1: value of u to stop at
+ *
+ * Throws:
+ *   std::out_of_range if 0 <= u0,u1 <= 1 is not satisfied
+ */
+template <std::size_t Dim, typename T>
+T CurveView<Dim, T>::getLength(T u0, T u1) const {
+    if (u0 < 0. || u0 > 1. || u1 < 0. || u1 > 1.) {
+        throw std::out_of_range("CurveView::getLength: u must be in [0, 1]");
+    }
+
+    if (bezier_count == 0) {
+        return 0;
+    }
+
+    if (u1 < u0) {
+        std::swap(u0, u1);
+    }
+
+    T pos0 = u0 * (T)(bezier_count);
+    T pos1 = u1 * (T)(bezier_count);
+    std::size_t s0 = std::min((std::size_t)(pos0), bezier_count - 1);
+    std::size_t s1 = std::min((std::size_t)(pos1), bezier_count - 1);
+    std::size_t s;
+    T length = 0.;
+
+    for (s = s0; s <= s1; s++) {
+        T a = s == s0 ? pos0 - (T)(s) : 0.;
+        T b = s == s1 ? pos1 - (T)(s) : 1.;
+
+        length += segmentLength(s, a, b);
+    }
+
+    return length;
+}
+
+/*
+ * function: getLength
+ *
+ * Returns the total length of the view.
+ */
+template <std::size_t Dim, typename T>
+T CurveView<Dim, T>::getLength(void) const {
+    return getLength(0., 1.);
+}
+
+/*
+ * function: copyTo
+ *
+ * Overwrites the given Curve with the points of the view, reusing its storage
+ * when it is large enough. The Curve is open and uniformly parameterized, and
+ * keeps the copied control points until one of its anchor points is edited.
+ *
+ * out may be the viewed Curve itself, after which the view must not be used
+ * again.
+ *
+ * Every point is copied to an index no greater than the one it is read from,
+ * so copying in ascending order is safe when out is the viewed Curve.
+ *
+ * Args:
+ *   out: Curve to overwrite
+ */
+template <std::size_t Dim, typename T>
+void CurveView<Dim, T>::copyTo(Curve<Dim, T>& out) const {
+    std::size_t size = 3 * bezier_count + 1;
+    std::size_t s, p;
+
+    // Shrinking first would discard points the view still reads
+    if (out.points.size() < size) {
+        out.points.resize(size);
+    }
+
+    if (bezier_count == 0) {
+        out.points[0] = head[0];
+    }
+
+    for (s = 0; s < bezier_count; s++) {
+        for (p = 0; p < 3; p++) {
+            out.points[3 * s + p] = segmentPoint(s, p);
+        }
+    }
+    if (bezier_count > 0) {
+        out.points[size - 1] = tail[3];
+    }
+
+    out.points.resize(size);
+
+    out.anchor_count = bezier_count + 1;
+    out.bezier_count = bezier_count;
+    out.closed = false;
+    out.parameterization = BEZ_UNIFORM;
+
+    // No solver state matches the copied control points, which tells the
+    // next edit to solve from scratch
+    out.B_points.clear();
+    out.c.clear();
+    out.z.clear();
+    out.knots.clear();
+    out.knot_buckets.clear();
+
+    out.dirty_begin = out.dirty_end = 0;
+    out.arc_lengths_valid = false;
+}
+
+template <std::size_t Dim, typename T>
+std::size_t CurveView<Dim, T>::segmentCount(void) const {
+    return bezier_count;
+}
+
+template <std::size_t Dim, typename T>
+T CurveView<Dim, T>::get(std::size_t s, std::size_t p, std::size_t d) const {
+    return segmentPoint(s, p)[d];
+}
+
+
+//*****************************************************************************
+// Hidden procedures
+//*****************************************************************************
+
+/*
+ * function: segmentPoint
+ *
+ * Returns point p (0 ... 3) of Bezier curve s of the view.
+ */
+template <std::size_t Dim, typename T>
+const typename CurveView<Dim, T>::Vect& CurveView<Dim, T>::segmentPoint(std::size_t s, std::size_t p) const {
+    if (s == 0) {
+        return head[p];
+    }
+    if (s == bezier_count - 1) {
+        return tail[p];
+    }
+
+    return points[3 * s + p];
+}
+
+/*
+ * function: segmentLength
+ *
+ * Returns the length of Bezier curve s of the view between local parameter
+ * values a <= b.
+ */
+template <std::size_t Dim, typename T>
+T CurveView<Dim, T>::segmentLength(std::size_t s, T a, T b) const {
+    std::size_t i, k;
+    double total = 0.;
+    Vect v, last{};
+
+    BEZ_STATS_ADD(evaluations, BEZ_ARC_SAMPLES + 1);
+
+    for (i = 0; i <= BEZ_ARC_SAMPLES; i++) {
+        T t = a + (b - a) * (T)(i) / (T)(BEZ_ARC_SAMPLES);
+
+        v = bezEvaluateSegment(segmentPoint(s, 0), segmentPoint(s, 1), segmentPoint(s, 2),
+                               segmentPoint(s, 3), t);
+
+        if (i > 0) {
+            double chord = 0.;
+
+            for (k = 0; k < Dim; k++) {
+                chord += (double)((v[k] - last[k]) * (v[k] - last[k]));
+            }
+
+            total += sqrt(chord);
+        }
+
+        last = v;
+    }
+
+    return (T)(total);
+}
+
+
+//*****************************************************************************
+// Curve::split
+//*****************************************************************************
+
+/*
+ * function: split
+ *
+ * Splits the spline into two sub-splines.
+ *
+ * Overwrites the two given Curve objects with the sub-splines.
+ *
+ * Both halves are viewed before either output is written, and the half that
+ * does not alias *this is written first, so either output may be *this. The
+ * outputs reuse their existing storage when it is large enough.
+ *
+ * Args:
+ *   t: parameter value at which to split, in range [0, 1]
+ *   c1: sub-spline taken from [0, t]
+ *   c2: sub-spline taken from [t, 1]
+ *
+ * Throws:
+ *   std::out_of_range if 0 <= t <= 1 is not satisfied
+ */
+template <std::size_t Dim, typename T>
+void Curve<Dim, T>::split(T t, Curve& c1, Curve& c2) const {
+    if (!(t >= 0. && t <= 1.)) {
+        throw std::out_of_range("Curve::split: t must be in [0, 1]");
+    }
+
+    CurveView<Dim, T> first(*this, 0., t);
+    CurveView<Dim, T> second(*this, t, 1.);
+
+    if (&c1 == this) {
+        second.copyTo(c2);
+        first.copyTo(c1);
+    }
+    else {
+        first.copyTo(c1);
+        second.copyTo(c2);
+    }
+}
+
+
+//*****************************************************************************
+// Explicit instantiations
+//*****************************************************************************
+
+template class CurveView<2, BEZ_DTYPE>;
+template class CurveView<3, BEZ_DTYPE>;
+
+template void Curve<2, BEZ_DTYPE>::split(BEZ_DTYPE, Curve&, Curve&) const;
+template void Curve<3, BEZ_DTYPE>::split(BEZ_DTYPE, Curve&, Curve&) const;
@@ -0,0 +1,106 @@
+/*
+ * frame_arena.cpp
+ *
+ * Implements the class FrameArena.
+ */
+
+#include "frame_arena.h"
+
+
+//*****************************************************************************
+// Constructors/Destructors
+//*****************************************************************************
+
+/*
+ * constructor
+ *
+ * Allocates the initial buffer from the upstream resource.
+ *
+ * Args:
+ *   initial_size: size in bytes of the initial buffer
+ *   upstream: resource for the buffer and for allocations beyond it
+ */
+FrameArena::FrameArena(std::size_t initial_size, std::pmr::memory_resource* upstream) :
+    upstream(upstream), buffer_size(initial_size > 0 ? initial_size : 1), used(0) {
+    buffer = upstream->allocate(buffer_size, alignof(std::max_align_t));
+    arena.emplace(buffer, buffer_size, upstream);
+}
+
+/*
+ * destructor
+ *
+ * Returns the buffer and any overflow to the upstream resource.
+ */
+FrameArena::~FrameArena(void) {
+    arena.reset();
+    upstream->deallocate(buffer, buffer_size, alignof(std::max_align_t));
+}
+
+
+//*****************************************************************************
+// Access functions
+//*****************************************************************************
+
+/*
+ * function: bytesUsed
+ *
+ * Returns the number of bytes handed out since the last reset, counting
+ * alignment padding.
+ */
+std::size_t FrameArena::bytesUsed(void) const {
+    return used;
+}
+
+/*
+ * function: capacity
+ *
+ * Returns the size in bytes of the reusable buffer.
+ */
+std::size_t FrameArena::capacity(void) const {
+    return buffer_size;
+}
+
+
+//*****************************************************************************
+// Manipulation procedures
+//*****************************************************************************
+
+/*
+ * function: reset
+ *
+ * Frees everything allocated since the last reset, growing the buffer if this
+ * frame overflowed it.
+ */
+void FrameArena::reset(void) {
+    // Releases the overflow chunks back to upstream
+    arena.reset();
+
+    if (used > buffer_size) {
+        upstream->deallocate(buffer, buffer_size, alignof(std::max_align_t));
+        buffer_size = used;
+        buffer = upstream->allocate(buffer_size, alignof(std::max_align_t));
+    }
+
+    arena.emplace(buffer, buffer_size, upstream);
+    used = 0;
+}
+
+
+//*****************************************************************************
+// Hidden procedures
+//*****************************************************************************
+
+void* FrameArena::do_allocate(std::size_t bytes, std::size_t alignment) {
+    // Worst case padding, so a buffer of the high-water size always suffices
+    used += bytes + alignment - 1;
+
+    return arena->allocate(bytes, alignment);
+}
+
+void FrameArena::do_deallocate(void*, std::size_t, std::size_t) {
+    // Freed all at once by reset
+}
+
+bool FrameArena::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
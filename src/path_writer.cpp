@@ -0,0 +1,368 @@
+/*
+ * path_writer.cpp
+ *
+ * Implements the class PathWriter.
+ */
+
+#include "path_writer.h"
+
+#include <errno.h>
+#include <string.h>
+
+#include <charconv>
+#include <stdexcept>
+#include <string>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#define BEZ_WRITE_FD ::write
+#elif defined(_WIN32)
+#include <io.h>
+#define BEZ_WRITE_FD(fd, data, size) ::_write(fd, data, (unsigned)(size))
+#endif
+
+// Room kept free in the buffer for one number in its shortest form, which
+// is at most 24 characters for a double
+#define BEZ_NUMBER_ROOM 32
+
+// Largest number of decimals accepted by setPrecision
+#define BEZ_MAX_PRECISION 17
+
+
+//*****************************************************************************
+// Constructors/Destructors
+//*****************************************************************************
+
+/*
+ * constructor
+ *
+ * Writes to an open file descriptor, which is not closed by the writer.
+ *
+ * Args:
+ *   fd: file descriptor to write to
+ *   buffer_size: size of the buffer in bytes, at least 64
+ *
+ * Throws:
+ *   std::invalid_argument if buffer_size is less than 64
+ */
+PathWriter::PathWriter(int fd, std::size_t buffer_size) :
+    fd(fd), buffer_size(buffer_size), used(0), flushed(0), precision(BEZ_SHORTEST) {
+    if (buffer_size < 2 * BEZ_NUMBER_ROOM) {
+        throw std::invalid_argument("PathWriter needs a buffer of at least 64 bytes");
+    }
+    buffer.reset(new char[buffer_size]);
+}
+
+/*
+ * constructor
+ *
+ * Passes the formatted text to a callback, which must use or copy it
+ * before returning.
+ *
+ * Args:
+ *   sink: function called with each full buffer
+ *   buffer_size: size of the buffer in bytes, at least 64
+ *
+ * Throws:
+ *   std::invalid_argument if buffer_size is less than 64
+ */
+PathWriter::PathWriter(Sink sink, std::size_t buffer_size) :
+    fd(-1), sink(std::move(sink)), buffer_size(buffer_size), used(0), flushed(0),
+    precision(BEZ_SHORTEST) {
+    if (buffer_size < 2 * BEZ_NUMBER_ROOM) {
+        throw std::invalid_argument("PathWriter needs a buffer of at least 64 bytes");
+    }
+    buffer.reset(new char[buffer_size]);
+}
+
+/*
+ * destructor
+ *
+ * Flushes the buffer, ignoring errors. Call flush first to see them.
+ */
+PathWriter::~PathWriter(void) {
+    try {
+        flush();
+    }
+    catch (...) {
+        // Nothing to do
+    }
+}
+
+
+//*****************************************************************************
+// Settings
+//*****************************************************************************
+
+/*
+ * function: setPrecision
+ *
+ * Sets the number of decimals written, or BEZ_SHORTEST for the shortest
+ * form that reads back to the same value, which is the default.
+ */
+void PathWriter::setPrecision(int decimals) {
+    if (decimals < 0) {
+        precision = BEZ_SHORTEST;
+    }
+    else {
+        precision = decimals < BEZ_MAX_PRECISION ? decimals : BEZ_MAX_PRECISION;
+    }
+}
+
+int PathWriter::getPrecision(void) const {
+    return precision;
+}
+
+
+//*****************************************************************************
+// Writing procedures
+//*****************************************************************************
+
+/*
+ * function: writeSvgPath
+ *
+ * Writes the path data of a spline, ending with Z if it is closed.
+ */
+void PathWriter::writeSvgPath(const Curve2D& curve) {
+    if (curve.anchorCount() == 0) {
+        return;
+    }
+
+    curve.solvePending();
+
+    reserve(1);
+    buffer[used++] = 'M';
+    putPoint(curve.points[0], ',');
+    for (std::size_t i = 1; i <= 3 * curve.bezier_count; i++) {
+        reserve(1);
+        buffer[used++] = i == 1 ? 'C' : ' ';
+        putPoint(curve.points[i], ',');
+    }
+    if (curve.isClosed()) {
+        reserve(1);
+        buffer[used++] = 'Z';
+    }
+}
+
+/*
+ * function: writeSvgPath
+ *
+ * Writes the path data of raw cubic Bezier curves of 4 points each, such
+ * as PathSegments2D::cubics. A new subpath starts wherever a curve does
+ * not begin at the end of the previous one.
+ *
+ * Args:
+ *   cubics: 4 * bezier_count points
+ *   bezier_count: number of Bezier curves
+ */
+void PathWriter::writeSvgPath(const bezVect2D* cubics, std::size_t bezier_count) {
+    for (std::size_t i = 0; i < bezier_count; i++) {
+        const bezVect2D* p = cubics + 4 * i;
+        bool joined = i > 0 && p[0] == p[-1];
+
+        if (!joined) {
+            reserve(1);
+            buffer[used++] = 'M';
+            putPoint(p[0], ',');
+        }
+        for (std::size_t j = 1; j < 4; j++) {
+            reserve(1);
+            buffer[used++] = j == 1 && !joined ? 'C' : ' ';
+            putPoint(p[j], ',');
+        }
+    }
+}
+
+/*
+ * function: writeSvgPolyline
+ *
+ * Writes the path data of a polyline, such as the output of tessellate.
+ */
+void PathWriter::writeSvgPolyline(const bezVect2D* points, std::size_t count) {
+    for (std::size_t i = 0; i < count; i++) {
+        reserve(1);
+        buffer[used++] = i == 0 ? 'M' : i == 1 ? 'L' : ' ';
+        putPoint(points[i], ',');
+    }
+}
+
+/*
+ * function: writeCsv
+ *
+ * Writes the points of a spline as in Curve::points, anchor points and
+ * control points alternating, one per line.
+ */
+template <std::size_t Dim, typename T>
+void PathWriter::writeCsv(const Curve<Dim, T>& curve) {
+    curve.solvePending();
+    writeCsv<Dim, T>(curve.points.data(), curve.points.size());
+}
+
+/*
+ * function: writeCsv
+ *
+ * Writes raw points, such as raw cubic Bezier curves or the output of
+ * tessellate, one per line.
+ */
+template <std::size_t Dim, typename T>
+void PathWriter::writeCsv(const std::array<T, Dim>* points, std::size_t count) {
+    for (std::size_t i = 0; i < count; i++) {
+        putPoint(points[i], ',');
+        reserve(1);
+        buffer[used++] = '\n';
+    }
+}
+
+/*
+ * function: write
+ *
+ * Writes text as is, such as the surrounding SVG elements or a CSV
+ * header.
+ */
+void PathWriter::write(const char* text, std::size_t size) {
+    while (size > 0) {
+        std::size_t n = buffer_size - used < size ? buffer_size - used : size;
+
+        memcpy(&buffer[used], text, n);
+        used += n;
+        text += n;
+        size -= n;
+        if (used == buffer_size) {
+            flush();
+        }
+    }
+}
+
+/*
+ * function: flush
+ *
+ * Hands the buffered text to the file descriptor or callback.
+ *
+ * Throws:
+ *   std::runtime_error if writing to the file descriptor fails
+ */
+void PathWriter::flush(void) {
+    std::size_t done = 0;
+
+    if (fd < 0) {
+        if (used > 0 && sink) {
+            sink(buffer.get(), used);
+        }
+        done = used;
+    }
+    while (done < used) {
+        auto n = BEZ_WRITE_FD(fd, buffer.get() + done, used - done);
+
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            used = 0;
+            throw std::runtime_error(std::string("PathWriter: write failed: ") + strerror(errno));
+        }
+        done += (std::size_t)(n);
+    }
+
+    flushed += used;
+    used = 0;
+}
+
+/*
+ * function: bytesWritten
+ *
+ * Returns the number of bytes formatted so far, flushed or not.
+ */
+std::size_t PathWriter::bytesWritten(void) const {
+    return flushed + used;
+}
+
+
+//*****************************************************************************
+// Hidden procedures
+//*****************************************************************************
+
+/*
+ * function: reserve
+ *
+ * Flushes if fewer than size bytes are left in the buffer.
+ */
+void PathWriter::reserve(std::size_t size) {
+    if (buffer_size - used < size) {
+        flush();
+    }
+}
+
+/*
+ * function: put
+ *
+ * Appends a number to the buffer, flushing first if needed.
+ */
+template <typename T>
+void PathWriter::put(T value) {
+    char* first;
+    char* last = &buffer[buffer_size];
+    std::to_chars_result result;
+
+    reserve(BEZ_NUMBER_ROOM);
+    first = &buffer[used];
+
+    if (precision == BEZ_SHORTEST) {
+        result = std::to_chars(first, last, value);
+    }
+    else {
+        result = std::to_chars(first, last, value, std::chars_format::fixed, precision);
+        if (result.ec == std::errc::value_too_large && used > 0) {
+            flush();
+            first = &buffer[0];
+            result = std::to_chars(first, last, value, std::chars_format::fixed, precision);
+        }
+
+        // Too large for the buffer in fixed notation, so use the shortest form
+        if (result.ec != std::errc()) {
+            result = std::to_chars(first, last, value);
+        }
+        else if (precision > 0) {
+            // Drop the trailing zeros, and the point if nothing follows it
+            while (result.ptr[-1] == '0') {
+                result.ptr--;
+            }
+            if (result.ptr[-1] == '.') {
+                result.ptr--;
+            }
+        }
+
+        // Values rounded to zero lose their sign
+        if (result.ptr - first == 2 && first[0] == '-' && first[1] == '0') {
+            first[0] = '0';
+            result.ptr--;
+        }
+    }
+
+    used = result.ptr - &buffer[0];
+}
+
+/*
+ * function: putPoint
+ *
+ * Appends the coordinates of a point separated by the given character.
+ */
+template <std::size_t Dim, typename T>
+void PathWriter::putPoint(const std::array<T, Dim>& point, char separator) {
+    for (std::size_t d = 0; d < Dim; d++) {
+        if (d > 0) {
+            reserve(1);
+            buffer[used++] = separator;
+        }
+        put(point[d]);
+    }
+}
+
+
+//*****************************************************************************
+// Explicit instantiations
+//*****************************************************************************
+
+template void PathWriter::writeCsv<2, BEZ_DTYPE>(const Curve<2, BEZ_DTYPE>&);
+template void PathWriter::writeCsv<3, BEZ_DTYPE>(const Curve<3, BEZ_DTYPE>&);
+template void PathWriter::writeCsv<2, BEZ_DTYPE>(const bezVect2D*, std::size_t);
+template void PathWriter::writeCsv<3, BEZ_DTYPE>(const bezVect3D*, std::size_t);
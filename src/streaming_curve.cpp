@@ -0,0 +1,275 @@
+/*
+ * streaming_curve.cpp
+ *
+ * Implements the class template StreamingCurve.
+ */
+
+#include "streaming_curve.h"
+
+#include <stdexcept>
+
+#include "bezier_stats.h"
+
+#define BEZ_ONE_THIRD 0.33333333333333333333333333333
+#define BEZ_TWO_THIRDS 0.66666666666666666666666666666
+
+
+//*****************************************************************************
+// Constructors/Destructors
+//*****************************************************************************
+
+/*
+ * constructor
+ *
+ * Constructs an empty spline that keeps at most capacity anchor points.
+ *
+ * Args:
+ *   capacity: number of anchor points to keep, at least 2
+ *
+ * Throws:
+ *   std::invalid_argument if capacity < 2
+ */
+template <std::size_t Dim, typename T>
+StreamingCurve<Dim, T>::StreamingCurve(std::size_t capacity) :
+    begin(0), end(0) {
+    if (capacity < 2) {
+        throw std::invalid_argument("StreamingCurve: capacity must be at least 2");
+    }
+
+    ring.resize(capacity);
+}
+
+
+//*****************************************************************************
+// Access functions
+//*****************************************************************************
+
+/*
+ * function: getPositionAt
+ *
+ * Returns the coordinates of the spline evaluated at the given t, spread
+ * evenly over the Bezier curves currently kept.
+ *
+ * Args:
+ *   t: parameter value in the range [0, 1]
+ */
+template <std::size_t Dim, typename T>
+typename StreamingCurve<Dim, T>::Vect StreamingCurve<Dim, T>::getPositionAt(T t) const {
+    std::size_t n = segmentCount();
+
+    if (n == 0) {
+        return slot(begin).anchor;
+    }
+
+    t *= (T)(n);
+    std::size_t s = (std::size_t)(t);  // index of Bezier curve
+
+    // t = 1 is the end of the final Bezier curve
+    if (s >= n) {
+        s = n - 1;
+    }
+
+    t -= (T)(s);
+
+    const Slot& from = slot(begin + s);
+    const Slot& to = slot(begin + s + 1);
+
+    BEZ_STATS_ADD(evaluations, 1);
+
+    return bezEvaluateSegment(from.anchor, from.control1, from.control2, to.anchor, t);
+}
+
+/*
+ * function: anchorCount
+ *
+ * Returns the number of anchor points currently kept.
+ */
+template <std::size_t Dim, typename T>
+std::size_t StreamingCurve<Dim, T>::anchorCount(void) const {
+    return end - begin;
+}
+
+/*
+ * function: capacity
+ *
+ * Returns the largest number of anchor points kept at once.
+ */
+template <std::size_t Dim, typename T>
+std::size_t StreamingCurve<Dim, T>::capacity(void) const {
+    return ring.size();
+}
+
+/*
+ * function: streamLength
+ *
+ * Returns the number of anchor points appended since construction or the last
+ * clear, retired ones included.
+ */
+template <std::size_t Dim, typename T>
+std::size_t StreamingCurve<Dim, T>::streamLength(void) const {
+    return end;
+}
+
+/*
+ * function: getAnchor
+ *
+ * Returns the coordinates of the anchor point at the given index, 0 being the
+ * oldest one kept.
+ *
+ * Args:
+ *   i: index of point, less than anchorCount()
+ */
+template <std::size_t Dim, typename T>
+const typename StreamingCurve<Dim, T>::Vect& StreamingCurve<Dim, T>::getAnchor(std::size_t i) const {
+    return slot(begin + i).anchor;
+}
+
+template <std::size_t Dim, typename T>
+std::size_t StreamingCurve<Dim, T>::segmentCount(void) const {
+    return end - begin > 0 ? end - begin - 1 : 0;
+}
+
+template <std::size_t Dim, typename T>
+T StreamingCurve<Dim, T>::get(std::size_t s, std::size_t p, std::size_t d) const {
+    const Slot& from = slot(begin + s);
+
+    switch (p) {
+    case 0:
+        return from.anchor[d];
+    case 1:
+        return from.control1[d];
+    case 2:
+        return from.control2[d];
+    default:
+        return slot(begin + s + 1).anchor[d];
+    }
+}
+
+
+//*****************************************************************************
+// Manipulation procedures
+//*****************************************************************************
+
+/*
+ * function: append
+ *
+ * Adds an anchor point after the newest one, retiring the oldest if the buffer
+ * is full, and updates the affected control points.
+ *
+ * Re-solves the rows of the C2 system from BEZ_LOCAL_SOLVE_MARGIN before the
+ * new anchor point up to it with the Thomas algorithm, holding the B_point
+ * just before the window fixed, the same way as Curve::solveRange. The new
+ * anchor point is a natural end, so its own B_point is the anchor point.
+ *
+ * Args:
+ *   position: the position of the new anchor point
+ */
+template <std::size_t Dim, typename T>
+void StreamingCurve<Dim, T>::append(const Vect& position) {
+    T c[BEZ_LOCAL_SOLVE_MARGIN + 1];  // Thomas coefficients of the window
+    std::size_t first;  // first row of the window
+    std::size_t last;  // last row of the window
+    std::size_t i, j, k;
+
+    if (end - begin == ring.size()) {
+        begin++;
+    }
+
+    Slot& newest = slot(end);
+    newest.anchor = position;
+    newest.B_point = position;
+    end++;
+
+    if (end - begin == 1) {
+        return;
+    }
+
+    // Straight line, as in Curve
+    if (end == 2) {
+        slot(0).control1 = slot(0).anchor;
+        slot(0).control2 = position;
+
+        return;
+    }
+
+    last = end - 2;
+    first = last > begin + BEZ_LOCAL_SOLVE_MARGIN ? last - BEZ_LOCAL_SOLVE_MARGIN : begin + 1;
+
+    // Rows strictly between the oldest anchor point kept and the newest
+    if (last > begin) {
+        // Forward sweep, with c restarted at the left boundary of the window
+        for (i = first; i <= last; i++) {
+            const Vect& prev = slot(i - 1).B_point;
+            Slot& row = slot(i);
+
+            c[i - first] = 1. / (4. - (i > first ? c[i - first - 1] : 0.));
+
+            for (k = 0; k < Dim; k++) {
+                T rhs = 6. * row.anchor[k];
+                if (i == last) {
+                    rhs -= position[k];
+                }
+                row.B_point[k] = c[i - first] * (rhs - prev[k]);
+            }
+        }
+
+        // Back-substitution
+        for (i = last; i > first; i--) {
+            const Vect& next = slot(i).B_point;
+            Slot& row = slot(i - 1);
+
+            for (k = 0; k < Dim; k++) {
+                row.B_point[k] -= c[i - 1 - first] * next[k];
+            }
+        }
+    }
+
+    // Control points of every Bezier curve touching a re-solved B_point
+    for (j = first - 1; j <= last; j++) {
+        Slot& from = slot(j);
+        const Vect& next = slot(j + 1).B_point;
+
+        for (k = 0; k < Dim; k++) {
+            from.control1[k] = BEZ_TWO_THIRDS * from.B_point[k] + BEZ_ONE_THIRD * next[k];
+            from.control2[k] = BEZ_ONE_THIRD * from.B_point[k] + BEZ_TWO_THIRDS * next[k];
+        }
+    }
+}
+
+/*
+ * function: clear
+ *
+ * Removes all anchor points, keeping the buffer.
+ */
+template <std::size_t Dim, typename T>
+void StreamingCurve<Dim, T>::clear(void) {
+    begin = end = 0;
+}
+
+
+//*****************************************************************************
+// Hidden procedures
+//*****************************************************************************
+
+/*
+ * function: slot
+ *
+ * Returns the ring slot of the anchor point with the given stream index.
+ */
+template <std::size_t Dim, typename T>
+typename StreamingCurve<Dim, T>::Slot& StreamingCurve<Dim, T>::slot(std::size_t i) {
+    return ring[i % ring.size()];
+}
+
+template <std::size_t Dim, typename T>
+const typename StreamingCurve<Dim, T>::Slot& StreamingCurve<Dim, T>::slot(std::size_t i) const {
+    return ring[i % ring.size()];
+}
+
+
+//*****************************************************************************
+// Explicit instantiations
+//*****************************************************************************
+
+template class StreamingCurve<2, BEZ_DTYPE>;
+template class StreamingCurve<3, BEZ_DTYPE>;
@@ -0,0 +1,447 @@
+/*
+ * svg_path.cpp
+ *
+ * Implements the class template PathSegments and the class SvgPathParser.
+ */
+
+#include "svg_path.h"
+
+#include <charconv>
+#include <stdexcept>
+
+#define BEZ_ONE_THIRD 0.33333333333333333333333333333
+#define BEZ_TWO_THIRDS 0.66666666666666666666666666666
+
+
+//*****************************************************************************
+//* PATHSEGMENTS
+//*****************************************************************************
+
+/*
+ * function: segmentCount
+ *
+ * Returns the number of cubic Bezier curves.
+ */
+template <std::size_t Dim, typename T>
+std::size_t PathSegments<Dim, T>::segmentCount(void) const {
+    return cubics.size() / 4;
+}
+
+/*
+ * function: get
+ *
+ * Returns coordinate d of control point p of cubic Bezier curve s.
+ */
+template <std::size_t Dim, typename T>
+T PathSegments<Dim, T>::get(std::size_t s, std::size_t p, std::size_t d) const {
+    return cubics[4 * s + p][d];
+}
+
+/*
+ * function: quadraticCount
+ *
+ * Returns the number of quadratic Bezier curves.
+ */
+template <std::size_t Dim, typename T>
+std::size_t PathSegments<Dim, T>::quadraticCount(void) const {
+    return quadratics.size() / 3;
+}
+
+/*
+ * function: clear
+ *
+ * Removes every Bezier curve and subpath, keeping the allocated storage.
+ */
+template <std::size_t Dim, typename T>
+void PathSegments<Dim, T>::clear(void) {
+    cubics.clear();
+    quadratics.clear();
+    subpaths.clear();
+}
+
+
+//*****************************************************************************
+//* SVGPATHPARSER
+//*****************************************************************************
+
+namespace {
+
+/*
+ * function: argumentCount
+ *
+ * Returns the number of values taken by the given command, 0 for Z and -1 for
+ * a character that is not a supported command.
+ */
+int argumentCount(char command) {
+    switch (command) {
+        case 'M': case 'm': case 'L': case 'l': case 'T': case 't':
+            return 2;
+        case 'H': case 'h': case 'V': case 'v':
+            return 1;
+        case 'S': case 's': case 'Q': case 'q':
+            return 4;
+        case 'C': case 'c':
+            return 6;
+        case 'Z': case 'z':
+            return 0;
+        default:
+            return -1;
+    }
+}
+
+bool isSeparator(char c) {
+    return c == ' ' || c == ',' || c == '\t' || c == '\n' || c == '\r' || c == '\f';
+}
+
+bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+/*
+ * function: scanNumber
+ *
+ * Returns the end of the number starting at p, which is end if the number
+ * may continue past it, or p if there is no valid number at p.
+ */
+const char* scanNumber(const char* p, const char* end) {
+    const char* q = p;
+    std::size_t digits = 0;
+
+    if (q != end && (*q == '+' || *q == '-')) {
+        q++;
+    }
+    for (; q != end && isDigit(*q); q++) {
+        digits++;
+    }
+    if (q != end && *q == '.') {
+        for (q++; q != end && isDigit(*q); q++) {
+            digits++;
+        }
+    }
+    if (q == end) {
+        return end;
+    }
+    if (digits == 0) {
+        return p;
+    }
+    if (*q == 'e' || *q == 'E') {
+        const char* e = q + 1;
+
+        if (e != end && (*e == '+' || *e == '-')) {
+            e++;
+        }
+        if (e == end) {
+            return end;
+        }
+        if (isDigit(*e)) {
+            for (; e != end && isDigit(*e); e++) {
+                // Nothing to do
+            }
+            q = e;
+        }
+    }
+    return q;
+}
+
+}  // namespace
+
+
+/*
+ * constructor
+ *
+ * Args:
+ *   out: segments to append to
+ *   elevate_quadratics: whether to emit quadratic Bezier curves as cubic
+ */
+SvgPathParser::SvgPathParser(PathSegments<2, BEZ_DTYPE>& out, bool elevate_quadratics) :
+    out(out), elevate_quadratics(elevate_quadratics), command(0), previous(0),
+    arg_count(0), awaiting_args(false), open_subpath(false), current{}, start{}, control{},
+    offset(0) {
+    // Nothing to do
+}
+
+/*
+ * function: feed
+ *
+ * Parses the next chunk of path data.
+ *
+ * Args:
+ *   data: characters of the chunk
+ *   size: number of characters
+ *
+ * Throws:
+ *   std::invalid_argument if the data is not valid path data
+ */
+void SvgPathParser::feed(const char* data, std::size_t size) {
+    std::size_t i = 0;
+
+    // Complete the number cut off by the previous chunk. It ends at the first
+    // character that cannot belong to a number, but may hold several numbers,
+    // as in "1.5.5"
+    if (!carry.empty()) {
+        while (i < size && !isSeparator(data[i]) && argumentCount(data[i]) < 0) {
+            i++;
+        }
+        carry.append(data, i);
+        if (i == size) {
+            offset += size;
+            return;
+        }
+        parse(carry.data(), carry.size(), true);
+        carry.clear();
+    }
+
+    parse(data + i, size - i, false);
+    offset += size;
+}
+
+/*
+ * function: finish
+ *
+ * Parses whatever is left of the path data and gets ready for another
+ * path.
+ *
+ * Throws:
+ *   std::invalid_argument if the data ends part way through a command
+ */
+void SvgPathParser::finish(void) {
+    if (!carry.empty()) {
+        parse(carry.data(), carry.size(), true);
+        carry.clear();
+    }
+    if (arg_count != 0 || awaiting_args) {
+        fail("path data ends part way through a command");
+    }
+
+    command = 0;
+    previous = 0;
+    open_subpath = false;
+    current = start = control = Vect{};
+    offset = 0;
+}
+
+/*
+ * function: parse
+ *
+ * Parses the given characters. If terminated is false and the last number
+ * runs up to the end, that number is left in carry instead.
+ */
+void SvgPathParser::parse(const char* data, std::size_t size, bool terminated) {
+    const char* p = data;
+    const char* end = data + size;
+
+    while (p != end) {
+        if (isSeparator(*p)) {
+            p++;
+            continue;
+        }
+
+        int count = argumentCount(*p);
+        if (count >= 0) {
+            if (arg_count != 0 || awaiting_args) {
+                fail("command interrupts the arguments of the previous one");
+            }
+            if (command == 0 && *p != 'M' && *p != 'm') {
+                fail("path data does not start with a moveto command");
+            }
+            command = *p++;
+            awaiting_args = true;
+            if (count == 0) {
+                execute();
+            }
+            continue;
+        }
+
+        const char* number_end = scanNumber(p, end);
+        if (number_end == p) {
+            fail("unexpected character");
+        }
+        if (number_end == end && !terminated) {
+            carry.assign(p, end);
+            return;
+        }
+        if (command == 0) {
+            fail("path data does not start with a moveto command");
+        }
+        if (command == 'Z' || command == 'z') {
+            fail("closepath command takes no arguments");
+        }
+
+        // std::from_chars does not accept a leading plus sign
+        const char* first = *p == '+' ? p + 1 : p;
+        std::from_chars_result result = std::from_chars(first, number_end, args[arg_count]);
+        if (result.ec != std::errc() || result.ptr != number_end) {
+            fail("malformed number");
+        }
+        p = number_end;
+
+        if (++arg_count == (std::size_t)(argumentCount(command))) {
+            execute();
+            arg_count = 0;
+        }
+    }
+}
+
+/*
+ * function: execute
+ *
+ * Emits the Bezier curve of the current command from args.
+ */
+void SvgPathParser::execute(void) {
+    bool relative = command >= 'a';
+    BEZ_DTYPE x = relative ? current[0] : 0;
+    BEZ_DTYPE y = relative ? current[1] : 0;
+    Vect c1;
+
+    awaiting_args = false;
+
+    switch (command) {
+        case 'M': case 'm':
+            current = start = {{args[0] + x, args[1] + y}};
+            open_subpath = false;
+            previous = 'M';
+
+            // Further pairs of numbers are implicit lineto commands
+            command = relative ? 'l' : 'L';
+            return;
+        case 'L': case 'l':
+            lineTo({{args[0] + x, args[1] + y}});
+            previous = 'L';
+            return;
+        case 'H': case 'h':
+            lineTo({{args[0] + x, current[1]}});
+            previous = 'L';
+            return;
+        case 'V': case 'v':
+            lineTo({{current[0], args[0] + y}});
+            previous = 'L';
+            return;
+        case 'C': case 'c':
+            control = {{args[2] + x, args[3] + y}};
+            cubicTo({{args[0] + x, args[1] + y}}, control, {{args[4] + x, args[5] + y}});
+            previous = 'C';
+            return;
+        case 'S': case 's':
+            c1 = current;
+            if (previous == 'C') {
+                c1 = {{2 * current[0] - control[0], 2 * current[1] - control[1]}};
+            }
+            control = {{args[0] + x, args[1] + y}};
+            cubicTo(c1, control, {{args[2] + x, args[3] + y}});
+            previous = 'C';
+            return;
+        case 'Q': case 'q':
+            control = {{args[0] + x, args[1] + y}};
+            quadraticTo(control, {{args[2] + x, args[3] + y}});
+            previous = 'Q';
+            return;
+        case 'T': case 't':
+            c1 = current;
+            if (previous == 'Q') {
+                c1 = {{2 * current[0] - control[0], 2 * current[1] - control[1]}};
+            }
+            control = c1;
+            quadraticTo(control, {{args[0] + x, args[1] + y}});
+            previous = 'Q';
+            return;
+        default:  // Z or z
+            if (current != start) {
+                lineTo(start);
+            }
+            if (open_subpath) {
+                out.subpaths.back().closed = true;
+            }
+
+            // A command after closepath starts a new subpath at the same point
+            open_subpath = false;
+            previous = 'Z';
+            return;
+    }
+}
+
+void SvgPathParser::lineTo(const Vect& p) {
+    Vect c1, c2;
+
+    for (std::size_t i = 0; i < 2; i++) {
+        c1[i] = current[i] + (p[i] - current[i]) * BEZ_ONE_THIRD;
+        c2[i] = current[i] + (p[i] - current[i]) * BEZ_TWO_THIRDS;
+    }
+    cubicTo(c1, c2, p);
+}
+
+void SvgPathParser::cubicTo(const Vect& c1, const Vect& c2, const Vect& p) {
+    startSubpath();
+    out.cubics.push_back(current);
+    out.cubics.push_back(c1);
+    out.cubics.push_back(c2);
+    out.cubics.push_back(p);
+    current = p;
+}
+
+void SvgPathParser::quadraticTo(const Vect& c, const Vect& p) {
+    if (elevate_quadratics) {
+        Vect c1, c2;
+
+        for (std::size_t i = 0; i < 2; i++) {
+            c1[i] = current[i] + (c[i] - current[i]) * BEZ_TWO_THIRDS;
+            c2[i] = p[i] + (c[i] - p[i]) * BEZ_TWO_THIRDS;
+        }
+        cubicTo(c1, c2, p);
+        return;
+    }
+
+    startSubpath();
+    out.quadratics.push_back(current);
+    out.quadratics.push_back(c);
+    out.quadratics.push_back(p);
+    current = p;
+}
+
+/*
+ * function: startSubpath
+ *
+ * Adds a Subpath entry before the first Bezier curve of a subpath, so that
+ * lone moveto commands leave no empty subpaths behind.
+ */
+void SvgPathParser::startSubpath(void) {
+    if (!open_subpath) {
+        out.subpaths.push_back({out.cubics.size() / 4, out.quadratics.size() / 3, false});
+        open_subpath = true;
+    }
+}
+
+/*
+ * function: fail
+ *
+ * Throws std::invalid_argument with the given message and the offset of
+ * the current chunk.
+ */
+void SvgPathParser::fail(const char* message) const {
+    throw std::invalid_argument(std::string("SvgPathParser: ") + message +
+                                " in chunk at offset " + std::to_string(offset));
+}
+
+
+/*
+ * function: parseSvgPath
+ *
+ * Parses one complete SVG path and appends its Bezier curves to out.
+ *
+ * Throws:
+ *   std::invalid_argument if the data is not valid path data
+ */
+void parseSvgPath(const char* data, std::size_t size, PathSegments<2, BEZ_DTYPE>& out,
+                  bool elevate_quadratics) {
+    SvgPathParser parser(out, elevate_quadratics);
+
+    parser.feed(data, size);
+    parser.finish();
+}
+
+
+//*****************************************************************************
+// Explicit instantiations
+//*****************************************************************************
+
+template class PathSegments<2, BEZ_DTYPE>;
+template class PathSegments<3, BEZ_DTYPE>;
@@ -0,0 +1,200 @@
+/*
+ * thread_pool.cpp
+ *
+ * Implements the class ThreadPool.
+ */
+
+#include "thread_pool.h"
+
+
+// Pool whose tasks the calling thread is running, if any
+static thread_local const ThreadPool* draining_pool = nullptr;
+
+// Number of threads the shared pool is created with, or zero for one per
+// hardware thread
+static std::size_t shared_thread_count = 0;
+
+
+//*****************************************************************************
+// Constructors/Destructors
+//*****************************************************************************
+
+/*
+ * constructor
+ *
+ * Starts thread_count - 1 worker threads.
+ *
+ * Args:
+ *   thread_count: total number of threads, including the caller of run
+ */
+ThreadPool::ThreadPool(std::size_t thread_count) :
+    task(nullptr), task_count(0), next_task(0), generation(0),
+    busy_workers(0), stopping(false) {
+    std::size_t i;
+
+    for (i = 1; i < thread_count; i++) {
+        workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+/*
+ * destructor
+ *
+ * Stops and joins the worker threads.
+ */
+ThreadPool::~ThreadPool(void) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    start_cv.notify_all();
+
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+
+//*****************************************************************************
+// Access functions
+//*****************************************************************************
+
+/*
+ * function: threadCount
+ *
+ * Returns the number of threads that execute tasks, including the caller.
+ */
+std::size_t ThreadPool::threadCount(void) const {
+    return workers.size() + 1;
+}
+
+/*
+ * function: shared
+ *
+ * Returns a process-wide pool with one thread per hardware thread, or as
+ * many as setSharedThreadCount asked for, creating it on first use.
+ */
+ThreadPool& ThreadPool::shared(void) {
+    static ThreadPool pool(shared_thread_count > 0 ? shared_thread_count :
+                           std::thread::hardware_concurrency() > 0 ?
+                           std::thread::hardware_concurrency() : 1);
+
+    return pool;
+}
+
+/*
+ * function: setSharedThreadCount
+ *
+ * Sets the number of threads the shared pool is created with, or restores one
+ * per hardware thread if thread_count is zero. Has no effect once shared has
+ * been called, and must not race with its first call.
+ *
+ * Args:
+ *   thread_count: total number of threads of the shared pool
+ */
+void ThreadPool::setSharedThreadCount(std::size_t thread_count) {
+    shared_thread_count = thread_count;
+}
+
+
+//*****************************************************************************
+// Execution procedures
+//*****************************************************************************
+
+/*
+ * function: run
+ *
+ * Calls task(i) for every i in [0, task_count) and returns once all calls have
+ * finished. Tasks are handed out dynamically, so their order is unspecified.
+ * Tasks must not throw. Concurrent calls are serialized.
+ * A call from one of this pool's own tasks runs its tasks serially on the
+ * calling thread, since the batch it belongs to holds the pool.
+ *
+ * Args:
+ *   task_count: number of tasks to run
+ *   task: function to call with each task index
+ */
+void ThreadPool::run(std::size_t task_count, const std::function<void(std::size_t)>& task) {
+    std::size_t i;
+
+    // Not worth waking the workers, or nested in a batch of this pool, whose
+    // workers are busy and whose run_mutex is held
+    if (workers.empty() || task_count <= 1 || draining_pool == this) {
+        for (i = 0; i < task_count; i++) {
+            task(i);
+        }
+        return;
+    }
+
+    std::lock_guard<std::mutex> run_lock(run_mutex);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        this->task = &task;
+        this->task_count = task_count;
+        next_task.store(0);
+        busy_workers = workers.size();
+        generation++;
+    }
+    start_cv.notify_all();
+
+    drain();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done_cv.wait(lock, [this] { return busy_workers == 0; });
+    this->task = nullptr;
+}
+
+
+//*****************************************************************************
+// Hidden procedures
+//*****************************************************************************
+
+/*
+ * function: workerLoop
+ *
+ * Body of each worker thread. Waits for a batch, drains it, and reports back
+ * until the pool is destroyed.
+ */
+void ThreadPool::workerLoop(void) {
+    std::size_t seen_generation = 0;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            start_cv.wait(lock, [&] { return stopping || generation != seen_generation; });
+
+            if (stopping) {
+                return;
+            }
+
+            seen_generation = generation;
+        }
+
+        drain();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            busy_workers--;
+            if (busy_workers == 0) {
+                done_cv.notify_one();
+            }
+        }
+    }
+}
+
+/*
+ * function: drain
+ *
+ * Claims and runs tasks from the current batch until none are left.
+ */
+void ThreadPool::drain(void) {
+    const ThreadPool* outer_pool = draining_pool;
+    std::size_t i;
+
+    draining_pool = this;
+    while ((i = next_task.fetch_add(1)) < task_count) {
+        (*task)(i);
+    }
+    draining_pool = outer_pool;
+}
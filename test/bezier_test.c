@@ -8,9 +8,11 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <limits.h>
+#include <float.h>
 #include <math.h>
 
 #include "bezier.h"
+#include "bezier_stats.h"
 
 
 #define BEZ_TRUE 1
@@ -43,6 +45,13 @@ double randomUniform(double a, double b);
  */
 double roundDigits(double x, int d);
 
+/*
+ * function: ulpError
+ *
+ * Returns how many units in the last place of exact value lies from it.
+ */
+double ulpError(BEZ_DTYPE value, double exact);
+
 
 int main(int argc, char* argv[]) {
     BEZ_DTYPE x,  y,  z,
@@ -813,6 +822,209 @@ int main(int argc, char* argv[]) {
     num_tests = num_fails = -1;
 
 
+    //*************************************************************************
+    printf("\nTesting function bez2ArcLength:\n");
+    //*************************************************************************
+    num_tests = 5;
+    num_fails = 0;
+
+    for (i = 0; i < num_tests; i++) {
+        if (i < num_tests - 1) {
+            x0 = randomUniform(-10., 10.);
+            y0 = randomUniform(-10., 10.);
+            x1 = randomUniform(-10., 10.);
+            y1 = randomUniform(-10., 10.);
+            x2 = randomUniform(-10., 10.);
+            y2 = randomUniform(-10., 10.);
+            x3 = randomUniform(-10., 10.);
+            y3 = randomUniform(-10., 10.);
+        }
+        else {
+            // its halves round back to themselves near the cusp, so this
+            // only ends because of BEZ_ARC_LENGTH_MAX_DEPTH
+            x0 = 40.3771896;
+            y0 = 19.2814522;
+            x1 = 93.5667725;
+            y1 = 80.5280075;
+            x2 = 50.0105133;
+            y2 = 63.6462555;
+            x3 = 77.5185471;
+            y3 = 15.3418941;
+        }
+
+        a = bez2ArcLength(x0, y0, x1, y1, x2, y2, x3, y3, 1.01);
+
+        // the length lies between the chord and the perimeter of the hull
+        b = sqrt(pow(x3 - x0, 2.) + pow(y3 - y0, 2.));
+        c = sqrt(pow(x1 - x0, 2.) + pow(y1 - y0, 2.)) +
+            sqrt(pow(x2 - x1, 2.) + pow(y2 - y1, 2.)) +
+            sqrt(pow(x3 - x2, 2.) + pow(y3 - y2, 2.));
+
+        if (!(a >= b - ERROR_TOLERANCE && a <= c + ERROR_TOLERANCE)) {
+            num_fails++;
+            printf("failed test %d\n", i + 1);
+        }
+    }
+
+    if (num_fails == 0) {
+        printf("all %d tests passed\n", num_tests);
+    }
+    else {
+        printf("failed %d/%d tests\n", num_fails, num_tests);
+    }
+    num_tests = num_fails = -1;
+
+
+    //*************************************************************************
+    printf("\nTesting function bezStatsSnapshot:\n");
+    //*************************************************************************
+    num_tests = 4;
+    num_fails = 0;
+
+    {
+        bezStats stats[4];
+
+        bezStatsReset();
+
+        // a straight curve is flat without being split
+        bez2ArcLength(0., 0., 1., 1., 2., 2., 3., 3., 1.01);
+        bezStatsSnapshot(&stats[0]);
+
+        // x has one extremum inside the curve and y none
+        bez2BoundingBox(0., 0., 3., 1., 1., 3., 0., 3.5, &a, &b, &c, &d);
+        bezStatsSnapshot(&stats[1]);
+
+        // a curved one is split at least once
+        bez2ArcLength(0., 0., 0., 1., 1., 1., 1., 0., 1.001);
+        bezStatsSnapshot(&stats[2]);
+
+        // without a quadratic term, x has the linear root t = 0.5 and y,
+        // whose derivative is constant, none
+        bez2BoundingBox(0., 0., 1., 1., 1., 2., 0., 3., &a, &b, &c, &d);
+        bezStatsSnapshot(&stats[3]);
+
+#if defined(BEZ_ENABLE_STATS)
+        if (stats[0].arc_length_calls != 1 || stats[0].arc_length_leaves != 1 ||
+            stats[0].arc_length_max_depth != 0) {
+            num_fails++;
+            printf("failed test 1\n");
+        }
+        if (stats[1].bounding_box_calls != 1 || stats[1].bounding_box_extrema[0] != 1 ||
+            stats[1].bounding_box_extrema[1] != 1 || stats[1].bounding_box_degenerate != 0) {
+            num_fails++;
+            printf("failed test 2\n");
+        }
+        if (stats[2].arc_length_calls != 2 || stats[2].arc_length_leaves < 3 ||
+            stats[2].arc_length_max_depth == 0 || stats[2].arc_length_depth_limited != 0) {
+            num_fails++;
+            printf("failed test 3\n");
+        }
+        if (stats[3].bounding_box_calls != 2 || stats[3].bounding_box_extrema[0] != 2 ||
+            stats[3].bounding_box_extrema[1] != 2 || stats[3].bounding_box_extrema[2] != 0 ||
+            stats[3].bounding_box_degenerate != 2) {
+            num_fails++;
+            printf("failed test 4\n");
+        }
+#else
+        // without BEZ_ENABLE_STATS nothing is counted
+        for (i = 0; i < num_tests; i++) {
+            if (stats[i].arc_length_calls != 0 || stats[i].bounding_box_calls != 0) {
+                num_fails++;
+                printf("failed test %d\n", i + 1);
+            }
+        }
+#endif
+    }
+
+    if (num_fails == 0) {
+        printf("all %d tests passed\n", num_tests);
+    }
+    else {
+        printf("failed %d/%d tests\n", num_fails, num_tests);
+    }
+    num_tests = num_fails = -1;
+
+
+    //*************************************************************************
+    printf("\nTesting fast math functions:\n");
+    //*************************************************************************
+    num_tests = 4;
+    num_fails = 0;
+
+    {
+        // the estimates repeat every two binades, so [1, 4) has every case,
+        // and a sparser sample of it scaled checks the exponents
+        double max_ulps[4] = {0., 0., 0., 0.};
+        BEZ_DTYPE in[4], out[4];
+        long k;
+        int scale;
+
+        for (scale = -60; scale <= 60; scale += 2) {
+            for (k = 0; k < (1L << 24); k += (scale == 0 ? 1 : 4097)) {
+                x = ldexp(1. + (double)(k & 0x7fffff) / (double)(1L << 23), (int)(k >> 23) + scale);
+
+                a = bezFastRsqrt(x);
+                max_ulps[0] = fmax(max_ulps[0], ulpError(a, 1. / sqrt((double)(x))));
+
+                a = bezFastSqrt(x);
+                max_ulps[1] = fmax(max_ulps[1], ulpError(a, sqrt((double)(x))));
+
+                // both steps cycle k % 4 through every lane in turn
+                in[k % 4] = x;
+                if (k % 4 == 3) {
+                    bezFastSqrt4(in, out);
+                    for (i = 0; i < 4; i++) {
+                        max_ulps[2] = fmax(max_ulps[2], ulpError(out[i], sqrt((double)(in[i]))));
+                    }
+                }
+
+                // the reciprocal only takes magnitudes below 2^126
+                if (scale < 60) {
+                    x = (k % 2 == 0 ? x : -x) * .5;
+                    a = bezFastReciprocal(x);
+                    max_ulps[3] = fmax(max_ulps[3], ulpError(a, 1. / (double)(x)));
+                }
+            }
+        }
+
+        // below the smallest normal float square roots round to zero
+        in[0] = 0.;
+        in[1] = 1e-40;
+        in[2] = 4.;
+        in[3] = 0.;
+        bezFastSqrt4(in, out);
+        if (bezFastSqrt(0.) != 0. || bezFastSqrt(1e-40) != 0. ||
+            out[0] != 0. || out[1] != 0. || out[3] != 0.) {
+            max_ulps[1] = max_ulps[2] = INFINITY;
+        }
+
+        if (max_ulps[0] > BEZ_FAST_RSQRT_MAX_ULP) {
+            num_fails++;
+            printf("failed test 1: bezFastRsqrt is off by %f ulp\n", max_ulps[0]);
+        }
+        if (max_ulps[1] > BEZ_FAST_SQRT_MAX_ULP) {
+            num_fails++;
+            printf("failed test 2: bezFastSqrt is off by %f ulp\n", max_ulps[1]);
+        }
+        if (max_ulps[2] > BEZ_FAST_SQRT_MAX_ULP) {
+            num_fails++;
+            printf("failed test 3: bezFastSqrt4 is off by %f ulp\n", max_ulps[2]);
+        }
+        if (max_ulps[3] > BEZ_FAST_RECIPROCAL_MAX_ULP) {
+            num_fails++;
+            printf("failed test 4: bezFastReciprocal is off by %f ulp\n", max_ulps[3]);
+        }
+    }
+
+    if (num_fails == 0) {
+        printf("all %d tests passed\n", num_tests);
+    }
+    else {
+        printf("failed %d/%d tests\n", num_fails, num_tests);
+    }
+    num_tests = num_fails = -1;
+
+
     printf("\n\nThis concludes the unit tests for bezier.h/cpp\n");
 
     return 0;
@@ -859,3 +1071,16 @@ double roundDigits(double x, int d) {
     double mult = pow(10, (double)(d));
     return round(x * mult) / mult;
 }
+
+/*
+ * function: ulpError
+ *
+ * Returns how many units in the last place of exact value lies from it.
+ */
+double ulpError(BEZ_DTYPE value, double exact) {
+    int digits = sizeof(BEZ_DTYPE) == sizeof(float) ? FLT_MANT_DIG : DBL_MANT_DIG;
+    int exponent;
+
+    frexp(exact, &exponent);
+    return fabs((double)(value) - exact) / ldexp(1., exponent - digits);
+}
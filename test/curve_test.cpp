@@ -0,0 +1,1860 @@
+/*
+ * curve_test.cpp
+ *
+ * Contains unit tests for the classes defined in curve.h
+ */
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bezier.h"
+#include "bezier_stats.h"
+#include "curve.h"
+#include "curve_file.h"
+#include "curve_layout.h"
+#include "curve_publisher.h"
+#include "curve_set.h"
+#include "curve_trace.h"
+#include "curve_view.h"
+#include "frame_arena.h"
+#include "path_writer.h"
+#include "streaming_curve.h"
+#include "svg_path.h"
+#include "thread_pool.h"
+
+
+#define BEZ_TRUE 1
+#define BEZ_FALSE 0
+
+#define ERROR_TOLERANCE 1e-4
+#define LENGTH_ERROR_TOLERANCE 1e-2
+
+
+/*
+ * function: is_close
+ *
+ * Returns BEZ_TRUE if a and b are within tolerance of each other,
+ *     BEZ_FALSE otherwise.
+ */
+int is_close(BEZ_DTYPE a, BEZ_DTYPE b, BEZ_DTYPE tolerance = ERROR_TOLERANCE);
+
+/*
+ * function: randomUniform
+ *
+ * Returns a random value uniformly distributed on [a, b].
+ */
+double randomUniform(double a, double b);
+
+/*
+ * function: randomAnchors2D
+ *
+ * Returns n random anchor points in the square [-10, 10] x [-10, 10].
+ */
+std::vector<bezVect2D> randomAnchors2D(std::size_t n);
+
+/*
+ * function: distance2D
+ *
+ * Returns the Euclidean distance between a and b.
+ */
+BEZ_DTYPE distance2D(const bezVect2D& a, const bezVect2D& b);
+
+/*
+ * function: countInFile
+ *
+ * Returns the number of times text occurs in the file at path.
+ */
+std::size_t countInFile(const char* path, const char* text);
+
+
+/*
+ * struct: CountingResource
+ *
+ * Forwards to the default resource and counts the allocations made through it.
+ */
+struct CountingResource : std::pmr::memory_resource {
+    std::size_t allocations = 0;
+
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        allocations++;
+        return std::pmr::get_default_resource()->allocate(bytes, alignment);
+    }
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+        std::pmr::get_default_resource()->deallocate(p, bytes, alignment);
+    }
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+
+int main(int argc, char* argv[]) {
+    int num_tests = -1, num_fails = -1;
+    int i;
+    std::size_t j;
+    int failed;
+
+    srand(7);
+
+    printf("Beginning unit tests for curve.h/cpp\n");
+
+
+    //*************************************************************************
+    printf("\nTesting function Curve2D::getLength:\n");
+    //*************************************************************************
+    num_tests = 2;
+    num_fails = 0;
+
+    {
+        // test 1: evenly spaced collinear anchors give a straight segment
+        std::vector<bezVect2D> anchors{ {0, 0}, {1, 0}, {2, 0}, {3, 0} };
+        Curve2D c(anchors);
+
+        if (!(is_close(c.getLength(), 3.) && is_close(c.getLength(0., 0.5), 1.5))) {
+            num_fails++;
+            printf("failed test 1\n");
+        }
+
+        // test 2: the lengths of complementary ranges add up
+        Curve2D d(randomAnchors2D(8));
+        BEZ_DTYPE t = randomUniform(0., 1.);
+
+        if (!is_close(d.getLength(0., t) + d.getLength(t, 1.), d.getLength(),
+                      LENGTH_ERROR_TOLERANCE)) {
+            num_fails++;
+            printf("failed test 2\n");
+        }
+    }
+
+    if (num_fails == 0) {
+        printf("all %d tests passed\n", num_tests);
+    }
+    else {
+        printf("failed %d/%d tests\n", num_fails, num_tests);
+    }
+    num_tests = num_fails = -1;
+
+
+    //*************************************************************************
+    printf("\nTesting function Curve2D::positionAtDistance:\n");
+    //*************************************************************************
+    num_tests = 5;
+    num_fails = 0;
+
+    for (i = 0; i < num_tests; i++) {
+        Curve2D c(randomAnchors2D(6));
+        ArcLengthCursor cursor;
+        BEZ_DTYPE s;
+        failed = BEZ_FALSE;
+
+        // the endpoints are the first and last anchors
+        if (!(is_close(distance2D(c.positionAtDistance(0.), c.getAnchor(0)), 0.) &&
+              is_close(distance2D(c.positionAtDistance(c.getLength()), c.getAnchor(5)), 0.))) {
+            failed = BEZ_TRUE;
+            printf("failed test: endpoints do not match anchors\n");
+        }
+
+        // the cursor must not change the result
+        for (s = 0.; s < c.getLength(); s += c.getLength() * 0.0123) {
+            if (!is_close(distance2D(c.positionAtDistance(s),
+                                     c.positionAtDistance(s, cursor)), 0.)) {
+                failed = BEZ_TRUE;
+                printf("failed test: cursor lookup differs from binary search\n");
+                break;
+            }
+        }
+
+        // moving the cursor backwards still finds the right point
+        s = c.getLength() * 0.25;
+        if (!is_close(distance2D(c.positionAtDistance(s),
+                                 c.positionAtDistance(s, cursor)), 0.)) {
+            failed = BEZ_TRUE;
+            printf("failed test: cursor lookup differs after moving backwards\n");
+        }
+
+        if (failed) {
+            num_fails++;
+        }
+    }
+
+    if (num_fails == 0) {
+        printf("all %d tests passed\n", num_tests);
+    }
+    else {
+        printf("failed %d/%d tests\n", num_fails, num_tests);
+    }
+    num_tests = num_fails = -1;
+
+
+    //*************************************************************************
+    printf("\nTesting function Curve2D::resampleByArcLength:\n");
+    //*************************************************************************
+    num_tests = 5;
+    num_fails = 0;
+
+    for (i = 0; i < num_tests; i++) {
+        Curve2D c(randomAnchors2D(5));
+        std::vector<bezVect2D> samples;
+        BEZ_DTYPE spacing = c.getLength() / 200.;
+        BEZ_DTYPE travelled = 0.;
+
+        c.resampleByArcLength(spacing, samples);
+
+        // consecutive samples are one spacing apart along the curve, so the
+        // polyline through them is never longer than the curve
+        for (j = 1; j < samples.size(); j++) {
+            travelled += distance2D(samples[j - 1], samples[j]);
+        }
+
+        if (samples.size() != 201 && samples.size() != 200) {
+            num_fails++;
+            printf("failed test %d: wrong number of samples\n", i + 1);
+        }
+        else if (!is_close(travelled / ((samples.size() - 1) * spacing), 1., LENGTH_ERROR_TOLERANCE)) {
+            num_fails++;
+            printf("failed test %d: samples are not evenly spaced\n", i + 1);
+        }
+    }
+
+    if (num_fails == 0) {
+        printf("all %d tests passed\n", num_tests);
+    }
+    else {
+        printf("failed %d/%d tests\n", num_fails, num_tests);
+    }
+    num_tests = num_fails = -1;
+
+
+    //*************************************************************************
+    printf("\nTesting class Curve3D:\n");
+    //*************************************************************************
+    num_tests = 5;
+    num_fails = 0;
+
+    for (i = 0; i < num_tests; i++) {
+        std::vector<bezVect2D> anchors2 = randomAnchors2D(7);
+        std::vector<bezVect3D> anchors3(anchors2.size());
+        BEZ_DTYPE t = randomUniform(0., 1.);
+
+        for (j = 0; j < anchors2.size(); j++) {
+            anchors3[j] = bezVect3D{ anchors2[j][0], anchors2[j][1], 0. };
+        }
+
+        // a planar 3D spline must match the 2D spline through the same anchors
+        Curve2D c2(anchors2);
+        Curve3D c3(anchors3);
+        bezVect2D p2 = c2.getPositionAt(t);
+        bezVect3D p3 = c3.getPositionAt(t);
+
+        if (!(is_close(p2[0], p3[0]) && is_close(p2[1], p3[1]) && is_close(p3[2], 0.) &&
+              is_close(c2.getLength(), c3.getLength(), LENGTH_ERROR_TOLERANCE))) {
+            num_fails++;
+            printf("failed test %d\n", i + 1);
+        }
+    }
+
+    if (num_fails == 0) {
+        printf("all %d tests passed\n", num_tests);
+    }
+    else {
+        printf("failed %d/%d tests\n", num_fails, num_tests);
+    }
+    num_tests = num_fails = -1;
+
+
+    //*************************************************************************
+    printf("\nTesting functions Curve2D::addAnchor/removeAnchor:\n");
+    //*************************************************************************
+    num_tests = 5;
+    num_fails = 0;
+
+    for (i = 0; i < num_tests; i++) {
+        std::vector<bezVect2D> anchors = randomAnchors2D(6);
+        std::size_t index = rand() % anchors.size();
+        bezVect2D removed = anchors[index];
+        BEZ_DTYPE t = randomUniform(0., 1.);
+        failed = BEZ_FALSE;
+
+        Curve2D expected(anchors);
+        anchors.erase(anchors.begin() + index);
+        Curve2D c(anchors);
+
+        // inserting the missing anchor reproduces the full spline
+        c.addAnchor(removed, index);
+        if (!is_close(distance2D(c.getPositionAt(t), expected.getPositionAt(t)), 0.)) {
+            failed = BEZ_TRUE;
+            printf("failed test: addAnchor does not match constructor\n");
+        }
+
+        // and removing it again gives back the shorter one
+        c.removeAnchor(index);
+        Curve2D shorter(anchors);
+        if (!(c.anchorCount() == anchors.size() &&
+              is_close(distance2D(c.getPositionAt(t), shorter.getPositionAt(t)), 0.))) {
+            failed = BEZ_TRUE;
+            printf("failed test: removeAnchor does not match constructor\n");
+        }
+
+        if (failed) {
+            num_fails++;
+        }
+    }
+
+    if (num_fails == 0) {
+        printf("all %d tests passed\n", num_tests);
+    }
+    else {
+        printf("failed %d/%d tests\n", num_fails, num_tests);
+    }
+    num_tests = num_fails = -1;
+
+
+    //*************************************************************************
+    printf("\nTesting function Curve2D::updateControlPoints(ThreadPool&):\n");
+    //*************************************************************************
+    {
+        std::size_t sizes[] = { 3, 4, 5, 9, 17, 100, 1000, 100000 };
+        ThreadPool pool(4);
+
+        num_tests = sizeof(sizes) / sizeof(sizes[0]) + 1;
+        num_fails = 0;
+
+        for (i = 0; i < num_tests - 1; i++) {
+            Curve2D serial(randomAnchors2D(sizes[i]));
+            Curve2D parallel = serial;
+            failed = BEZ_FALSE;
+
+            parallel.updateControlPoints(pool);
+
+            // the chunked solve only reorders rounding, so it must agree
+            // closely with the serial sweep at every control point
+            for (j = 0; j < serial.points.size(); j++) {
+                if (!is_close(distance2D(serial.points[j], parallel.points[j]), 0.)) {
+                    failed = BEZ_TRUE;
+                }
+            }
+
+            if (failed) {
+                num_fails++;
+                printf("failed test %d: %zu anchors\n", i + 1, sizes[i]);
+            }
+        }
+
+        // a task of the pool solving on the same pool runs that solve
+        // serially rather than waiting on itself
+        Curve2D serial(randomAnchors2D(1000));
+        std::vector<Curve2D> nested(8, serial);
+        failed = BEZ_FALSE;
+
+        pool.run(nested.size(), [&](std::size_t k) { nested[k].updateControlPoints(pool); });
+        for (const Curve2D& c : nested) {
+            for (j = 0; j < serial.points.size(); j++) {
+                if (!is_close(distance2D(serial.points[j], c.points[j]), 0.)) {
+                    failed = BEZ_TRUE;
+                }
+            }
+        }
+
+        if (failed) {
+            num_fails++;
+            printf("failed test %d: nested in a task of the pool\n", num_tests);
+        }
+    }
+
+    if (num_fails == 0) {
+        printf("all %d tests passed\n", num_tests);
+    }
+    else {
+        printf("failed %d/%d tests\n", num_fails, num_tests);
+    }
+    num_tests = num_fails = -1;
+
+
+    //*************************************************************************
+    printf("\nTesting curve_layout.h kernels:\n");
+    //*************************************************************************
+    num_tests = 6;
+    num_fails = 0;
+
+    for (i = 0; i < num_tests - 1; i++) {
+        Curve2D c(randomAnchors2D(9 + 3 * i));  // whole and partial groups of SIMD lanes
+        CurveInterleavedView<2, BEZ_DTYPE> view(c);
+        CurveSoA<2, BEZ_DTYPE> soa(c);
+        CurvePacked<2, BEZ_DTYPE> packed(c);
+        std::vector<bezVect2D> tess[3];
+        std::vector<bezVect2D> mins[3], maxs[3];
+        std::vector<bezVect2D> evals[3];
+        std::vector<std::size_t> segments;
+        std::vector<BEZ_DTYPE> ts;
+        std::size_t k;
+        BEZ_DTYPE x_min, y_min, x_max, y_max;
+        failed = BEZ_FALSE;
+
+        for (j = 0; j < 50; j++) {
+            segments.push_back(rand() % c.bezier_count);
+            ts.push_back(randomUniform(0., 1.));
+        }
+
+        for (k = 0; k < 3; k++) {
+            mins[k].resize(c.bezier_count);
+            maxs[k].resize(c.bezier_count);
+            evals[k].resize(segments.size());
+        }
+
+        tessellate(view, 10, tess[0]);
+        tessellate(soa, 10, tess[1]);
+        tessellate(packed, 10, tess[2]);
+        segmentBoundingBoxes(view, mins[0].data(), maxs[0].data());
+        segmentBoundingBoxes(soa, mins[1].data(), maxs[1].data());
+        segmentBoundingBoxes(packed, mins[2].data(), maxs[2].data());
+        evaluateSegments(view, segments.data(), ts.data(), ts.size(), evals[0].data());
+        evaluateSegments(soa, segments.data(), ts.data(), ts.size(), evals[1].data());
+        evaluateSegments(packed, segments.data(), ts.data(), ts.size(), evals[2].data());
+
+        if ((std::size_t)(packed.data.data()) % BEZ_PACKED_ALIGNMENT != 0) {
+            failed = BEZ_TRUE;
+            printf("failed test: packed layout is misaligned\n");
+        }
+
+        // every layout matches the Curve itself
+        for (k = 0; k < 3; k++) {
+            for (j = 0; j < tess[k].size(); j++) {
+                bezVect2D expected = j + 1 < tess[k].size() ?
+                    c.evaluateSegment(j / 10, (BEZ_DTYPE)(j % 10) / 10.) :
+                    c.getAnchor(c.anchorCount() - 1);
+
+                if (!is_close(distance2D(tess[k][j], expected), 0.)) {
+                    failed = BEZ_TRUE;
+                }
+            }
+
+            for (j = 0; j < segments.size(); j++) {
+                if (!is_close(distance2D(evals[k][j], c.evaluateSegment(segments[j], ts[j])), 0.)) {
+                    failed = BEZ_TRUE;
+                }
+            }
+
+            for (j = 0; j < c.bezier_count; j++) {
+                const bezVect2D* p = &c.points[3 * j];
+
+                bez2BoundingBox(p[0][0], p[0][1], p[1][0], p[1][1],
+                                p[2][0], p[2][1], p[3][0], p[3][1],
+                                &x_min, &y_min, &x_max, &y_max);
+
+                if (!(is_close(mins[k][j][0], x_min) && is_close(mins[k][j][1], y_min) &&
+                      is_close(maxs[k][j][0], x_max) && is_close(maxs[k][j][1], y_max))) {
+                    failed = BEZ_TRUE;
+                }
+            }
+        }
+
+        if (failed) {
+            num_fails++;
+            printf("failed test %d\n", i + 1);
+        }
+    }
+
+    {
+        // without a quadratic term the derivative of x has its root at
+        // t = 0.5, where x = 0.75, and that of y has none
+        const bezVect2D points[4] = {{0., 0.}, {1., 1.}, {1., 2.}, {0., 3.}};
+        bezVect2D min, max;
+        BEZ_DTYPE x_min, y_min, x_max, y_max;
+        failed = BEZ_FALSE;
+
+        segmentBoundingBoxes(CurveInterleavedView<2, BEZ_DTYPE>(points, 1), &min, &max);
+        bez2BoundingBox(points[0][0], points[0][1], points[1][0], points[1][1],
+                        points[2][0], points[2][1], points[3][0], points[3][1],
+                        &x_min, &y_min, &x_max, &y_max);
+
+        if (!(is_close(x_min, 0.) && is_close(y_min, 0.) && is_close(x_max, 0.75) && is_close(y_max, 3.)) ||
+            !(is_close(min[0], x_min) && is_close(min[1], y_min) &&
+              is_close(max[0], x_max) && is_close(max[1], y_max))) {
+            failed = BEZ_TRUE;
+        }
+
+        if (failed) {
+            num_fails++;
+            printf("failed test %d: derivative without a quadratic term\n", num_tests);
+        }
+    }
+
+    if (num_fails == 0) {
+        printf("all %d tests passed\n", num_tests);
+    }
+    else {
+        printf("failed %d/%d tests\n", num_fails, num_tests);
+    }
+    num_tests = num_fails = -1;
+
+
+    //*************************************************************************
+    printf("\nTesting lazy updates after Curve2D::setAnchor:\n");
+    //*************************************************************************
+    num_tests = 5;
+    num_fails = 0;
+
+    for (i = 0; i < num_tests; i++) {
+        std::size_t n = i < 2 ? 10 : 2000;  // full and windowed re-solve
+        std::vector<bezVect2D> anchors = randomAnchors2D(n);
+        Curve2D c(anchors);
+        std::size_t k;
+        failed = BEZ_FALSE;
+
+        // batch several nearby edits, then read once
+        for (k = 0; k < 4; k++) {
+            std::size_t index = (n / 3 + 7 * k) % n;
+            anchors[index][0] += randomUniform(-1., 1.);
+            anchors[index][1] += randomUniform(-1., 1.);
+            c.setAnchor(anchors[index], index);
+        }
+        c.moveAnchor(bezVect2D{ 0.5, -0.5 }, 0);
+        anchors[0][0] += 0.5;
+        anchors[0][1] -= 0.5;
+
+        c.getPositionAt(0.5);
+
+        // reading brought every control point up to date
+        Curve2D expected(anchors);
+        for (j = 0; j < c.points.size(); j++) {
+            if (!is_close(distance2D(c.points[j], expected.points[j]), 0.)) {
+                failed = BEZ_TRUE;
+            }
+        }
+
+        if (failed) {
+            num_fails++;
+            printf("failed test %d\n", i + 1);
+        }
+    }
+
+    if (num_fails == 0) {
+        printf("all %d tests passed\n", num_tests);
+    }
+    else {
+        printf("failed %d/%d tests\n", num_fails, num_tests);
+    }
+    num_tests = num_fails = -1;
+
+
+    //*************************************************************************
+    printf("\nTesting closed Curve2D:\n");
+    //*************************************************************************
+    num_tests = 5;
+    num_fails = 0;
+
+    for (i = 0; i < num_tests; i++) {
+        std::size_t n = i < 3 ? i + 2 : 500;
+        std::vector<bezVect2D> anchors = randomAnchors2D(n);
+        Curve2D c(anchors, true);
+        std::size_t k;
+        failed = BEZ_FALSE;
+
+        if (i == 4) {
+            // edits far from and next to the seam, then an insertion
+            for (k = 0; k < n; k += 97) {
+                anchors[k][0] += randomUniform(-1., 1.);
+                c.setAnchor(anchors[k], k);
+                c.getPositionAt(0.5);
+            }
+            anchors.insert(anchors.begin(), bezVect2D{ 3., 4. });
+            c.addAnchor(bezVect2D{ 3., 4. }, 0);
+            n++;
+            c.updateControlPoints();
+
+            Curve2D expected(anchors, true);
+            for (j = 0; j < c.points.size(); j++) {
+                if (!is_close(distance2D(c.points[j], expected.points[j]), 0.)) {
+                    failed = BEZ_TRUE;
+                }
+            }
+        }
+
+        // every joint, including the seam, is C2 continuous
+        for (j = 0; j < n; j++) {
+            const bezVect2D* p = &c.points[3 * j];
+            const bezVect2D* q = &c.points[3 * ((j + 1) % n)];
+            std::size_t d;
+
+            for (d = 0; d < 2; d++) {
+                BEZ_DTYPE d1_end = 3. * (p[3][d] - p[2][d]);
+                BEZ_DTYPE d1_start = 3. * (q[1][d] - q[0][d]);
+                BEZ_DTYPE d2_end = 6. * (p[3][d] - 2. * p[2][d] + p[1][d]);
+                BEZ_DTYPE d2_start = 6. * (q[0][d] - 2. * q[1][d] + q[2][d]);
+
+                if (!is_close(d1_end, d1_start, 1e-2) || !is_close(d2_end, d2_start, 1e-2)) {
+                    failed = BEZ_TRUE;
+                }
+            }
+        }
+
+        // evaluation and distance both wrap around
+        if (distance2D(c.getPositionAt(1.), c.getPositionAt(0.)) > 1e-3 ||
+            distance2D(c.getPositionAt(1.25), c.getPositionAt(0.25)) > 1e-3 ||
+            distance2D(c.positionAtDistance(c.getLength() + 1.), c.positionAtDistance(1.)) > 1e-2) {
+            failed = BEZ_TRUE;
+        }
+
+        if (failed) {
+            num_fails++;
+            printf("failed test %d\n", i + 1);
+        }
+    }
+
+    if (num_fails == 0) {
+        printf("all %d tests passed\n", num_tests);
+    }
+    else {
+        printf("failed %d/%d tests\n", num_fails, num_tests);
+    }
+    num_tests = num_fails = -1;
+
+
+    //*************************************************************************
+    printf("\nTesting Curve2D switched back to open and uniform:\n");
+    //*************************************************************************
+    num_tests = 2;
+    num_fails = 0;
+
+    for (i = 0; i < num_tests; i++) {
+        // three anchor points read the first row of the solver's state, which
+        // the closed and non-uniform solves leave behind
+        std::vector<bezVect2D> anchors = { bezVect2D{ 0., 0. }, bezVect2D{ 1., 3. }, bezVect2D{ 4., 0. } };
+        Curve2D c(anchors, i == 0, i == 0 ? BEZ_UNIFORM : BEZ_CHORD_LENGTH);
+        Curve2D expected(anchors);
+        failed = BEZ_FALSE;
+
+        c.updateControlPoints();
+        if (i == 0) {
+            c.setClosed(false);
+        }
+        else {
+            c.setParameterization(BEZ_UNIFORM);
+        }
+        c.updateControlPoints();
+
+        if (c.points.size() != expected.points.size()) {
+            failed = BEZ_TRUE;
+        }
+        else {
+            for (j = 0; j < c.points.size(); j++) {
+                if (!is_close(distance2D(c.points[j], expected.points[j]), 0.)) {
+                    failed = BEZ_TRUE;
+                }
+            }
+        }
+
+        if (failed) {
+            num_fails++;
+            printf("failed test %d: from %s\n", i + 1, i == 0 ? "closed" : "chord-length");
+        }
+    }
+
+    if (num_fails == 0) {
+        printf("all %d tests passed\n", num_tests);
+    }
+    else {
+        printf("failed %d/%d tests\n", num_fails, num_tests);
+    }
+    num_tests = num_fails = -1;
+
+
+    //*************************************************************************
+    printf("\nTesting chord-length and centripetal Curve2D:\n");
+    //*************************************************************************
+    num_tests = 5;
+    num_fails = 0;
+
+    for (i = 0; i < num_tests; i++) {
+        bezParameterization param = i % 2 ? BEZ_CENTRIPETAL : BEZ_CHORD_LENGTH;
+        std::size_t n = 50;
+        std::vector<bezVect2D> anchors(n);
+        failed = BEZ_FALSE;
+
+        if (i < 2) {
+            // equal chords give the same control points as BEZ_UNIFORM
+            for (j = 0; j < n; j++) {
+                if (i == 0) {
+                    anchors[j][0] = (BEZ_DTYPE)(j);
+                    anchors[j][1] = (BEZ_DTYPE)(j % 2);
+                }
+                else {
+                    anchors[j][0] = 10. * cos(6.283185307 * j / n);
+                    anchors[j][1] = 10. * sin(6.283185307 * j / n);
+                }
+            }
+            Curve2D c(anchors, i == 1, param);
+            Curve2D uniform(anchors, i == 1);
+
+            for (j = 0; j < c.points.size(); j++) {
+                if (!is_close(distance2D(c.points[j], uniform.points[j]), 0., 1e-3)) {
+                    failed = BEZ_TRUE;
+                }
+            }
+        }
+        else {
+            anchors = randomAnchors2D(n);
+            Curve2D c(anchors, i == 4, param);
+            std::size_t m = c.bezier_count;
+
+            // coincident anchor points leave the rest of the spline finite
+            std::vector<bezVect2D> repeated(anchors);
+            repeated[7] = repeated[6];
+            Curve2D degenerate(repeated, i == 4, param);
+            for (j = 0; j < degenerate.points.size(); j++) {
+                if (!std::isfinite(degenerate.points[j][0]) || !std::isfinite(degenerate.points[j][1])) {
+                    failed = BEZ_TRUE;
+                }
+            }
+
+            // C2 continuous with respect to t at every joint
+            for (j = 0; j + 1 < m || (c.isClosed() && j < m); j++) {
+                const bezVect2D* p = &c.points[3 * j];
+                const bezVect2D* q = &c.points[3 * ((j + 1) % m)];
+                BEZ_DTYPE h0 = c.knots[j + 1] - c.knots[j];
+                BEZ_DTYPE h1 = c.knots[(j + 1) % m + 1] - c.knots[(j + 1) % m];
+                std::size_t d;
+
+                for (d = 0; d < 2; d++) {
+                    BEZ_DTYPE d1_end = 3. * (p[3][d] - p[2][d]) / h0;
+                    BEZ_DTYPE d1_start = 3. * (q[1][d] - q[0][d]) / h1;
+                    BEZ_DTYPE d2_end = 6. * (p[3][d] - 2. * p[2][d] + p[1][d]) / (h0 * h0);
+                    BEZ_DTYPE d2_start = 6. * (q[0][d] - 2. * q[1][d] + q[2][d]) / (h1 * h1);
+
+                    if (!(fabs(d1_end - d1_start) <= 1e-3 * (fabs(d1_end) + 1.)) ||
+                        !(fabs(d2_end - d2_start) <= 1e-2 * (fabs(d2_end) + 1.))) {
+                        failed = BEZ_TRUE;
+                    }
+                }
+            }
+
+            // each knot maps to its anchor point
+            for (j = 0; j < n; j++) {
+                if (!is_close(distance2D(c.getPositionAt(c.knots[j]), anchors[j]), 0., 1e-3)) {
+                    failed = BEZ_TRUE;
+                }
+            }
+        }
+
+        if (failed) {
+            num_fails++;
+            printf("failed test %d\n", i + 1);
+        }
+    }
+
+    if (num_fails == 0) {
+        printf("all %d tests passed\n", num_tests);
+    }
+    else {
+        printf("failed %d/%d tests\n", num_fails, num_tests);
+    }
+    num_tests = num_fails = -1;
+
+
+    //*************************************************************************
+    printf("\nTesting CurveView and Curve2D::split:\n");
+    //*************************************************************************
+    num_tests = 5;
+    num_fails = 0;
+
+    for (i = 0; i < num_tests; i++) {
+        std::vector<bezVect2D> anchors = randomAnchors2D(20);
+        Curve2D c(anchors);
+        BEZ_DTYPE t0 = randomUniform(0., .5);
+        BEZ_DTYPE t1 = i == 0 ? t0 + .01 : randomUniform(.5, 1.);
+        failed = BEZ_FALSE;
+
+        // the view covers exactly [t0, t1] of the spline
+        CurveView2D view(c, t0, t1);
+        if (!is_close(distance2D(view.getPositionAt(0.), c.getPositionAt(t0)), 0., 1e-3) ||
+            !is_close(distance2D(view.getPositionAt(1.), c.getPositionAt(t1)), 0., 1e-3) ||
+            !is_close(view.getLength(), c.getLength(t0, t1), LENGTH_ERROR_TOLERANCE * c.getLength(t0, t1) + 1e-3)) {
+            failed = BEZ_TRUE;
+        }
+
+        // split reuses the capacity of its outputs
+        Curve2D c1(randomAnchors2D(40)), c2;
+        const bezVect2D* storage = c1.points.data();
+        BEZ_DTYPE t = randomUniform(0., 1.);
+
+        c.split(t, c1, c2);
+        if (c1.points.data() != storage ||
+            c1.anchorCount() + c2.anchorCount() < c.anchorCount() + 1 ||
+            !is_close(distance2D(c1.getPositionAt(1.), c.getPositionAt(t)), 0., 1e-3) ||
+            !is_close(distance2D(c2.getPositionAt(0.), c.getPositionAt(t)), 0., 1e-3) ||
+            !is_close(distance2D(c2.getPositionAt(1.), c.getPositionAt(1.)), 0., 1e-3) ||
+            !is_close(c1.getLength() + c2.getLength(), c.getLength(), LENGTH_ERROR_TOLERANCE * c.getLength())) {
+            failed = BEZ_TRUE;
+        }
+
+        // whole Bezier curves before the split are copied unchanged
+        for (j = 0; j + 4 < c1.points.size(); j++) {
+            if (c1.points[j] != c.points[j]) {
+                failed = BEZ_TRUE;
+            }
+        }
+
+        // either output may be the spline being split
+        Curve2D self(anchors), other;
+        self.split(t, self, other);
+        for (j = 0; j < c1.points.size(); j++) {
+            if (!is_close(distance2D(self.points[j], c1.points[j]), 0.)) {
+                failed = BEZ_TRUE;
+            }
+        }
+        Curve2D self2(anchors);
+        self2.split(t, other, self2);
+        for (j = 0; j < c2.points.size(); j++) {
+            if (!is_close(distance2D(self2.points[j], c2.points[j]), 0.)) {
+                failed = BEZ_TRUE;
+            }
+        }
+
+        // editing an output solves it from scratch
+        c2.setAnchor(c2.getAnchor(0), 0);
+        std::vector<bezVect2D> c2_anchors;
+        for (j = 0; j < c2.anchorCount(); j++) {
+            c2_anchors.push_back(c2.getAnchor(j));
+        }
+        Curve2D expected(c2_anchors);
+        c2.updateControlPoints();
+        for (j = 0; j < c2.points.size(); j++) {
+            if (!is_close(distance2D(c2.points[j], expected.points[j]), 0., 1e-3)) {
+                failed = BEZ_TRUE;
+            }
+        }
+
+        if (failed) {
+            num_fails++;
+            printf("failed test %d\n", i + 1);
+        }
+    }
+
+    if (num_fails == 0) {
+        printf("all %d tests passed\n", num_tests);
+    }
+    else {
+        printf("failed %d/%d tests\n", num_fails, num_tests);
+    }
+    num_tests = num_fails = -1;
+
+
+    //*************************************************************************
+    printf("\nTesting CurvePublisher with concurrent readers:\n");
+    //*************************************************************************
+    num_tests = 4;
+    num_fails = 0;
+
+    for (i = 0; i < num_tests; i++) {
+        // Every published spline is flat at y = version, so a snapshot mixing
+        // two versions, or one overwritten while read, has y varying along it
+        std::size_t n = 200;
+        std::vector<bezVect2D> anchors(n);
+        for (j = 0; j < n; j++) {
+            anchors[j] = bezVect2D{ (BEZ_DTYPE)(j), 1. };
+        }
+
+        CurvePublisher2D publisher(Curve2D(anchors), 8);
+        std::atomic<bool> done(false);
+        std::atomic<int> torn(0);
+        std::vector<std::thread> readers;
+        std::size_t r;
+
+        for (r = 0; r < (std::size_t)(i) + 1; r++) {
+            readers.emplace_back([&] {
+                std::size_t reader = publisher.registerReader();
+                BEZ_DTYPE last_version = 0.;
+
+                while (!done.load()) {
+                    CurvePublisher2D::Snapshot snapshot = publisher.read(reader);
+                    BEZ_DTYPE version = snapshot->getAnchor(0)[1];
+
+                    if (version < last_version ||
+                        snapshot->getAnchor(n - 1)[1] != version ||
+                        !is_close(snapshot->getPositionAt(.37)[1], version, 1e-2) ||
+                        !is_close(snapshot->getLength(), (BEZ_DTYPE)(n - 1), 1e-2)) {
+                        torn++;
+                    }
+                    last_version = version;
+                }
+            });
+        }
+
+        for (j = 2; j <= 300; j++) {
+            std::size_t k;
+
+            for (k = 0; k < n; k++) {
+                publisher.edit().setAnchor(bezVect2D{ (BEZ_DTYPE)(k), (BEZ_DTYPE)(j) }, k);
+            }
+            publisher.publish();
+        }
+
+        done = true;
+        for (std::thread& reader : readers) {
+            reader.join();
+        }
+
+        if (torn.load() > 0 || publisher.version() != 300 ||
+            publisher.read(publisher.registerReader())->getAnchor(0)[1] != 300.) {
+            num_fails++;
+            printf("failed test %d: %d inconsistent snapshots\n", i + 1, torn.load());
+        }
+    }
+
+    if (num_fails == 0) {
+        printf("all %d tests passed\n", num_tests);
+    }
+    else {
+        printf("failed %d/%d tests\n", num_fails, num_tests);
+    }
+    num_tests = num_fails = -1;
+
+
+    //*************************************************************************
+    printf("\nTesting StreamingCurve against Curve2D:\n");
+    //*************************************************************************
+    num_tests = 6;
+    num_fails = 0;
+
+    for (i = 0; i < num_tests; i++) {
+        // The first three tests never fill the buffer, so the whole stream is
+        // compared; the last three retire anchor points and compare the
+        // Bezier curves still kept with the same ones of the full spline
+        std::size_t n = 2 + 150 * i;
+        std::size_t capacity = i < 3 ? n + 1 : 64;
+        std::vector<bezVect2D> anchors = randomAnchors2D(n);
+        StreamingCurve2D stream(capacity);
+        Curve2D full(anchors);
+        const StreamingCurve2D::Slot* storage = stream.ring.data();
+        failed = BEZ_FALSE;
+
+        for (j = 0; j < n; j++) {
+            stream.append(anchors[j]);
+        }
+        full.updateControlPoints();
+
+        std::size_t kept = n < capacity ? n : capacity;
+        std::size_t offset = n - kept;
+
+        if (stream.anchorCount() != kept || stream.streamLength() != n ||
+            stream.ring.data() != storage || stream.ring.size() != capacity) {
+            failed = BEZ_TRUE;
+        }
+        for (j = 0; j < stream.segmentCount() && !failed; j++) {
+            std::size_t p, k;
+            for (p = 0; p < 4; p++) {
+                for (k = 0; k < 2; k++) {
+                    if (!is_close(stream.get(j, p, k), full.points[3 * (offset + j) + p][k], 1e-3)) {
+                        failed = BEZ_TRUE;
+                    }
+                }
+            }
+        }
+        if (!failed && kept > 1) {
+            bezVect2D last = stream.getPositionAt(1.);
+            if (!is_close(last[0], anchors[n - 1][0], 1e-4) ||
+                !is_close(last[1], anchors[n - 1][1], 1e-4)) {
+                failed = BEZ_TRUE;
+            }
+        }
+
+        if (failed) {
+            num_fails++;
+            printf("failed test %d\n", i + 1);
+        }
+    }
+
+    if (num_fails == 0) {
+        printf("all %d tests passed\n", num_tests);
+    }
+    else {
+        printf("failed %d/%d tests\n", num_fails, num_tests);
+    }
+    num_tests = num_fails = -1;
+
+
+    //*************************************************************************
+    printf("\nTesting Curve2D allocated from a FrameArena:\n");
+    //*************************************************************************
+    num_tests = 4;
+    num_fails = 0;
+
+    {
+        CountingResource upstream;
+        FrameArena arena(1024, &upstream);
+        std::size_t first_frame_allocations = 0;
+
+        // Frames of short-lived splines of the same sizes: only the first
+        // frame may outgrow the arena and reach the upstream resource
+        for (i = 0; i < num_tests; i++) {
+            std::size_t before = upstream.allocations;
+            std::size_t k;
+            failed = BEZ_FALSE;
+
+            for (k = 0; k < 20; k++) {
+                std::vector<bezVect2D> anchors = randomAnchors2D(10 + k);
+                Curve2D expected(anchors);
+                Curve2D c(anchors, false, BEZ_UNIFORM, &arena);
+
+                c.addAnchor(bezVect2D{ 1., 2. }, 3);
+                expected.addAnchor(bezVect2D{ 1., 2. }, 3);
+                c.setParameterization(BEZ_CHORD_LENGTH);
+                expected.setParameterization(BEZ_CHORD_LENGTH);
+                c.getLength();
+                expected.getLength();
+
+                // a copy into the arena, and a plain copy out of it
+                Curve2D copy(c, &arena);
+                Curve2D escaped(c);
+
+                if (c.getResource() != &arena || copy.getResource() != &arena ||
+                    escaped.getResource() != std::pmr::get_default_resource() ||
+                    c.knots.get_allocator().resource() != &arena ||
+                    c.arc_lengths.get_allocator().resource() != &arena) {
+                    failed = BEZ_TRUE;
+                }
+                for (j = 0; j < c.points.size(); j++) {
+                    if (c.points[j] != expected.points[j] || copy.points[j] != c.points[j]) {
+                        failed = BEZ_TRUE;
+                    }
+                }
+            }
+
+            if (i == 0) {
+                first_frame_allocations = upstream.allocations - before;
+            }
+            else if (upstream.allocations != before) {
+                failed = BEZ_TRUE;
+            }
+            if (arena.bytesUsed() == 0 || first_frame_allocations == 0) {
+                failed = BEZ_TRUE;
+            }
+
+            arena.reset();
+
+            if (failed) {
+                num_fails++;
+                printf("failed test %d\n", i + 1);
+            }
+        }
+    }
+
+    if (num_fails == 0) {
+        printf("all %d tests passed\n", num_tests);
+    }
+    else {
+        printf("failed %d/%d tests\n", num_fails, num_tests);
+    }
+    num_tests = num_fails = -1;
+
+
+    //*************************************************************************
+    printf("\nTesting CurveSet batch operations:\n");
+    //*************************************************************************
+    num_tests = 4;
+    num_fails = 0;
+
+    for (i = 0; i < num_tests; i++) {
+        std::size_t count = i < 2 ? 20 : 500;
+        std::vector<Curve2D> curves;
+        CurveSet2D set;
+        ThreadPool pool(4);
+        std::size_t k;
+        failed = BEZ_FALSE;
+
+        for (k = 0; k < count; k++) {
+            std::vector<bezVect2D> anchors = randomAnchors2D(1 + rand() % 40);
+            curves.emplace_back(anchors);
+            set.add(anchors);
+        }
+
+        // edits after the first rebuild only re-solve the edited splines
+        if (i % 2) {
+            set.rebuild();
+            for (k = 0; k < count; k += 7) {
+                bezVect2D moved = set.getAnchor(k, 0);
+                moved[0] += 1.;
+                set.setAnchor(k, 0, moved);
+                curves[k].setAnchor(moved, 0);
+            }
+        }
+        if (i < 2) {
+            set.rebuild();
+        }
+        else {
+            set.rebuild(pool);
+        }
+
+        std::vector<std::size_t> queries;
+        std::vector<BEZ_DTYPE> ts;
+        for (k = 0; k < 1000; k++) {
+            queries.push_back(rand() % count);
+            ts.push_back(randomUniform(0., 1.));
+        }
+        std::vector<bezVect2D> evals(queries.size());
+        std::vector<bezVect2D> mins(count), maxs(count);
+        std::vector<bezVect2D> seg_mins(set.segmentCount()), seg_maxs(set.segmentCount());
+        std::vector<bezVect2D> polylines;
+        std::vector<std::size_t> offsets;
+
+        set.evaluate(queries.data(), ts.data(), queries.size(), evals.data());
+        set.boundingBoxes(mins.data(), maxs.data());
+        set.segmentBoundingBoxes(seg_mins.data(), seg_maxs.data());
+        set.tessellate(8, polylines, offsets);
+
+        // the stored points match a Curve2D built from the same anchors
+        for (k = 0; k < count; k++) {
+            curves[k].updateControlPoints();
+            for (j = 0; j < curves[k].points.size(); j++) {
+                if (!is_close(distance2D(set.points[set.point_offsets[k] + j], curves[k].points[j]), 0., 1e-3)) {
+                    failed = BEZ_TRUE;
+                }
+            }
+        }
+        for (k = 0; k < queries.size(); k++) {
+            if (!is_close(distance2D(evals[k], curves[queries[k]].getPositionAt(ts[k])), 0., 1e-3)) {
+                failed = BEZ_TRUE;
+            }
+        }
+
+        // every polyline lies in the box of its spline and of its segment
+        if (offsets.size() != count + 1 || offsets[count] != polylines.size()) {
+            failed = BEZ_TRUE;
+        }
+        for (k = 0; k < count && !failed; k++) {
+            std::size_t segments = set.anchorCount(k) - 1;
+
+            for (j = offsets[k]; j < offsets[k + 1]; j++) {
+                std::size_t s = set.segment_offsets[k] + std::min((j - offsets[k]) / 8, segments ? segments - 1 : 0);
+                std::size_t d;
+
+                for (d = 0; d < 2; d++) {
+                    if (polylines[j][d] < mins[k][d] - 1e-4 || polylines[j][d] > maxs[k][d] + 1e-4 ||
+                        (segments > 0 && (polylines[j][d] < seg_mins[s][d] - 1e-4 ||
+                                          polylines[j][d] > seg_maxs[s][d] + 1e-4))) {
+                        failed = BEZ_TRUE;
+                    }
+                }
+            }
+            if (polylines[offsets[k + 1] - 1] != set.getAnchor(k, set.anchorCount(k) - 1)) {
+                failed = BEZ_TRUE;
+            }
+        }
+
+        if (failed) {
+            num_fails++;
+            printf("failed test %d\n", i + 1);
+        }
+    }
+
+    if (num_fails == 0) {
+        printf("all %d tests passed\n", num_tests);
+    }
+    else {
+        printf("failed %d/%d tests\n", num_fails, num_tests);
+    }
+    num_tests = num_fails = -1;
+
+
+    //*************************************************************************
+    printf("\nTesting writeCurveFile and MappedCurve:\n");
+    //*************************************************************************
+    num_tests = 5;
+    num_fails = 0;
+
+    for (i = 0; i < num_tests - 1; i++) {
+        const char* path = "curve_test.bin";
+        std::vector<bezVect2D> anchors = randomAnchors2D(100);
+        Curve2D c(anchors, i == 1, i == 1 ? BEZ_CHORD_LENGTH : BEZ_UNIFORM);
+        failed = BEZ_FALSE;
+
+        writeCurveFile(c, path, i == 2 ? 0 : BEZ_CURVE_FILE_BOXES | BEZ_CURVE_FILE_ARC_LENGTHS);
+
+        if (i < 3) {
+            MappedCurve2D mapped(path);
+            const bezVect2D* p = mapped.points();
+
+            if (mapped.anchorCount() != c.anchorCount() || mapped.segmentCount() != c.bezier_count ||
+                mapped.isClosed() != c.isClosed() || mapped.getParameterization() != c.getParameterization() ||
+                (std::size_t)(p) % BEZ_CURVE_FILE_ALIGNMENT != 0) {
+                failed = BEZ_TRUE;
+            }
+            for (j = 0; j < c.points.size(); j++) {
+                if (p[j] != c.points[j]) {
+                    failed = BEZ_TRUE;
+                }
+            }
+
+            // cached sections match what the Curve computes itself
+            if (i == 2) {
+                if (mapped.boxMins() != nullptr || mapped.arcLengths() != nullptr) {
+                    failed = BEZ_TRUE;
+                }
+            }
+            else {
+                std::vector<bezVect2D> mins(c.bezier_count), maxs(c.bezier_count);
+                segmentBoundingBoxes(CurveInterleavedView<2, BEZ_DTYPE>(c), mins.data(), maxs.data());
+                c.getLength();
+
+                for (j = 0; j < c.bezier_count; j++) {
+                    if (mapped.boxMins()[j] != mins[j] || mapped.boxMaxs()[j] != maxs[j]) {
+                        failed = BEZ_TRUE;
+                    }
+                }
+                for (j = 0; j < c.arc_lengths.size(); j++) {
+                    if (mapped.arcLengths()[j] != c.arc_lengths[j]) {
+                        failed = BEZ_TRUE;
+                    }
+                }
+            }
+            if (i == 1) {
+                for (j = 0; j <= c.bezier_count; j++) {
+                    if (mapped.knots()[j] != c.knots[j]) {
+                        failed = BEZ_TRUE;
+                    }
+                }
+            }
+            else if (!is_close(distance2D(mapped.view().getPositionAt(.3), c.getPositionAt(.3)), 0.) ||
+                     !is_close(mapped.view().getLength(), c.getLength(), LENGTH_ERROR_TOLERANCE * c.getLength())) {
+                failed = BEZ_TRUE;
+            }
+        }
+        else {
+            // damaged files and other point types are rejected
+            FILE* file = fopen(path, "r+b");
+            int rejected = 0;
+
+            try {
+                MappedCurve3D wrong_dims(path);
+            }
+            catch (const std::runtime_error&) {
+                rejected++;
+            }
+
+            fseek(file, 0, SEEK_SET);
+            fputc('X', file);
+            fclose(file);
+            try {
+                MappedCurve2D bad_magic(path);
+            }
+            catch (const std::runtime_error&) {
+                rejected++;
+            }
+
+            writeCurveFile(c, path);
+            file = fopen(path, "r+b");
+            fseek(file, 0, SEEK_END);
+            fputc(0, file);
+            fclose(file);
+            try {
+                MappedCurve2D too_long(path);
+            }
+            catch (const std::runtime_error&) {
+                rejected++;
+            }
+
+            if (rejected != 3) {
+                failed = BEZ_TRUE;
+            }
+        }
+
+        remove(path);
+
+        if (failed) {
+            num_fails++;
+            printf("failed test %d\n", i + 1);
+        }
+    }
+
+    {
+        // a spline without anchor points has an empty points section at the
+        // very end of the file
+        const char* path = "curve_test.bin";
+        failed = BEZ_FALSE;
+
+        writeCurveFile(Curve2D(), path);
+        {
+            MappedCurve2D mapped(path);
+
+            if (mapped.anchorCount() != 0 || mapped.segmentCount() != 0) {
+                failed = BEZ_TRUE;
+            }
+        }
+        remove(path);
+
+        if (failed) {
+            num_fails++;
+            printf("failed test %d: spline without anchor points\n", num_tests);
+        }
+    }
+
+    if (num_fails == 0) {
+        printf("all %d tests passed\n", num_tests);
+    }
+    else {
+        printf("failed %d/%d tests\n", num_fails, num_tests);
+    }
+    num_tests = num_fails = -1;
+
+
+    //*************************************************************************
+    printf("\nTesting SvgPathParser:\n");
+    //*************************************************************************
+    num_tests = 5;
+    num_fails = 0;
+
+    for (i = 0; i < num_tests; i++) {
+        PathSegments2D path;
+        failed = BEZ_FALSE;
+
+        if (i == 0) {
+            // lines become cubic Bezier curves, closepath returns to the start
+            const char* data = "M10 20L30 40H50V60Z";
+            bezVect2D ends[5] = {{{10, 20}}, {{30, 40}}, {{50, 40}}, {{50, 60}}, {{10, 20}}};
+            parseSvgPath(data, strlen(data), path);
+
+            if (path.segmentCount() != 4 || path.quadraticCount() != 0 || path.subpaths.size() != 1 ||
+                !path.subpaths[0].closed) {
+                failed = BEZ_TRUE;
+            }
+            for (j = 0; !failed && j < 4; j++) {
+                if (path.cubics[4 * j] != ends[j] || path.cubics[4 * j + 3] != ends[j + 1] ||
+                    !is_close(distance2D(path.cubics[4 * j + 1], path.cubics[4 * j + 2]),
+                              distance2D(ends[j], ends[j + 1]) / 3)) {
+                    failed = BEZ_TRUE;
+                }
+            }
+        }
+        else if (i == 1) {
+            // relative commands, implicit repetition and compact numbers
+            const char* data = "m1,1 2,0-.5.5e1zl+1-1";
+            parseSvgPath(data, strlen(data), path);
+
+            if (path.segmentCount() != 4 || path.subpaths.size() != 2 ||
+                path.cubics[3] != bezVect2D({{3, 1}}) || path.cubics[7] != bezVect2D({{2.5, 6}}) ||
+                path.cubics[11] != bezVect2D({{1, 1}}) || path.cubics[15] != bezVect2D({{2, 0}}) ||
+                path.subpaths[1].cubic_begin != 3 || path.subpaths[1].closed) {
+                failed = BEZ_TRUE;
+            }
+        }
+        else if (i == 2) {
+            // S and T reflect the previous control point, quadratics elevate
+            const char* data = "M0 0C1 1 2 1 3 0S5-1 6 0Q7 1 8 0T10 0";
+            parseSvgPath(data, strlen(data), path);
+
+            if (path.segmentCount() != 2 || path.quadraticCount() != 2 ||
+                path.cubics[5] != bezVect2D({{4, -1}}) || path.quadratics[4] != bezVect2D({{9, -1}})) {
+                failed = BEZ_TRUE;
+            }
+
+            PathSegments2D elevated;
+            parseSvgPath(data, strlen(data), elevated, true);
+            if (elevated.segmentCount() != 4 || elevated.quadraticCount() != 0) {
+                failed = BEZ_TRUE;
+            }
+            for (j = 0; !failed && j < 2; j++) {
+                const bezVect2D* c = elevated.cubics.data() + 4 * (j + 2);
+                const bezVect2D* q = path.quadratics.data() + 3 * j;
+
+                for (BEZ_DTYPE t = 0; t <= 1; t += .125) {
+                    bezVect2D a, b;
+                    bez2Evaluate(c[0][0], c[0][1], c[1][0], c[1][1], c[2][0], c[2][1], c[3][0], c[3][1],
+                                 t, &a[0], &a[1]);
+                    bez2EvaluateQuadratic(q[0][0], q[0][1], q[1][0], q[1][1], q[2][0], q[2][1], t, &b[0], &b[1]);
+                    if (!is_close(distance2D(a, b), 0.)) {
+                        failed = BEZ_TRUE;
+                    }
+                }
+            }
+        }
+        else if (i == 3) {
+            // any split into chunks gives the same segments as a single feed
+            std::string data = "M 0.5,1e1 c 1.25 -2 3 4.5e-1 -5 6 s 1 2 3 4 q -1 -2 -3 -4 t 5 6";
+            data += " L 7 8 h -9.75 v 10 Z m 1 1 l 2 2 3 3 z";
+            parseSvgPath(data.data(), data.size(), path);
+
+            for (std::size_t chunk = 1; chunk <= 7; chunk++) {
+                PathSegments2D chunked;
+                SvgPathParser parser(chunked);
+
+                for (j = 0; j < data.size(); j += chunk) {
+                    parser.feed(data.data() + j, std::min(chunk, data.size() - j));
+                }
+                parser.finish();
+
+                if (chunked.cubics != path.cubics || chunked.quadratics != path.quadratics ||
+                    chunked.subpaths.size() != path.subpaths.size()) {
+                    failed = BEZ_TRUE;
+                }
+            }
+
+            // the parsed segments feed the batch kernels directly
+            std::vector<bezVect2D> mins(path.segmentCount()), maxs(path.segmentCount());
+            segmentBoundingBoxes(path, mins.data(), maxs.data());
+            for (j = 0; j < path.segmentCount(); j++) {
+                const bezVect2D* c = path.cubics.data() + 4 * j;
+                bezVect2D min, max;
+                bez2BoundingBox(c[0][0], c[0][1], c[1][0], c[1][1], c[2][0], c[2][1], c[3][0], c[3][1],
+                                &min[0], &min[1], &max[0], &max[1]);
+                if (!is_close(distance2D(min, mins[j]), 0.) || !is_close(distance2D(max, maxs[j]), 0.)) {
+                    failed = BEZ_TRUE;
+                }
+            }
+        }
+        else {
+            // malformed path data is rejected
+            const char* bad[7] = {"L 1 2", "M 1 2 L 3", "M 1 2 Z 3", "M 1 2 A 1 1 0 0 1 3 4", "M 1 2 L 3 - 4",
+                                  "M L 1 1", "M 1 2 L"};
+            int rejected = 0;
+
+            for (j = 0; j < 7; j++) {
+                try {
+                    parseSvgPath(bad[j], strlen(bad[j]), path);
+                }
+                catch (const std::invalid_argument&) {
+                    rejected++;
+                }
+            }
+            if (rejected != 7) {
+                failed = BEZ_TRUE;
+            }
+        }
+
+        if (failed) {
+            num_fails++;
+            printf("failed test %d\n", i + 1);
+        }
+    }
+
+    if (num_fails == 0) {
+        printf("all %d tests passed\n", num_tests);
+    }
+    else {
+        printf("failed %d/%d tests\n", num_fails, num_tests);
+    }
+    num_tests = num_fails = -1;
+
+
+    //*************************************************************************
+    printf("\nTesting PathWriter:\n");
+    //*************************************************************************
+    num_tests = 4;
+    num_fails = 0;
+
+    for (i = 0; i < num_tests; i++) {
+        std::string text;
+        failed = BEZ_FALSE;
+
+        if (i == 0) {
+            // shortest round-trip output parses back to the same points
+            Curve2D open(randomAnchors2D(20)), closed(randomAnchors2D(20), true);
+
+            for (const Curve2D* c : {&open, &closed}) {
+                PathSegments2D parsed, reparsed;
+                text.clear();
+                {
+                    PathWriter writer([&text](const char* data, std::size_t size) { text.append(data, size); });
+                    writer.writeSvgPath(*c);
+                }
+                parseSvgPath(text.data(), text.size(), parsed);
+
+                if (parsed.segmentCount() != c->bezier_count || parsed.subpaths[0].closed != c->isClosed()) {
+                    failed = BEZ_TRUE;
+                }
+                for (j = 0; !failed && j < c->bezier_count; j++) {
+                    for (std::size_t p = 0; p < 4; p++) {
+                        if (parsed.cubics[4 * j + p] != c->points[3 * j + p]) {
+                            failed = BEZ_TRUE;
+                        }
+                    }
+                }
+
+                // raw cubic Bezier curves as well
+                text.clear();
+                {
+                    PathWriter writer([&text](const char* data, std::size_t size) { text.append(data, size); });
+                    writer.writeSvgPath(parsed.cubics.data(), parsed.segmentCount());
+                }
+                parseSvgPath(text.data(), text.size(), reparsed);
+                if (reparsed.cubics != parsed.cubics || reparsed.subpaths.size() != 1) {
+                    failed = BEZ_TRUE;
+                }
+            }
+        }
+        else if (i == 1) {
+            // fixed decimals drop trailing zeros and the sign of zero
+            bezVect2D points[2] = {{{1.5, 2}}, {{-0.001, 3.14159}}};
+            {
+                PathWriter writer([&text](const char* data, std::size_t size) { text.append(data, size); });
+                writer.setPrecision(2);
+                writer.writeCsv<2, BEZ_DTYPE>(points, 2);
+                writer.writeSvgPolyline(points, 2);
+            }
+            if (text != "1.5,2\n0,3.14\nM1.5,2L0,3.14") {
+                failed = BEZ_TRUE;
+            }
+        }
+        else if (i == 2) {
+            // a minimal buffer flushes often but gives the same text
+            std::vector<bezVect3D> anchors(50);
+            std::string small;
+            std::size_t flushes = 0;
+
+            for (j = 0; j < anchors.size(); j++) {
+                anchors[j] = {{(BEZ_DTYPE)(rand()) / RAND_MAX * 100, (BEZ_DTYPE)(rand()) / RAND_MAX * 100,
+                               (BEZ_DTYPE)(rand()) / RAND_MAX * 100}};
+            }
+            Curve3D c(anchors);
+            {
+                PathWriter writer([&text](const char* data, std::size_t size) { text.append(data, size); });
+                writer.writeCsv(c);
+            }
+            {
+                PathWriter writer([&small, &flushes](const char* data, std::size_t size) {
+                    small.append(data, size);
+                    flushes++;
+                }, 64);
+                writer.writeCsv(c);
+                writer.flush();
+                if (writer.bytesWritten() != text.size()) {
+                    failed = BEZ_TRUE;
+                }
+            }
+            if (small != text || flushes < text.size() / 64) {
+                failed = BEZ_TRUE;
+            }
+
+            const char* p = text.c_str();
+            char* end;
+            for (j = 0; !failed && j < c.points.size(); j++) {
+                for (std::size_t d = 0; d < 3; d++) {
+                    if (strtof(p, &end) != c.points[j][d]) {
+                        failed = BEZ_TRUE;
+                    }
+                    p = end + 1;
+                }
+            }
+        }
+        else {
+            // a file descriptor receives the same text as a callback
+            Curve2D c(randomAnchors2D(30));
+            FILE* file = tmpfile();
+            {
+                PathWriter writer([&text](const char* data, std::size_t size) { text.append(data, size); });
+                writer.writeSvgPath(c);
+            }
+            {
+                PathWriter writer(fileno(file), 128);
+                writer.writeSvgPath(c);
+            }
+
+            std::string read(text.size() + 1, '\0');
+            rewind(file);
+            read.resize(fread(&read[0], 1, read.size(), file));
+            fclose(file);
+            if (read != text) {
+                failed = BEZ_TRUE;
+            }
+        }
+
+        if (failed) {
+            num_fails++;
+            printf("failed test %d\n", i + 1);
+        }
+    }
+
+    if (num_fails == 0) {
+        printf("all %d tests passed\n", num_tests);
+    }
+    else {
+        printf("failed %d/%d tests\n", num_fails, num_tests);
+    }
+    num_tests = num_fails = -1;
+
+
+    //*************************************************************************
+    printf("\nTesting bezStats with Curve2D:\n");
+    //*************************************************************************
+    num_tests = 4;
+    num_fails = 0;
+
+    for (i = 0; i < num_tests; i++) {
+        Curve2D c(randomAnchors2D(200));
+        bezStats stats;
+        failed = BEZ_FALSE;
+
+        bezStatsReset();
+        if (i == 0) {
+            // a read after a single edit solves a window around it
+            c.setAnchor(randomAnchors2D(1)[0], 100);
+            c.getPositionAt(0.5);
+        }
+        else if (i == 1) {
+            c.markDirty(0, 200);
+            c.updateControlPoints();
+        }
+        else if (i == 2) {
+            ThreadPool pool(2);
+            c.updateControlPoints(pool);
+        }
+        else {
+            // the set counts its solves on the rebuilding thread, and the
+            // set, its views and streaming splines count their evaluations
+            CurveSet2D set;
+            StreamingCurve2D stream(8);
+            ThreadPool pool(2);
+            std::size_t curves[3] = {0, 1, 1};
+            BEZ_DTYPE ts[3] = {0., 0.5, 1.};
+            bezVect2D out[3];
+
+            set.add(randomAnchors2D(50));
+            set.add(randomAnchors2D(20));
+            set.rebuild(pool);
+            set.evaluate(curves, ts, 3, out);
+            set.view(0).getPositionAt(0.5);
+            for (const bezVect2D& anchor : randomAnchors2D(4)) {
+                stream.append(anchor);
+            }
+            stream.getPositionAt(0.5);
+        }
+        bezStatsSnapshot(&stats);
+
+#if defined(BEZ_ENABLE_STATS)
+        if (i == 0) {
+            if (stats.update_calls != 0 || stats.full_solves != 0 || stats.local_solves != 1 ||
+                stats.solved_anchors != 2 * BEZ_LOCAL_SOLVE_MARGIN + 1 || stats.evaluations != 1) {
+                failed = BEZ_TRUE;
+            }
+        }
+        else if (i == 3) {
+            if (stats.full_solves != 2 || stats.solved_anchors != 70 ||
+                stats.max_solved_anchors != 50 || stats.evaluations != 5) {
+                failed = BEZ_TRUE;
+            }
+        }
+        else if (stats.update_calls != 1 || stats.full_solves != 1 || stats.local_solves != 0 ||
+                 stats.max_solved_anchors != 200) {
+            failed = BEZ_TRUE;
+        }
+#else
+        // without BEZ_ENABLE_STATS nothing is counted
+        if (stats.update_calls != 0 || stats.full_solves != 0 || stats.local_solves != 0 ||
+            stats.evaluations != 0) {
+            failed = BEZ_TRUE;
+        }
+#endif
+
+        if (failed) {
+            num_fails++;
+            printf("failed test %d\n", i + 1);
+        }
+    }
+
+    if (num_fails == 0) {
+        printf("all %d tests passed\n", num_tests);
+    }
+    else {
+        printf("failed %d/%d tests\n", num_fails, num_tests);
+    }
+    num_tests = num_fails = -1;
+
+
+    //*************************************************************************
+    printf("\nTesting bezTrace with Curve2D:\n");
+    //*************************************************************************
+    num_tests = 4;
+    num_fails = 0;
+
+    {
+        const char* path = "curve_test_trace.json";
+        std::size_t events[4], threads[4], constructions[4], updates[4], tessellations[4];
+        std::size_t full_solves[4], local_solves[4];
+        std::vector<bezVect2D> tess;
+
+        for (i = 0; i < num_tests; i++) {
+            bezTraceClear();
+            bezTraceStart();
+            if (i == 0) {
+                Curve2D c(randomAnchors2D(50));
+                c.setAnchor(randomAnchors2D(1)[0], 10);
+                c.updateControlPoints();
+                tessellate(CurveInterleavedView<2, BEZ_DTYPE>(c), 4, tess);
+            }
+            else if (i == 1) {
+                // each thread records to its own buffer
+                std::thread other([]() { Curve2D c(randomAnchors2D(50)); });
+                Curve2D c(randomAnchors2D(50));
+                other.join();
+            }
+            else if (i == 2) {
+                bezTraceStop();
+                Curve2D c(randomAnchors2D(50));
+            }
+            else {
+                // a read of a dirty spline records the solve it triggers
+                bezTraceStop();
+                Curve2D c(randomAnchors2D(50));
+                c.setAnchor(randomAnchors2D(1)[0], 25);
+                bezTraceStart();
+                c.getPositionAt(0.5);
+            }
+            bezTraceStop();
+
+            if (!bezTraceWrite(path)) {
+                events[i] = threads[i] = constructions[i] = updates[i] = tessellations[i] = 1000;
+                full_solves[i] = local_solves[i] = 1000;
+                continue;
+            }
+            events[i] = countInFile(path, "\"ph\": \"X\"");
+            threads[i] = countInFile(path, "\"thread_name\"");
+            constructions[i] = countInFile(path, "\"Curve::Curve\"");
+            updates[i] = countInFile(path, "\"Curve::updateControlPoints\"");
+            tessellations[i] = countInFile(path, "\"tessellate\"");
+            full_solves[i] = countInFile(path, "\"Curve::solveAll\"");
+            local_solves[i] = countInFile(path, "\"Curve::solveRange\"");
+        }
+        bezTraceClear();
+        remove(path);
+
+#if defined(BEZ_ENABLE_TRACE)
+        // the construction and the update each solve every row
+        if (events[0] != 5 || threads[0] != 1 || constructions[0] != 1 || updates[0] != 1 ||
+            tessellations[0] != 1 || full_solves[0] != 2) {
+            num_fails++;
+            printf("failed test 1\n");
+        }
+        if (events[1] != 4 || threads[1] != 2 || constructions[1] != 2 || full_solves[1] != 2) {
+            num_fails++;
+            printf("failed test 2\n");
+        }
+        if (events[3] != 1 || threads[3] != 1 || full_solves[3] + local_solves[3] != 1) {
+            num_fails++;
+            printf("failed test 4\n");
+        }
+#else
+        // without BEZ_ENABLE_TRACE nothing is recorded
+        for (i = 0; i < 4; i++) {
+            if (i != 2 && (events[i] != 0 || threads[i] != 0 || full_solves[i] != 0 ||
+                           local_solves[i] != 0)) {
+                num_fails++;
+                printf("failed test %d\n", i + 1);
+            }
+        }
+#endif
+        // after bezTraceStop nothing is recorded either
+        if (events[2] != 0 || threads[2] != 0) {
+            num_fails++;
+            printf("failed test 3\n");
+        }
+    }
+
+    if (num_fails == 0) {
+        printf("all %d tests passed\n", num_tests);
+    }
+    else {
+        printf("failed %d/%d tests\n", num_fails, num_tests);
+    }
+    num_tests = num_fails = -1;
+
+
+    printf("\n\nThis concludes the unit tests for curve.h/cpp\n");
+
+    return 0;
+}
+
+
+/*
+ * function: is_close
+ *
+ * Returns BEZ_TRUE if a and b are within tolerance of each other,
+ *     BEZ_FALSE otherwise.
+ */
+int is_close(BEZ_DTYPE a, BEZ_DTYPE b, BEZ_DTYPE tolerance) {
+    BEZ_DTYPE diff = a - b;
+
+    if (diff < 0) {
+        diff = -diff;
+    }
+
+    if (diff <= tolerance) {
+        return BEZ_TRUE;
+    }
+    else {
+        return BEZ_FALSE;
+    }
+}
+
+/*
+ * function: randomUniform
+ *
+ * Returns a random value uniformly distributed on [a, b].
+ */
+double randomUniform(double a, double b) {
+    double r = (double)(rand()) / (double)RAND_MAX;  // distributed on [0, 1]
+    return r * (b - a) + a;
+}
+
+/*
+ * function: randomAnchors2D
+ *
+ * Returns n random anchor points in the square [-10, 10] x [-10, 10].
+ */
+std::vector<bezVect2D> randomAnchors2D(std::size_t n) {
+    std::vector<bezVect2D> anchors(n);
+    std::size_t i;
+
+    for (i = 0; i < n; i++) {
+        anchors[i][0] = randomUniform(-10., 10.);
+        anchors[i][1] = randomUniform(-10., 10.);
+    }
+
+    return anchors;
+}
+
+/*
+ * function: distance2D
+ *
+ * Returns the Euclidean distance between a and b.
+ */
+BEZ_DTYPE distance2D(const bezVect2D& a, const bezVect2D& b) {
+    BEZ_DTYPE dx = a[0] - b[0];
+    BEZ_DTYPE dy = a[1] - b[1];
+
+    return sqrt(dx * dx + dy * dy);
+}
+
+/*
+ * function: countInFile
+ *
+ * Returns the number of times text occurs in the file at path.
+ */
+std::size_t countInFile(const char* path, const char* text) {
+    FILE* file = fopen(path, "rb");
+    std::string contents;
+    std::size_t count = 0, position = 0;
+    int ch;
+
+    if (file == NULL) {
+        return 0;
+    }
+    while ((ch = fgetc(file)) != EOF) {
+        contents.push_back((char)(ch));
+    }
+    fclose(file);
+
+    while ((position = contents.find(text, position)) != std::string::npos) {
+        count++;
+        position += strlen(text);
+    }
+    return count;
+}